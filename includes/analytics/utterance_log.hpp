@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sadhana {
+
+// Append-only columnar store of per-utterance records, for questions across
+// many finished sessions (which variants fire in a section, seconds per
+// offering, where people press the key). Rows are buffered and written in
+// chunks; inside a chunk every column is one contiguous fixed-width array,
+// so a scan reads only the columns it needs and filters them in tight loops.
+// Strings are dictionary-encoded: each chunk carries the entries it added to
+// the file-wide dictionary, and columns hold 32-bit ids.
+//
+// Layout, host byte order:
+//   FileHeader
+//   chunk*: ChunkHeader, new dictionary entries (u32 length + bytes),
+//           then each column in Column order, every section padded to 8 bytes
+// A chunk whose declared size runs past the end of the file is a torn append
+// and is ignored (and cut off when the file is reopened for writing).
+
+enum class UtteranceKind : uint8_t {
+    Recognized = 1,     // a transcript reached the flow, counted or not
+    ManualAdvance = 2   // a key press moved the flow on
+};
+
+struct UtteranceRecord {
+    int64_t wallMs{0};     // system clock
+    int64_t streamMs{0};   // session's stream clock (audio time for live and offline runs)
+    UtteranceKind kind{UtteranceKind::Recognized};
+    bool accepted{false};  // counted as an offering
+    std::string section;
+    std::string part;
+    std::string transcript;
+    std::string marker;    // matched marker variant, empty when nothing matched
+    float confidence{0.0f};
+    float decodeMs{0.0f};
+    int32_t repetition{0};  // after the record was applied
+};
+
+// One chunk's columns as read back; string columns hold dictionary ids
+struct UtteranceChunk {
+    enum Column : uint32_t {
+        Session, WallMs, StreamMs, Kind, Accepted, Section, Part,
+        Transcript, Marker, Confidence, DecodeMs, Repetition,
+        COLUMN_COUNT
+    };
+    static constexpr uint32_t ALL_COLUMNS = (1u << COLUMN_COUNT) - 1;
+
+    size_t rows{0};
+    std::vector<uint32_t> session;
+    std::vector<int64_t> wallMs;
+    std::vector<int64_t> streamMs;
+    std::vector<uint8_t> kind;
+    std::vector<uint8_t> accepted;
+    std::vector<uint32_t> section;
+    std::vector<uint32_t> part;
+    std::vector<uint32_t> transcript;
+    std::vector<uint32_t> marker;
+    std::vector<float> confidence;
+    std::vector<float> decodeMs;
+    std::vector<int32_t> repetition;
+};
+
+class UtteranceLogWriter {
+public:
+    struct Config {
+        std::string path;
+        size_t chunkRows{4096};
+        double flushSeconds{30.0};  // a chunk is also written once its oldest row is this old
+    };
+
+    explicit UtteranceLogWriter(const Config& config);
+    ~UtteranceLogWriter();
+
+    UtteranceLogWriter(const UtteranceLogWriter&) = delete;
+    UtteranceLogWriter& operator=(const UtteranceLogWriter&) = delete;
+
+    // Creates the file or appends to an existing one, keeping its dictionary
+    bool open(std::string* error = nullptr);
+    // Writes the buffered rows
+    void close();
+
+    // Applies to the rows appended after it
+    void setSession(const std::string& session);
+    // One thread at a time (the flow's). Writes the buffered rows when the
+    // section changes, after chunkRows rows or after flushSeconds, so a crash
+    // mid-session loses little more than the section in progress.
+    void append(const UtteranceRecord& record);
+    bool flush();
+
+    uint64_t rowsWritten() const { return rowsWritten_; }
+
+private:
+    Config config_;
+    int fd_{-1};
+    uint32_t session_{0};
+
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<std::string> pendingEntries_;  // added since the last chunk
+    uint32_t dictionarySize_{0};
+
+    UtteranceChunk buffer_;
+    std::vector<char> chunkBytes_;  // reused to assemble each chunk
+    uint64_t rowsWritten_{0};
+
+    uint32_t intern(const std::string& value);
+};
+
+class UtteranceLogReader {
+public:
+    UtteranceLogReader() = default;
+    ~UtteranceLogReader();
+
+    UtteranceLogReader(const UtteranceLogReader&) = delete;
+    UtteranceLogReader& operator=(const UtteranceLogReader&) = delete;
+
+    bool open(const std::string& path, std::string* error = nullptr);
+    void close();
+
+    // Reads the next complete chunk, loading only the columns in the mask
+    // (bits by UtteranceChunk::Column). False at the end of the file.
+    bool next(UtteranceChunk& chunk, uint32_t columns = UtteranceChunk::ALL_COLUMNS);
+
+    // Entries seen so far; covers every id in the chunks returned by next()
+    const std::vector<std::string>& dictionary() const { return dictionary_; }
+    // Byte offset just past the last complete chunk read
+    uint64_t validBytes() const { return offset_; }
+
+private:
+    int fd_{-1};
+    uint64_t fileSize_{0};
+    uint64_t offset_{0};
+    std::vector<std::string> dictionary_;
+    std::vector<char> dictionaryBytes_;
+};
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "asr/vosk_asr.hpp"
+#include "audio/spsc_queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sadhana {
+
+// Decodes utterances on N recognizers sharing one Vosk model. Jobs are dealt
+// round-robin into per-worker deques, each behind its own mutex. Idle workers
+// sleep on a semaphore that counts queued jobs, then take the oldest job in
+// their own deque or the newest in another's. Results are put back into
+// submission order before the callback sees them. An utterance re-decoded on
+// a larger model keeps its place: later results wait behind it.
+class AsrExecutor {
+public:
+    struct Config {
+        size_t workers{1};
+    };
+
+    struct Job {
+        uint64_t sequence{0};
+        std::vector<float> samples;
+        size_t tier{0};
+        std::chrono::steady_clock::time_point endTime{};  // carried through to the result
+        uint64_t traceId{0};
+        int64_t startNs{0};   // trace timestamps, carried through to the result
+        int64_t queuedNs{0};
+    };
+
+    struct Result {
+        uint64_t sequence{0};
+        std::string json;
+        std::chrono::steady_clock::duration decodeTime{};
+        size_t worker{0};
+        size_t tier{0};
+        std::chrono::steady_clock::time_point endTime{};
+        bool decoded{true};  // false when the result bypassed the recognizers
+        double audioSeconds{0.0};
+        uint64_t traceId{0};
+        int64_t startNs{0};
+    };
+
+    // Called in sequence order, one call at a time, from a worker thread and
+    // without the executor's lock held. Returning false keeps the sequence
+    // open: the callback has submitted the utterance again on a larger tier,
+    // and that result is the next one delivered.
+    using ResultCallback = std::function<bool(const Result&)>;
+    // Called whenever a worker finishes a decode, before results are reordered
+    using WorkerFreeCallback = std::function<void()>;
+
+    AsrExecutor(const VoskASR& asr, const Config& config);
+    ~AsrExecutor();
+
+    bool start(ResultCallback callback, WorkerFreeCallback workerFree = {});
+    void stop();
+
+    // Sequence numbers of tier 0 jobs must start at 0 and have no gaps;
+    // re-decodes on a larger tier reuse the original utterance's sequence and
+    // are submitted from the callback that keeps it open. False once stopped.
+    bool submit(Job job);
+    // Slot an externally produced result (e.g. a keyword spot) into the sequence
+    void submitDecoded(Result result);
+
+    size_t workerCount() const { return workers_.size(); }
+    size_t inFlight() const { return inFlight_.load(std::memory_order_acquire); }
+    uint64_t stolenJobs() const { return stolenJobs_.load(std::memory_order_relaxed); }
+    // Utterances stop() found undecoded or undelivered and discarded
+    uint64_t abandonedJobs() const { return abandonedJobs_.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::vector<VoskASR::RecognizerPtr> recognizers;  // one per tier, created on first use
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        std::thread thread;
+    };
+
+    const VoskASR& asr_;
+    Config config_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::counting_semaphore<> pending_{0};
+    StageSignal submitted_;  // bumped after each job is queued
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> nextWorker_{0};
+    std::atomic<size_t> inFlight_{0};
+    std::atomic<uint64_t> stolenJobs_{0};
+    std::atomic<uint64_t> abandonedJobs_{0};
+
+    std::mutex reorderMutex_;
+    std::map<uint64_t, Result> reorderBuffer_;
+    uint64_t nextToDeliver_{0};
+    bool delivering_{false};  // a worker is running the callback
+    ResultCallback callback_;
+    WorkerFreeCallback workerFree_;
+
+    void runWorker(size_t index);
+    bool takeJob(size_t index, Job& job);
+    void deliver(Result result);
+};
+
+}
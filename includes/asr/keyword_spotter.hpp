@@ -0,0 +1,90 @@
+#pragma once
+
+#include "audio/fft.hpp"
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sadhana {
+
+// Template-matching spotter for the iteration marker. Log-mel features of
+// utterances that full ASR already confirmed are enrolled as templates;
+// later utterances are compared against them with banded DTW. Templates are
+// held per key (the caller's section and part), since each part's offerings
+// open differently and a template's transcript must suit the flow it feeds.
+class KeywordSpotter {
+public:
+    struct Config {
+        int sampleRate{48000};
+        int featureRate{16000};
+        int melBands{32};
+        int frameMs{25};
+        int hopMs{10};
+        size_t enrollmentCount{4};
+        float acceptFactor{1.15f};   // of the mean distance between templates
+        float bandFraction{0.2f};    // Sakoe-Chiba band, as a fraction of length
+        float maxLengthRatio{1.6f};
+    };
+
+    struct Features {
+        std::vector<float> data;
+        size_t frames{0};
+        size_t dims{0};
+
+        const float* frame(size_t i) const { return data.data() + i * dims; }
+    };
+
+    struct SpotResult {
+        bool accepted{false};
+        float distance{0.0f};
+        float threshold{0.0f};
+        float confidence{0.0f};
+        std::string transcript;
+    };
+
+    explicit KeywordSpotter(const Config& config);
+
+    Features extractFeatures(const float* samples, size_t numSamples) const;
+
+    // Returns true once enough templates are held under key to start spotting
+    bool enroll(const std::string& key, Features features, const std::string& transcript);
+    SpotResult spot(const std::string& key, const Features& features) const;
+
+    bool isEnrolled(const std::string& key) const;
+    // Over all keys
+    size_t templateCount() const;
+    void reset();
+
+private:
+    struct Template {
+        Features features;
+        std::string transcript;
+    };
+
+    struct TemplateSet {
+        std::vector<Template> templates;
+        float threshold{0.0f};
+    };
+
+    struct MelFilter {
+        size_t firstBin{0};
+        std::vector<float> weights;
+    };
+
+    Config config_;
+    size_t frameLength_{0};
+    size_t hopLength_{0};
+    Fft fft_;
+    std::vector<float> window_;
+    std::vector<MelFilter> melFilters_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, TemplateSet> sets_;
+
+    void buildMelFilters();
+    float dtwDistance(const Features& a, const Features& b) const;
+    void updateThreshold(TemplateSet& set) const;
+};
+
+}
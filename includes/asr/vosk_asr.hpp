@@ -2,6 +2,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <vosk_api.h>
 
 namespace sadhana {
@@ -10,24 +11,34 @@ struct VoskASR {
     struct Config {
         std::string modelPath;
         float sampleRate;
+        // Larger models tried in order when the fast model's result is not good enough
+        std::vector<std::string> escalationModelPaths;
     };
 
-    explicit VoskASR(const Config& config) : config_(config) {}
-
-    bool init();
-    std::string processAudio(const float* samples, size_t numSamples);
-
-private:
-    Config config_;
     struct VoskModelDeleter {
         void operator()(VoskModel* p) { if (p) vosk_model_free(p); }
     };
     struct VoskRecognizerDeleter {
         void operator()(VoskRecognizer* p) { if (p) vosk_recognizer_free(p); }
     };
+    using RecognizerPtr = std::unique_ptr<VoskRecognizer, VoskRecognizerDeleter>;
+
+    explicit VoskASR(const Config& config) : config_(config) {}
+
+    // Loads the models; recognizers are created by their users
+    bool init();
+
+    // Extra recognizers share the loaded model, one per decoding thread.
+    // Tier 0 is modelPath, tier N is escalationModelPaths[N - 1].
+    RecognizerPtr createRecognizer(size_t tier = 0) const;
+    size_t tierCount() const { return models_.size(); }
+    static std::string decode(VoskRecognizer* recognizer, const float* samples, size_t numSamples);
 
-    std::unique_ptr<VoskModel, VoskModelDeleter> model_;
-    std::unique_ptr<VoskRecognizer, VoskRecognizerDeleter> recognizer_;
+    const Config& getConfig() const { return config_; }
+
+private:
+    Config config_;
+    std::vector<std::unique_ptr<VoskModel, VoskModelDeleter>> models_;
 };
 
-}
\ No newline at end of file
+}
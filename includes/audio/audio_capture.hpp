@@ -1,4 +1,5 @@
 #pragma once
+#include "metrics/metrics.hpp"
 #include <portaudio.h>
 #include <functional>
 #include <string>
@@ -24,6 +25,9 @@ public:
               std::function<void(const float*, size_t)> callback);
     void stop();
 
+    // ADC time of the buffer being delivered; only meaningful inside the data callback
+    double currentInputAdcTime() const { return currentAdcTime_; }
+
     static constexpr int DEFAULT_SAMPLE_RATE = 48000;
     static constexpr int DEFAULT_FRAMES_PER_BUFFER = 480 * 3;
 
@@ -37,6 +41,9 @@ private:
     PaStream* stream_{nullptr};
     int selectedDevice_{-1};
     std::function<void(const float*, size_t)> dataCallback_;
+    double currentAdcTime_{0.0};
+    Counter& inputOverflows_;
+    Counter& inputUnderflows_;
 };
 
 }
\ No newline at end of file
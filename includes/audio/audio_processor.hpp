@@ -2,23 +2,70 @@
 
 #include "audio/audio_capture.hpp"
 #include "audio/vad.hpp"
-#include "audio/vosk_asr.hpp"
+#include "audio/clock.hpp"
+#include "audio/spsc_queue.hpp"
+#include "audio/segment_admission.hpp"
+#include "audio/utterance_pipeline.hpp"
+#include "asr/vosk_asr.hpp"
+#include "asr/asr_executor.hpp"
+#include "asr/keyword_spotter.hpp"
 #include "definition/definition.hpp"
-#include "phrase_manager.hpp"
+#include "phrase/phrase_manager.hpp"
+#include "trace/tracer.hpp"
+#include "metrics/metrics.hpp"
+#include <array>
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <chrono>
 #include <map>
+#include <mutex>
+#include <thread>
 
 namespace sadhana {
 
+class SessionRecorder;
+class FlowManager;
+struct FlowProgress;
+struct RitualAssets;
+
 class RitualAudioProcessor {
 public:
+    // What the VAD stage does with a finished utterance when the ASR queue is full
+    enum class OverloadPolicy {
+        Queue,  // hold it in a backlog on the VAD thread and retry
+        Merge,  // append it to the newest utterance still waiting for ASR
+        Drop    // discard it and count the drop
+    };
+
+    enum class ClockSource {
+        Samples,  // audio time: sample count, or ADC timestamps for live input
+        Steady    // wall time
+    };
+
     struct Config {
         int sampleRate{AudioCapture::DEFAULT_SAMPLE_RATE};
+        ClockSource clockSource{ClockSource::Samples};
         int framesPerBuffer{AudioCapture::DEFAULT_FRAMES_PER_BUFFER};
         VAD::Config vadConfig;
         VoskASR::Config asrConfig;
+        size_t audioQueueBlocks{256};
+        size_t utteranceQueueDepth{4};
+        size_t transcriptQueueDepth{16};
+        size_t asrWorkers{1};
+        bool enableKeywordSpotter{true};
+        KeywordSpotter::Config kwsConfig;
+        float kwsMinConfidence{0.55f};
+        size_t retainedUtterances{32};  // kept for re-decoding on a larger model
+        bool suspendVadBuffering{false};  // while suspended, keep only the pre-roll ring
+        int prerollMs{1500};
+        SegmentAdmission::Config admission;
+        OverloadPolicy overloadPolicy{OverloadPolicy::Queue};
+        // Most the Queue and Merge backlog holds while ASR is behind; past
+        // either limit the oldest held utterance is dropped
+        size_t backlogUtterances{16};
+        double backlogSeconds{60.0};
     };
 
     struct ProcessingResult {
@@ -40,10 +87,41 @@ public:
         std::map<std::string, int> counts;
     };
 
+    using StageStats = UtterancePipeline::StageStats;
+
+    struct PipelineStats {
+        StageStats vad;
+        StageStats asr;
+        StageStats match;
+        StageStats kws;
+        uint64_t audioOverruns{0};
+        uint64_t utterancesMerged{0};
+        uint64_t utterancesDropped{0};  // backlog over its limits, Drop policy, or lost on stop()
+        size_t asrWorkers{0};
+        size_t asrInFlight{0};
+        uint64_t asrStolenJobs{0};
+        size_t kwsTemplates{0};
+        uint64_t kwsHits{0};
+        uint64_t kwsFallbacks{0};
+        std::vector<StageStats> asrTiers;  // decode latency per model tier
+        uint64_t escalations{0};
+        double escalationRate{0.0};
+        uint64_t escalationsKept{0};  // the larger model did no better; the first result stood
+        uint64_t decodesSkipped{0};
+        double suspendedSeconds{0.0};
+        double cpuSeconds{0.0};
+        double wallSeconds{0.0};
+        std::map<std::string, uint64_t> admission;  // segments by verdict
+    };
+
     using ProgressCallback = std::function<void(const RitualProgress&)>;
     using ResultCallback = std::function<void(const ProcessingResult&)>;
     using ErrorCallback = std::function<void(const std::string&)>;
-    using TranscriptionCallback = std::function<void(const std::string&)>;
+    // The final text with its match; decode time is that of the model tier that
+    // produced it, and the trace id and speech onset tie it to its utterance in
+    // latency traces
+    using TranscriptionCallback = std::function<void(const UtterancePipeline::Transcript& transcript)>;
+    using CalibrationCallback = std::function<void()>;
 
     explicit RitualAudioProcessor(const RitualDefinition& ritual);
     ~RitualAudioProcessor();
@@ -61,44 +139,108 @@ public:
     void setTranscriptionCallback(TranscriptionCallback callback) {
         transcriptionCallback_ = std::move(callback);
     }
+    void setCalibrationCallback(CalibrationCallback callback) {
+        calibrationCallback_ = std::move(callback);
+    }
 
     bool isRunning() const { return running_; }
-    bool isSpeechActive() const { return speechActive_; }
+    bool isCalibrating() const { return !pipeline_ || pipeline_->isCalibrating(); }
+    bool isSpeechActive() const { return pipeline_ && pipeline_->isSpeechActive(); }
+    float getCurrentLevel() const { return pipeline_ ? pipeline_->currentLevelDb() : -60.0f; }
     const RitualProgress& getCurrentProgress() const { return currentProgress_; }
+    PipelineStats getStats() const;
+    // Time base for VAD, cooldowns and anything else that should follow the audio
+    const Clock& getClock() const { return *clock_; }
+
+    // After init(): suspension, keyword spotting, escalation threshold and
+    // admission thresholds as the flow's current section wants them
+    void followFlow(const FlowManager& flow, const FlowProgress& progress) {
+        pipeline_->followFlow(flow, progress);
+    }
+    // Gets a copy of every captured block, before the VAD; set before start()
+    void setRecorder(SessionRecorder* recorder) { recorder_ = recorder; }
+    // Any thread: the next transcript is matched (and its cooldown looked up)
+    // with this definition and matcher; one already being matched finishes
+    // with the previous pair
+    void reload(std::shared_ptr<const RitualAssets> assets);
 
 private:
-    const RitualDefinition& ritual_;
+    static constexpr size_t MAX_BLOCK_FRAMES = 2048;
+
+    struct AudioBlock {
+        std::array<float, MAX_BLOCK_FRAMES> samples;
+        size_t count{0};
+        double adcTime{0.0};
+    };
+
+    using Utterance = UtterancePipeline::Utterance;
+    using Transcript = UtterancePipeline::Transcript;
+
     std::unique_ptr<AudioCapture> audioCapture_;
-    std::unique_ptr<VAD> vad_;
+    std::unique_ptr<SampleClock> sampleClock_;
+    const Clock* clock_{&SteadyClock::instance()};
     std::unique_ptr<VoskASR> asr_;
-    std::unique_ptr<PhraseManager> phraseManager_;
-
-    bool running_{false};
-    bool speechActive_{false};
-    std::vector<float> speechBuffer_;
+    std::unique_ptr<AsrExecutor> asrExecutor_;
+    std::shared_ptr<const RitualAssets> initialAssets_;  // handed to the pipeline by init()
+    std::unique_ptr<UtterancePipeline> pipeline_;
+
+    std::atomic<bool> running_{false};
+    std::chrono::steady_clock::time_point startTime_;
+    double startCpuSeconds_{0.0};
+    uint64_t nextAsrSequence_{0};
+
+    std::unique_ptr<SpscQueue<AudioBlock>> audioQueue_;
+    std::unique_ptr<SpscQueue<Utterance>> utteranceQueue_;
+    std::unique_ptr<SpscQueue<Transcript>> transcriptQueue_;
+    std::deque<Utterance> utteranceBacklog_;
+    size_t backlogSamples_{0};  // VAD thread only
+    std::atomic<size_t> backlogSize_{0};
+    StageSignal vadSignal_;
+    StageSignal asrSignal_;
+    StageSignal matchSignal_;
+    StageSignal transcriptSpace_;  // match stage popped; a delivering worker may push again
+    std::thread vadThread_;
+    std::thread asrThread_;
+    std::thread matchThread_;
+
+    std::atomic<uint64_t> audioOverruns_{0};
+    SessionRecorder* recorder_{nullptr};
+    std::atomic<uint64_t> utterancesMerged_{0};
+    std::atomic<uint64_t> utterancesDropped_{0};
+
+    // Exported through MetricsRegistry; the counters above feed getStats()
+    Counter& audioOverrunsMetric_;
+    Counter& utterancesDroppedMetric_;
 
     ProgressCallback progressCallback_;
     ResultCallback resultCallback_;
     ErrorCallback errorCallback_;
     TranscriptionCallback transcriptionCallback_;
+    CalibrationCallback calibrationCallback_;
 
     Config config_;
     RitualProgress currentProgress_;
 
     struct MarkerState {
-        std::chrono::steady_clock::time_point lastTriggerTime;
+        TimePoint lastTriggerTime;
         int cooldownMs;
     };
     std::map<std::string, MarkerState> markerStates_;
 
     void handleAudioData(const float* samples, size_t numSamples);
-    void handleSpeechStateChange(bool active);
-    void processTranscription(const std::string& text);
+    void runVadStage();
+    void runAsrStage();
+    void runMatchStage();
+    bool handleDecoded(const AsrExecutor::Result& result);
+    void emitUtterance(Utterance utterance);
+    void flushBacklog();
+    void dropUtterances(uint64_t count);
+    void processTranscription(const Transcript& transcript);
     void updateProgress(const ProcessingResult& result);
 
-    bool isInCooldown(const std::string& markerId) const;
-    void updateMarkerState(const std::string& markerId, int cooldownMs);
+    bool isInCooldown(const std::string& markerId, TimePoint at) const;
+    void updateMarkerState(const std::string& markerId, int cooldownMs, TimePoint at);
     void notifyError(const std::string& error);
 };
 
-}
\ No newline at end of file
+}
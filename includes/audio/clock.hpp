@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace sadhana {
+
+using TimePoint = std::chrono::steady_clock::time_point;
+
+// Time source for anything that measures hang times, cooldowns or flow timing.
+// Components take a Clock instead of calling steady_clock::now() so replayed
+// audio runs on audio time rather than wall time.
+class Clock {
+public:
+    virtual ~Clock() = default;
+    virtual TimePoint now() const = 0;
+};
+
+class SteadyClock : public Clock {
+public:
+    TimePoint now() const override { return std::chrono::steady_clock::now(); }
+
+    static const SteadyClock& instance() {
+        static SteadyClock clock;
+        return clock;
+    }
+};
+
+// Derives time from the audio actually consumed. The stage that processes the
+// stream advances it once per block; offline this is pure sample counting, so
+// results do not depend on replay speed. For live input, the PortAudio ADC
+// timestamp of the block is used when the host provides one.
+class SampleClock : public Clock {
+public:
+    explicit SampleClock(int sampleRate) : sampleRate_(sampleRate > 0 ? sampleRate : 1) {}
+
+    // streamTime is PortAudio's inputBufferAdcTime for the block, or 0 if unknown
+    void advance(size_t numSamples, double streamTime = 0.0) {
+        uint64_t consumedBefore = samples_;
+        samples_ += numSamples;
+
+        int64_t ns;
+        if (streamTime > 0.0) {
+            if (streamOrigin_ < 0.0) {
+                streamOrigin_ = streamTime - static_cast<double>(consumedBefore) / sampleRate_;
+            }
+            ns = static_cast<int64_t>((streamTime - streamOrigin_) * 1e9) + samplesToNs(numSamples);
+        } else {
+            ns = samplesToNs(samples_);
+        }
+
+        // Host timestamps can jitter backwards; time never does
+        if (ns > position_.load(std::memory_order_relaxed)) {
+            position_.store(ns, std::memory_order_release);
+        }
+    }
+
+    TimePoint now() const override {
+        return TimePoint(std::chrono::nanoseconds(position_.load(std::memory_order_acquire)));
+    }
+
+    uint64_t samples() const { return samples_; }
+    int sampleRate() const { return sampleRate_; }
+
+private:
+    int64_t samplesToNs(uint64_t samples) const {
+        return static_cast<int64_t>(samples / sampleRate_) * 1000000000LL +
+               static_cast<int64_t>(samples % sampleRate_) * 1000000000LL / sampleRate_;
+    }
+
+    const int sampleRate_;
+    uint64_t samples_{0};
+    double streamOrigin_{-1.0};
+    std::atomic<int64_t> position_{0};
+};
+
+// Set explicitly by whoever owns the timeline, e.g. a trace replay
+class ManualClock : public Clock {
+public:
+    void set(TimePoint time) { position_.store(time.time_since_epoch().count(), std::memory_order_release); }
+
+    TimePoint now() const override {
+        return TimePoint(TimePoint::duration(position_.load(std::memory_order_acquire)));
+    }
+
+private:
+    std::atomic<TimePoint::rep> position_{0};
+};
+
+}
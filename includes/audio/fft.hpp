@@ -0,0 +1,84 @@
+#pragma once
+
+#include <complex>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace sadhana {
+
+// In-place iterative radix-2 FFT with precomputed twiddles, sized once
+class Fft {
+public:
+    explicit Fft(size_t minSize) {
+        size_ = 1;
+        while (size_ < minSize) size_ <<= 1;
+
+        const float pi = 3.14159265358979f;
+        twiddles_.resize(size_ / 2);
+        for (size_t i = 0; i < twiddles_.size(); ++i) {
+            twiddles_[i] = std::polar(1.0f, -2.0f * pi * i / size_);
+        }
+
+        size_t bits = 0;
+        while ((size_t{1} << bits) < size_) ++bits;
+        bitReverse_.resize(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; ++b) {
+                if (i & (size_t{1} << b)) r |= size_t{1} << (bits - 1 - b);
+            }
+            bitReverse_[i] = r;
+        }
+    }
+
+    size_t size() const { return size_; }
+
+    void transform(std::vector<std::complex<float>>& data) const {
+        for (size_t i = 0; i < size_; ++i) {
+            if (i < bitReverse_[i]) std::swap(data[i], data[bitReverse_[i]]);
+        }
+        for (size_t len = 2; len <= size_; len <<= 1) {
+            size_t half = len / 2;
+            size_t step = size_ / len;
+            for (size_t start = 0; start < size_; start += len) {
+                for (size_t k = 0; k < half; ++k) {
+                    auto t = twiddles_[k * step] * data[start + k + half];
+                    data[start + k + half] = data[start + k] - t;
+                    data[start + k] += t;
+                }
+            }
+        }
+    }
+
+    // Windowed frame in, |X|^2 for bins 0..size/2 out
+    void powerSpectrum(const float* frame, const float* window, size_t length,
+                       std::vector<std::complex<float>>& scratch, std::vector<float>& power) const {
+        scratch.assign(size_, std::complex<float>{});
+        for (size_t i = 0; i < length && i < size_; ++i) {
+            scratch[i] = {frame[i] * window[i], 0.0f};
+        }
+        transform(scratch);
+        power.resize(size_ / 2 + 1);
+        for (size_t bin = 0; bin < power.size(); ++bin) {
+            power[bin] = std::norm(scratch[bin]);
+        }
+    }
+
+    static std::vector<float> hannWindow(size_t length) {
+        const float pi = 3.14159265358979f;
+        std::vector<float> window(length);
+        for (size_t i = 0; i < length; ++i) {
+            window[i] = 0.5f - 0.5f * std::cos(2.0f * pi * i / (length - 1));
+        }
+        return window;
+    }
+
+private:
+    size_t size_{1};
+    std::vector<std::complex<float>> twiddles_;
+    std::vector<size_t> bitReverse_;
+};
+
+}
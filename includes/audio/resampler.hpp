@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sadhana {
+
+// Streaming band-limited rate conversion for any pair of integer rates. Each
+// output sample is a Blackman-windowed sinc sum over the input around it,
+// with the cutoff just under the lower of the two Nyquist frequencies, so
+// taking 48 kHz capture down to 16 kHz removes what would otherwise fold
+// back into the band the recognizer listens to. Output sample i sits at
+// input time i * fromRate / toRate; it is emitted once the filter's half
+// width of input past that point has arrived, and finish() emits the rest.
+class Resampler {
+public:
+    Resampler(int fromRate, int toRate);
+
+    bool passthrough() const { return from_ == to_; }
+
+    // Calls emit(float) for every output sample the input so far completes
+    template <typename Emit>
+    void process(const float* samples, size_t count, Emit&& emit) {
+        if (passthrough()) {
+            for (size_t i = 0; i < count; ++i) emit(samples[i]);
+            return;
+        }
+        history_.insert(history_.end(), samples, samples + count);
+        received_ += count;
+        emitReady(received_, emit);
+    }
+
+    // The input ends here; emits the outputs that fall inside it
+    template <typename Emit>
+    void finish(Emit&& emit) {
+        if (passthrough()) return;
+        history_.insert(history_.end(), static_cast<size_t>(halfTaps_), 0.0f);
+        emitReady(received_, emit);
+        reset();
+    }
+
+    void reset();
+
+private:
+    static constexpr int ZERO_CROSSINGS = 16;  // of the kernel, each side
+    static constexpr int TABLE_STEPS = 128;    // kernel values per input sample
+
+    uint64_t from_;
+    uint64_t to_;
+    int64_t halfTaps_{0};       // input samples each side of an output that it reads
+    std::vector<float> kernel_;  // one side, at 1/TABLE_STEPS input sample spacing
+
+    std::vector<float> history_;  // input from index base_ on
+    uint64_t base_{0};
+    uint64_t received_{0};
+    uint64_t next_{0};            // next output sample
+
+    float sampleAt(uint64_t whole, uint64_t remainder) const;
+    void trim();
+
+    template <typename Emit>
+    void emitReady(uint64_t limit, Emit& emit) {
+        for (;;) {
+            uint64_t whole = next_ * from_ / to_;
+            if (whole >= limit || whole + halfTaps_ >= base_ + history_.size()) break;
+            emit(sampleAt(whole, next_ * from_ % to_));
+            ++next_;
+        }
+        trim();
+    }
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "audio/fft.hpp"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace sadhana {
+
+// Scores a finished VAD segment before it is allowed into the recognizer.
+// Clicks, coughs and pouring water fail on length, voicing, spectral
+// flatness or the lack of a pitch track.
+class SegmentAdmission {
+public:
+    struct Config {
+        bool enabled{true};
+        int minDurationMs{350};
+        float minVoicedRatio{0.3f};
+        float maxSpectralFlatness{0.45f};
+        float minPitchedRatio{0.2f};  // of voiced frames; 0 disables the pitch check
+        float minPitchHz{70.0f};
+        float maxPitchHz{450.0f};
+        float pitchClarity{0.45f};
+    };
+
+    enum class Reason {
+        Admitted,
+        TooShort,
+        LowVoicing,
+        NoiseLike,
+        NoPitch
+    };
+    static constexpr size_t REASON_COUNT = 5;
+
+    struct Verdict {
+        Reason reason{Reason::Admitted};
+        float durationMs{0.0f};
+        float voicedRatio{0.0f};
+        float spectralFlatness{0.0f};
+        float pitchedRatio{0.0f};
+
+        bool admitted() const { return reason == Reason::Admitted; }
+    };
+
+    explicit SegmentAdmission(int sampleRate);
+
+    Verdict evaluate(const float* samples, size_t numSamples, const Config& config) const;
+
+    static const char* reasonName(Reason reason);
+    // Reads the flow.json "admission" keys, keeping defaults for anything missing.
+    // Mistyped or out-of-range values fall back to the default with a warning.
+    static Config configFromJson(const nlohmann::json& json, Config defaults);
+    // False, with the first problem in error, if configFromJson would have to fall back
+    static bool validateJson(const nlohmann::json& json, std::string* error = nullptr);
+
+private:
+    static constexpr int ANALYSIS_RATE = 16000;
+    static constexpr int FRAME_MS = 32;
+
+    int sampleRate_;
+    size_t decimation_{1};
+    size_t frameLength_{0};
+    Fft fft_;
+    std::vector<float> window_;
+
+    float pitchClarity(const float* frame, const Config& config) const;
+    static Config parseConfig(const nlohmann::json& json, Config defaults, std::vector<std::string>& problems);
+};
+
+}
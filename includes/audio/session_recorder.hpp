@@ -0,0 +1,150 @@
+#pragma once
+
+#include "audio/spsc_queue.hpp"
+#include "audio/mpsc_queue.hpp"
+#include "audio/resampler.hpp"
+#include "ritual/flow_manager.hpp"
+#include "metrics/metrics.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace sadhana {
+
+// Records a live session for the evaluation corpus: the captured audio as a
+// 16-bit mono WAV (optionally resampled to 16 kHz) and a JSON-lines track of
+// what the flow detected, each event stamped with its sample position in the
+// WAV. The capture callback only copies into a fixed ring and never waits;
+// a writer thread converts, fills a large page-aligned buffer and writes it
+// with O_DIRECT where the filesystem allows (plain writes otherwise). If the
+// disk stalls long enough for the ring to fill, blocks are dropped and
+// counted, and the gap is written as silence so event positions stay true.
+//
+// Files in the recording directory, per session:
+//   <stem>.wav            header is finalized on close()
+//   <stem>.events.jsonl   {"t":seconds,"sample":n,"event":...} per line
+class SessionRecorder {
+public:
+    struct Config {
+        std::string directory;
+        std::string stem;                // default: session-<local time>
+        int inputRate{16000};
+        int outputRate{16000};           // 0 keeps the capture rate
+        size_t queueBlocks{512};         // ring between capture and writer
+        size_t writeBufferBytes{1 << 20};
+        bool directIo{true};
+        size_t queueEvents{256};
+    };
+
+    struct Stats {
+        uint64_t blocks{0};
+        uint64_t droppedBlocks{0};
+        uint64_t droppedSamples{0};
+        uint64_t bytesWritten{0};
+        uint64_t events{0};
+        uint64_t droppedEvents{0};
+        double recordedSeconds{0.0};
+        double maxWriteMs{0.0};
+        bool directIo{false};  // whether O_DIRECT ended up in use
+    };
+
+    explicit SessionRecorder(const Config& config);
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    bool open();
+    // Writes what is queued, finalizes the WAV header and stops the writer
+    void close();
+
+    // Capture thread only; copies and returns, never blocks
+    void pushAudio(const float* samples, size_t count);
+
+    // Flow thread only: offerings, section changes and manual waits, derived
+    // from consecutive snapshots
+    void recordProgress(const FlowProgress& progress);
+    // Any thread
+    void recordRecognized(const std::string& text, float confidence);
+    void recordManualAdvance();
+
+    const std::string& audioPath() const { return audioPath_; }
+    const std::string& eventsPath() const { return eventsPath_; }
+    Stats stats() const;
+
+private:
+    static constexpr size_t BLOCK_FRAMES = 1024;
+    static constexpr size_t WAV_HEADER_BYTES = 44;
+    static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+    struct Block {
+        std::array<float, BLOCK_FRAMES> samples;
+        uint32_t count{0};
+        uint64_t start{0};  // capture sample index of samples[0]
+    };
+
+    struct Event {
+        uint64_t sample{0};  // capture sample index
+        std::string body;    // JSON object; the writer prepends the position fields
+    };
+
+    Config config_;
+    std::string audioPath_;
+    std::string eventsPath_;
+    int audioFd_{-1};
+    int eventsFd_{-1};
+    std::atomic<bool> directIo_{false};  // bulk writes bypass the page cache
+    bool fdDirect_{false};               // O_DIRECT currently set on audioFd_
+    bool writeFailed_{false};  // writer thread; stops audio output after a disk error
+
+    SpscQueue<Block> blocks_;
+    MpscQueue<Event> events_;
+    StageSignal signal_;
+    std::atomic<bool> running_{false};
+    std::thread writer_;
+
+    // Capture thread
+    uint64_t captured_{0};
+    std::atomic<uint64_t> capturedPublished_{0};  // read by event producers
+
+    // Flow thread
+    FlowProgress lastProgress_;
+    bool haveProgress_{false};
+
+    // Writer thread
+    unsigned char* buffer_{nullptr};
+    size_t bufferSize_{0};
+    size_t bufferFill_{0};
+    uint64_t fileOffset_{0};
+    uint64_t nextSample_{0};     // next capture sample the writer expects
+    uint64_t outputSamples_{0};
+    Resampler resampler_{1, 1};  // set up by open()
+    std::string eventLine_;
+
+    std::atomic<uint64_t> blockCount_{0};
+    std::atomic<uint64_t> droppedBlocks_{0};
+    std::atomic<uint64_t> droppedSamples_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::atomic<uint64_t> eventCount_{0};
+    std::atomic<uint64_t> droppedEvents_{0};
+    std::atomic<uint64_t> writtenSamples_{0};
+    std::atomic<double> maxWriteMs_{0.0};
+
+    Counter& droppedMetric_;
+    Histogram& writeSecondsMetric_;
+
+    int outputRate() const;
+    void pushEvent(const std::string& body);
+    void runWriter();
+    void writeSilenceUntil(uint64_t sample);
+    void writeSamples(const float* samples, size_t count);
+    void appendSample(float sample);
+    bool flushBuffer(bool final);
+    bool writeAudio(const void* data, size_t size);
+    void writeEvent(const Event& event);
+    bool finalizeHeader();
+};
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace sadhana {
+
+// Bounded single-producer/single-consumer ring used between pipeline stages.
+// Capacity is rounded up to a power of two; push/pop never block or lock.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : buffer_(roundUpPow2(capacity)), mask_(buffer_.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(T item) {
+        return tryPushWith([&item](T& slot) { slot = std::move(item); });
+    }
+
+    // Fill the slot in place, so fixed-size payloads are never copied twice
+    template <typename Fill>
+    bool tryPushWith(Fill&& fill) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= buffer_.size()) {
+            return false;
+        }
+        fill(buffer_[tail & mask_]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = std::move(buffer_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return buffer_.size(); }
+    bool empty() const { return size() == 0; }
+
+private:
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    std::vector<T> buffer_;
+    const size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// Wakes a consumer stage after its input queue was written. Consumers read
+// current() before checking their queue, then wait(seen), so no push is missed.
+class StageSignal {
+public:
+    uint32_t current() const { return seq_.load(std::memory_order_acquire); }
+
+    void wait(uint32_t seen) const { seq_.wait(seen, std::memory_order_acquire); }
+
+    void notify() {
+        seq_.fetch_add(1, std::memory_order_release);
+        seq_.notify_one();
+    }
+
+private:
+    std::atomic<uint32_t> seq_{0};
+};
+
+}
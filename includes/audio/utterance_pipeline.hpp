@@ -0,0 +1,265 @@
+#pragma once
+
+#include "audio/clock.hpp"
+#include "audio/vad.hpp"
+#include "audio/segment_admission.hpp"
+#include "asr/vosk_asr.hpp"
+#include "asr/keyword_spotter.hpp"
+#include "phrase/phrase_manager.hpp"
+#include "metrics/metrics.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sadhana {
+
+class FlowManager;
+struct FlowProgress;
+struct RitualAssets;
+
+// Everything that happens to an utterance between the microphone and the
+// flow, whoever schedules the work: calibration, VAD, pause handling and
+// admission; keyword spotting; decoding with escalation to larger models;
+// phrase matching and the stage counters. The live processor spreads these
+// calls over its stage threads and ASR executor, while the session host and
+// the offline evaluator run them inline through recognize(), so all three
+// make the same decisions and report the same numbers.
+//
+// processBlock() belongs to one thread, the dispatch calls (spotKeyword,
+// retainForEscalation) to another, and resolve() is called in sequence
+// order, never concurrently with itself. The setters work from any thread.
+class UtterancePipeline {
+public:
+    struct Config {
+        int sampleRate{16000};
+        VAD::Config vadConfig;
+        bool enableKeywordSpotter{true};
+        KeywordSpotter::Config kwsConfig;
+        float kwsMinConfidence{0.55f};
+        size_t retainedUtterances{32};  // kept for re-decoding on a larger model
+        bool suspendVadBuffering{false};  // while suspended, keep only the pre-roll ring
+        int prerollMs{1500};
+        SegmentAdmission::Config admission;  // fallback for keys flow.json leaves out
+    };
+
+    // The segmentation the app ships with; the evaluator and hosted sessions
+    // start from it so they cut utterances where a live practitioner's are cut
+    static Config shippedConfig();
+
+    struct Utterance {
+        std::vector<float> samples;
+        uint64_t sequence{0};
+        int mergedCount{1};
+        TimePoint endTime;
+        uint64_t traceId{0};
+        int64_t startNs{0};  // speech onset, trace clock
+        int64_t endNs{0};
+    };
+
+    struct Transcript {
+        std::string text;
+        uint64_t sequence{0};
+        size_t tier{0};
+        TimePoint endTime;
+        uint64_t traceId{0};
+        int64_t startNs{0};
+        float decodeMs{0.0f};
+        // Matched when decoded, to decide on escalation; the flow reuses the
+        // result unless a reload has since given it another matcher
+        PhraseManager::MatchResult match;
+        std::shared_ptr<const RitualAssets> assets;
+    };
+
+    enum class Verdict {
+        Deliver,   // the transcript is final
+        Empty,     // nothing was heard; there is nothing to deliver
+        Escalate   // decode the returned audio on tier + 1 and resolve that result
+    };
+
+    struct StageStats {
+        size_t queueDepth{0};
+        size_t queueCapacity{0};
+        uint64_t processed{0};
+        double avgServiceMs{0.0};
+        double maxServiceMs{0.0};
+    };
+
+    struct Stats {
+        StageStats vad;
+        StageStats asr;
+        StageStats match;
+        StageStats kws;
+        std::vector<StageStats> asrTiers;  // decode latency per model tier
+        uint64_t utterances{0};  // admitted segments that got a first result
+        uint64_t rejected{0};    // segments the admission stage kept from the recognizer
+        size_t kwsTemplates{0};
+        uint64_t kwsHits{0};
+        uint64_t kwsFallbacks{0};
+        uint64_t escalations{0};
+        double escalationRate{0.0};
+        uint64_t escalationsKept{0};  // the larger model did no better; the first result stood
+        uint64_t decodesSkipped{0};
+        double suspendedSeconds{0.0};
+        std::map<std::string, uint64_t> admission;  // segments by verdict
+    };
+
+    using CalibrationCallback = std::function<void()>;
+
+    UtterancePipeline(const VoskASR& asr, const Clock& clock,
+                      std::shared_ptr<const RitualAssets> assets, const Config& config);
+
+    UtterancePipeline(const UtterancePipeline&) = delete;
+    UtterancePipeline& operator=(const UtterancePipeline&) = delete;
+
+    // Segmentation, on the thread that owns the audio. The caller advances
+    // the clock first; an utterance comes back once it has ended and passed
+    // admission.
+    std::optional<Utterance> processBlock(const float* samples, size_t numSamples);
+    void setCalibrationCallback(CalibrationCallback callback) { calibrationCallback_ = std::move(callback); }
+    bool isCalibrating() const { return calibrating_.load(std::memory_order_relaxed); }
+    bool isSpeechActive() const { return speechActive_.load(std::memory_order_relaxed); }
+    float currentLevelDb() const { return currentLevelDb_.load(std::memory_order_relaxed); }
+
+    // Dispatch. True (and counted) when recognition is suspended and the
+    // utterance should not be decoded at all.
+    bool discardIfSuspended();
+    // A confident spot of the iteration marker stands in for the full decode;
+    // returns it as a Vosk result
+    std::optional<std::string> spotKeyword(uint64_t sequence, const Utterance& utterance);
+    // Keeps the audio while a larger model might still be asked for it
+    void retainForEscalation(uint64_t sequence, const Utterance& utterance);
+    void recordDecode(size_t tier, std::chrono::steady_clock::duration decodeTime, double audioSeconds);
+    static std::string parseText(const std::string& json);
+
+    // Matches a result and decides what becomes of it. On Escalate the
+    // transcript is held and rerun receives the audio to decode next; the
+    // larger model's result is then resolved against it and falls back to it
+    // when empty or matched worse.
+    Verdict resolve(Transcript& transcript, Utterance* rerun);
+    // The rerun could not be scheduled: the held transcript stands
+    Transcript abandonEscalation(uint64_t sequence);
+
+    // Consumer side, once per delivered transcript: enrolls confirmed
+    // iteration markers with the spotter and feeds the confidence histogram
+    void accept(const Transcript& transcript);
+    void recordMatch(std::chrono::steady_clock::duration elapsed);
+
+    // The inline path: decode (or spot), escalate and accept on the calling
+    // thread. Empty when suspended or nothing was heard.
+    std::optional<Transcript> recognize(Utterance utterance);
+    // One recognizer per tier for recognize(); the live path never needs them
+    bool createRecognizers(std::string* error = nullptr);
+
+    // Only worth spotting while the flow expects the section's iteration marker
+    void setKeywordSpottingEnabled(bool enabled) { spottingEnabled_ = enabled; }
+    // Match confidence below this sends the utterance to the next model tier
+    void setEscalationThreshold(float threshold) { escalationThreshold_ = threshold; }
+    // While the flow would discard results, finished utterances are not decoded
+    void setRecognitionSuspended(bool suspended) { recognitionSuspended_ = suspended; }
+    // Thresholds that decide which VAD segments are worth decoding
+    void setAdmissionConfig(const SegmentAdmission::Config& config);
+    // All four of the above, as the flow's current section wants them
+    void followFlow(const FlowManager& flow, const FlowProgress& progress);
+    // The next result is matched with this definition and matcher; keyword
+    // templates are dropped if an iteration marker changed
+    void reload(std::shared_ptr<const RitualAssets> assets);
+
+    Stats stats() const;
+
+private:
+    struct StageCounters {
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0};
+
+        void record(std::chrono::steady_clock::duration elapsed);
+        StageStats snapshot() const;
+    };
+
+    const VoskASR& asr_;
+    const Clock& clock_;
+    Config config_;
+    std::atomic<std::shared_ptr<const RitualAssets>> assets_;
+
+    // Segmentation state, processBlock() only
+    VAD vad_;
+    SegmentAdmission admission_;
+    long calibrationSamplesRemaining_{0};
+    std::vector<float> speechBuffer_;
+    bool vadSawSuspended_{false};
+    std::vector<float> prerollRing_;
+    size_t prerollWrite_{0};
+    size_t prerollFilled_{0};
+    TimePoint suspendedSince_;
+    uint64_t nextSequence_{0};
+    uint64_t speechTraceId_{0};
+    int64_t speechStartNs_{0};
+    std::atomic<bool> calibrating_{true};
+    std::atomic<bool> speechActive_{false};
+    std::atomic<float> currentLevelDb_{-60.0f};
+    CalibrationCallback calibrationCallback_;
+
+    std::atomic<bool> recognitionSuspended_{false};
+    std::atomic<bool> spottingEnabled_{false};
+    std::atomic<float> escalationThreshold_{0.0f};
+    std::mutex admissionMutex_;
+    SegmentAdmission::Config admissionConfig_;
+
+    struct PendingEnrollment {
+        KeywordSpotter::Features features;
+        std::string key;        // the part it was heard in
+        std::string sectionId;
+    };
+
+    std::unique_ptr<KeywordSpotter> spotter_;
+    std::mutex enrollmentMutex_;  // also guards spotKey_ and spotSection_
+    std::string spotKey_;
+    std::string spotSection_;
+    std::map<uint64_t, PendingEnrollment> pendingEnrollment_;
+    std::mutex retainedMutex_;
+    std::map<uint64_t, Utterance> retainedUtterances_;
+    // Best result so far of each utterance out on a larger model; resolve() only
+    std::map<uint64_t, Transcript> escalated_;
+    std::vector<VoskASR::RecognizerPtr> recognizers_;  // recognize() only
+
+    StageCounters vadCounters_;
+    StageCounters asrCounters_;
+    StageCounters matchCounters_;
+    StageCounters kwsCounters_;
+    std::unique_ptr<StageCounters[]> tierCounters_;
+    std::atomic<uint64_t> utterances_{0};
+    std::atomic<uint64_t> kwsHits_{0};
+    std::atomic<uint64_t> kwsFallbacks_{0};
+    std::atomic<uint64_t> escalations_{0};
+    std::atomic<uint64_t> escalationsKept_{0};
+    std::atomic<uint64_t> decodesSkipped_{0};
+    std::atomic<uint64_t> suspendedNs_{0};
+    std::array<std::atomic<uint64_t>, SegmentAdmission::REASON_COUNT> admissionCounts_{};
+
+    // Exported through MetricsRegistry; the counters above feed stats()
+    Counter& vadTriggersMetric_;
+    Counter& asrResultsMetric_;
+    Counter& asrEmptyResultsMetric_;
+    Histogram& asrRtfMetric_;
+    Histogram& matchConfidenceMetric_;
+    std::vector<Histogram*> decodeSecondsMetrics_;  // per tier
+    std::array<Counter*, SegmentAdmission::REASON_COUNT> admissionMetrics_{};
+
+    bool admit(const Utterance& utterance);
+    void updateSuspension();
+    void writePreroll(const float* samples, size_t numSamples);
+    std::vector<float> drainPreroll();
+    void enrollKeyword(uint64_t sequence, const std::string& sectionId, const std::string& text);
+    void retainUtterance(uint64_t sequence, const Utterance& utterance);
+    Utterance releaseUtterance(uint64_t sequence);
+    Transcript decode(const Utterance& utterance, uint64_t sequence, size_t tier);
+};
+
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "audio/clock.hpp"
 #include <chrono>
 #include <functional>
 
@@ -17,7 +18,7 @@ public:
         int maxRecordingMs{10000};   // Add this
     };
 
-    explicit VAD(const Config& config);
+    explicit VAD(const Config& config, const Clock& clock = SteadyClock::instance());
 
     void calibrate(const float* samples, size_t numSamples);
     bool process(const float* samples, size_t numSamples);
@@ -32,8 +33,9 @@ private:
     Config config_;
     float noiseFloor_{0.0f};
     bool speechActive_{false};
-    std::chrono::steady_clock::time_point lastSpeechTime_;
-    static inline std::chrono::steady_clock::time_point lastTriggerTime_;
+    const Clock* clock_;
+    TimePoint lastSpeechTime_;
+    TimePoint lastTriggerTime_;
     std::function<void(bool)> stateChangeCallback_;
 };
 
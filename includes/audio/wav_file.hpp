@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sadhana {
+
+struct WavData {
+    std::vector<float> samples;  // mono, [-1, 1]
+    int sampleRate{0};
+};
+
+// Reads 16-bit PCM or 32-bit float WAV files, downmixing to mono
+bool readWavFile(const std::string& path, WavData& out, std::string* error = nullptr);
+
+// Whole-buffer rate conversion through Resampler, low-passed below the
+// lower Nyquist frequency; the length scales with the rate, rounded down
+std::vector<float> resample(const std::vector<float>& samples, int fromRate, int toRate);
+
+}
@@ -4,12 +4,16 @@
 #include <vector>
 #include <optional>
 #include <map>
+#include <memory>
+#include <functional>
+#include <string_view>
 #include <nlohmann/json.hpp>
 
 namespace sadhana {
 
 struct Section;
 struct Material;
+class DefinitionReader;
 
 using JsonValue = nlohmann::json;
 
@@ -73,13 +77,53 @@ struct Material {
     JsonValue additional_data;
 };
 
+// Entry of a common mantras file; given either as an object or as a plain
+// list of lines
+struct Mantra {
+    std::string id;
+    std::optional<std::string> text;
+    std::string type;
+    std::vector<std::string> beejas;
+    std::vector<std::vector<std::string>> pairs;
+    std::vector<std::string> sequence;        // the list form
+    std::vector<std::string> full_variants;   // observed misrecognitions of text
+    JsonValue additional_data;
+};
+
 class RitualDefinition {
 public:
     using MetadataMap = std::map<std::string, JsonValue>;
-    using MantraMap = std::map<std::string, JsonValue>;
+    using MantraMap = std::map<std::string, Mantra>;
+    using MaterialList = std::vector<Material>;
+    using ProcedureMap = std::map<std::string, Step>;
+
+    // Turns a materials_ref / mantras_ref / procedures_ref into its parsed
+    // file under rituals/common. Parsed files are immutable, so one copy can
+    // back every definition that names it. A missing materials file is
+    // tolerated (null with no error); a missing mantras or procedures file,
+    // or any unparsable one, fails the load.
+    struct CommonResolver {
+        std::function<std::shared_ptr<const MaterialList>(const std::string& ref, std::string* error)> materials;
+        std::function<std::shared_ptr<const MantraMap>(const std::string& ref, std::string* error)> mantras;
+        std::function<std::shared_ptr<const ProcedureMap>(const std::string& ref, std::string* error)> procedures;
+    };
+
+    // Names of the common files a definition uses
+    struct CommonRefs {
+        std::optional<std::string> materials;
+        std::optional<std::string> mantras;
+        std::optional<std::string> procedures;
+    };
 
+    // Resolves the common files three directories up, rituals/definitions/<group>/<file>
     bool loadFromFile(const std::string& filepath);
-    bool loadFromJson(const JsonValue& json);
+    // Reads the definition straight from its JSON text (DefinitionReader), then
+    // attaches the common files it references
+    bool loadFromText(std::string_view text, const CommonResolver& resolver, std::string* error = nullptr);
+    // The rituals/common directory for a definition at the usual depth
+    static std::string commonDirectoryFor(const std::string& filepath);
+    // Resolver that reads and parses each file on every call, no sharing
+    static CommonResolver directoryResolver(const std::string& commonDirectory);
 
     const std::string& getId() const { return id_; }
     const std::string& getTitle() const { return title_; }
@@ -87,8 +131,10 @@ public:
     const std::string& getSource() const { return source_; }
 
     const MetadataMap& getMetadata() const { return metadata_; }
-    const std::vector<Material>& getMaterials() const { return materials_; }
-    const MantraMap& getMantras() const { return mantras_; }
+    const std::vector<Material>& getMaterials() const { return *materials_; }
+    const MantraMap& getMantras() const { return *mantras_; }
+    const ProcedureMap& getProcedures() const { return *procedures_; }
+    const Step* findProcedure(const std::string& id) const;
     const std::vector<Section>& getSections() const { return sections_; }
 
     std::optional<const Section*> findSection(const std::string& id) const;
@@ -108,19 +154,20 @@ public:
     CurrentState getCurrentState(const std::string& sectionId, const std::string& partId) const;
 
 private:
+    friend class DefinitionReader;
+
     std::string id_;
     std::string title_;
     std::string version_;
     std::string source_;
     MetadataMap metadata_;
-    std::vector<Material> materials_;
-    MantraMap mantras_;
+    // Shared with every other definition that references the same common files
+    std::shared_ptr<const MaterialList> materials_{std::make_shared<const MaterialList>()};
+    std::shared_ptr<const MantraMap> mantras_{std::make_shared<const MantraMap>()};
+    std::shared_ptr<const ProcedureMap> procedures_{std::make_shared<const ProcedureMap>()};
     std::vector<Section> sections_;
 
-    void parseFromJson(const JsonValue& json);
-    void loadMaterialsFromJson(const JsonValue& json);
-    void loadProceduresFromJson(const JsonValue& json);
-    void loadMantrasFromJson(const JsonValue& json);
+    bool attachCommon(const CommonRefs& refs, const CommonResolver& resolver, std::string* error);
 };
 
 } // namespace sadhana
\ No newline at end of file
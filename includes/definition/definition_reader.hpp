@@ -0,0 +1,33 @@
+#pragma once
+
+#include "definition/definition.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace sadhana {
+
+// Reads ritual files straight from the JSON token stream into the typed
+// structs, without building a document first. Keys are dispatched through a
+// perfect hash per struct, computed at compile time; anything a struct does
+// not model is kept in its additional_data (or additional_params), built
+// only for those values. Section description/introduction and part
+// description/mantra_ref are kept there too, as the document loader always
+// did. Produces the same definitions as that loader, which
+// tools/sadhana_load_bench keeps as its baseline and checks against.
+class DefinitionReader {
+public:
+    // Sections, metadata and the names of the common files; those are left
+    // for the caller to resolve
+    static bool readDefinition(std::string_view text, RitualDefinition& definition,
+                               RitualDefinition::CommonRefs& refs, std::string* error = nullptr);
+
+    static std::shared_ptr<const RitualDefinition::MaterialList> readMaterials(std::string_view text,
+                                                                               std::string* error = nullptr);
+    static std::shared_ptr<const RitualDefinition::MantraMap> readMantras(std::string_view text,
+                                                                          std::string* error = nullptr);
+    static std::shared_ptr<const RitualDefinition::ProcedureMap> readProcedures(std::string_view text,
+                                                                                std::string* error = nullptr);
+};
+
+}
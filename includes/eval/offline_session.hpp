@@ -0,0 +1,59 @@
+#pragma once
+
+#include "audio/utterance_pipeline.hpp"
+#include "asr/vosk_asr.hpp"
+#include "definition/definition.hpp"
+#include "ritual/flow_manager.hpp"
+#include <string>
+#include <vector>
+
+namespace sadhana {
+
+class UtteranceLogWriter;
+
+// Runs one recording through the live utterance pipeline (VAD, admission,
+// keyword spotting, Vosk with escalation, matching) and the flow on the
+// calling thread, timed by the recording's own sample clock. The models are
+// shared; each session decodes with its own recognizers.
+class OfflineSession {
+public:
+    struct Config {
+        // Shipped segmentation; sampleRate is taken from the recognizer
+        UtterancePipeline::Config pipeline{UtterancePipeline::shippedConfig()};
+        std::string flowConfigPath;
+        size_t blockFrames{1440};
+        bool autoAdvance{true};  // press "space" whenever the flow waits for it
+        UtteranceLogWriter* analytics{nullptr};  // optional; rows go under its current session
+    };
+
+    // One repetition the flow counted from recognized speech
+    struct CountEvent {
+        double audioSeconds{0.0};  // end of the utterance in the recording
+        double processingMs{0.0};  // decode and match time for that utterance
+        std::string text;
+    };
+
+    struct Result {
+        bool ok{false};
+        std::string error;
+        double audioSeconds{0.0};
+        double processingSeconds{0.0};
+        size_t utterances{0};
+        size_t rejected{0};  // segments the admission stage kept from the recognizer
+        UtterancePipeline::Stats pipeline;
+        std::vector<CountEvent> counts;
+        FlowProgress finalProgress;
+    };
+
+    OfflineSession(const RitualDefinition& ritual, const VoskASR& asr, const Config& config);
+
+    // samples must already be at the recognizer's sample rate
+    Result run(const std::vector<float>& samples);
+
+private:
+    const RitualDefinition& ritual_;
+    const VoskASR& asr_;
+    Config config_;
+};
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace sadhana {
+
+// Single-threaded epoll loop for the interactive side of the app. File
+// descriptors and timers (timerfd) are dispatched on the thread that calls
+// run(); other threads hand work over with post(), which wakes the loop
+// through an eventfd. Nothing here polls, so an idle session sleeps in
+// epoll_wait until a key, a timer or a pipeline result arrives.
+class EventLoop {
+public:
+    using FdHandler = std::function<void(uint32_t events)>;
+    using Task = std::function<void()>;
+    using TimerId = int;
+
+    EventLoop() = default;
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool init();
+
+    // Level-triggered; the handler should drain the descriptor
+    bool watchReadable(int fd, FdHandler handler);
+    // Adds or drops EPOLLOUT on a watched descriptor, for sockets with queued output
+    bool setWritable(int fd, bool writable);
+    void unwatch(int fd);
+
+    // A zero interval makes a one-shot timer. Returns -1 on failure.
+    TimerId addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval, Task callback);
+    void cancelTimer(TimerId id);
+
+    // Thread-safe; the task runs on the loop thread
+    void post(Task task);
+
+    // Runs until stop(); returns false if the loop was never initialized
+    bool run();
+    // Thread-safe and async-signal-safe
+    void stop();
+
+private:
+    struct Watch {
+        FdHandler handler;
+        bool writable{false};
+    };
+
+    int epollFd_{-1};
+    int wakeFd_{-1};
+    std::atomic<bool> stopRequested_{false};
+    std::unordered_map<int, std::shared_ptr<Watch>> watches_;
+
+    std::mutex postMutex_;
+    std::vector<Task> posted_;
+    std::vector<Task> runQueue_;  // loop thread only; keeps its capacity between wakes
+
+    void signalWake();
+    void drainWake();
+    bool addWatch(int fd, std::shared_ptr<Watch> watch);
+};
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "definition/definition.hpp"
+#include "phrase/phrase_manager.hpp"
+#include <memory>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace sadhana {
+
+// What every session of one ritual can share read-only: the parsed
+// definition, the phrase matcher compiled from it and the flow settings.
+// Sessions hold the whole bundle, which keeps the matcher's reference to the
+// definition valid for as long as any of them runs.
+struct RitualAssets {
+    std::shared_ptr<const RitualDefinition> ritual;
+    std::shared_ptr<const PhraseManager> matcher;
+    nlohmann::json flowConfig;
+
+    // Common files are read from the rituals/common next to the definition
+    static std::shared_ptr<const RitualAssets> load(const std::string& ritualPath,
+                                                    const std::string& flowPath,
+                                                    std::string* error = nullptr);
+    static std::shared_ptr<const RitualAssets> load(const std::string& ritualPath,
+                                                    const std::string& flowPath,
+                                                    const RitualDefinition::CommonResolver& resolver,
+                                                    std::string* error = nullptr);
+};
+
+}
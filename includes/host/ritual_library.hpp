@@ -0,0 +1,122 @@
+#pragma once
+
+#include "host/ritual_assets.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace sadhana {
+
+// Every ritual under <root>/definitions, found by a cheap scan at startup and
+// loaded in full only when asked for. The scan reads the top-level id, title
+// and version of each definition and stops there; loads run on a small pool
+// of workers, so several rituals can be prepared at once, and a ritual being
+// loaded is never loaded twice.
+//
+// Files under <root>/common (materials, mantras, procedures) are parsed once
+// and shared by every definition that references them. The library only
+// keeps weak references to them: a common file stays in memory while some
+// loaded ritual uses it and is parsed again if it is needed after that.
+//
+// A definition's flow settings come from <stem>.flow.json next to it, or
+// from flow.json in the same directory.
+class RitualLibrary {
+public:
+    // What the app and sadhana_server run when no --ritual-id is given
+    static constexpr const char* DEFAULT_RITUAL = "maha_ganapati_caturvrtti_tarpanam";
+
+    struct Config {
+        std::string root{"rituals"};
+        size_t workers{0};  // 0: one per hardware thread, at most 4
+    };
+
+    struct Entry {
+        std::string id;
+        std::string title;
+        std::string version;
+        std::string definitionPath;
+        std::string flowPath;
+    };
+
+    struct LoadResult {
+        std::shared_ptr<const RitualAssets> assets;
+        std::string error;
+    };
+
+    struct Stats {
+        size_t rituals{0};          // in the catalog
+        size_t loaded{0};           // held by the library
+        size_t commonLive{0};       // common files currently in memory
+        uint64_t commonParsed{0};
+        uint64_t commonShared{0};   // references served from memory
+    };
+
+    RitualLibrary();
+    explicit RitualLibrary(const Config& config);
+    ~RitualLibrary();
+
+    RitualLibrary(const RitualLibrary&) = delete;
+    RitualLibrary& operator=(const RitualLibrary&) = delete;
+
+    // Rebuilds the catalog; loaded rituals are kept. False when the
+    // definitions directory cannot be read; unreadable files are skipped.
+    bool scan(std::string* error = nullptr);
+
+    std::vector<Entry> catalog() const;
+    std::optional<Entry> find(const std::string& id) const;
+
+    // Starts loading the ritual unless it is loaded or on its way
+    std::shared_future<LoadResult> loadAsync(const std::string& id);
+    // Waits for the load; null with the error when it failed
+    std::shared_ptr<const RitualAssets> load(const std::string& id, std::string* error = nullptr);
+    // Drops the library's reference; sessions still running keep theirs
+    void release(const std::string& id);
+
+    Stats stats() const;
+    const Config& getConfig() const { return config_; }
+
+private:
+    // One common file; whoever finds it empty parses it while others wait
+    struct CommonSlot {
+        std::mutex mutex;
+        std::weak_ptr<const void> value;
+    };
+
+    Config config_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry> catalog_;
+    std::map<std::string, std::shared_future<LoadResult>> loads_;
+    std::map<std::string, std::shared_ptr<CommonSlot>> common_;
+
+    std::mutex jobsMutex_;
+    std::condition_variable jobsCv_;
+    std::deque<std::function<void(bool cancelled)>> jobs_;  // cancelled: run at shutdown, not loaded
+    bool running_{true};
+    std::vector<std::thread> workers_;
+
+    std::atomic<uint64_t> commonParsed_{0};
+    std::atomic<uint64_t> commonShared_{0};
+
+    void runWorker();
+    LoadResult loadEntry(const Entry& entry);
+    RitualDefinition::CommonResolver resolver();
+    // Returns the shared copy of <root>/common/<kind>/<ref>.json, parsing it if needed
+    template <typename T>
+    std::shared_ptr<const T> common(const std::string& kind, const std::string& ref,
+                                    std::shared_ptr<const T> (*read)(std::string_view, std::string*),
+                                    bool optional, std::string* error);
+};
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "host/ritual_assets.hpp"
+#include "metrics/metrics.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sadhana {
+
+// Watches a ritual's definition, its flow settings and the files under
+// rituals/common with inotify, so variant lists can be edited while a session
+// runs. After a change (and a short quiet period, since editors save in
+// several steps) the whole bundle is parsed and its matcher compiled on the
+// watcher's thread; only a complete bundle is handed on. A file that fails to
+// parse is reported and the running version stays in use.
+class RitualWatcher {
+public:
+    struct Config {
+        std::string ritualPath;
+        std::string flowPath;
+        int debounceMs{250};
+    };
+
+    struct Stats {
+        uint64_t reloads{0};
+        uint64_t failures{0};
+        double lastReloadMs{0.0};
+        std::string version;  // of the last bundle handed on
+    };
+
+    // Called on the watcher's thread with each newly compiled bundle and the
+    // time it took; returns whether the bundle was taken into use
+    using ReloadCallback = std::function<bool(std::shared_ptr<const RitualAssets> assets, double reloadMs)>;
+
+    explicit RitualWatcher(const Config& config);
+    ~RitualWatcher();
+
+    RitualWatcher(const RitualWatcher&) = delete;
+    RitualWatcher& operator=(const RitualWatcher&) = delete;
+
+    void setReloadCallback(ReloadCallback callback) { reloadCallback_ = std::move(callback); }
+
+    bool start();
+    void stop();
+
+    Stats stats() const;
+
+private:
+    Config config_;
+    ReloadCallback reloadCallback_;
+    int inotifyFd_{-1};
+    int wakeFd_{-1};
+    int ritualDirWatch_{-1};
+    int flowDirWatch_{-1};
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    std::atomic<uint64_t> reloads_{0};
+    std::atomic<uint64_t> failures_{0};
+    std::atomic<double> lastReloadMs_{0.0};
+    mutable std::mutex versionMutex_;
+    std::string version_;
+
+    Counter& reloadsMetric_;
+    Counter& failuresMetric_;
+    Histogram& reloadSecondsMetric_;
+
+    void run();
+    // True when an event in the batch touches a file the bundle is built from
+    bool relevant(const char* buffer, size_t length) const;
+    void reload();
+};
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "audio/clock.hpp"
+#include "audio/spsc_queue.hpp"
+#include "audio/utterance_pipeline.hpp"
+#include "asr/vosk_asr.hpp"
+#include "host/ritual_assets.hpp"
+#include "ritual/flow_manager.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sadhana {
+
+class SessionHost;
+
+// One practitioner inside a SessionHost: their audio ring, utterance pipeline
+// (with its recognizers) and flow, plus the sinks their progress is reported
+// to. Audio comes from a single producer (a capture callback or a network
+// connection); the host's workers run the pipeline inline, never more than
+// one at a time per session, so everything past the ring is single-threaded.
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    static constexpr size_t MAX_BLOCK_FRAMES = 2048;
+
+    struct Config {
+        std::string id;
+        // Shipped segmentation; sampleRate is taken from the host
+        UtterancePipeline::Config pipeline{UtterancePipeline::shippedConfig()};
+        size_t queueBlocks{256};
+        bool autoAdvance{false};  // press "space" whenever the flow waits for it
+    };
+
+    struct Stats {
+        std::string id;
+        double audioSeconds{0.0};
+        double busySeconds{0.0};   // worker time spent on this session
+        double rtf{0.0};           // over the whole session
+        double recentRtf{0.0};     // smoothed over the last ~30 s of audio
+        size_t backlogBlocks{0};
+        uint64_t droppedBlocks{0};
+        uint64_t utterances{0};
+        uint64_t rejected{0};      // segments the admission stage kept from the recognizer
+        UtterancePipeline::Stats pipeline;
+    };
+
+    using TranscriptionCallback = std::function<void(const std::string& text, float confidence)>;
+
+    Session(SessionHost& host, std::shared_ptr<const RitualAssets> assets,
+            const VoskASR& asr, int sampleRate, const Config& config);
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    const std::string& id() const { return config_.id; }
+    int sampleRate() const { return sampleRate_; }
+
+    // Single producer; false when the ring is full and the samples were dropped
+    bool pushAudio(const float* samples, size_t count);
+    // 16-bit PCM, converted straight into the ring
+    bool pushAudio(const int16_t* samples, size_t count);
+    void postManualIntervention();
+
+    FlowManager::ProgressSnapshot progress() const { return flow_.snapshot(); }
+    Stats stats() const;
+    bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+    // Nothing queued and no worker running it
+    bool isIdle() const { return !scheduled_.load(std::memory_order_acquire) && !hasPendingWork(); }
+
+    // Set before audio arrives; both run on a host worker
+    void setProgressCallback(FlowManager::ProgressCallback callback) {
+        flow_.setProgressCallback(std::move(callback));
+    }
+    void setTranscriptionCallback(TranscriptionCallback callback) {
+        transcriptionCallback_ = std::move(callback);
+    }
+
+private:
+    friend class SessionHost;
+
+    struct AudioBlock {
+        std::array<float, MAX_BLOCK_FRAMES> samples;
+        size_t count{0};
+    };
+
+    SessionHost& host_;
+    std::shared_ptr<const RitualAssets> assets_;
+    const int sampleRate_;
+    Config config_;
+
+    // Worker-side pipeline state
+    SampleClock clock_;
+    UtterancePipeline pipeline_;
+    FlowManager flow_;
+    TranscriptionCallback transcriptionCallback_;
+
+    SpscQueue<AudioBlock> queue_;
+    std::atomic<bool> manualPending_{false};
+    std::atomic<bool> scheduled_{false};
+    std::atomic<bool> closed_{false};
+
+    std::atomic<uint64_t> audioFrames_{0};
+    std::atomic<uint64_t> busyNs_{0};
+    std::atomic<double> recentRtf_{0.0};
+    std::atomic<uint64_t> droppedBlocks_{0};
+
+    double recentAudioSeconds_{0.0};  // worker only
+
+    // Loads the flow settings and creates the recognizers; called once by the
+    // host before the session is published
+    bool init(std::string* error);
+    bool hasPendingWork() const {
+        return !queue_.empty() || manualPending_.load(std::memory_order_acquire);
+    }
+    // Runs up to maxBlocks of queued audio; host worker only
+    void runSlice(size_t maxBlocks);
+    template <typename Sample>
+    bool pushSamples(const Sample* samples, size_t count);
+    void processBlock(const AudioBlock& block);
+    void finishUtterance(UtterancePipeline::Utterance utterance);
+    // Presses "space" if the session auto-advances, then points the pipeline
+    // at whatever the flow now expects
+    void settleFlow();
+};
+
+}
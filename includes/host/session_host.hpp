@@ -0,0 +1,104 @@
+#pragma once
+
+#include "host/session.hpp"
+#include "host/ritual_assets.hpp"
+#include "asr/vosk_asr.hpp"
+#include "metrics/metrics.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sadhana {
+
+// Runs many sessions in one process on a fixed pool of workers. The Vosk
+// model, ritual definitions and compiled matchers are loaded once and shared
+// read-only; each session only owns its recognizers and pipeline state. A
+// session with queued audio sits in the ready list at most once and a worker
+// runs it for a bounded slice, so one busy session cannot starve the others.
+//
+// New sessions are admitted only while the measured load leaves headroom:
+// the sum of every session's recent real-time factor, divided by the number
+// of workers, must stay under maxUtilization with the newcomer included.
+class SessionHost {
+public:
+    struct Config {
+        size_t workers{0};                // 0: one per hardware thread
+        size_t maxSessions{16};
+        double maxUtilization{0.75};
+        double newSessionRtf{0.25};       // assumed cost of a session until it has warmed up
+        double warmupSeconds{10.0};       // audio after which a session's own RTF is trusted
+        size_t sliceBlocks{8};            // blocks a worker runs before moving on
+        size_t maxBacklogBlocks{64};      // any session this far behind blocks admission
+    };
+
+    struct Stats {
+        size_t workers{0};
+        size_t sessions{0};
+        double utilization{0.0};
+        uint64_t admitted{0};
+        uint64_t rejected{0};
+        std::vector<Session::Stats> perSession;
+    };
+
+    explicit SessionHost(std::shared_ptr<const VoskASR> asr);
+    SessionHost(std::shared_ptr<const VoskASR> asr, const Config& config);
+    ~SessionHost();
+
+    SessionHost(const SessionHost&) = delete;
+    SessionHost& operator=(const SessionHost&) = delete;
+
+    bool start();
+    // Closes every session and joins the workers
+    void stop();
+
+    // Null when the host is full or the session cannot be set up; error says why
+    std::shared_ptr<Session> openSession(std::shared_ptr<const RitualAssets> assets,
+                                         const Session::Config& config,
+                                         std::string* error = nullptr);
+    void closeSession(const std::string& id);
+
+    bool canAdmit(std::string* reason = nullptr) const;
+    double utilization() const;
+    Stats stats() const;
+
+    const Config& getConfig() const { return config_; }
+    // Rate every session's audio must arrive at: the recognizer's
+    int sampleRate() const { return sampleRate_; }
+
+private:
+    friend class Session;
+
+    std::shared_ptr<const VoskASR> asr_;
+    Config config_;
+    int sampleRate_;
+
+    mutable std::mutex sessionsMutex_;
+    std::map<std::string, std::shared_ptr<Session>> sessions_;
+
+    std::mutex readyMutex_;
+    std::condition_variable readyCv_;
+    std::deque<std::shared_ptr<Session>> ready_;
+    bool running_{false};
+    std::vector<std::thread> workers_;
+
+    std::atomic<uint64_t> admitted_{0};
+    std::atomic<uint64_t> rejected_{0};
+
+    Gauge& sessionsMetric_;
+    Gauge& utilizationMetric_;
+    Counter& rejectedMetric_;
+
+    // Queues the session unless it is already queued or running
+    void schedule(std::shared_ptr<Session> session);
+    void runWorker();
+    double loadLocked() const;
+    bool canAdmitLocked(std::string* reason) const;
+};
+
+}
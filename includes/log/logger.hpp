@@ -0,0 +1,160 @@
+#pragma once
+
+#include "audio/spsc_queue.hpp"
+#include "metrics/metrics.hpp"
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Lowest level compiled in; calls below it vanish entirely
+#ifndef SADHANA_LOG_LEVEL
+#define SADHANA_LOG_LEVEL 1
+#endif
+
+namespace sadhana {
+
+enum class LogLevel { Trace, Debug, Info, Warn, Error, Off };
+
+// Leveled logger for code that must not block on terminal I/O. Each thread
+// formats into a fixed record in its own SPSC ring (no locks, no allocation
+// after the thread's first message); a background writer sleeps until a
+// message is queued, then drains the rings and writes time-ordered lines to
+// stderr or a file. When a ring is full the message is dropped and counted,
+// never waited on.
+class Logger {
+public:
+    static constexpr size_t RING_RECORDS = 512;
+    static constexpr size_t MAX_MESSAGE = 240;
+
+    struct Record {
+        int64_t timeNs{0};  // system clock, for wall-clock timestamps
+        const char* tag{""};
+        LogLevel level{LogLevel::Info};
+        uint32_t thread{0};
+        uint16_t length{0};
+        char text[MAX_MESSAGE];
+    };
+
+    static Logger& instance();
+
+    // Runtime floor on top of SADHANA_LOG_LEVEL
+    void setLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const {
+        return level >= level_.load(std::memory_order_relaxed) &&
+               (!toConsole_.load(std::memory_order_relaxed) ||
+                level >= consoleFloor_.load(std::memory_order_relaxed));
+    }
+    // Extra floor for stderr only, raised while a full-screen display owns the
+    // terminal; a log file set with setOutputFile() still gets everything
+    void setConsoleFloor(LogLevel level) { consoleFloor_.store(level, std::memory_order_relaxed); }
+    bool toConsole() const { return toConsole_.load(std::memory_order_relaxed); }
+
+    // Default is stderr; an empty path goes back to it
+    bool setOutputFile(const std::string& path);
+    // Drains everything queued so far; used at shutdown
+    void flush();
+    // Messages dropped since start, also exported as sadhana_log_dropped_total
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static LogLevel parseLevel(std::string_view name, LogLevel fallback = LogLevel::Info);
+
+    // tag must be a string literal; args are strings, numbers, bools or chars
+    template <typename... Args>
+    void log(LogLevel level, const char* tag, const Args&... args) {
+        if (!enabled(level)) return;
+
+        auto& ring = threadRing();
+        bool pushed = ring.queue.tryPushWith([&](Record& record) {
+            record.timeNs = nowNs();
+            record.tag = tag;
+            record.level = level;
+            record.thread = ring.id;
+            size_t length = 0;
+            (append(record.text, length, args), ...);
+            record.length = static_cast<uint16_t>(length);
+        });
+        if (!pushed) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wakeup_.notify();
+    }
+
+    ~Logger();
+
+private:
+    struct ThreadRing {
+        SpscQueue<Record> queue{RING_RECORDS};
+        uint32_t id{0};
+    };
+
+    Logger();
+
+    ThreadRing& threadRing();
+    static int64_t nowNs();
+
+    static void appendText(char* out, size_t& length, const char* text, size_t size) {
+        size_t n = std::min(size, MAX_MESSAGE - length);
+        std::memcpy(out + length, text, n);
+        length += n;
+    }
+
+    template <typename T>
+    static void append(char* out, size_t& length, const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            appendText(out, length, value ? "true" : "false", value ? 4 : 5);
+        } else if constexpr (std::is_same_v<T, char>) {
+            appendText(out, length, &value, 1);
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            auto result = std::to_chars(out + length, out + MAX_MESSAGE, value);
+            length = result.ec == std::errc() ? static_cast<size_t>(result.ptr - out) : length;
+        } else {
+            std::string_view text(value);
+            appendText(out, length, text.data(), text.size());
+        }
+    }
+
+    std::atomic<LogLevel> level_{LogLevel::Info};
+    std::atomic<LogLevel> consoleFloor_{LogLevel::Trace};
+    std::atomic<bool> toConsole_{true};
+    std::atomic<uint64_t> dropped_{0};  // since start; drain() reports the growth
+    uint64_t reportedDropped_{0};       // writerMutex_
+    Counter& droppedMetric_;
+
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+
+    std::mutex writerMutex_;  // writer thread vs flush()
+    std::FILE* output_{stderr};
+    std::vector<Record> batch_;
+    std::atomic<bool> running_{true};
+    StageSignal wakeup_;
+    std::thread writer_;
+
+    void drain();
+    void run();
+};
+
+}
+
+#define SADHANA_LOG(level, tag, ...)                                                   \
+    do {                                                                               \
+        if constexpr (static_cast<int>(level) >= SADHANA_LOG_LEVEL) {                  \
+            ::sadhana::Logger::instance().log(level, tag, __VA_ARGS__);                \
+        }                                                                              \
+    } while (0)
+
+#define SADHANA_LOG_TRACE(tag, ...) SADHANA_LOG(::sadhana::LogLevel::Trace, tag, __VA_ARGS__)
+#define SADHANA_LOG_DEBUG(tag, ...) SADHANA_LOG(::sadhana::LogLevel::Debug, tag, __VA_ARGS__)
+#define SADHANA_LOG_INFO(tag, ...) SADHANA_LOG(::sadhana::LogLevel::Info, tag, __VA_ARGS__)
+#define SADHANA_LOG_WARN(tag, ...) SADHANA_LOG(::sadhana::LogLevel::Warn, tag, __VA_ARGS__)
+#define SADHANA_LOG_ERROR(tag, ...) SADHANA_LOG(::sadhana::LogLevel::Error, tag, __VA_ARGS__)
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sadhana {
+
+// Always-on aggregates, rendered in the Prometheus text format. Metrics are
+// registered once (under a lock) and then updated from any thread with
+// relaxed atomics only, so hot paths keep a reference and never look up.
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+    void add(double delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+// Log-bucketed histogram: bucket bounds grow by 2^(1/subBuckets) from lowest
+// to highest, so relative error stays constant across the range (about 19%
+// with 4 sub-buckets). Values above highest land in the +Inf bucket.
+class Histogram {
+public:
+    Histogram(double lowest, double highest, int subBuckets = 4);
+
+    void observe(double value);
+
+    const std::vector<double>& bounds() const { return bounds_; }
+    // Per-bucket (not cumulative) counts, the last one being +Inf
+    std::vector<uint64_t> bucketCounts() const;
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    double sum() const { return sum_.load(std::memory_order_relaxed); }
+
+private:
+    double lowest_;
+    double subBuckets_;
+    std::vector<double> bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<double> sum_{0.0};
+};
+
+class MetricsRegistry {
+public:
+    // {"tier", "0"}, ... rendered as name{tier="0"}
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    static MetricsRegistry& instance();
+
+    // Returns the existing metric when name and labels were registered before
+    Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         double lowest, double highest, const Labels& labels = {});
+
+    std::string renderPrometheus() const;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::map<std::string, std::unique_ptr<Counter>> counters;
+        std::map<std::string, std::unique_ptr<Gauge>> gauges;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+
+    Family& family(const std::string& name, const std::string& help, Type type);
+    static std::string formatLabels(const Labels& labels);
+};
+
+}
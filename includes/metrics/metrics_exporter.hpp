@@ -0,0 +1,43 @@
+#pragma once
+
+#include "metrics/metrics.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace sadhana {
+
+// Publishes the registry from a background thread: rewrites a text file
+// atomically (write + rename, suitable for node_exporter's textfile
+// collector) and/or answers on a Unix socket with a minimal HTTP response,
+// e.g. curl --unix-socket /run/sadhana.sock http://localhost/metrics
+class MetricsExporter {
+public:
+    struct Config {
+        std::string filePath;
+        std::string socketPath;
+        int fileIntervalMs{5000};
+    };
+
+    explicit MetricsExporter(const MetricsRegistry& registry = MetricsRegistry::instance())
+        : registry_(registry) {}
+    ~MetricsExporter();
+
+    bool start(const Config& config);
+    void stop();
+
+    bool writeFile() const;
+
+private:
+    const MetricsRegistry& registry_;
+    Config config_;
+    int listenFd_{-1};
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    bool openSocket();
+    void serveClient(int fd) const;
+    void run();
+};
+
+}
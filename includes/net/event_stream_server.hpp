@@ -0,0 +1,98 @@
+#pragma once
+
+#include "event/event_loop.hpp"
+#include "ritual/flow_manager.hpp"
+#include "metrics/metrics.hpp"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace sadhana {
+
+// Broadcasts flow progress and recognition results to browsers on the local
+// network as Server-Sent Events (GET /events; GET / serves a minimal page).
+// One thread runs its own EventLoop for every client. Each event is
+// serialized once and the same immutable frame is queued to every client;
+// a client whose queue is full loses its oldest unsent frames rather than
+// slowing the others, and progress frames carry the full state so the
+// newest one is always enough.
+class EventStreamServer {
+public:
+    struct Config {
+        int port{8077};
+        std::string bindAddress{"0.0.0.0"};
+        size_t maxClients{1024};
+        size_t queueFrames{16};          // per client, before stale frames are dropped
+        int heartbeatMs{15000};          // SSE comment so idle proxies keep the stream open
+    };
+
+    struct Stats {
+        uint64_t clients{0};
+        uint64_t accepted{0};
+        uint64_t events{0};
+        uint64_t framesQueued{0};
+        uint64_t framesDropped{0};
+        uint64_t bytesSent{0};
+    };
+
+    EventStreamServer();
+    explicit EventStreamServer(const Config& config);
+    ~EventStreamServer();
+
+    EventStreamServer(const EventStreamServer&) = delete;
+    EventStreamServer& operator=(const EventStreamServer&) = delete;
+
+    bool start();
+    void stop();
+
+    // Any thread; serialization happens on the caller, fan-out on the server thread
+    void publishProgress(const FlowProgress& progress);
+    void publishRecognized(const std::string& text, float confidence);
+
+    Stats stats() const;
+
+private:
+    using Frame = std::shared_ptr<const std::string>;
+
+    struct Client {
+        int fd{-1};
+        std::string request;      // until the header block is complete
+        bool streaming{false};
+        bool closeAfterFlush{false};
+        std::deque<Frame> queue;
+        size_t offset{0};         // bytes of queue.front() already sent
+    };
+
+    Config config_;
+    EventLoop loop_;
+    std::thread thread_;
+    int listenFd_{-1};
+    std::unordered_map<int, std::unique_ptr<Client>> clients_;  // server thread only
+    Frame latestProgress_;                                      // server thread only
+    std::atomic<uint64_t> nextEventId_{1};
+
+    std::atomic<uint64_t> clientCount_{0};
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> events_{0};
+    std::atomic<uint64_t> framesQueued_{0};
+    std::atomic<uint64_t> framesDropped_{0};
+    std::atomic<uint64_t> bytesSent_{0};
+
+    Gauge& clientsMetric_;
+    Counter& droppedMetric_;
+
+    Frame makeFrame(const char* event, const nlohmann::json& data);
+    void broadcast(const Frame& frame, bool progress);
+    void acceptClients();
+    bool readRequest(Client& client);   // false once the client has been closed
+    void enqueue(Client& client, const Frame& frame);
+    bool flush(Client& client);
+    void closeClient(int fd);
+};
+
+}
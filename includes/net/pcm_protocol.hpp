@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace sadhana {
+
+// Wire format between thin capture clients and PcmServer. Every message is a
+// fixed 20-byte header followed by payloadBytes of payload; fields are
+// little-endian. One connection may carry several streams, told apart by
+// sessionId. Audio frames carry mono samples in the stated format at the
+// stated rate; the sequence number lets the server count frames lost on the
+// client side and drop replays.
+//
+// Client to server: Audio (PCM payload), ManualAdvance (the space key, no
+// payload), End (stream finished, no payload).
+// Server to client: Progress (JSON progress object), Error (UTF-8 text; the
+// stream named by sessionId is closed, sessionId 0 means the connection).
+enum class PcmFrameType : uint8_t {
+    Audio = 1,
+    ManualAdvance = 2,
+    End = 3,
+    Progress = 16,
+    Error = 17
+};
+
+enum class PcmSampleFormat : uint8_t {
+    None = 0,
+    Int16 = 1,
+    Float32 = 2
+};
+
+struct PcmFrameHeader {
+    static constexpr uint16_t MAGIC = 0x5053;  // "SP"
+
+    uint16_t magic{MAGIC};
+    uint8_t type{0};
+    uint8_t format{0};
+    uint32_t sessionId{0};
+    uint32_t sampleRate{0};
+    uint32_t sequence{0};
+    uint32_t payloadBytes{0};
+};
+static_assert(sizeof(PcmFrameHeader) == 20, "PCM frame header layout");
+
+inline size_t pcmSampleBytes(PcmSampleFormat format) {
+    switch (format) {
+        case PcmSampleFormat::Int16: return 2;
+        case PcmSampleFormat::Float32: return 4;
+        default: return 0;
+    }
+}
+
+inline PcmFrameHeader readPcmHeader(const void* data) {
+    PcmFrameHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    return header;
+}
+
+}
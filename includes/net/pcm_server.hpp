@@ -0,0 +1,162 @@
+#pragma once
+
+#include "event/event_loop.hpp"
+#include "host/session_host.hpp"
+#include "metrics/metrics.hpp"
+#include "net/pcm_protocol.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace sadhana {
+
+// Accepts PCM streams from remote practitioners over TCP and/or a Unix
+// socket and feeds each into its own SessionHost session. Everything network
+// side runs on the EventLoop thread: frames are parsed in place in a
+// per-connection receive buffer and converted straight into the session's
+// audio ring, so payload bytes are copied once. Progress published by the
+// session's flow is framed on the worker thread and written back on the same
+// connection by the loop. Opening a session builds its recognizers, so that
+// runs on a separate opener thread; audio arriving meanwhile is held on the
+// stream and handed over once the session is posted back to the loop.
+class PcmServer {
+public:
+    struct Config {
+        int tcpPort{0};                     // 0: no TCP listener
+        std::string bindAddress{"0.0.0.0"};
+        std::string unixPath;               // empty: no Unix listener
+        size_t maxConnections{256};
+        size_t maxStreamsPerConnection{8};  // open or opening; sessionIds past this are refused
+        size_t maxRefusedStreams{16};       // refused sessionIds remembered per connection
+        size_t maxPayloadBytes{65536};
+        size_t maxOutboundBytes{262144};    // queued progress per connection before frames are skipped
+        double openingBufferSeconds{2.0};   // audio held per stream while its session is opened
+        Session::Config session;            // template for every stream; id is filled in
+    };
+
+    struct Stats {
+        uint64_t connections{0};
+        uint64_t accepted{0};
+        uint64_t frames{0};
+        uint64_t bytes{0};
+        uint64_t lostFrames{0};       // sequence gaps reported by clients' numbering
+        uint64_t replayedFrames{0};   // duplicates and reordered frames that were dropped
+        uint64_t openingDroppedFrames{0};  // beyond openingBufferSeconds while a session opened
+        uint64_t progressSent{0};
+        uint64_t progressSkipped{0};
+        uint64_t protocolErrors{0};
+    };
+
+    PcmServer(EventLoop& loop, SessionHost& host, std::shared_ptr<const RitualAssets> assets,
+              const Config& config);
+    ~PcmServer();
+
+    PcmServer(const PcmServer&) = delete;
+    PcmServer& operator=(const PcmServer&) = delete;
+
+    // Both on the loop thread
+    bool start();
+    void stop();
+
+    Stats stats() const;
+
+private:
+    struct Stream {
+        std::shared_ptr<Session> session;  // null while opening
+        uint64_t openTicket{0};            // nonzero while the opener works on this stream
+        std::vector<float> opening;        // audio received before the session was ready
+        bool advancePending{false};        // space pressed before the session was ready
+        uint32_t nextSequence{0};
+        bool started{false};
+    };
+
+    struct Connection {
+        int fd{-1};
+        uint64_t id{0};
+
+        // Loop thread only
+        std::vector<unsigned char> in;
+        size_t inBegin{0};
+        size_t inEnd{0};
+        std::unordered_map<uint32_t, Stream> streams;
+        size_t openingStreams{0};        // opener jobs not yet posted back, ended streams included
+        std::deque<uint32_t> refused;    // newest last; older ids are forgotten
+        std::string out;
+        size_t outOffset{0};
+
+        // Filled by host workers, drained by the loop
+        std::mutex pendingMutex;
+        std::string pending;
+        bool flushPosted{false};
+        bool closed{false};
+    };
+
+    EventLoop& loop_;
+    SessionHost& host_;
+    std::shared_ptr<const RitualAssets> assets_;
+    Config config_;
+
+    int tcpFd_{-1};
+    int unixFd_{-1};
+    uint64_t nextConnectionId_{1};
+    std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+
+    std::atomic<uint64_t> openConnections_{0};
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> lostFrames_{0};
+    std::atomic<uint64_t> replayedFrames_{0};
+    std::atomic<uint64_t> openingDroppedFrames_{0};
+    std::atomic<uint64_t> progressSent_{0};
+    std::atomic<uint64_t> progressSkipped_{0};
+    std::atomic<uint64_t> protocolErrors_{0};
+
+    // Session opens, one at a time, off the loop thread
+    std::mutex openMutex_;
+    std::condition_variable openCv_;
+    std::deque<std::function<void()>> openJobs_;
+    bool openerRunning_{false};
+    std::thread opener_;
+    uint64_t nextOpenTicket_{1};
+
+    Gauge& connectionsMetric_;
+    Counter& bytesMetric_;
+    Counter& lostFramesMetric_;
+    Counter& progressSkippedMetric_;
+
+    int listenTcp();
+    int listenUnix();
+    void acceptConnections(int listenFd);
+    void readConnection(const std::shared_ptr<Connection>& connection);
+    // False when the connection has to be dropped
+    bool handleFrame(const std::shared_ptr<Connection>& connection, const PcmFrameHeader& header,
+                     const unsigned char* payload);
+    // Errors here close only the stream named by the frame
+    void handleAudio(const std::shared_ptr<Connection>& connection, const PcmFrameHeader& header,
+                     const unsigned char* payload);
+    // Starts opening the stream's session on the opener thread
+    Stream& openStream(const std::shared_ptr<Connection>& connection, uint32_t sessionId);
+    void streamOpened(const std::shared_ptr<Connection>& connection, uint32_t sessionId, uint64_t ticket,
+                      std::shared_ptr<Session> session, const std::string& error);
+    // Sends an Error for the stream and drops it; its id stays refused, among
+    // the connection's last maxRefusedStreams, until the client ends it
+    void failStream(const std::shared_ptr<Connection>& connection, uint32_t sessionId, const std::string& error);
+    void closeConnection(const std::shared_ptr<Connection>& connection);
+    void runOpener();
+
+    // Any thread; frames are written by the loop
+    void queueFrame(const std::shared_ptr<Connection>& connection, PcmFrameType type,
+                    uint32_t sessionId, const std::string& payload, bool droppable);
+    void flush(const std::shared_ptr<Connection>& connection);
+};
+
+}
@@ -31,7 +31,7 @@ public:
 
     explicit PhraseManager(const RitualDefinition& ritual);
 
-    MatchResult matchPhrase(const std::string& text);
+    MatchResult matchPhrase(const std::string& text) const;
     
 private:
     const RitualDefinition& ritual_;
@@ -1,114 +1,243 @@
 #pragma once
 
 #include "ritual/flow_manager.hpp"
-#include <string>
-#include <mutex>
-#include <iostream>
+#include "host/ritual_assets.hpp"
+#include "trace/tracer.hpp"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/ioctl.h>
+#include <unistd.h>
 
 namespace sadhana {
 
+// Draws the ritual progress at a fixed frame rate, one renderFrame() per
+// tick of the owner's event loop. Other threads only publish: progress and
+// messages are swapped in as immutable snapshots, and the level is read from
+// an atomic the audio side already maintains, so nothing on the audio or ASR
+// paths waits on the terminal. Each frame is rendered into a back buffer and
+// only the lines that changed since the previous frame are written. Text
+// comes from the flow's current ritual bundle, so an edited definition shows
+// up on the next frame after a reload.
 class DisplayManager {
 public:
-    DisplayManager() 
-        : lastLevel_(0.0f)
-        , needsUpdate_(true)
-        , lastUpdate_(std::chrono::steady_clock::now())
-        , updateIntervalMs_(2000)  // Increase to 2 seconds
-        , levelThresholdDb_(10.0f) // Increase to 10dB
-    {}
-
-    void requestUpdate() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        needsUpdate_ = true;
+    struct Config {
+        int frameRateHz{15};
+        float meterFloorDb{-60.0f};
+        float meterCeilingDb{0.0f};
+    };
+
+    using LevelSource = std::function<float()>;
+
+    explicit DisplayManager(const FlowManager& flow) : DisplayManager(flow, Config()) {}
+    DisplayManager(const FlowManager& flow, const Config& config)
+        : flow_(flow), config_(config) {}
+
+    DisplayManager(const DisplayManager&) = delete;
+    DisplayManager& operator=(const DisplayManager&) = delete;
+
+    // Read once per frame; must be lock-free
+    void setLevelSource(LevelSource source) { levelSource_ = std::move(source); }
+
+    // Takes the flow's snapshot as is; nothing is copied per update
+    void publish(FlowManager::ProgressSnapshot progress) {
+        progress_.store(std::move(progress), std::memory_order_release);
+    }
+
+    void showMessage(const std::string& message) {
+        message_.store(std::make_shared<const std::string>(message), std::memory_order_release);
+    }
+
+    std::chrono::milliseconds frameInterval() const {
+        return std::chrono::milliseconds(1000 / std::max(1, config_.frameRateHz));
     }
 
-    void updateDisplay(const FlowProgress& progress, 
-                      const RitualDefinition& ritual,
-                      float currentLevel) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto currentTime = std::chrono::steady_clock::now();
-        auto timeSinceLastUpdate = std::chrono::duration_cast<std::chrono::milliseconds>(
-            currentTime - lastUpdate_).count();
-
-        // Update only if:
-        // 1. Update is requested, or
-        // 2. Section or part changed, or
-        // 3. Level changed significantly (>5dB), or
-        // 4. Update interval has passed
-        if (!needsUpdate_ &&
-            lastSectionId_ == progress.currentSectionId &&
-            lastPartId_ == progress.currentPartId &&
-            std::abs(currentLevel - lastLevel_) <= levelThresholdDb_ &&
-            timeSinceLastUpdate < updateIntervalMs_) {
-            return;
+    // Renders and writes one frame; frames must come from a single thread
+    void renderFrame() {
+        auto progress = progress_.load(std::memory_order_acquire);
+        // The first frame to show a recognized phrase's effect is the end of
+        // that utterance's journey in the latency trace
+        uint64_t traceId = progress && progress->version != tracedVersion_ ? progress->traceId : 0;
+        {
+            SADHANA_TRACE_CONTEXT(traceId);
+            SADHANA_TRACE_SPAN("display.redraw");
+            drawFrame(progress);
+        }
+        if (traceId != 0) {
+            tracedVersion_ = progress->version;
+            SADHANA_TRACE_RECORD("utterance", traceId, progress->traceStartNs, Tracer::timestamp());
+        }
+    }
+
+    // Leaves the cursor below the last frame for whatever prints next
+    void finish() {
+        if (!cleared_) return;
+        writeAll("\033[" + std::to_string(front_.size() + 1) + ";1H\n");
+        front_.clear();
+        cleared_ = false;
+    }
+
+private:
+    const FlowManager& flow_;
+    Config config_;
+    LevelSource levelSource_;
+    std::atomic<FlowManager::ProgressSnapshot> progress_;
+    std::atomic<std::shared_ptr<const std::string>> message_;
+
+    // Frame state, touched only by the thread calling renderFrame()
+    std::vector<std::string> front_;
+    std::vector<std::string> back_;
+    bool cleared_{false};
+    uint64_t tracedVersion_{0};
+    std::string stateSectionId_;
+    std::string statePartId_;
+    uint64_t stateGeneration_{0};
+    bool haveState_{false};
+    RitualDefinition::CurrentState state_;
+
+    void drawFrame(const FlowManager::ProgressSnapshot& progress) {
+        buildFrame(back_, progress);
+
+        std::string out;
+        if (!cleared_) {
+            out += "\033[2J";
+            cleared_ = true;
+        }
+        for (size_t row = 0; row < back_.size(); ++row) {
+            if (row < front_.size() && front_[row] == back_[row]) continue;
+            out += "\033[" + std::to_string(row + 1) + ";1H" + back_[row] + "\033[K";
+        }
+        for (size_t row = back_.size(); row < front_.size(); ++row) {
+            out += "\033[" + std::to_string(row + 1) + ";1H\033[K";
+        }
+
+        if (!out.empty()) {
+            writeAll(out);
         }
+        std::swap(front_, back_);
+    }
+
+    void buildFrame(std::vector<std::string>& lines, const FlowManager::ProgressSnapshot& progress) {
+        lines.clear();
+        size_t width = terminalWidth();
+        auto add = [&lines, width](std::string line) {
+            lines.push_back(fitToWidth(std::move(line), width));
+        };
+
+        float level = levelSource_ ? levelSource_() : config_.meterFloorDb;
 
-        auto state = ritual.getCurrentState(progress.currentSectionId, progress.currentPartId);
-        
-        // Clear screen and reset cursor
-        std::cout << "\033[2J\033[H";
-        
-        // Show header
-        std::cout << "=== Ritual Progress ===\n";
-        std::cout << "Section: " << progress.currentSectionId << "\n";
-        std::cout << "Part: " << (progress.currentPartId.empty() ? "-" : progress.currentPartId) << "\n";
-        std::cout << "Audio Level: " << std::fixed << std::setprecision(1) 
-                 << currentLevel << " dB\n";
-        std::cout << "-------------------\n\n";
-
-        // Show current instructions
-        if (!state.description.empty()) {
-            std::cout << "\033[1mInstructions:\033[0m\n";
-            std::cout << state.description << "\n\n";
+        add("=== Ritual Progress ===");
+        if (progress) {
+            add("Section: " + progress->currentSectionId);
+            add("Part: " + (progress->currentPartId.empty() ? std::string("-") : progress->currentPartId));
         }
+        add("Audio Level: " + formatLevel(level) + " dB " + levelMeter(level));
+        add("-------------------");
+        add("");
 
-        // Show expected utterance
-        std::cout << "\033[1mExpected Utterance:\033[0m\n";
-        if (!state.expectedUtterance.empty()) {
-            std::cout << state.expectedUtterance;
-            if (state.requiredRepetitions > 1) {
-                std::cout << " (" << progress.currentRepetition << "/"
-                         << state.requiredRepetitions << " times)";
+        if (progress) {
+            // Definition lookups happen here, once per section/part change or reload
+            uint64_t generation = flow_.assetsGeneration();
+            if (!haveState_ || stateGeneration_ != generation ||
+                stateSectionId_ != progress->currentSectionId || statePartId_ != progress->currentPartId) {
+                state_ = flow_.assets()->ritual->getCurrentState(progress->currentSectionId,
+                                                                 progress->currentPartId);
+                stateGeneration_ = generation;
+                stateSectionId_ = progress->currentSectionId;
+                statePartId_ = progress->currentPartId;
+                haveState_ = true;
+            }
+
+            if (!state_.description.empty()) {
+                add("\033[1mInstructions:\033[0m");
+                size_t start = 0;
+                while (start <= state_.description.size()) {
+                    size_t end = state_.description.find('\n', start);
+                    if (end == std::string::npos) end = state_.description.size();
+                    add(state_.description.substr(start, end - start));
+                    start = end + 1;
+                }
+                add("");
+            }
+
+            add("\033[1mExpected Utterance:\033[0m");
+            if (!state_.expectedUtterance.empty()) {
+                std::string line = state_.expectedUtterance;
+                if (state_.requiredRepetitions > 1) {
+                    line += " (" + std::to_string(progress->currentRepetition) + "/" +
+                            std::to_string(state_.requiredRepetitions) + " times)";
+                }
+                add(line);
+            } else if (progress->awaitingManualIntervention) {
+                add("\033[33mPress SPACE to continue\033[0m");
+            } else {
+                add("(Waiting for next section)");
             }
-            std::cout << "\n";
-        } else if (progress.awaitingManualIntervention) {
-            std::cout << "\033[33mPress SPACE to continue\033[0m\n";
-        } else {
-            std::cout << "(Waiting for next section)\n";
         }
 
-        std::cout << std::flush;
+        if (auto message = message_.load(std::memory_order_acquire)) {
+            add("");
+            add(*message);
+        }
+    }
 
-        // Update state tracking
-        lastSectionId_ = progress.currentSectionId;
-        lastPartId_ = progress.currentPartId;
-        lastLevel_ = currentLevel;
-        lastUpdate_ = currentTime;
-        needsUpdate_ = false;
+    std::string formatLevel(float level) const {
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "%.1f", level);
+        return buffer;
     }
 
-    void showMessage(const std::string& message) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        clearLine();
-        std::cout << "\r" << message << std::flush;
-        needsUpdate_ = true;
+    std::string levelMeter(float level) const {
+        const int cells = 20;
+        float span = config_.meterCeilingDb - config_.meterFloorDb;
+        int filled = span > 0.0f
+            ? static_cast<int>(std::lround(cells * (level - config_.meterFloorDb) / span))
+            : 0;
+        filled = std::clamp(filled, 0, cells);
+        return "[" + std::string(filled, '#') + std::string(cells - filled, '.') + "]";
     }
 
-private:
-    std::mutex mutex_;
-    float lastLevel_;
-    std::string lastSectionId_;
-    std::string lastPartId_;
-    std::chrono::steady_clock::time_point lastUpdate_;
-    bool needsUpdate_;
-    const int updateIntervalMs_;
-    const float levelThresholdDb_;  // New threshold member
-
-    void clearLine() {
-        std::cout << "\r" << std::string(120, ' ') << "\r";
+    // Keeps every line on one terminal row so cursor addressing stays valid.
+    // Escape sequences do not take up columns; cuts stay on UTF-8 boundaries.
+    static std::string fitToWidth(std::string line, size_t width) {
+        size_t columns = 0;
+        for (size_t i = 0; i < line.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(line[i]);
+            if (c == '\033') {
+                while (i < line.size() && line[i] != 'm') ++i;
+                continue;
+            }
+            if ((c & 0xC0) == 0x80) continue;
+            if (++columns > width) {
+                line.resize(i);
+                line += "\033[0m";
+                break;
+            }
+        }
+        return line;
+    }
+
+    static size_t terminalWidth() {
+        winsize ws{};
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+            return ws.ws_col;
+        }
+        return 120;
+    }
+
+    static void writeAll(const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::write(STDOUT_FILENO, data.data() + written, data.size() - written);
+            if (n <= 0) break;
+            written += static_cast<size_t>(n);
+        }
     }
 };
 
-} // namespace sadhana
\ No newline at end of file
+} // namespace sadhana
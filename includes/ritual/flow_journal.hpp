@@ -0,0 +1,147 @@
+#pragma once
+
+#include "ritual/flow_manager.hpp"
+#include "audio/spsc_queue.hpp"
+#include "metrics/metrics.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+namespace sadhana {
+
+// Append-only, crash-safe log of flow changes so an interrupted ritual can
+// resume where it stopped. Every record is fixed-size and carries the full
+// compact position (section and part by index, repetition, manual-advance
+// flag, completed sections), so the newest valid record is the state and a
+// torn tail is simply ignored. The flow thread only pushes records into a
+// ring; a writer thread group-commits them with one fdatasync per batch and
+// periodically compacts the journal into a snapshot file.
+//
+// Files in the journal directory:
+//   flow.journal   header + records, truncated after each snapshot
+//   flow.snapshot  header + one record, replaced atomically via rename
+class FlowJournal {
+public:
+    enum class RecordType : uint8_t {
+        Offering = 1,       // a repetition was counted
+        ManualAdvance = 2,  // a key press changed the position
+        SectionChange = 3,  // moved to another section or part
+        Restored = 4        // position taken over from a previous run
+    };
+
+    struct Config {
+        std::string directory;
+        int commitIntervalMs{50};    // longest a record waits for its fdatasync
+        size_t snapshotEvery{256};   // records between compactions
+        size_t queueRecords{1024};
+    };
+
+    struct ResumeState {
+        FlowProgress progress;
+        uint64_t completedSections{0};  // bit per section, in definition order
+        uint64_t sequence{0};
+        size_t replayedRecords{0};
+        bool fromSnapshot{false};
+        double loadMs{0.0};
+    };
+
+    struct Stats {
+        uint64_t appended{0};
+        uint64_t committed{0};
+        uint64_t dropped{0};
+        uint64_t commits{0};
+        uint64_t snapshots{0};
+    };
+
+    FlowJournal(const RitualDefinition& ritual, const Config& config);
+    ~FlowJournal();
+
+    FlowJournal(const FlowJournal&) = delete;
+    FlowJournal& operator=(const FlowJournal&) = delete;
+
+    // Reads the snapshot and the journal tail. False when there is nothing to
+    // resume from; error is set when files exist but cannot be used.
+    bool load(ResumeState& state, std::string* error = nullptr);
+
+    // Opens the journal for appending and starts the writer. With resume the
+    // sequence continues from the last load(); otherwise both files are reset.
+    bool open(bool resume);
+    // Commits everything appended so far and stops the writer
+    void close();
+
+    // Flow thread only; bounded cost, never blocks on disk
+    void append(RecordType type, const FlowProgress& progress, uint64_t completedSections);
+
+    Stats stats() const;
+
+private:
+    static constexpr uint32_t JOURNAL_MAGIC = 0x314a4453;   // "SDJ1"
+    static constexpr uint32_t SNAPSHOT_MAGIC = 0x31534453;  // "SDS1"
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    static constexpr uint16_t NO_INDEX = 0xffff;
+
+    // On-disk layout, host byte order
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t fingerprint;  // section and part ids of the definition
+    };
+
+    struct Record {
+        uint32_t crc;
+        uint8_t type;
+        uint8_t awaiting;
+        uint16_t section;
+        uint16_t part;
+        uint16_t reserved;
+        uint32_t repetition;
+        uint64_t sequence;
+        uint64_t completedSections;
+        int64_t wallTimeMs;
+    };
+    static_assert(sizeof(FileHeader) == 16, "journal header layout");
+    static_assert(sizeof(Record) == 40, "journal record layout");
+
+    const RitualDefinition& ritual_;
+    Config config_;
+    uint64_t fingerprint_{0};
+    int fd_{-1};
+    uint64_t nextSequence_{1};  // flow thread
+    uint64_t sinceSnapshot_{0};  // writer thread
+    Record lastRecord_{};
+    bool loaded_{false};
+    uint64_t validJournalBytes_{0};  // up to the last intact record seen by load()
+    off_t journalEnd_{0};  // writer thread; end of the last committed record
+
+    SpscQueue<Record> queue_;
+    StageSignal signal_;
+    std::atomic<bool> running_{false};
+    std::thread writer_;
+
+    std::atomic<uint64_t> appended_{0};
+    std::atomic<uint64_t> committed_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> commits_{0};
+    std::atomic<uint64_t> snapshots_{0};
+
+    Counter& droppedMetric_;
+    Histogram& appendSecondsMetric_;
+    Histogram& commitSecondsMetric_;
+    Histogram& batchRecordsMetric_;
+
+    std::string journalPath() const;
+    std::string snapshotPath() const;
+    uint64_t computeFingerprint() const;
+    static uint32_t recordCrc(const Record& record);
+    bool decode(const Record& record, ResumeState& state) const;
+
+    void runWriter();
+    void commitBatch(const std::vector<Record>& batch);
+    bool writeBatch(const std::vector<Record>& batch);
+    bool writeSnapshot(const Record& record);
+};
+
+}
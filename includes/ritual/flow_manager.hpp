@@ -2,8 +2,15 @@
 
 #include "definition/definition.hpp"
 #include "phrase/phrase_manager.hpp"
+#include "audio/clock.hpp"
+#include "audio/mpsc_queue.hpp"
+#include "audio/spsc_queue.hpp"
+#include "metrics/metrics.hpp"
+#include <atomic>
+#include <memory>
 #include <string>
 #include <optional>
+#include <thread>
 #include <functional>
 #include <chrono>
 #include <map>
@@ -11,6 +18,10 @@
 
 namespace sadhana {
 
+class FlowJournal;
+class UtteranceLogWriter;
+struct RitualAssets;
+
 struct FlowProgress {
     std::string currentSectionId;
     std::string currentPartId;
@@ -19,42 +30,157 @@ struct FlowProgress {
     std::map<std::string, int> counts;
     bool awaitingManualIntervention{false};
     float lastConfidence{0.0f};
+    bool complete{false};
+    uint64_t version{0};  // bumped on every published change
+    // The utterance behind this change, for latency traces; 0 for key presses
+    uint64_t traceId{0};
+    int64_t traceStartNs{0};  // its speech onset, trace clock
 };
 
+// Compact form pushed to remote displays; counts are left out
+nlohmann::json progressToJson(const FlowProgress& progress);
+
+// Runs as an actor: recognition and keyboard events are posted from any
+// thread into a lock-free queue and applied in order by a single thread,
+// either the one started with start() or a caller of processPending().
+// Readers never see live state, only immutable snapshots swapped in
+// atomically after each change. The definition, matcher and flow settings
+// are one immutable bundle too: reload() swaps in a new one and the thread
+// picks it up between events, so an event is always judged by one version.
 class FlowManager {
-private:
-    PhraseManager phraseManager_;  // Add this
 public:
+    using ProgressSnapshot = std::shared_ptr<const FlowProgress>;
+
+    static constexpr size_t EVENT_QUEUE_CAPACITY = 1024;
+
     explicit FlowManager(const RitualDefinition& definition);
-    ~FlowManager() = default;
+    // Shares an already compiled matcher for the same definition
+    FlowManager(const RitualDefinition& definition, std::shared_ptr<const PhraseManager> matcher);
+    ~FlowManager();
+
+    FlowManager(const FlowManager&) = delete;
+    FlowManager& operator=(const FlowManager&) = delete;
 
     bool loadFlowConfiguration(const std::string& configPath);
-    void handleRecognizedPhrase(const std::string& phrase, float confidence);
-    void handleManualIntervention();
-    bool isComplete() const;
+    // Same, from flow settings already parsed (e.g. shared between sessions)
+    bool setFlowConfiguration(const nlohmann::json& config);
+
+    // Any thread: publishes a newly compiled definition, matcher and flow
+    // settings for the next event. Refused when the flow settings are invalid
+    // or the sections, or the parts within a section, differ in id or order
+    // from the running definition's, since progress, journal and displays
+    // refer to them.
+    bool reload(std::shared_ptr<const RitualAssets> assets, std::string* error = nullptr);
+    // Bumped by every accepted reload; 0 for the assets the flow started with.
+    // Published after the bundle, so assets() read after it is at least as new.
+    uint64_t assetsGeneration() const { return assetsGeneration_.load(std::memory_order_acquire); }
+    // The latest accepted bundle; displays look their text up here
+    std::shared_ptr<const RitualAssets> assets() const { return assets_.load(std::memory_order_acquire); }
+
+    // Thread-safe and lock-free; false when the event queue is full. The trace
+    // id and onset are handed on through the published progress.
+    bool postRecognizedPhrase(std::string phrase, float confidence, float decodeMs = 0.0f,
+                              uint64_t traceId = 0, int64_t traceStartNs = 0);
+    // With the pipeline's match of the phrase and the assets it was made with;
+    // the flow uses it as long as it still has the same matcher
+    bool postRecognizedPhrase(std::string phrase, PhraseManager::MatchResult match,
+                              const std::shared_ptr<const RitualAssets>& matchedWith, float decodeMs = 0.0f,
+                              uint64_t traceId = 0, int64_t traceStartNs = 0);
+    bool postManualIntervention();
+
+    // Both before start(): every published change is appended to the journal, and
+    // restore() continues from a position read back from it
+    void setJournal(FlowJournal* journal) { journal_ = journal; }
+    void restore(const FlowProgress& progress, uint64_t completedSections);
+    // Before start(): every phrase the flow judges and every key press becomes a row
+    void setUtteranceLog(UtteranceLogWriter* log) { utteranceLog_ = log; }
+
+    // Processes events on a dedicated thread until stop(), which drains the queue
+    void start();
+    void stop();
+    // Applies queued events on the calling thread; only without start()
+    size_t processPending();
+
+    ProgressSnapshot snapshot() const { return snapshot_.load(std::memory_order_acquire); }
+    bool isComplete() const { return snapshot()->complete; }
+    uint64_t droppedEvents() const { return droppedEvents_.load(std::memory_order_relaxed); }
 
-    // Callbacks
-    using ProgressCallback = std::function<void(const FlowProgress&)>;
+    // Called on the processing thread after each change
+    using ProgressCallback = std::function<void(const ProgressSnapshot&)>;
     void setProgressCallback(ProgressCallback callback) { progressCallback_ = callback; }
 
-    // Progress access
-    const FlowProgress& getCurrentProgress() const { return progress_; }
+    // Attempt timestamps follow this clock (the pipeline's stream clock in practice);
+    // events are stamped when posted, so queueing delay does not shift them
+    void setClock(const Clock& clock) { clock_.store(&clock, std::memory_order_release); }
+
+    float getThresholdForSection(const std::string& sectionId) const;
+    // "admission" defaults from flow.json with the section's overrides applied
+    nlohmann::json getAdmissionSettings(const std::string& sectionId) const;
 
 private:
-    const RitualDefinition& definition_;
-    nlohmann::json flowConfig_;
-    FlowProgress progress_;
+    struct Event {
+        enum class Type { RecognizedPhrase, ManualIntervention };
+        Type type{Type::RecognizedPhrase};
+        std::string phrase;
+        float confidence{0.0f};
+        float decodeMs{0.0f};
+        uint64_t traceId{0};
+        int64_t traceStartNs{0};
+        TimePoint time;
+        std::optional<PhraseManager::MatchResult> match;
+        std::shared_ptr<const PhraseManager> matchedWith;
+    };
+
+    // Latest published bundle, and the processing thread's copy of it, which
+    // is refreshed only between events
+    std::atomic<std::shared_ptr<const RitualAssets>> assets_;
+    std::shared_ptr<const RitualAssets> active_;
+    std::atomic<uint64_t> assetsGeneration_{0};
     ProgressCallback progressCallback_;
+    std::atomic<const Clock*> clock_{&SteadyClock::instance()};
+
+    // Owned by the processing thread
+    FlowProgress progress_;
+    bool applyingManual_{false};
+    FlowJournal* journal_{nullptr};
+    UtteranceLogWriter* utteranceLog_{nullptr};
+
+    MpscQueue<Event> events_{EVENT_QUEUE_CAPACITY};
+    StageSignal eventSignal_;
+    std::atomic<uint64_t> droppedEvents_{0};
+    std::atomic<ProgressSnapshot> snapshot_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    // Interventions and failures are only counted when flow.json "logging" asks for them
+    Counter& offeringsMetric_;
+    Counter& manualInterventionsMetric_;
+    Counter& recognitionFailuresMetric_;
+    bool trackManualInterventions_{false};
+    bool trackRecognitionFailures_{false};
 
     struct SectionState {
         bool isComplete{false};
         int failedAttempts{0};
-        std::chrono::steady_clock::time_point lastAttempt;
+        TimePoint lastAttempt;
     };
     std::map<std::string, SectionState> sectionStates_;
 
-    bool validateConfiguration() const;
-    float getThresholdForSection(const std::string& sectionId) const;
+    bool post(Event event);
+    void run();
+    void apply(const Event& event);
+    void handleRecognizedPhrase(const Event& event);
+    void handleManualIntervention();
+    void logUtterance(const Event& event, bool accepted, const PhraseManager::MatchResult* match);
+    void publish(bool restored = false);
+    bool allSectionsComplete() const;
+    uint64_t completedSectionMask() const;
+
+    void activateLatestAssets();
+    void applyLoggingSettings(const nlohmann::json& flowConfig);
+    const RitualDefinition& definition() const;
+    static bool validateConfiguration(const nlohmann::json& flowConfig);
+    static float thresholdForSection(const nlohmann::json& flowConfig, const std::string& sectionId);
     bool checkSectionCompletion(const std::string& sectionId);
     void advanceSection();
 };
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "audio/clock.hpp"
+#include "ritual/flow_manager.hpp"
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sadhana {
+
+// One line of a flow trace: what the recognizer heard, or a key the user pressed.
+//   {"t": 12.48, "type": "asr", "text": "om shreem ...", "confidence": 0.8}
+//   {"t": 15.02, "type": "key", "key": "space"}
+// "asr" lines may carry the raw Vosk result object under "result" instead of "text".
+struct FlowTraceEvent {
+    enum class Type { Recognized, ManualAdvance };
+
+    Type type{Type::Recognized};
+    double time{0.0};  // seconds since the start of the session
+    std::string text;
+    float confidence{0.8f};
+};
+
+bool loadFlowTrace(const std::string& path, std::vector<FlowTraceEvent>& events, std::string* error = nullptr);
+
+// Appends events from a live session as JSON lines, flushed per line so a
+// crash keeps everything up to the last event
+class FlowTraceRecorder {
+public:
+    explicit FlowTraceRecorder(const Clock& clock = SteadyClock::instance()) : clock_(&clock) {}
+
+    bool open(const std::string& path);
+    bool isOpen() const { return file_.is_open(); }
+
+    void recordRecognized(const std::string& text, float confidence);
+    void recordManualAdvance();
+
+private:
+    const Clock* clock_;
+    TimePoint start_;
+    std::mutex mutex_;
+    std::ofstream file_;
+
+    void write(const nlohmann::json& line);
+};
+
+struct FlowReplayStats {
+    size_t phrases{0};
+    size_t manualAdvances{0};
+    size_t countedRepetitions{0};
+    double seconds{0.0};
+    double phrasesPerSecond{0.0};
+    FlowProgress finalProgress;
+};
+
+// Feeds the events to the flow as fast as it takes them. The flow's clock
+// follows the trace timestamps during the replay and is the steady clock after.
+FlowReplayStats replayFlowTrace(FlowManager& flow, const std::vector<FlowTraceEvent>& events);
+
+}
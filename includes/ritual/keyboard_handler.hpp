@@ -1,31 +1,33 @@
 #pragma once
 
 #include <functional>
-#include <thread>
-#include <atomic>
+#include <chrono>
 #include <termios.h>
 #include <unistd.h>
+#include "event/event_loop.hpp"
+#include "log/logger.hpp"
 #include <iostream>
 #include <fcntl.h>
 
 namespace sadhana {
 
+// Reads raw keys from stdin on an EventLoop; no thread of its own
 class KeyboardHandler {
 public:
     using KeyCallback = std::function<void()>;
-    
-    KeyboardHandler() : running_(false), spaceCallback_(nullptr) {
+
+    KeyboardHandler() : spaceCallback_(nullptr) {
         // Save terminal settings
         if (tcgetattr(STDIN_FILENO, &oldSettings_) < 0) {
             std::cerr << "Failed to get terminal attributes\n";
             return;
         }
-        
+
         newSettings_ = oldSettings_;
         newSettings_.c_lflag &= ~(ICANON | ECHO | ISIG);  // Also disable signals
         newSettings_.c_cc[VMIN] = 1;    // Wait for at least one character
         newSettings_.c_cc[VTIME] = 0;   // No timeout
-        
+
         // Set non-blocking mode
         int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
         if (flags < 0 || fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK) < 0) {
@@ -33,71 +35,95 @@ public:
             return;
         }
     }
-    
+
     ~KeyboardHandler() {
         stop();
         // Restore terminal settings
         tcsetattr(STDIN_FILENO, TCSANOW, &oldSettings_);
     }
-    
-    void start() {
-        if (running_) return;
-        
-        std::cout << "Debug: KeyboardHandler starting...\n" << std::flush;
-        
+
+    bool start(EventLoop& loop) {
+        if (loop_) return true;
+
+        SADHANA_LOG_DEBUG("keyboard", "KeyboardHandler starting");
+
         // Apply new terminal settings
         if (tcsetattr(STDIN_FILENO, TCSANOW, &newSettings_) < 0) {
             std::cerr << "Failed to set terminal attributes\n";
-            return;
+            return false;
         }
-        
-        running_ = true;
-        thread_ = std::thread([this]() {
-            char c;
-            auto lastSpaceTime = std::chrono::steady_clock::now();
-            const auto debounceTime = std::chrono::milliseconds(250);  // Reduced debounce time
-            const auto pollInterval = std::chrono::milliseconds(1);    // More frequent polling
-            
-            while (running_) {
-                if (read(STDIN_FILENO, &c, 1) > 0) {
-                    if (c == ' ' || c == '\n') {  // Also accept Enter key
-                        auto now = std::chrono::steady_clock::now();
-                        if (std::chrono::duration_cast<std::chrono::milliseconds>(
-                            now - lastSpaceTime) >= debounceTime) {
-                            std::cout << "Debug: Space/Enter key detected\n" << std::flush;
-                            if (spaceCallback_) {
-                                try {
-                                    spaceCallback_();
-                                } catch (const std::exception& e) {
-                                    std::cerr << "Error in space callback: " << e.what() << std::endl;
-                                }
-                            }
-                            lastSpaceTime = now;
-                        }
-                    }
-                }
-                std::this_thread::sleep_for(pollInterval);
-            }
-        });
+
+        if (!loop.watchReadable(STDIN_FILENO, [this](uint32_t) { readKeys(); })) {
+            return false;
+        }
+        loop_ = &loop;
+        return true;
     }
-    
+
+    // Must run on the loop thread, or after the loop has returned
     void stop() {
-        running_ = false;
-        if (thread_.joinable()) {
-            thread_.join();
+        if (loop_) {
+            loop_->unwatch(STDIN_FILENO);
+            loop_ = nullptr;
         }
     }
-    
+
     void setSpaceCallback(KeyCallback callback) {
         spaceCallback_ = std::move(callback);
     }
 
+    // Ctrl+C / Ctrl+D; ISIG is off, so these arrive as bytes rather than signals
+    void setQuitCallback(KeyCallback callback) {
+        quitCallback_ = std::move(callback);
+    }
+
 private:
-    std::atomic<bool> running_;
-    std::thread thread_;
+    static constexpr auto DEBOUNCE_TIME = std::chrono::milliseconds(250);
+
+    EventLoop* loop_{nullptr};
     KeyCallback spaceCallback_;
+    KeyCallback quitCallback_;
+    std::chrono::steady_clock::time_point lastSpaceTime_{};
     struct termios oldSettings_;
     struct termios newSettings_;
+
+    void readKeys() {
+        char buffer[64];
+        ssize_t count;
+        while ((count = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t i = 0; i < count; ++i) {
+                handleKey(buffer[i]);
+            }
+        }
+        if (count == 0) {
+            // stdin closed; stop watching rather than spinning on EOF
+            stop();
+        }
+    }
+
+    void handleKey(char c) {
+        if (c == '\x03' || c == '\x04') {
+            if (quitCallback_) quitCallback_();
+            return;
+        }
+        if (c != ' ' && c != '\n') {  // Also accept Enter key
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastSpaceTime_ < DEBOUNCE_TIME) {
+            return;
+        }
+        lastSpaceTime_ = now;
+        SADHANA_LOG_DEBUG("keyboard", "Space/Enter key detected");
+        if (spaceCallback_) {
+            try {
+                spaceCallback_();
+            } catch (const std::exception& e) {
+                SADHANA_LOG_ERROR("keyboard", "Error in space callback: ", e.what());
+            }
+        }
+    }
 };
 
-} // namespace sadhana
\ No newline at end of file
+} // namespace sadhana
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sadhana {
+
+// Fixed-layout snapshot of ritual progress in a POSIX shared-memory object,
+// for projectors, tablets and other local displays. One writer (the session)
+// updates it under a seqlock; any number of readers map it read-only and
+// copy it out without locks or syscalls, retrying only if a write overlapped
+// the copy. Strings are NUL-terminated and truncated to their field.
+//
+// This header and progress_page.cpp are the whole reader library: they
+// depend on nothing else in sadhana.
+struct ProgressPageData {
+    char sectionId[64];
+    char sectionTitle[128];
+    char partId[64];
+    char stepId[64];
+    char expectedUtterance[256];
+    char lastRecognized[256];
+    int32_t repetition;
+    int32_t requiredRepetitions;
+    int32_t sectionIndex;    // 0-based position in the definition, -1 if unknown
+    int32_t sectionCount;
+    float lastConfidence;
+    uint8_t awaitingManual;
+    uint8_t complete;
+    uint8_t reserved[2];
+    uint64_t version;        // FlowProgress::version of the last published change
+    int64_t updatedWallMs;   // system clock, ms since the epoch
+};
+
+struct ProgressPage {
+    static constexpr uint32_t MAGIC = 0x50504453;  // "SDPP"
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+    static constexpr const char* DEFAULT_NAME = "/sadhana-progress";
+
+    uint32_t magic;
+    uint32_t layoutVersion;
+    uint32_t dataSize;
+    uint32_t writerPid;
+    // Odd while a write is in progress; bumped by two per update
+    alignas(64) std::atomic<uint64_t> sequence;
+    alignas(64) ProgressPageData data;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock needs a lock-free counter in shared memory");
+
+// Copies a consistent page out of the mapping; wait-free in the sense that
+// it gives up after a bounded number of attempts instead of spinning
+class ProgressPageReader {
+public:
+    ProgressPageReader() = default;
+    ~ProgressPageReader();
+
+    ProgressPageReader(const ProgressPageReader&) = delete;
+    ProgressPageReader& operator=(const ProgressPageReader&) = delete;
+
+    // Maps the page read-only; false if it does not exist yet or has another layout
+    bool open(const std::string& name = ProgressPage::DEFAULT_NAME, std::string* error = nullptr);
+    void close();
+    bool isOpen() const { return page_ != nullptr; }
+
+    enum class Result {
+        Updated,     // out holds a newer page than the last successful read
+        Unchanged,   // nothing new since the last read; out untouched
+        Busy         // every attempt overlapped a write; try again next poll
+    };
+    Result read(ProgressPageData& out, int maxAttempts = 4);
+
+    uint64_t lastSequence() const { return lastSequence_; }
+
+private:
+    const ProgressPage* page_{nullptr};
+    size_t mappedSize_{0};
+    uint64_t lastSequence_{0};
+};
+
+}
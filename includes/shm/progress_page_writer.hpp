@@ -0,0 +1,50 @@
+#pragma once
+
+#include "shm/progress_page.hpp"
+#include "ritual/flow_manager.hpp"
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+
+namespace sadhana {
+
+// Publishes the session's progress into a ProgressPage. Updates come from
+// the flow thread (position) and the pipeline (recognized text), so writers
+// serialize on a mutex; readers never see it. Titles and expected text are
+// looked up in the flow's current ritual bundle, again after every reload.
+class ProgressPageWriter {
+public:
+    struct Config {
+        std::string name{ProgressPage::DEFAULT_NAME};
+        mode_t mode{0644};
+    };
+
+    explicit ProgressPageWriter(const FlowManager& flow);
+    ProgressPageWriter(const FlowManager& flow, const Config& config);
+    ~ProgressPageWriter();
+
+    ProgressPageWriter(const ProgressPageWriter&) = delete;
+    ProgressPageWriter& operator=(const ProgressPageWriter&) = delete;
+
+    // Creates (or takes over) the shared-memory object; unlinks it again on close()
+    bool open();
+    void close();
+
+    void publish(const FlowProgress& progress);
+    void publishRecognized(const std::string& text, float confidence);
+
+private:
+    const FlowManager& flow_;
+    Config config_;
+    ProgressPage* page_{nullptr};
+
+    std::mutex mutex_;
+    ProgressPageData data_{};  // last published content
+    std::string stateSectionId_;  // cache key for the definition lookups
+    std::string statePartId_;
+    uint64_t stateGeneration_{0};
+
+    void commit();
+};
+
+}
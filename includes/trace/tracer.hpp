@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifndef SADHANA_TRACING
+#define SADHANA_TRACING 0
+#endif
+
+namespace sadhana {
+
+// Latency spans for following one utterance from capture to display. Each
+// thread writes into its own fixed ring (lock-free, oldest events overwritten)
+// and the rings can be dumped as Chrome trace-event JSON for chrome://tracing
+// or Perfetto. Built without SADHANA_TRACING, the macros below are no-ops.
+class Tracer {
+public:
+    static constexpr bool compiledIn = SADHANA_TRACING != 0;
+    static constexpr size_t RING_EVENTS = 16384;
+
+    // Steady-clock nanoseconds, or 0 when tracing is compiled out
+    static int64_t timestamp() {
+        if constexpr (compiledIn) return nowNs();
+        return 0;
+    }
+
+    // name must outlive the tracer; string literals only
+    static void record(const char* name, uint64_t traceId, int64_t beginNs, int64_t endNs);
+    static void setThreadName(const char* name);
+
+    // A thread's first record() allocates its ring and takes a lock, which a
+    // real-time thread (the audio callback) must not do. Its ring is prepared
+    // from another thread before it starts, then claimed lock-free from the
+    // real-time thread itself; a thread that finds none records nothing.
+    static void prepareRealtimeThread(const char* name);
+    static void enterRealtimeThread();
+
+    // Trace ID picked up by spans opened on this thread (0 = not tied to an utterance)
+    static uint64_t currentTraceId();
+    static void setCurrentTraceId(uint64_t traceId);
+
+    // Rings are read without stopping writers; dump after the pipeline has stopped
+    static bool writeChromeTrace(const std::string& path);
+
+private:
+    static int64_t nowNs();
+};
+
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, uint64_t traceId = Tracer::currentTraceId())
+        : name_(name), traceId_(traceId), begin_(Tracer::timestamp()) {}
+    ~TraceSpan() { Tracer::record(name_, traceId_, begin_, Tracer::timestamp()); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    uint64_t traceId_;
+    int64_t begin_;
+};
+
+// Tags every span opened on this thread in the enclosing scope with traceId
+class TraceContext {
+public:
+    explicit TraceContext(uint64_t traceId) : previous_(Tracer::currentTraceId()) {
+        Tracer::setCurrentTraceId(traceId);
+    }
+    ~TraceContext() { Tracer::setCurrentTraceId(previous_); }
+
+    TraceContext(const TraceContext&) = delete;
+    TraceContext& operator=(const TraceContext&) = delete;
+
+private:
+    uint64_t previous_;
+};
+
+}
+
+#define SADHANA_TRACE_CONCAT_(a, b) a##b
+#define SADHANA_TRACE_CONCAT(a, b) SADHANA_TRACE_CONCAT_(a, b)
+
+#if SADHANA_TRACING
+#define SADHANA_TRACE_SPAN(name) ::sadhana::TraceSpan SADHANA_TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#define SADHANA_TRACE_CONTEXT(id) ::sadhana::TraceContext SADHANA_TRACE_CONCAT(traceContext_, __LINE__)(id)
+#define SADHANA_TRACE_RECORD(name, id, beginNs, endNs) ::sadhana::Tracer::record(name, id, beginNs, endNs)
+#define SADHANA_TRACE_THREAD(name) ::sadhana::Tracer::setThreadName(name)
+#define SADHANA_TRACE_PREPARE_REALTIME(name) ::sadhana::Tracer::prepareRealtimeThread(name)
+#define SADHANA_TRACE_REALTIME_THREAD() ::sadhana::Tracer::enterRealtimeThread()
+#else
+#define SADHANA_TRACE_SPAN(name) ((void)0)
+#define SADHANA_TRACE_CONTEXT(id) ((void)0)
+#define SADHANA_TRACE_RECORD(name, id, beginNs, endNs) ((void)0)
+#define SADHANA_TRACE_THREAD(name) ((void)0)
+#define SADHANA_TRACE_PREPARE_REALTIME(name) ((void)0)
+#define SADHANA_TRACE_REALTIME_THREAD() ((void)0)
+#endif
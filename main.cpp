@@ -1,60 +1,129 @@
-#include "audio/audio_capture.hpp"
-#include "audio/vad.hpp"
-#include "asr/vosk_asr.hpp"
+#include "audio/audio_processor.hpp"
 #include "definition/definition.hpp"
 #include "ritual/flow_manager.hpp"
 #include "ritual/display_manager.hpp"
 #include "ritual/keyboard_handler.hpp"
+#include "event/event_loop.hpp"
+#include "ritual/flow_trace.hpp"
+#include "ritual/flow_journal.hpp"
+#include "shm/progress_page_writer.hpp"
+#include "net/event_stream_server.hpp"
+#include "audio/session_recorder.hpp"
+#include "analytics/utterance_log.hpp"
+#include "host/ritual_library.hpp"
+#include "host/ritual_watcher.hpp"
+#include "trace/tracer.hpp"
+#include "metrics/metrics_exporter.hpp"
+#include "log/logger.hpp"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 #include <thread>
 #include <csignal>
+#include <cstdlib>
+#include <ctime>
 #include <regex>
 #include <nlohmann/json.hpp>
 #include <mutex>
 #include <filesystem>
 #include <fstream>
 
-static volatile bool running = true;
+// Keys, display frames and pipeline results are all handled on this loop
+static sadhana::EventLoop eventLoop;
 
 void signalHandler(int) {
-    running = false;
+    eventLoop.stop();
 }
 
-float calculateRMSdB(const float* samples, size_t numSamples) {
-    float sumSquares = 0.0f;
-    for (size_t i = 0; i < numSamples; ++i) {
-        sumSquares += samples[i] * samples[i];
-    }
-    float rms = std::sqrt(sumSquares / numSamples);
-    return 20.0f * std::log10(rms + 1e-9f);
-}
-
-int main() {
+int main(int argc, char* argv[]) {
     signal(SIGINT, signalHandler);
 
+    // --record-trace <file> saves recognized phrases and key presses for sadhana_replay,
+    // --trace-out <file> writes latency spans as Chrome trace JSON (tracing builds only),
+    // --metrics-file / --metrics-socket <path> publish Prometheus text metrics,
+    // --log-file <path> and --log-level <trace|debug|info|warn|error> control diagnostics,
+    // --journal <dir> keeps a crash-safe record of progress and resumes from it on restart,
+    // --progress-shm <name> mirrors progress into shared memory for external displays,
+    // --events-port <port> streams progress to browsers on the local network (SSE),
+    // --record <dir> saves the session audio and detected offerings for the corpus
+    // (--record-rate <hz> sets the WAV rate, 0 keeps the capture rate),
+    // --analytics <file> appends every utterance to a columnar store for sadhana_stats,
+    // --watch <0|1> recompiles the ritual when its files are edited (on by default),
+    // --ritual-id <id> picks the ritual from the library under --library <dir> (rituals)
+    std::string tracePath;
+    std::string spanTracePath;
+    std::string journalDir;
+    std::string progressShmName;
+    int eventsPort = 0;
+    sadhana::SessionRecorder::Config recorderConfig;
+    std::string analyticsPath;
+    bool watchRitual = true;
+    std::string ritualId = sadhana::RitualLibrary::DEFAULT_RITUAL;
+    sadhana::RitualLibrary::Config libraryConfig;
+    sadhana::MetricsExporter::Config metricsConfig;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--record-trace") {
+            tracePath = argv[i + 1];
+        } else if (arg == "--journal") {
+            journalDir = argv[i + 1];
+        } else if (arg == "--progress-shm") {
+            progressShmName = argv[i + 1];
+        } else if (arg == "--analytics") {
+            analyticsPath = argv[i + 1];
+        } else if (arg == "--record") {
+            recorderConfig.directory = argv[i + 1];
+        } else if (arg == "--record-rate") {
+            recorderConfig.outputRate = std::atoi(argv[i + 1]);
+        } else if (arg == "--ritual-id") {
+            ritualId = argv[i + 1];
+        } else if (arg == "--library") {
+            libraryConfig.root = argv[i + 1];
+        } else if (arg == "--watch") {
+            watchRitual = std::atoi(argv[i + 1]) != 0;
+        } else if (arg == "--events-port") {
+            eventsPort = std::atoi(argv[i + 1]);
+        } else if (arg == "--trace-out") {
+            spanTracePath = argv[i + 1];
+        } else if (arg == "--metrics-file") {
+            metricsConfig.filePath = argv[i + 1];
+        } else if (arg == "--metrics-socket") {
+            metricsConfig.socketPath = argv[i + 1];
+        } else if (arg == "--log-file") {
+            if (!sadhana::Logger::instance().setOutputFile(argv[i + 1])) {
+                std::cerr << "Failed to open log file: " << argv[i + 1] << "\n";
+            }
+        } else if (arg == "--log-level") {
+            sadhana::Logger::instance().setLevel(sadhana::Logger::parseLevel(argv[i + 1]));
+        }
+    }
+    if (!spanTracePath.empty() && !sadhana::Tracer::compiledIn) {
+        std::cerr << "--trace-out needs a build with SADHANA_ENABLE_TRACING=ON\n";
+    }
+
     try {
-        // Load ritual definition
-        sadhana::RitualDefinition ritual;
-        if (!ritual.loadFromFile("rituals/definitions/ganapati/maha_ganapati_caturvrtti_tarpanam.json")) {
-            std::cerr << "Failed to load ritual definition\n";
+        // Resolved the same way sadhana_server does; the watcher follows the files the library used
+        sadhana::RitualLibrary library(libraryConfig);
+        std::string libraryError;
+        std::shared_ptr<const sadhana::RitualAssets> assets;
+        if (library.scan(&libraryError)) {
+            assets = library.load(ritualId, &libraryError);
+        }
+        if (!assets) {
+            std::cerr << "Failed to load ritual " << ritualId << ": " << libraryError << "\n";
             return 1;
         }
+        const sadhana::RitualLibrary::Entry ritualEntry = *library.find(ritualId);
+        const sadhana::RitualDefinition& ritual = *assets->ritual;
 
-        // Add this after loading the ritual definition
-        std::cout << "\nDebug: Initial section structure:\n";
         for (const auto& section : ritual.getSections()) {
-            std::cout << "Section: " << section.id << "\n";
+            SADHANA_LOG_DEBUG("main", "Section: ", section.id);
             if (section.parts) {
                 for (const auto& part : *section.parts) {
-                    std::cout << "  Part: " << part.id;
-                    if (part.utterance) {
-                        std::cout << " (utterance: " << *part.utterance << ")";
-                    }
-                    std::cout << "\n";
+                    SADHANA_LOG_DEBUG("main", "  Part: ", part.id,
+                                      part.utterance ? " (utterance: " + *part.utterance + ")" : "");
                 }
             }
-            std::cout << "\n";
         }
 
         // Display ritual information
@@ -67,14 +136,68 @@ int main() {
                   << "Sections: " << ritual.getSections().size() << "\n";
 
         // Initialize managers
-        sadhana::FlowManager flowManager(ritual);
-        if (!flowManager.loadFlowConfiguration("rituals/definitions/ganapati/flow.json")) {
+        sadhana::FlowManager flowManager(ritual, assets->matcher);
+        if (!flowManager.setFlowConfiguration(assets->flowConfig)) {
             std::cerr << "Failed to load flow configuration\n";
             return 1;
         }
 
-        sadhana::DisplayManager displayManager;
-        std::mutex consoleMutex;
+        // A finished ritual in the journal starts a new one; anything else picks up where it stopped
+        std::unique_ptr<sadhana::FlowJournal> journal;
+        if (!journalDir.empty()) {
+            sadhana::FlowJournal::Config journalConfig;
+            journalConfig.directory = journalDir;
+            journal = std::make_unique<sadhana::FlowJournal>(ritual, journalConfig);
+
+            sadhana::FlowJournal::ResumeState resume;
+            std::string journalError;
+            bool resuming = journal->load(resume, &journalError) && !resume.progress.complete;
+            if (!journalError.empty()) {
+                std::cerr << "Not resuming from journal: " << journalError << "\n";
+            }
+            if (!journal->open(resuming)) {
+                std::cerr << "Failed to open journal in " << journalDir << "\n";
+                return 1;
+            }
+            flowManager.setJournal(journal.get());
+            if (resuming) {
+                flowManager.restore(resume.progress, resume.completedSections);
+                std::cout << "Resuming at " << resume.progress.currentSectionId
+                          << (resume.progress.currentPartId.empty() ? "" : " / " + resume.progress.currentPartId)
+                          << ", repetition " << resume.progress.currentRepetition
+                          << " (" << resume.replayedRecords << " journal records"
+                          << (resume.fromSnapshot ? " after snapshot" : "") << ", "
+                          << std::fixed << std::setprecision(2) << resume.loadMs << " ms)\n";
+            }
+        }
+
+        std::unique_ptr<sadhana::ProgressPageWriter> progressPage;
+        if (!progressShmName.empty()) {
+            sadhana::ProgressPageWriter::Config pageConfig;
+            pageConfig.name = progressShmName;
+            progressPage = std::make_unique<sadhana::ProgressPageWriter>(flowManager, pageConfig);
+            if (!progressPage->open()) {
+                return 1;
+            }
+            progressPage->publish(*flowManager.snapshot());
+        }
+
+        std::unique_ptr<sadhana::EventStreamServer> eventStream;
+        if (eventsPort > 0) {
+            sadhana::EventStreamServer::Config streamConfig;
+            streamConfig.port = eventsPort;
+            eventStream = std::make_unique<sadhana::EventStreamServer>(streamConfig);
+            if (!eventStream->start()) {
+                return 1;
+            }
+            eventStream->publishProgress(*flowManager.snapshot());
+        }
+
+        sadhana::DisplayManager displayManager(flowManager);
+        if (!eventLoop.init()) {
+            std::cerr << "Failed to initialize event loop\n";
+            return 1;
+        }
 
         // Setup Phase
         std::cout << "\n=== Setup Phase ===\n";
@@ -83,8 +206,10 @@ int main() {
         std::cout << "3. Finally, you can begin the ritual\n\n";
 
         // Audio device selection
-        sadhana::AudioCapture audio;
-        auto devices = audio.listDevices();
+        sadhana::RitualAudioProcessor processor(ritual);
+        // Matches against the library's compiled phrases rather than a copy of its own
+        processor.reload(assets);
+        auto devices = processor.listAudioDevices();
         std::cout << "Available input devices:\n";
         std::cout << "------------------------\n";
         for (const auto& device : devices) {
@@ -97,174 +222,317 @@ int main() {
         std::cin >> deviceIndex;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-        if (!audio.setDevice(deviceIndex)) {
+        if (!processor.setAudioDevice(deviceIndex)) {
             std::cerr << "Failed to set device\n";
             return 1;
         }
 
         // Setup VAD and ASR
-        sadhana::VAD::Config vadConfig;
-        vadConfig.attackThreshold = 15.0f;
-        vadConfig.releaseThreshold = 12.0f;
-        vadConfig.hangTimeMs = 2000;        // Increase from 500 to 2000
-        vadConfig.calibrationMs = 2000;
-        vadConfig.calibrationAttackFactor = 0.05f;
-        vadConfig.calibrationReleaseAboveFloor = 10.0f;
-        vadConfig.maxSilenceMs = 3000;      // Add this line - max silence before stopping
-        vadConfig.maxRecordingMs = 10000;   // Add this line - max total recording time
-
-        sadhana::VAD vad(vadConfig);
-        sadhana::VoskASR asr({
-            .modelPath = "models/vosk-model-en-in-0.5",
-            .sampleRate = sadhana::AudioCapture::DEFAULT_SAMPLE_RATE
+        sadhana::RitualAudioProcessor::Config processorConfig;
+        const auto shipped = sadhana::UtterancePipeline::shippedConfig();
+        processorConfig.vadConfig = shipped.vadConfig;
+        processorConfig.suspendVadBuffering = shipped.suspendVadBuffering;
+
+        // The shipped small model decodes every utterance; the large Indian-English
+        // model, when installed, only re-decodes the ones that match poorly
+        auto& asrConfig = processorConfig.asrConfig;
+        asrConfig.modelPath = "models/vosk-model-small-en-us-0.15";
+        asrConfig.sampleRate = sadhana::AudioCapture::DEFAULT_SAMPLE_RATE;
+        if (std::filesystem::exists("models/vosk-model-en-in-0.5")) {
+            asrConfig.escalationModelPaths.push_back("models/vosk-model-en-in-0.5");
+        }
+        processorConfig.overloadPolicy = sadhana::RitualAudioProcessor::OverloadPolicy::Queue;
+        // Short offerings can overlap in decoding; each worker holds its own recognizer
+        processorConfig.asrWorkers = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+
+        processor.setErrorCallback([](const std::string& error) {
+            std::cerr << "Error: " << error << "\n";
         });
 
-        if (!asr.init()) {
+        if (!processor.init(processorConfig)) {
             std::cerr << "Failed to initialize ASR\n";
             return 1;
         }
 
+        std::unique_ptr<sadhana::SessionRecorder> recorder;
+        if (!recorderConfig.directory.empty()) {
+            recorderConfig.inputRate = processorConfig.sampleRate;
+            recorder = std::make_unique<sadhana::SessionRecorder>(recorderConfig);
+            if (!recorder->open()) {
+                return 1;
+            }
+            recorder->recordProgress(*flowManager.snapshot());
+            processor.setRecorder(recorder.get());
+        }
+
+        // Flow timing runs on the audio stream's clock, like VAD and cooldowns
+        flowManager.setClock(processor.getClock());
+        displayManager.setLevelSource([&processor]() { return processor.getCurrentLevel(); });
+
+        sadhana::MetricsExporter metricsExporter;
+        if ((!metricsConfig.filePath.empty() || !metricsConfig.socketPath.empty()) &&
+            !metricsExporter.start(metricsConfig)) {
+            std::cerr << "Failed to start metrics exporter\n";
+            return 1;
+        }
+
+        sadhana::FlowTraceRecorder traceRecorder(processor.getClock());
+        if (!tracePath.empty() && !traceRecorder.open(tracePath)) {
+            std::cerr << "Failed to open trace file: " << tracePath << "\n";
+            return 1;
+        }
+
         // Setup keyboard handler - place this BEFORE starting audio processing
         sadhana::KeyboardHandler keyboardHandler;
 
         // Set up the progress callback for display updates
-        flowManager.setProgressCallback([&displayManager, &ritual](const sadhana::FlowProgress& progress) {
-            std::cout << "Debug: Progress callback triggered\n" << std::flush;
-            displayManager.updateDisplay(progress, ritual, -60.0f);
+        // The keyword spotter only runs while the section has an iteration marker to count,
+        // escalation to the larger model follows the section's recognition threshold, and
+        // nothing is decoded while the flow waits for a manual advance
+        auto syncPipeline = [&processor, &flowManager](const sadhana::FlowProgress& progress) {
+            processor.followFlow(flowManager, progress);
+        };
+        syncPipeline(*flowManager.snapshot());
+
+        displayManager.publish(flowManager.snapshot());
+
+        // Runs on the flow's thread; the loop draws the change right away instead of
+        // waiting for the next frame tick
+        bool displayStarted = false;  // loop thread only
+        bool completeShown = false;   // flow thread only
+        flowManager.setProgressCallback([&](const sadhana::FlowManager::ProgressSnapshot& progress) {
+            SADHANA_LOG_DEBUG("main", "Progress callback triggered");
+            syncPipeline(*progress);
+            displayManager.publish(progress);
+            if (progressPage) {
+                progressPage->publish(*progress);
+            }
+            if (eventStream) {
+                eventStream->publishProgress(*progress);
+            }
+            if (recorder) {
+                recorder->recordProgress(*progress);
+            }
+            if (!completeShown && progress->complete) {
+                displayManager.showMessage("Ritual complete! Press Ctrl+C to exit.");
+                completeShown = true;
+            }
+            eventLoop.post([&displayManager, &displayStarted]() {
+                if (displayStarted) {
+                    displayManager.renderFrame();
+                }
+            });
         });
 
         // Set up the space key callback
-        keyboardHandler.setSpaceCallback([&flowManager, &displayManager, &ritual]() {
-            std::cout << "Debug: Space callback triggered\n" << std::flush;
-            flowManager.handleManualIntervention();
-            const auto& progress = flowManager.getCurrentProgress();
-            displayManager.updateDisplay(progress, ritual, -60.0f);
-            displayManager.requestUpdate();
+        // The flow's progress callback publishes the new state to the display
+        keyboardHandler.setSpaceCallback([&flowManager, &traceRecorder, &recorder]() {
+            SADHANA_LOG_DEBUG("main", "Space callback triggered");
+            traceRecorder.recordManualAdvance();
+            if (recorder) {
+                recorder->recordManualAdvance();
+            }
+            flowManager.postManualIntervention();
         });
+        keyboardHandler.setQuitCallback([]() { eventLoop.stop(); });
 
         // Start keyboard handling
-        std::cout << "Debug: Starting keyboard handler\n" << std::flush;
-        keyboardHandler.start();
+        SADHANA_LOG_DEBUG("main", "Starting keyboard handler");
+        if (!keyboardHandler.start(eventLoop)) {
+            std::cerr << "Failed to start keyboard handler\n";
+            return 1;
+        }
 
         // Calibration Phase
         std::cout << "\n=== Calibration Phase ===\n";
         std::cout << "Please remain quiet for 2 seconds while we calibrate background noise levels...\n";
+        if (sadhana::Logger::instance().toConsole()) {
+            std::cout << "Only errors are logged to the terminal while the display runs; use --log-file for the rest.\n";
+        }
 
-        bool calibrating = true;
-        bool recording = false;
-        std::vector<float> speechBuffer;
-        int calibrationSamplesRemaining = 
-            vadConfig.calibrationMs * (sadhana::AudioCapture::DEFAULT_SAMPLE_RATE / 1000);
+        // From here on the display's frame timer owns the terminal
+        processor.setCalibrationCallback([&displayManager, &displayStarted]() {
+            displayManager.showMessage(
+                "Calibration complete! Speak mantras clearly, or press SPACE to advance manually.");
+            eventLoop.post([&displayManager, &displayStarted]() {
+                displayStarted = true;
+                // Lines written to stderr would land in the middle of the frame
+                sadhana::Logger::instance().setConsoleFloor(sadhana::LogLevel::Error);
+                eventLoop.addTimer(std::chrono::milliseconds(0), displayManager.frameInterval(),
+                                   [&displayManager]() { displayManager.renderFrame(); });
+            });
+        });
 
-        // Start audio processing
-        audio.start(sadhana::AudioCapture::DEFAULT_SAMPLE_RATE,
-                   sadhana::AudioCapture::DEFAULT_FRAMES_PER_BUFFER,
-                   [&](const float* samples, size_t numSamples) {
-            if (calibrating) {
-                vad.calibrate(samples, numSamples);
-                calibrationSamplesRemaining -= numSamples;
-                if (calibrationSamplesRemaining <= 0) {
-                    calibrating = false;
-                    {
-                        std::lock_guard<std::mutex> lock(consoleMutex);
-                        std::cout << "\n=== Ritual Phase ===\n";
-                        std::cout << "Calibration complete! You can now:\n";
-                        std::cout << "- Speak mantras clearly into the microphone\n";
-                        std::cout << "- Press SPACE if you need to manually advance\n\n";
-                        std::cout << "Current Status:\n";
-                        std::cout << "---------------\n";
-                    }
-                }
-                return;
+        // Recognized text from the pipeline's match stage is posted to the flow; the match
+        // thread goes straight back to its queue
+        processor.setTranscriptionCallback([&](const sadhana::UtterancePipeline::Transcript& transcript) {
+            const auto& text = transcript.text;
+            const float confidence = transcript.match.confidence;
+            displayManager.showMessage("Recognized: \"" + text + "\"");
+            if (progressPage) {
+                progressPage->publishRecognized(text, confidence);
             }
-
-            float currentLevel = calculateRMSdB(samples, numSamples);
-            bool wasSpeechActive = vad.isSpeechActive();
-            bool isSpeechActive = vad.process(samples, numSamples);
-
-            if (isSpeechActive && !recording) {
-                recording = true;
-                speechBuffer.clear();
+            if (eventStream) {
+                eventStream->publishRecognized(text, confidence);
             }
-
-            if (recording) {
-                speechBuffer.insert(speechBuffer.end(), samples, samples + numSamples);
+            if (recorder) {
+                recorder->recordRecognized(text, confidence);
             }
+            traceRecorder.recordRecognized(text, confidence);
+            flowManager.postRecognizedPhrase(text, transcript.match, transcript.assets,
+                                             transcript.decodeMs, transcript.traceId, transcript.startNs);
+        });
 
-            if (recording && (!isSpeechActive && wasSpeechActive)) {
-                std::string result = asr.processAudio(speechBuffer.data(), speechBuffer.size());
-                try {
-                    auto j = nlohmann::json::parse(result);
-                    if (j.contains("text")) {
-                        std::string text = j["text"];
-                        if (!text.empty()) {
-                            {
-                                std::lock_guard<std::mutex> lock(consoleMutex);
-                                std::cout << "Debug: Raw Vosk output: " << result << std::endl;
-                                displayManager.showMessage("Recognized: \"" + text + "\"");
-                            }
-                            
-                            // Only try to handle the phrase if we got actual text
-                            flowManager.handleRecognizedPhrase(text, 0.8f);
-                            displayManager.requestUpdate();  // Request display update after handling
-                        }
-                    }
-                } catch (...) {}
-                recording = false;
-                speechBuffer.clear();
+        std::unique_ptr<sadhana::UtteranceLogWriter> analytics;
+        if (!analyticsPath.empty()) {
+            sadhana::UtteranceLogWriter::Config analyticsConfig;
+            analyticsConfig.path = analyticsPath;
+            analytics = std::make_unique<sadhana::UtteranceLogWriter>(analyticsConfig);
+            std::string analyticsError;
+            if (!analytics->open(&analyticsError)) {
+                std::cerr << "Failed to open analytics file: " << analyticsError << "\n";
+                return 1;
             }
+            // One session per run, named by its start time
+            std::time_t now = std::time(nullptr);
+            char sessionName[32];
+            std::strftime(sessionName, sizeof(sessionName), "live-%Y%m%d-%H%M%S", std::localtime(&now));
+            analytics->setSession(sessionName);
+            flowManager.setUtteranceLog(analytics.get());
+        }
 
-// In the audio callback, replace the existing display update logic with:
-if (!calibrating) {
-    // Only show display updates in two cases:
-    // 1. When speech is processed and recognized
-    // 2. When space key is pressed (already handled in keyboard callback)
-    
-    // Initial display after calibration
-    static bool initialDisplay = true;
-    if (initialDisplay) {
-        const auto& progress = flowManager.getCurrentProgress();
-        displayManager.updateDisplay(progress, ritual, currentLevel);
-        initialDisplay = false;
-    }
-    
-    // Only update display when we have recognized speech
-    if (recording && (!isSpeechActive && wasSpeechActive)) {
-        std::string result = asr.processAudio(speechBuffer.data(), speechBuffer.size());
-        try {
-            auto j = nlohmann::json::parse(result);
-            if (j.contains("text")) {
-                std::string text = j["text"];
-                if (!text.empty()) {
-                    {
-                        std::lock_guard<std::mutex> lock(consoleMutex);
-                        std::cout << "Debug: Raw Vosk output: " << result << std::endl;
-                        displayManager.showMessage("Recognized: \"" + text + "\"");
-                    }
-                    
-                    // Handle the recognized phrase
-                    flowManager.handleRecognizedPhrase(text, 0.8f);
-                    // Update display after handling the phrase
-                    displayManager.requestUpdate();
+        flowManager.start();
+
+        // Edited variants reach the matchers without a restart; a bundle the
+        // flow refuses (changed sections, bad settings) leaves both as they are
+        std::unique_ptr<sadhana::RitualWatcher> watcher;
+        if (watchRitual) {
+            sadhana::RitualWatcher::Config watcherConfig;
+            watcherConfig.ritualPath = ritualEntry.definitionPath;
+            watcherConfig.flowPath = ritualEntry.flowPath;
+            watcher = std::make_unique<sadhana::RitualWatcher>(watcherConfig);
+            watcher->setReloadCallback([&flowManager, &processor, &progressPage](
+                                           std::shared_ptr<const sadhana::RitualAssets> assets, double reloadMs) {
+                std::string error;
+                if (!flowManager.reload(assets, &error)) {
+                    SADHANA_LOG_WARN("main", "Not applying the edited ritual: ", error);
+                    return false;
                 }
+                processor.reload(assets);
+                // The display picks the new text up on its next frame; the page
+                // is only written on changes, so it is republished here
+                if (progressPage) {
+                    progressPage->publish(*flowManager.snapshot());
+                }
+                SADHANA_LOG_INFO("main", "Ritual generation ", flowManager.assetsGeneration(),
+                                 " in use, compiled in ", reloadMs, " ms");
+                return true;
+            });
+            if (!watcher->start()) {
+                watcher.reset();
             }
-        } catch (...) {}
-        recording = false;
-        speechBuffer.clear();
-    }
-}
-        });
+        }
 
-        while (running) {
-            std::cout << "." << std::flush;  // Visual indicator that the main loop is running
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            if (flowManager.isComplete()) {
-                displayManager.showMessage("Ritual complete! Press Ctrl+C to exit.");
+        // Producers stop before what they write to is closed; the flow is
+        // running from here on, so every exit goes through this
+        auto shutdown = [&]() {
+            if (watcher) {
+                watcher->stop();
+            }
+            keyboardHandler.stop();
+            processor.stop();
+            flowManager.stop();
+            if (analytics) {
+                analytics->close();
+            }
+            if (journal) {
+                journal->close();
+            }
+            if (recorder) {
+                recorder->close();
             }
+            displayManager.finish();
+            sadhana::Logger::instance().setConsoleFloor(sadhana::LogLevel::Trace);
+            sadhana::Logger::instance().flush();
+        };
+
+        // Start audio processing
+        if (!processor.start()) {
+            std::cerr << "Failed to start audio processing\n";
+            shutdown();
+            return 1;
         }
 
-        keyboardHandler.stop();
-        audio.stop();
+        eventLoop.run();
+        shutdown();
+
+        if (sadhana::Tracer::compiledIn && !spanTracePath.empty()) {
+            if (sadhana::Tracer::writeChromeTrace(spanTracePath)) {
+                std::cout << "\nWrote latency trace to " << spanTracePath << "\n";
+            } else {
+                std::cerr << "Failed to write latency trace: " << spanTracePath << "\n";
+            }
+        }
+
+        auto stats = processor.getStats();
+        auto printStage = [](const char* name, const sadhana::RitualAudioProcessor::StageStats& stage) {
+            std::cout << "  " << name << ": depth " << stage.queueDepth << "/" << stage.queueCapacity
+                      << ", processed " << stage.processed
+                      << ", avg " << std::fixed << std::setprecision(2) << stage.avgServiceMs << " ms"
+                      << ", max " << stage.maxServiceMs << " ms\n";
+        };
+        std::cout << "\nPipeline stats:\n";
+        printStage("vad", stats.vad);
+        printStage("asr", stats.asr);
+        printStage("match", stats.match);
+        std::cout << "  audio overruns: " << stats.audioOverruns
+                  << ", merged: " << stats.utterancesMerged
+                  << ", dropped: " << stats.utterancesDropped << "\n";
+        std::cout << "  asr workers: " << stats.asrWorkers
+                  << ", stolen jobs: " << stats.asrStolenJobs << "\n";
+        printStage("kws", stats.kws);
+        std::cout << "  kws templates: " << stats.kwsTemplates
+                  << ", hits: " << stats.kwsHits
+                  << ", fallbacks: " << stats.kwsFallbacks << "\n";
+        for (size_t tier = 0; tier < stats.asrTiers.size(); ++tier) {
+            printStage(("asr tier " + std::to_string(tier)).c_str(), stats.asrTiers[tier]);
+        }
+        std::cout << "  decodes skipped while paused: " << stats.decodesSkipped
+                  << " (paused " << std::setprecision(1) << stats.suspendedSeconds << " s)\n";
+        std::cout << "  admission:";
+        for (const auto& [reason, count] : stats.admission) {
+            std::cout << " " << reason << "=" << count;
+        }
+        std::cout << "\n";
+        std::cout << "  cpu: " << stats.cpuSeconds << " s over " << stats.wallSeconds << " s wall\n";
+        std::cout << "  escalations: " << stats.escalations
+                  << " (" << std::setprecision(1) << stats.escalationRate * 100.0 << "%), "
+                  << stats.escalationsKept << " kept the first result\n";
+        if (journal) {
+            auto journalStats = journal->stats();
+            std::cout << "  journal: " << journalStats.committed << "/" << journalStats.appended
+                      << " records committed in " << journalStats.commits << " syncs"
+                      << ", snapshots " << journalStats.snapshots
+                      << ", dropped " << journalStats.dropped << "\n";
+        }
+        if (recorder) {
+            auto recorderStats = recorder->stats();
+            std::cout << "  recording: " << recorderStats.recordedSeconds << " s to " << recorder->audioPath()
+                      << ", " << recorderStats.events << " events"
+                      << ", dropped blocks " << recorderStats.droppedBlocks
+                      << ", max write " << recorderStats.maxWriteMs << " ms"
+                      << (recorderStats.directIo ? " (O_DIRECT)" : "") << "\n";
+        }
+        if (watcher) {
+            auto watcherStats = watcher->stats();
+            std::cout << "  ritual reloads: " << watcherStats.reloads << ", refused or failed " << watcherStats.failures;
+            if (watcherStats.reloads > 0) {
+                std::cout << ", generation " << flowManager.assetsGeneration()
+                          << " (version " << watcherStats.version << ")"
+                          << ", last compiled in " << watcherStats.lastReloadMs << " ms";
+            }
+            std::cout << "\n";
+        }
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,325 @@
+#include "analytics/utterance_log.hpp"
+#include "log/logger.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+namespace {
+
+constexpr uint32_t FILE_MAGIC = 0x41554453;   // "SDUA"
+constexpr uint32_t CHUNK_MAGIC = 0x4b4e4843;  // "CHNK"
+constexpr uint32_t FORMAT_VERSION = 1;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t columns;
+    uint32_t reserved;
+};
+
+struct ChunkHeader {
+    uint32_t magic;
+    uint32_t rows;
+    uint32_t dictionaryEntries;
+    uint32_t reserved;
+    uint64_t dictionaryBytes;  // padded
+    uint64_t payloadBytes;     // dictionary and columns, padded
+};
+static_assert(sizeof(FileHeader) == 16, "analytics file header layout");
+static_assert(sizeof(ChunkHeader) == 32, "analytics chunk header layout");
+
+size_t padded(size_t bytes) {
+    return (bytes + 7) & ~size_t{7};
+}
+
+// Visits the columns in file order with their vectors
+template <typename Chunk, typename F>
+void forEachColumn(Chunk& chunk, F&& f) {
+    f(UtteranceChunk::Session, chunk.session);
+    f(UtteranceChunk::WallMs, chunk.wallMs);
+    f(UtteranceChunk::StreamMs, chunk.streamMs);
+    f(UtteranceChunk::Kind, chunk.kind);
+    f(UtteranceChunk::Accepted, chunk.accepted);
+    f(UtteranceChunk::Section, chunk.section);
+    f(UtteranceChunk::Part, chunk.part);
+    f(UtteranceChunk::Transcript, chunk.transcript);
+    f(UtteranceChunk::Marker, chunk.marker);
+    f(UtteranceChunk::Confidence, chunk.confidence);
+    f(UtteranceChunk::DecodeMs, chunk.decodeMs);
+    f(UtteranceChunk::Repetition, chunk.repetition);
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readAt(int fd, void* data, size_t size, uint64_t offset) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = ::pread(fd, bytes, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        bytes += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+void setError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+}
+
+}
+
+UtteranceLogWriter::UtteranceLogWriter(const Config& config) : config_(config) {}
+
+UtteranceLogWriter::~UtteranceLogWriter() {
+    close();
+}
+
+bool UtteranceLogWriter::open(std::string* error) {
+    if (fd_ >= 0) return true;
+
+    // An existing file keeps its dictionary; anything after the last whole chunk goes
+    uint64_t validBytes = 0;
+    ids_.clear();
+    dictionarySize_ = 0;
+    {
+        UtteranceLogReader reader;
+        std::string readError;
+        if (reader.open(config_.path, &readError)) {
+            UtteranceChunk skipped;
+            while (reader.next(skipped, 0)) {}
+            for (const auto& entry : reader.dictionary()) {
+                ids_.emplace(entry, dictionarySize_++);
+            }
+            validBytes = reader.validBytes();
+        } else if (struct stat st; ::stat(config_.path.c_str(), &st) == 0 && st.st_size > 0) {
+            // A zero-length file is one created by a run that died before the header
+            setError(error, readError);
+            return false;
+        }
+    }
+
+    fd_ = ::open(config_.path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        setError(error, config_.path + ": " + std::strerror(errno));
+        return false;
+    }
+    if (validBytes == 0) {
+        FileHeader header{FILE_MAGIC, FORMAT_VERSION, UtteranceChunk::COLUMN_COUNT, 0};
+        if (ftruncate(fd_, 0) < 0 || !writeAll(fd_, &header, sizeof(header))) {
+            setError(error, config_.path + ": " + std::strerror(errno));
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+    } else if (ftruncate(fd_, static_cast<off_t>(validBytes)) < 0 ||
+               lseek(fd_, static_cast<off_t>(validBytes), SEEK_SET) < 0) {
+        setError(error, config_.path + ": " + std::strerror(errno));
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    pendingEntries_.clear();
+    session_ = intern("");
+    return true;
+}
+
+void UtteranceLogWriter::close() {
+    if (fd_ < 0) return;
+    flush();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+uint32_t UtteranceLogWriter::intern(const std::string& value) {
+    auto [it, inserted] = ids_.emplace(value, dictionarySize_);
+    if (inserted) {
+        ++dictionarySize_;
+        pendingEntries_.push_back(value);
+    }
+    return it->second;
+}
+
+void UtteranceLogWriter::setSession(const std::string& session) {
+    if (fd_ < 0) return;
+    session_ = intern(session);
+}
+
+void UtteranceLogWriter::append(const UtteranceRecord& record) {
+    if (fd_ < 0) return;
+
+    uint32_t section = intern(record.section);
+    if (buffer_.rows > 0 && buffer_.section.back() != section) {
+        flush();
+    }
+
+    buffer_.session.push_back(session_);
+    buffer_.wallMs.push_back(record.wallMs);
+    buffer_.streamMs.push_back(record.streamMs);
+    buffer_.kind.push_back(static_cast<uint8_t>(record.kind));
+    buffer_.accepted.push_back(record.accepted ? 1 : 0);
+    buffer_.section.push_back(section);
+    buffer_.part.push_back(intern(record.part));
+    buffer_.transcript.push_back(intern(record.transcript));
+    buffer_.marker.push_back(intern(record.marker));
+    buffer_.confidence.push_back(record.confidence);
+    buffer_.decodeMs.push_back(record.decodeMs);
+    buffer_.repetition.push_back(record.repetition);
+    ++buffer_.rows;
+    const int64_t ageMs = record.wallMs - buffer_.wallMs.front();
+    if (buffer_.rows >= config_.chunkRows || ageMs >= static_cast<int64_t>(config_.flushSeconds * 1000.0)) {
+        flush();
+    }
+}
+
+bool UtteranceLogWriter::flush() {
+    if (fd_ < 0) return false;
+    if (buffer_.rows == 0) return true;
+
+    size_t dictionaryBytes = 0;
+    for (const auto& entry : pendingEntries_) {
+        dictionaryBytes += sizeof(uint32_t) + entry.size();
+    }
+    dictionaryBytes = padded(dictionaryBytes);
+    size_t columnBytes = 0;
+    forEachColumn(buffer_, [&](auto, const auto& column) {
+        columnBytes += padded(column.size() * sizeof(column[0]));
+    });
+
+    ChunkHeader header{CHUNK_MAGIC, static_cast<uint32_t>(buffer_.rows),
+                       static_cast<uint32_t>(pendingEntries_.size()), 0,
+                       dictionaryBytes, dictionaryBytes + columnBytes};
+    chunkBytes_.assign(sizeof(header) + header.payloadBytes, 0);
+    char* out = chunkBytes_.data();
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    char* dictionary = out;
+    for (const auto& entry : pendingEntries_) {
+        auto length = static_cast<uint32_t>(entry.size());
+        std::memcpy(dictionary, &length, sizeof(length));
+        std::memcpy(dictionary + sizeof(length), entry.data(), entry.size());
+        dictionary += sizeof(length) + entry.size();
+    }
+    out += dictionaryBytes;
+    forEachColumn(buffer_, [&](auto, const auto& column) {
+        size_t bytes = column.size() * sizeof(column[0]);
+        std::memcpy(out, column.data(), bytes);
+        out += padded(bytes);
+    });
+
+    // A failed write would leave later chunks referring to entries that never
+    // reached the file, so the writer stops rather than carrying on
+    if (!writeAll(fd_, chunkBytes_.data(), chunkBytes_.size())) {
+        SADHANA_LOG_ERROR("analytics", "Failed to write analytics to ", config_.path, ": ", std::strerror(errno));
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    rowsWritten_ += buffer_.rows;
+    buffer_.rows = 0;
+    forEachColumn(buffer_, [](auto, auto& column) { column.clear(); });
+    pendingEntries_.clear();
+    return true;
+}
+
+UtteranceLogReader::~UtteranceLogReader() {
+    close();
+}
+
+bool UtteranceLogReader::open(const std::string& path, std::string* error) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        setError(error, path + ": " + std::strerror(errno));
+        return false;
+    }
+    struct stat st{};
+    FileHeader header{};
+    if (fstat(fd_, &st) < 0 || !readAt(fd_, &header, sizeof(header), 0) ||
+        header.magic != FILE_MAGIC || header.version != FORMAT_VERSION ||
+        header.columns != UtteranceChunk::COLUMN_COUNT) {
+        setError(error, path + ": not an analytics file (or another format version)");
+        close();
+        return false;
+    }
+    fileSize_ = static_cast<uint64_t>(st.st_size);
+    offset_ = sizeof(header);
+    dictionary_.clear();
+    return true;
+}
+
+void UtteranceLogReader::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool UtteranceLogReader::next(UtteranceChunk& chunk, uint32_t columns) {
+    if (fd_ < 0 || offset_ + sizeof(ChunkHeader) > fileSize_) return false;
+
+    ChunkHeader header{};
+    if (!readAt(fd_, &header, sizeof(header), offset_) || header.magic != CHUNK_MAGIC ||
+        header.dictionaryBytes > header.payloadBytes ||
+        offset_ + sizeof(header) + header.payloadBytes > fileSize_) {
+        return false;
+    }
+    uint64_t base = offset_ + sizeof(header);
+
+    // Dictionary entries are needed even when no string column is read, so
+    // that later chunks' ids line up
+    if (header.dictionaryEntries > 0) {
+        dictionaryBytes_.resize(header.dictionaryBytes);
+        if (!readAt(fd_, dictionaryBytes_.data(), dictionaryBytes_.size(), base)) return false;
+        size_t pos = 0;
+        for (uint32_t i = 0; i < header.dictionaryEntries; ++i) {
+            uint32_t length = 0;
+            if (pos + sizeof(length) > dictionaryBytes_.size()) return false;
+            std::memcpy(&length, dictionaryBytes_.data() + pos, sizeof(length));
+            pos += sizeof(length);
+            if (pos + length > dictionaryBytes_.size()) return false;
+            dictionary_.emplace_back(dictionaryBytes_.data() + pos, length);
+            pos += length;
+        }
+    }
+
+    bool ok = true;
+    uint64_t columnOffset = base + header.dictionaryBytes;
+    forEachColumn(chunk, [&](UtteranceChunk::Column id, auto& column) {
+        size_t bytes = header.rows * sizeof(column[0]);
+        if (ok && (columns & (1u << id))) {
+            column.resize(header.rows);
+            ok = readAt(fd_, column.data(), bytes, columnOffset);
+        } else {
+            column.clear();
+        }
+        columnOffset += padded(bytes);
+    });
+    if (!ok) return false;
+
+    chunk.rows = header.rows;
+    offset_ = base + header.payloadBytes;
+    return true;
+}
+
+}
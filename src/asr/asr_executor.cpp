@@ -0,0 +1,194 @@
+#include "asr/asr_executor.hpp"
+#include "trace/tracer.hpp"
+#include "log/logger.hpp"
+
+namespace sadhana {
+
+AsrExecutor::AsrExecutor(const VoskASR& asr, const Config& config)
+    : asr_(asr), config_(config) {
+    if (config_.workers == 0) {
+        config_.workers = 1;
+    }
+}
+
+AsrExecutor::~AsrExecutor() {
+    stop();
+}
+
+bool AsrExecutor::start(ResultCallback callback, WorkerFreeCallback workerFree) {
+    if (running_) return false;
+
+    callback_ = std::move(callback);
+    workerFree_ = std::move(workerFree);
+    nextToDeliver_ = 0;
+    delivering_ = false;
+    reorderBuffer_.clear();
+
+    workers_.clear();
+    for (size_t i = 0; i < config_.workers; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->recognizers.resize(asr_.tierCount());
+        worker->recognizers[0] = asr_.createRecognizer();
+        if (!worker->recognizers[0]) {
+            SADHANA_LOG_ERROR("asr", "Failed to create Vosk recognizer for worker ", i);
+            // No worker may run, or it would steal jobs it cannot decode
+            workers_.clear();
+            return false;
+        }
+        workers_.push_back(std::move(worker));
+    }
+
+    running_ = true;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread([this, i]() { runWorker(i); });
+    }
+    return true;
+}
+
+void AsrExecutor::stop() {
+    if (!running_) return;
+
+    running_ = false;
+    pending_.release(static_cast<std::ptrdiff_t>(workers_.size()));
+    submitted_.notify();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    workers_.clear();
+
+    // Jobs left in the deques, and results parked behind one of them, are lost
+    std::lock_guard<std::mutex> lock(reorderMutex_);
+    abandonedJobs_.fetch_add(inFlight_.exchange(0) + reorderBuffer_.size(), std::memory_order_relaxed);
+    reorderBuffer_.clear();
+}
+
+bool AsrExecutor::submit(Job job) {
+    if (!running_ || workers_.empty()) return false;
+
+    size_t index = nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    inFlight_.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->jobs.push_back(std::move(job));
+    }
+    submitted_.notify();
+    pending_.release();
+    return true;
+}
+
+void AsrExecutor::submitDecoded(Result result) {
+    result.tier = 0;
+    result.decoded = false;
+    deliver(std::move(result));
+}
+
+// Own deque first (oldest job, so decode order roughly follows speech order),
+// then steal the newest job from another worker's deque
+bool AsrExecutor::takeJob(size_t index, Job& job) {
+    {
+        auto& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.front());
+            own.jobs.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+        auto& victim = *workers_[(index + offset) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.back());
+            victim.jobs.pop_back();
+            stolenJobs_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsrExecutor::runWorker(size_t index) {
+    SADHANA_TRACE_THREAD("asr-worker");
+    auto& worker = *workers_[index];
+    Job job;
+
+    while (true) {
+        pending_.acquire();
+        if (!running_) break;
+
+        // The permit means a job is queued for this worker. A scan can still
+        // miss it: another worker takes from a deque not yet visited while the
+        // job lands in one already passed. That job's submit bumps the signal.
+        for (;;) {
+            uint32_t seen = submitted_.current();
+            if (takeJob(index, job)) break;
+            if (!running_) return;
+            submitted_.wait(seen);
+        }
+
+        SADHANA_TRACE_CONTEXT(job.traceId);
+        SADHANA_TRACE_RECORD("asr.queue", job.traceId, job.queuedNs, Tracer::timestamp());
+
+        auto begin = std::chrono::steady_clock::now();
+        Result result;
+        result.sequence = job.sequence;
+        result.tier = job.tier;
+        result.endTime = job.endTime;
+        result.worker = index;
+        result.traceId = job.traceId;
+        result.audioSeconds = job.samples.size() / static_cast<double>(asr_.getConfig().sampleRate);
+        result.startNs = job.startNs;
+        if (job.tier < worker.recognizers.size()) {
+            auto& recognizer = worker.recognizers[job.tier];
+            if (!recognizer) {
+                recognizer = asr_.createRecognizer(job.tier);
+                if (!recognizer) {
+                    // Decodes to nothing, so the smaller model's result stands
+                    SADHANA_LOG_ERROR("asr", "Failed to create tier ", job.tier,
+                                      " recognizer for worker ", index);
+                }
+            }
+            result.json = VoskASR::decode(recognizer.get(), job.samples.data(), job.samples.size());
+        }
+        result.decodeTime = std::chrono::steady_clock::now() - begin;
+
+        inFlight_.fetch_sub(1, std::memory_order_acq_rel);
+        if (workerFree_) {
+            workerFree_();
+        }
+        deliver(std::move(result));
+    }
+}
+
+// Whichever worker finds the next sequence ready delivers it, and anything
+// queued behind it; the others leave their result in the buffer and go back
+// to decoding. The lock is dropped around the callback so a slow consumer
+// never holds up a worker that only needs to park a result.
+void AsrExecutor::deliver(Result result) {
+    std::unique_lock<std::mutex> lock(reorderMutex_);
+    uint64_t sequence = result.sequence;
+    reorderBuffer_.insert_or_assign(sequence, std::move(result));
+    if (delivering_) return;
+
+    delivering_ = true;
+    auto it = reorderBuffer_.begin();
+    while (it != reorderBuffer_.end() && it->first == nextToDeliver_) {
+        Result ready = std::move(it->second);
+        reorderBuffer_.erase(it);
+
+        lock.unlock();
+        bool resolved = !callback_ || callback_(ready);
+        lock.lock();
+
+        if (resolved) {
+            ++nextToDeliver_;
+        }
+        it = reorderBuffer_.begin();
+    }
+    delivering_ = false;
+}
+
+}
@@ -0,0 +1,227 @@
+#include "asr/keyword_spotter.hpp"
+#include "audio/resampler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace sadhana {
+
+namespace {
+
+float hzToMel(float hz) { return 2595.0f * std::log10(1.0f + hz / 700.0f); }
+float melToHz(float mel) { return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f); }
+
+// Kept as a flat loop over contiguous floats so the compiler vectorizes it
+float squaredDistance(const float* a, const float* b, size_t dims) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dims; ++i) {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+}
+
+KeywordSpotter::KeywordSpotter(const Config& config)
+    : config_(config),
+      fft_(static_cast<size_t>(config.featureRate * config.frameMs / 1000)) {
+    if (config_.featureRate <= 0) {
+        config_.featureRate = config_.sampleRate;
+        fft_ = Fft(static_cast<size_t>(config_.featureRate * config_.frameMs / 1000));
+    }
+    frameLength_ = static_cast<size_t>(config_.featureRate * config_.frameMs / 1000);
+    hopLength_ = std::max<size_t>(1, static_cast<size_t>(config_.featureRate * config_.hopMs / 1000));
+    window_ = Fft::hannWindow(frameLength_);
+
+    buildMelFilters();
+}
+
+void KeywordSpotter::buildMelFilters() {
+    const size_t bins = fft_.size() / 2 + 1;
+    const float melLow = hzToMel(20.0f);
+    const float melHigh = hzToMel(config_.featureRate / 2.0f);
+
+    std::vector<float> edges(config_.melBands + 2);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        float mel = melLow + (melHigh - melLow) * i / (edges.size() - 1);
+        edges[i] = melToHz(mel) * fft_.size() / config_.featureRate;
+    }
+
+    melFilters_.clear();
+    for (int band = 0; band < config_.melBands; ++band) {
+        float left = edges[band], center = edges[band + 1], right = edges[band + 2];
+        MelFilter filter;
+        filter.firstBin = static_cast<size_t>(std::ceil(left));
+        size_t lastBin = std::min(bins - 1, static_cast<size_t>(std::floor(right)));
+        for (size_t bin = filter.firstBin; bin <= lastBin; ++bin) {
+            float w = bin <= center ? (bin - left) / (center - left) : (right - bin) / (right - center);
+            filter.weights.push_back(std::max(0.0f, w));
+        }
+        melFilters_.push_back(std::move(filter));
+    }
+}
+
+KeywordSpotter::Features KeywordSpotter::extractFeatures(const float* samples, size_t numSamples) const {
+    Features features;
+    features.dims = melFilters_.size();
+
+    // Band-limited, so energy above the feature band does not fold into the mel bands
+    std::vector<float> signal;
+    signal.reserve(numSamples * config_.featureRate / config_.sampleRate + 1);
+    Resampler resampler(config_.sampleRate, config_.featureRate);
+    auto emit = [&signal](float sample) { signal.push_back(sample); };
+    resampler.process(samples, numSamples, emit);
+    resampler.finish(emit);
+
+    if (signal.size() < frameLength_) {
+        return features;
+    }
+
+    features.frames = (signal.size() - frameLength_) / hopLength_ + 1;
+    features.data.resize(features.frames * features.dims);
+
+    std::vector<std::complex<float>> spectrum;
+    std::vector<float> power;
+
+    for (size_t f = 0; f < features.frames; ++f) {
+        const float* frame = signal.data() + f * hopLength_;
+        fft_.powerSpectrum(frame, window_.data(), frameLength_, spectrum, power);
+
+        float* out = features.data.data() + f * features.dims;
+        for (size_t band = 0; band < melFilters_.size(); ++band) {
+            const auto& filter = melFilters_[band];
+            const float* p = power.data() + filter.firstBin;
+            float energy = 0.0f;
+            for (size_t i = 0; i < filter.weights.size(); ++i) {
+                energy += filter.weights[i] * p[i];
+            }
+            out[band] = std::log(energy + 1e-10f);
+        }
+    }
+
+    // Per-utterance mean normalization removes mic gain and channel colouring
+    std::vector<float> mean(features.dims, 0.0f);
+    for (size_t f = 0; f < features.frames; ++f) {
+        const float* row = features.frame(f);
+        for (size_t d = 0; d < features.dims; ++d) mean[d] += row[d];
+    }
+    for (auto& m : mean) m /= features.frames;
+    for (size_t f = 0; f < features.frames; ++f) {
+        float* row = features.data.data() + f * features.dims;
+        for (size_t d = 0; d < features.dims; ++d) row[d] -= mean[d];
+    }
+
+    return features;
+}
+
+float KeywordSpotter::dtwDistance(const Features& a, const Features& b) const {
+    if (a.frames == 0 || b.frames == 0 || a.dims != b.dims) {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    const float inf = std::numeric_limits<float>::infinity();
+    const size_t n = a.frames, m = b.frames;
+    const size_t band = std::max<size_t>(
+        static_cast<size_t>(config_.bandFraction * std::max(n, m)),
+        n > m ? n - m : m - n) + 1;
+
+    std::vector<float> prev(m + 1, inf), curr(m + 1, inf);
+    prev[0] = 0.0f;
+
+    for (size_t i = 1; i <= n; ++i) {
+        std::fill(curr.begin(), curr.end(), inf);
+        size_t center = i * m / n;
+        size_t lo = center > band ? center - band : 1;
+        size_t hi = std::min(m, center + band);
+        for (size_t j = std::max<size_t>(lo, 1); j <= hi; ++j) {
+            float cost = std::sqrt(squaredDistance(a.frame(i - 1), b.frame(j - 1), a.dims));
+            curr[j] = cost + std::min({prev[j], curr[j - 1], prev[j - 1]});
+        }
+        std::swap(prev, curr);
+    }
+
+    return prev[m] / static_cast<float>(n + m);
+}
+
+bool KeywordSpotter::enroll(const std::string& key, Features features, const std::string& transcript) {
+    if (features.frames == 0) return isEnrolled(key);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& set = sets_[key];
+    if (set.templates.size() >= config_.enrollmentCount) {
+        return true;
+    }
+    set.templates.push_back({std::move(features), transcript});
+    updateThreshold(set);
+    return set.templates.size() >= config_.enrollmentCount;
+}
+
+void KeywordSpotter::updateThreshold(TemplateSet& set) const {
+    const auto& templates = set.templates;
+    if (templates.size() < 2) {
+        set.threshold = 0.0f;
+        return;
+    }
+
+    float sum = 0.0f;
+    int pairs = 0;
+    for (size_t i = 0; i < templates.size(); ++i) {
+        for (size_t j = i + 1; j < templates.size(); ++j) {
+            sum += dtwDistance(templates[i].features, templates[j].features);
+            ++pairs;
+        }
+    }
+    set.threshold = config_.acceptFactor * sum / pairs;
+}
+
+KeywordSpotter::SpotResult KeywordSpotter::spot(const std::string& key, const Features& features) const {
+    SpotResult result;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sets_.find(key);
+    if (it == sets_.end() || it->second.templates.size() < config_.enrollmentCount || features.frames == 0) {
+        return result;
+    }
+    const auto& set = it->second;
+
+    result.distance = std::numeric_limits<float>::infinity();
+    result.threshold = set.threshold;
+    for (const auto& tmpl : set.templates) {
+        float ratio = static_cast<float>(features.frames) / tmpl.features.frames;
+        if (ratio > config_.maxLengthRatio || ratio < 1.0f / config_.maxLengthRatio) {
+            continue;
+        }
+        float distance = dtwDistance(features, tmpl.features);
+        if (distance < result.distance) {
+            result.distance = distance;
+            result.transcript = tmpl.transcript;
+        }
+    }
+
+    if (set.threshold > 0.0f && std::isfinite(result.distance)) {
+        result.confidence = std::clamp(1.0f - 0.5f * result.distance / set.threshold, 0.0f, 1.0f);
+        result.accepted = result.distance <= set.threshold;
+    }
+    return result;
+}
+
+bool KeywordSpotter::isEnrolled(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sets_.find(key);
+    return it != sets_.end() && it->second.templates.size() >= config_.enrollmentCount;
+}
+
+size_t KeywordSpotter::templateCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& [key, set] : sets_) count += set.templates.size();
+    return count;
+}
+
+void KeywordSpotter::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sets_.clear();
+}
+
+}
@@ -1,4 +1,5 @@
 #include "asr/vosk_asr.hpp"
+#include "trace/tracer.hpp"
 #include <vector>
 #include <iostream>
 #include <algorithm>
@@ -8,55 +9,62 @@ namespace sadhana {
 bool VoskASR::init() {
     vosk_set_log_level(-1);
 
-    auto* model = vosk_model_new(config_.modelPath.c_str());
-    if (!model) {
-        std::cerr << "Failed to create Vosk model\n";
-        return false;
-    }
-    model_.reset(model);
+    models_.clear();
 
-    auto* recognizer = vosk_recognizer_new(model_.get(), config_.sampleRate);
-    if (!recognizer) {
-        std::cerr << "Failed to create Vosk recognizer\n";
-        model_.reset();
-        return false;
+    std::vector<std::string> paths{config_.modelPath};
+    paths.insert(paths.end(), config_.escalationModelPaths.begin(), config_.escalationModelPaths.end());
+    for (const auto& path : paths) {
+        auto* model = vosk_model_new(path.c_str());
+        if (!model) {
+            std::cerr << "Failed to create Vosk model: " << path << "\n";
+            models_.clear();
+            return false;
+        }
+        models_.emplace_back(model);
     }
-    recognizer_.reset(recognizer);
-
-    vosk_recognizer_set_partial_words(recognizer_.get(), 1);
 
     return true;
 }
 
-std::string VoskASR::processAudio(const float* samples, size_t numSamples) {
-    if (!recognizer_) {
+VoskASR::RecognizerPtr VoskASR::createRecognizer(size_t tier) const {
+    if (tier >= models_.size()) {
+        return nullptr;
+    }
+
+    RecognizerPtr recognizer(vosk_recognizer_new(models_[tier].get(), config_.sampleRate));
+    if (recognizer) {
+        vosk_recognizer_set_partial_words(recognizer.get(), 1);
+    }
+    return recognizer;
+}
+
+std::string VoskASR::decode(VoskRecognizer* recognizer, const float* samples, size_t numSamples) {
+    if (!recognizer) {
         return "";
     }
 
     std::vector<int16_t> pcmSamples;
     pcmSamples.reserve(numSamples);
-    
-    for (size_t i = 0; i < numSamples; ++i) {
-        float sample = samples[i];
-        sample = std::max(-1.0f, std::min(1.0f, sample));
-        pcmSamples.push_back(static_cast<int16_t>(sample * 32767.0f));
+    {
+        SADHANA_TRACE_SPAN("asr.convert");
+        for (size_t i = 0; i < numSamples; ++i) {
+            float sample = samples[i];
+            sample = std::max(-1.0f, std::min(1.0f, sample));
+            pcmSamples.push_back(static_cast<int16_t>(sample * 32767.0f));
+        }
     }
 
+    SADHANA_TRACE_SPAN("asr.decode");
     const size_t CHUNK_SIZE = 8192;
     for (size_t offset = 0; offset < pcmSamples.size(); offset += CHUNK_SIZE) {
         size_t chunk = std::min(CHUNK_SIZE, pcmSamples.size() - offset);
-        vosk_recognizer_accept_waveform(recognizer_.get(), 
+        vosk_recognizer_accept_waveform(recognizer, 
                                       reinterpret_cast<const char*>(pcmSamples.data() + offset), 
                                       chunk * sizeof(int16_t));
     }
 
-    const char* result = vosk_recognizer_final_result(recognizer_.get());
-    
-    std::cout << "\nDebug: Processed " << numSamples << " samples, PCM size: "
-              << pcmSamples.size() << std::endl;
-    std::cout << "Debug: Raw Vosk output: " << (result ? result : "null") << std::endl;
-
+    const char* result = vosk_recognizer_final_result(recognizer);
     return result ? result : "";
 }
 
-}
\ No newline at end of file
+}
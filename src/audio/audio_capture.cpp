@@ -4,7 +4,11 @@
 
 namespace sadhana {
 
-AudioCapture::AudioCapture() {
+AudioCapture::AudioCapture()
+    : inputOverflows_(MetricsRegistry::instance().counter(
+          "sadhana_audio_input_overflows_total", "Input buffers PortAudio flagged as overflowed (samples lost)")),
+      inputUnderflows_(MetricsRegistry::instance().counter(
+          "sadhana_audio_input_underflows_total", "Input buffers PortAudio flagged as underflowed")) {
     PaError err = Pa_Initialize();
     if (err != paNoError) {
         throw std::runtime_error("Failed to initialize PortAudio: " + 
@@ -120,11 +124,16 @@ int AudioCapture::paCallback(const void* input, void* output,
                            PaStreamCallbackFlags statusFlags,
                            void* userData) {
     (void)output;
-    (void)timeInfo;
-    (void)statusFlags;
-    
+
     auto* self = static_cast<AudioCapture*>(userData);
+    if (statusFlags & paInputOverflow) {
+        self->inputOverflows_.inc();
+    }
+    if (statusFlags & paInputUnderflow) {
+        self->inputUnderflows_.inc();
+    }
     const float* inputBuffer = static_cast<const float*>(input);
+    self->currentAdcTime_ = timeInfo ? timeInfo->inputBufferAdcTime : 0.0;
     
     if (self->dataCallback_) {
         self->dataCallback_(inputBuffer, frameCount);
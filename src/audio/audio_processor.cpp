@@ -1,45 +1,123 @@
 #include "audio/audio_processor.hpp"
-#include <nlohmann/json.hpp>
+#include "audio/session_recorder.hpp"
+#include "host/ritual_assets.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <ctime>
 
 namespace sadhana {
 
+namespace {
+
+double processCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+}
+
 RitualAudioProcessor::RitualAudioProcessor(const RitualDefinition& ritual)
-    : ritual_(ritual),
-      audioCapture_(std::make_unique<AudioCapture>()),
-      phraseManager_(std::make_unique<PhraseManager>(ritual)) {
+    : audioCapture_(std::make_unique<AudioCapture>()),
+      audioOverrunsMetric_(MetricsRegistry::instance().counter(
+          "sadhana_audio_queue_overruns_total", "Audio blocks dropped because the VAD stage fell behind")),
+      utterancesDroppedMetric_(MetricsRegistry::instance().counter(
+          "sadhana_utterances_dropped_total", "Utterances never recognized: ASR fell too far behind, or the pipeline stopped")) {
+    // The caller keeps the definition alive, as before reloads existed
+    auto assets = std::make_shared<RitualAssets>();
+    assets->ritual = std::shared_ptr<const RitualDefinition>(&ritual, [](const RitualDefinition*) {});
+    assets->matcher = std::make_shared<const PhraseManager>(ritual);
+    initialAssets_ = std::move(assets);
 }
 
 RitualAudioProcessor::~RitualAudioProcessor() {
     stop();
 }
 
+void RitualAudioProcessor::reload(std::shared_ptr<const RitualAssets> assets) {
+    if (!assets || !assets->ritual || !assets->matcher) return;
+    if (pipeline_) {
+        pipeline_->reload(std::move(assets));
+    } else {
+        initialAssets_ = std::move(assets);
+    }
+}
+
 bool RitualAudioProcessor::init(const Config& config) {
     config_ = config;
 
-    vad_ = std::make_unique<VAD>(config.vadConfig);
-    vad_->setStateChangeCallback([this](bool active) {
-        handleSpeechStateChange(active);
-    });
+    if (config.clockSource == ClockSource::Samples) {
+        sampleClock_ = std::make_unique<SampleClock>(config.sampleRate);
+        clock_ = sampleClock_.get();
+    } else {
+        sampleClock_.reset();
+        clock_ = &SteadyClock::instance();
+    }
 
     asr_ = std::make_unique<VoskASR>(config.asrConfig);
     if (!asr_->init()) {
         notifyError("Failed to initialize ASR system");
         return false;
     }
+    asrExecutor_ = std::make_unique<AsrExecutor>(*asr_, AsrExecutor::Config{
+        .workers = config.asrWorkers
+    });
+    pipeline_ = std::make_unique<UtterancePipeline>(*asr_, *clock_, initialAssets_, UtterancePipeline::Config{
+        .sampleRate = config.sampleRate,
+        .vadConfig = config.vadConfig,
+        .enableKeywordSpotter = config.enableKeywordSpotter,
+        .kwsConfig = config.kwsConfig,
+        .kwsMinConfidence = config.kwsMinConfidence,
+        .retainedUtterances = config.retainedUtterances,
+        .suspendVadBuffering = config.suspendVadBuffering,
+        .prerollMs = config.prerollMs,
+        .admission = config.admission
+    });
+    pipeline_->setCalibrationCallback([this]() {
+        if (calibrationCallback_) {
+            calibrationCallback_();
+        }
+    });
+
+    audioQueue_ = std::make_unique<SpscQueue<AudioBlock>>(config.audioQueueBlocks);
+    utteranceQueue_ = std::make_unique<SpscQueue<Utterance>>(config.utteranceQueueDepth);
+    transcriptQueue_ = std::make_unique<SpscQueue<Transcript>>(config.transcriptQueueDepth);
 
     return true;
 }
 
 bool RitualAudioProcessor::start() {
-    if (running_) return false;
+    if (running_ || !pipeline_) return false;
 
-    return audioCapture_->start(
+    if (!asrExecutor_->start(
+            [this](const AsrExecutor::Result& result) { return handleDecoded(result); },
+            [this]() { asrSignal_.notify(); })) {
+        notifyError("Failed to start ASR workers");
+        return false;
+    }
+    nextAsrSequence_ = 0;
+    startTime_ = std::chrono::steady_clock::now();
+    startCpuSeconds_ = processCpuSeconds();
+    running_ = true;
+
+    vadThread_ = std::thread([this]() { runVadStage(); });
+    asrThread_ = std::thread([this]() { runAsrStage(); });
+    matchThread_ = std::thread([this]() { runMatchStage(); });
+
+    // The callback thread must not allocate its trace ring itself
+    SADHANA_TRACE_PREPARE_REALTIME("audio-callback");
+    bool started = audioCapture_->start(
         config_.sampleRate,
         config_.framesPerBuffer,
         [this](const float* samples, size_t numSamples) {
             handleAudioData(samples, numSamples);
         }
     );
+
+    if (!started) {
+        stop();
+    }
+    return started;
 }
 
 void RitualAudioProcessor::stop() {
@@ -47,6 +125,47 @@ void RitualAudioProcessor::stop() {
         audioCapture_->stop();
     }
     running_ = false;
+
+    vadSignal_.notify();
+    asrSignal_.notify();
+    matchSignal_.notify();
+    transcriptSpace_.notify();
+
+    for (auto* thread : {&vadThread_, &asrThread_, &matchThread_}) {
+        if (thread->joinable()) {
+            thread->join();
+        }
+    }
+    uint64_t abandoned = 0;
+    if (asrExecutor_) {
+        uint64_t before = asrExecutor_->abandonedJobs();
+        asrExecutor_->stop();
+        abandoned = asrExecutor_->abandonedJobs() - before;
+    }
+
+    // Whatever was still waiting for ASR or the match stage is counted, not silently lost
+    for (const auto& utterance : utteranceBacklog_) {
+        abandoned += utterance.mergedCount;
+    }
+    utteranceBacklog_.clear();
+    backlogSamples_ = 0;
+    backlogSize_.store(0, std::memory_order_relaxed);
+    if (utteranceQueue_) {
+        Utterance utterance;
+        while (utteranceQueue_->tryPop(utterance)) {
+            abandoned += utterance.mergedCount;
+        }
+    }
+    if (transcriptQueue_) {
+        Transcript transcript;
+        while (transcriptQueue_->tryPop(transcript)) {
+            ++abandoned;
+        }
+    }
+    if (abandoned > 0) {
+        dropUtterances(abandoned);
+        SADHANA_LOG_WARN("audio", "Stopped with ", abandoned, " utterances not yet recognized");
+    }
 }
 
 bool RitualAudioProcessor::setAudioDevice(int deviceIndex) {
@@ -57,41 +176,304 @@ std::vector<AudioDevice> RitualAudioProcessor::listAudioDevices() const {
     return audioCapture_ ? audioCapture_->listDevices() : std::vector<AudioDevice>();
 }
 
+RitualAudioProcessor::PipelineStats RitualAudioProcessor::getStats() const {
+    PipelineStats stats;
+    if (!audioQueue_) return stats;
+
+    auto pipeline = pipeline_->stats();
+    stats.vad = pipeline.vad;
+    stats.vad.queueDepth = audioQueue_->size();
+    stats.vad.queueCapacity = audioQueue_->capacity();
+    stats.asr = pipeline.asr;
+    stats.asr.queueDepth = utteranceQueue_->size() + backlogSize_.load(std::memory_order_relaxed);
+    stats.asr.queueCapacity = utteranceQueue_->capacity();
+    stats.match = pipeline.match;
+    stats.match.queueDepth = transcriptQueue_->size();
+    stats.match.queueCapacity = transcriptQueue_->capacity();
+    stats.audioOverruns = audioOverruns_.load(std::memory_order_relaxed);
+    stats.utterancesMerged = utterancesMerged_.load(std::memory_order_relaxed);
+    stats.utterancesDropped = utterancesDropped_.load(std::memory_order_relaxed);
+    stats.asrWorkers = asrExecutor_->workerCount();
+    stats.asrInFlight = asrExecutor_->inFlight();
+    stats.asrStolenJobs = asrExecutor_->stolenJobs();
+    stats.kws = pipeline.kws;
+    stats.kwsTemplates = pipeline.kwsTemplates;
+    stats.kwsHits = pipeline.kwsHits;
+    stats.kwsFallbacks = pipeline.kwsFallbacks;
+    stats.asrTiers = std::move(pipeline.asrTiers);
+    stats.decodesSkipped = pipeline.decodesSkipped;
+    stats.suspendedSeconds = pipeline.suspendedSeconds;
+    stats.cpuSeconds = processCpuSeconds() - startCpuSeconds_;
+    stats.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+    stats.admission = std::move(pipeline.admission);
+    stats.escalations = pipeline.escalations;
+    stats.escalationRate = pipeline.escalationRate;
+    stats.escalationsKept = pipeline.escalationsKept;
+    return stats;
+}
+
+// Runs on the PortAudio thread: copy into the ring and get out
 void RitualAudioProcessor::handleAudioData(const float* samples, size_t numSamples) {
-    if (!vad_ || !asr_) return;
+    if (!running_) return;
+    SADHANA_TRACE_REALTIME_THREAD();
+    SADHANA_TRACE_SPAN("capture");
+    if (recorder_) {
+        recorder_->pushAudio(samples, numSamples);
+    }
+
+    for (size_t offset = 0; offset < numSamples; offset += MAX_BLOCK_FRAMES) {
+        size_t count = std::min(MAX_BLOCK_FRAMES, numSamples - offset);
+        bool pushed = audioQueue_->tryPushWith([&](AudioBlock& block) {
+            std::copy(samples + offset, samples + offset + count, block.samples.begin());
+            block.count = count;
+            block.adcTime = audioCapture_->currentInputAdcTime() +
+                            static_cast<double>(offset) / config_.sampleRate;
+        });
+        if (!pushed) {
+            audioOverruns_.fetch_add(1, std::memory_order_relaxed);
+            audioOverrunsMetric_.inc();
+        }
+    }
+    vadSignal_.notify();
+}
+
+void RitualAudioProcessor::runVadStage() {
+    SADHANA_TRACE_THREAD("vad");
+    AudioBlock block;
+    while (true) {
+        uint32_t seen = vadSignal_.current();
+        if (!audioQueue_->tryPop(block)) {
+            if (!running_) break;
+            vadSignal_.wait(seen);
+            continue;
+        }
+
+        if (sampleClock_) {
+            sampleClock_->advance(block.count, block.adcTime);
+        }
+        if (auto utterance = pipeline_->processBlock(block.samples.data(), block.count)) {
+            emitUtterance(std::move(*utterance));
+        }
+        flushBacklog();
+    }
+}
+
+void RitualAudioProcessor::emitUtterance(Utterance utterance) {
+    // Keep ordering: nothing jumps ahead of utterances already held back.
+    // tryPushWith only moves on success; tryPush would empty it either way.
+    if (utteranceBacklog_.empty() &&
+        utteranceQueue_->tryPushWith([&utterance](Utterance& slot) { slot = std::move(utterance); })) {
+        asrSignal_.notify();
+        return;
+    }
+
+    const size_t maxSamples = static_cast<size_t>(config_.backlogSeconds * config_.sampleRate);
+    switch (config_.overloadPolicy) {
+        case OverloadPolicy::Queue:
+            backlogSamples_ += utterance.samples.size();
+            utteranceBacklog_.push_back(std::move(utterance));
+            break;
+        case OverloadPolicy::Merge:
+            // A merge that would run past the audio limit starts a new entry
+            // instead, and the limit below then drops the old one
+            if (utteranceBacklog_.empty() || backlogSamples_ + utterance.samples.size() > maxSamples) {
+                backlogSamples_ += utterance.samples.size();
+                utteranceBacklog_.push_back(std::move(utterance));
+            } else {
+                auto& pending = utteranceBacklog_.back();
+                pending.samples.insert(pending.samples.end(),
+                                       utterance.samples.begin(), utterance.samples.end());
+                pending.mergedCount += utterance.mergedCount;
+                backlogSamples_ += utterance.samples.size();
+                utterancesMerged_.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+        case OverloadPolicy::Drop:
+            dropUtterances(utterance.mergedCount);
+            break;
+    }
+
+    // Past either limit the oldest audio goes first; the newest utterance is
+    // always kept, so the flow hears the most recent offering
+    while (utteranceBacklog_.size() > 1 &&
+           (utteranceBacklog_.size() > config_.backlogUtterances || backlogSamples_ > maxSamples)) {
+        backlogSamples_ -= utteranceBacklog_.front().samples.size();
+        dropUtterances(utteranceBacklog_.front().mergedCount);
+        utteranceBacklog_.pop_front();
+    }
+    backlogSize_.store(utteranceBacklog_.size(), std::memory_order_relaxed);
+}
+
+void RitualAudioProcessor::dropUtterances(uint64_t count) {
+    utterancesDropped_.fetch_add(count, std::memory_order_relaxed);
+    utterancesDroppedMetric_.inc(count);
+}
+
+void RitualAudioProcessor::flushBacklog() {
+    bool pushed = false;
+    while (!utteranceBacklog_.empty()) {
+        auto& front = utteranceBacklog_.front();
+        size_t samples = front.samples.size();
+        if (!utteranceQueue_->tryPushWith([&front](Utterance& slot) { slot = std::move(front); })) break;
+        utteranceBacklog_.pop_front();
+        backlogSamples_ -= samples;
+        pushed = true;
+    }
+    backlogSize_.store(utteranceBacklog_.size(), std::memory_order_relaxed);
+    if (pushed) {
+        asrSignal_.notify();
+    }
+}
+
+// Dispatches to the executor, holding back while every worker is busy so
+// overload still shows up as a full utterance queue for the VAD stage
+void RitualAudioProcessor::runAsrStage() {
+    SADHANA_TRACE_THREAD("asr-dispatch");
+    Utterance utterance;
+    while (true) {
+        uint32_t seen = asrSignal_.current();
+        if (asrExecutor_->inFlight() >= asrExecutor_->workerCount() ||
+            !utteranceQueue_->tryPop(utterance)) {
+            if (!running_) break;
+            asrSignal_.wait(seen);
+            continue;
+        }
+
+        if (pipeline_->discardIfSuspended()) {
+            vadSignal_.notify();
+            continue;
+        }
 
-    bool wasSpeechActive = speechActive_;
-    speechActive_ = vad_->process(samples, numSamples);
+        SADHANA_TRACE_RECORD("vad.queue", utterance.traceId, utterance.endNs, Tracer::timestamp());
+        SADHANA_TRACE_CONTEXT(utterance.traceId);
+        uint64_t sequence = nextAsrSequence_++;
+        if (auto spotted = pipeline_->spotKeyword(sequence, utterance)) {
+            // Passes through the executor so it keeps its place among the decodes
+            AsrExecutor::Result result;
+            result.sequence = sequence;
+            result.json = std::move(*spotted);
+            result.endTime = utterance.endTime;
+            result.traceId = utterance.traceId;
+            result.startNs = utterance.startNs;
+            asrExecutor_->submitDecoded(std::move(result));
+        } else {
+            pipeline_->retainForEscalation(sequence, utterance);
+            asrExecutor_->submit({
+                .sequence = sequence,
+                .samples = std::move(utterance.samples),
+                .endTime = utterance.endTime,
+                .traceId = utterance.traceId,
+                .startNs = utterance.startNs,
+                .queuedNs = Tracer::timestamp()
+            });
+        }
+        // The queue has room again
+        vadSignal_.notify();
+    }
+}
 
-    if (speechActive_ && !wasSpeechActive) {
-        speechBuffer_.clear();
+// Executor results arrive here already back in utterance order, one at a
+// time; returns false when the utterance went to a larger model instead
+bool RitualAudioProcessor::handleDecoded(const AsrExecutor::Result& result) {
+    if (result.decoded) {
+        pipeline_->recordDecode(result.tier, result.decodeTime, result.audioSeconds);
     }
 
-    if (speechActive_) {
-        speechBuffer_.insert(speechBuffer_.end(), samples, samples + numSamples);
+    Transcript transcript;
+    transcript.sequence = result.sequence;
+    transcript.tier = result.tier;
+    transcript.endTime = result.endTime;
+    transcript.traceId = result.traceId;
+    transcript.startNs = result.startNs;
+    transcript.decodeMs = std::chrono::duration<float, std::milli>(result.decodeTime).count();
+    transcript.text = UtterancePipeline::parseText(result.json);
+
+    Utterance rerun;
+    switch (pipeline_->resolve(transcript, &rerun)) {
+        case UtterancePipeline::Verdict::Empty:
+            return true;
+        case UtterancePipeline::Verdict::Escalate:
+            // The sequence stays open in the executor until the larger model answers
+            if (asrExecutor_->submit({
+                    .sequence = transcript.sequence,
+                    .samples = std::move(rerun.samples),
+                    .tier = transcript.tier + 1,
+                    .endTime = rerun.endTime,
+                    .traceId = rerun.traceId,
+                    .startNs = rerun.startNs,
+                    .queuedNs = Tracer::timestamp()
+                })) {
+                return false;
+            }
+            transcript = pipeline_->abandonEscalation(transcript.sequence);
+            break;
+        case UtterancePipeline::Verdict::Deliver:
+            break;
     }
 
-    if (!speechActive_ && wasSpeechActive && !speechBuffer_.empty()) {
-        std::string result = asr_->processAudio(speechBuffer_.data(), speechBuffer_.size());
-        processTranscription(result);
-        speechBuffer_.clear();
+    // The match stage is cheap, so a full queue only means it is momentarily
+    // behind. The executor has already dropped its lock, so waiting here holds
+    // up this worker alone; the others keep parking results in the buffer.
+    while (true) {
+        uint32_t seen = transcriptSpace_.current();
+        if (transcriptQueue_->tryPush(transcript)) break;
+        if (!running_) {
+            dropUtterances(1);
+            return true;
+        }
+        transcriptSpace_.wait(seen);
     }
+    matchSignal_.notify();
+    return true;
 }
 
-void RitualAudioProcessor::handleSpeechStateChange(bool active) {
-    speechActive_ = active;
+void RitualAudioProcessor::runMatchStage() {
+    SADHANA_TRACE_THREAD("match");
+    Transcript transcript;
+    while (true) {
+        uint32_t seen = matchSignal_.current();
+        if (!transcriptQueue_->tryPop(transcript)) {
+            if (!running_) break;
+            matchSignal_.wait(seen);
+            continue;
+        }
+        transcriptSpace_.notify();
+
+        auto begin = std::chrono::steady_clock::now();
+        SADHANA_TRACE_CONTEXT(transcript.traceId);
+        processTranscription(transcript);
+        // Speech onset to the phrase being posted to the flow; "utterance",
+        // onset to display, is closed by the redraw that shows the change
+        SADHANA_TRACE_RECORD("utterance.matched", transcript.traceId, transcript.startNs, Tracer::timestamp());
+        pipeline_->recordMatch(std::chrono::steady_clock::now() - begin);
+    }
 }
 
-void RitualAudioProcessor::processTranscription(const std::string& text) {
+void RitualAudioProcessor::processTranscription(const Transcript& transcript) {
+    const auto& match = transcript.match;
+    const auto& assets = transcript.assets;
+
+    pipeline_->accept(transcript);
     if (transcriptionCallback_) {
-        transcriptionCallback_(text);
+        transcriptionCallback_(transcript);
     }
 
-    auto result = phraseManager_->matchPhrase(text);
-    if (!result.matchedText.empty()) {
-        if (!isInCooldown(result.matchedText)) {
-            updateMarkerState(result.matchedText,
-                ritual_.getCooldownForMarker(result.matchedText).value_or(700));
+    if (!match.matchedText.empty()) {
+        // Cooldowns are measured at the end of the utterance in stream time,
+        // so decode latency and replay speed do not change the outcome
+        if (!isInCooldown(match.matchedText, transcript.endTime)) {
+            updateMarkerState(match.matchedText,
+                assets->ritual->getCooldownForMarker(match.matchedText).value_or(700), transcript.endTime);
+
+            ProcessingResult result{
+                .sectionId = match.sectionId,
+                .partId = match.partId,
+                .stepId = match.stepId,
+                .matchedText = match.matchedText,
+                .markerType = match.markerType,
+                .confidence = match.confidence,
+                .additionalData = match.additionalData
+            };
             updateProgress(result);
             if (resultCallback_) {
                 resultCallback_(result);
@@ -125,20 +507,23 @@ void RitualAudioProcessor::updateProgress(const ProcessingResult& result) {
     }
 }
 
-bool RitualAudioProcessor::isInCooldown(const std::string& markerId) const {
+bool RitualAudioProcessor::isInCooldown(const std::string& markerId, TimePoint at) const {
     auto it = markerStates_.find(markerId);
     if (it == markerStates_.end()) return false;
 
-    auto now = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - it->second.lastTriggerTime).count();
+        at - it->second.lastTriggerTime).count();
 
-    return elapsed < it->second.cooldownMs;
+    // An utterance that ended before the last trigger is a separate offering
+    // that arrived late, not a repeat of it
+    return elapsed >= 0 && elapsed < it->second.cooldownMs;
 }
 
-void RitualAudioProcessor::updateMarkerState(const std::string& markerId, int cooldownMs) {
+void RitualAudioProcessor::updateMarkerState(const std::string& markerId, int cooldownMs, TimePoint at) {
+    auto it = markerStates_.find(markerId);
+    if (it != markerStates_.end() && at < it->second.lastTriggerTime) return;
     markerStates_[markerId] = {
-        .lastTriggerTime = std::chrono::steady_clock::now(),
+        .lastTriggerTime = at,
         .cooldownMs = cooldownMs
     };
 }
@@ -149,4 +534,4 @@ void RitualAudioProcessor::notifyError(const std::string& error) {
     }
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,74 @@
+#include "audio/resampler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace sadhana {
+
+namespace {
+
+// Passband edge as a fraction of the lower Nyquist frequency
+constexpr double ROLLOFF = 0.9;
+
+// Input consumed by every future output is dropped once this much piles up
+constexpr uint64_t TRIM_SAMPLES = 4096;
+
+}
+
+Resampler::Resampler(int fromRate, int toRate)
+    : from_(static_cast<uint64_t>(std::max(fromRate, 1))),
+      to_(static_cast<uint64_t>(std::max(toRate, 1))) {
+    if (passthrough()) return;
+
+    // Cutoff relative to the input Nyquist; the kernel widens as it narrows
+    const double cutoff = ROLLOFF * std::min(1.0, static_cast<double>(to_) / static_cast<double>(from_));
+    const double halfWidth = ZERO_CROSSINGS / cutoff;
+    halfTaps_ = static_cast<int64_t>(std::ceil(halfWidth));
+
+    kernel_.assign(static_cast<size_t>(halfTaps_ * TABLE_STEPS + 2), 0.0f);
+    for (size_t i = 0; i < kernel_.size(); ++i) {
+        double t = static_cast<double>(i) / TABLE_STEPS;
+        if (t >= halfWidth) break;
+        double x = M_PI * cutoff * t;
+        double sinc = i == 0 ? 1.0 : std::sin(x) / x;
+        double w = M_PI * t / halfWidth;
+        double window = 0.42 + 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+        kernel_[i] = static_cast<float>(cutoff * sinc * window);
+    }
+}
+
+void Resampler::reset() {
+    history_.clear();
+    base_ = 0;
+    received_ = 0;
+    next_ = 0;
+}
+
+float Resampler::sampleAt(uint64_t whole, uint64_t remainder) const {
+    const double frac = static_cast<double>(remainder) / static_cast<double>(to_);
+    const int64_t center = static_cast<int64_t>(whole);
+    const int64_t first = std::max<int64_t>(center - halfTaps_ + 1, 0);
+    const int64_t last = center + halfTaps_;
+
+    double sum = 0.0;
+    for (int64_t k = first; k <= last; ++k) {
+        // Distance from the output's position, in kernel table steps
+        double t = std::abs(static_cast<double>(k - center) - frac) * TABLE_STEPS;
+        auto index = static_cast<size_t>(t);
+        if (index + 1 >= kernel_.size()) continue;
+        float weight = kernel_[index] + (kernel_[index + 1] - kernel_[index]) * static_cast<float>(t - index);
+        sum += weight * history_[static_cast<size_t>(static_cast<uint64_t>(k) - base_)];
+    }
+    return static_cast<float>(sum);
+}
+
+void Resampler::trim() {
+    // The next output reads from its position minus the half width on
+    const uint64_t whole = next_ * from_ / to_;
+    const uint64_t keep = whole + 1 > static_cast<uint64_t>(halfTaps_) ? whole + 1 - halfTaps_ : 0;
+    if (keep < base_ + TRIM_SAMPLES) return;
+    size_t drop = static_cast<size_t>(std::min<uint64_t>(keep - base_, history_.size()));
+    history_.erase(history_.begin(), history_.begin() + static_cast<std::ptrdiff_t>(drop));
+    base_ += drop;
+}
+
+}
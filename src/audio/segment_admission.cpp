@@ -0,0 +1,205 @@
+#include "audio/segment_admission.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace sadhana {
+
+SegmentAdmission::SegmentAdmission(int sampleRate)
+    : sampleRate_(sampleRate),
+      decimation_(sampleRate % ANALYSIS_RATE == 0 ? sampleRate / ANALYSIS_RATE : 1),
+      frameLength_(static_cast<size_t>(sampleRate / decimation_ * FRAME_MS / 1000)),
+      fft_(frameLength_),
+      window_(Fft::hannWindow(frameLength_)) {
+}
+
+const char* SegmentAdmission::reasonName(Reason reason) {
+    switch (reason) {
+        case Reason::Admitted: return "admitted";
+        case Reason::TooShort: return "too_short";
+        case Reason::LowVoicing: return "low_voicing";
+        case Reason::NoiseLike: return "noise_like";
+        case Reason::NoPitch: return "no_pitch";
+    }
+    return "unknown";
+}
+
+namespace {
+
+template <typename T>
+void readKey(const nlohmann::json& json, const char* key, T& field, std::vector<std::string>& problems) {
+    auto it = json.find(key);
+    if (it == json.end()) return;
+    bool typed = std::is_same_v<T, bool> ? it->is_boolean() : it->is_number();
+    if (!typed) {
+        problems.push_back(std::string("admission key '") + key + "' has the wrong type");
+        return;
+    }
+    field = it->template get<T>();
+}
+
+void checkRatio(const char* key, float& field, float fallback, std::vector<std::string>& problems) {
+    if (field < 0.0f || field > 1.0f) {
+        problems.push_back(std::string("admission key '") + key + "' must be between 0 and 1");
+        field = fallback;
+    }
+}
+
+}
+
+SegmentAdmission::Config SegmentAdmission::parseConfig(const nlohmann::json& json, Config defaults,
+                                                       std::vector<std::string>& problems) {
+    if (!json.is_object()) {
+        if (!json.is_null()) problems.push_back("admission settings must be an object");
+        return defaults;
+    }
+
+    Config config = defaults;
+    readKey(json, "enabled", config.enabled, problems);
+    readKey(json, "min_duration_ms", config.minDurationMs, problems);
+    readKey(json, "min_voiced_ratio", config.minVoicedRatio, problems);
+    readKey(json, "max_spectral_flatness", config.maxSpectralFlatness, problems);
+    readKey(json, "min_pitched_ratio", config.minPitchedRatio, problems);
+    readKey(json, "min_pitch_hz", config.minPitchHz, problems);
+    readKey(json, "max_pitch_hz", config.maxPitchHz, problems);
+    readKey(json, "pitch_clarity", config.pitchClarity, problems);
+
+    if (config.minDurationMs < 0) {
+        problems.push_back("admission key 'min_duration_ms' must not be negative");
+        config.minDurationMs = defaults.minDurationMs;
+    }
+    checkRatio("min_voiced_ratio", config.minVoicedRatio, defaults.minVoicedRatio, problems);
+    checkRatio("max_spectral_flatness", config.maxSpectralFlatness, defaults.maxSpectralFlatness, problems);
+    checkRatio("min_pitched_ratio", config.minPitchedRatio, defaults.minPitchedRatio, problems);
+    checkRatio("pitch_clarity", config.pitchClarity, defaults.pitchClarity, problems);
+    // pitchClarity() divides the analysis rate by both bounds
+    if (config.minPitchHz <= 0.0f || config.maxPitchHz <= config.minPitchHz) {
+        problems.push_back("admission pitch range needs 0 < min_pitch_hz < max_pitch_hz");
+        config.minPitchHz = defaults.minPitchHz;
+        config.maxPitchHz = defaults.maxPitchHz;
+    }
+    return config;
+}
+
+SegmentAdmission::Config SegmentAdmission::configFromJson(const nlohmann::json& json, Config defaults) {
+    std::vector<std::string> problems;
+    Config config = parseConfig(json, defaults, problems);
+    for (const auto& problem : problems) {
+        SADHANA_LOG_WARN("admission", problem, "; using the default");
+    }
+    return config;
+}
+
+bool SegmentAdmission::validateJson(const nlohmann::json& json, std::string* error) {
+    std::vector<std::string> problems;
+    parseConfig(json, Config{}, problems);
+    if (!problems.empty() && error) *error = problems.front();
+    return problems.empty();
+}
+
+// Peak of the normalized autocorrelation over the allowed pitch lags
+float SegmentAdmission::pitchClarity(const float* frame, const Config& config) const {
+    const int rate = sampleRate_ / static_cast<int>(decimation_);
+    size_t minLag = static_cast<size_t>(rate / config.maxPitchHz);
+    size_t maxLag = std::min(frameLength_ / 2, static_cast<size_t>(rate / config.minPitchHz));
+
+    float energy = 0.0f;
+    for (size_t i = 0; i < frameLength_; ++i) energy += frame[i] * frame[i];
+    if (energy <= 0.0f) return 0.0f;
+
+    float best = 0.0f;
+    for (size_t lag = minLag; lag <= maxLag; ++lag) {
+        float corr = 0.0f, e1 = 0.0f, e2 = 0.0f;
+        for (size_t i = 0; i + lag < frameLength_; ++i) {
+            corr += frame[i] * frame[i + lag];
+            e1 += frame[i] * frame[i];
+            e2 += frame[i + lag] * frame[i + lag];
+        }
+        if (e1 > 0.0f && e2 > 0.0f) {
+            best = std::max(best, corr / std::sqrt(e1 * e2));
+        }
+    }
+    return best;
+}
+
+SegmentAdmission::Verdict SegmentAdmission::evaluate(const float* samples, size_t numSamples,
+                                                     const Config& config) const {
+    Verdict verdict;
+    verdict.durationMs = 1000.0f * numSamples / sampleRate_;
+    if (!config.enabled) return verdict;
+
+    if (verdict.durationMs < config.minDurationMs) {
+        verdict.reason = Reason::TooShort;
+        return verdict;
+    }
+
+    std::vector<float> signal(numSamples / decimation_);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        float sum = 0.0f;
+        for (size_t j = 0; j < decimation_; ++j) sum += samples[i * decimation_ + j];
+        signal[i] = sum / decimation_;
+    }
+
+    size_t frames = signal.size() / frameLength_;
+    if (frames == 0) {
+        verdict.reason = Reason::TooShort;
+        return verdict;
+    }
+
+    // Voicing is judged relative to the loudest frame so mic gain does not matter
+    std::vector<float> frameDb(frames);
+    std::vector<float> zcr(frames);
+    float peakDb = -200.0f;
+    for (size_t f = 0; f < frames; ++f) {
+        const float* frame = signal.data() + f * frameLength_;
+        float sumSquares = 0.0f;
+        size_t crossings = 0;
+        for (size_t i = 0; i < frameLength_; ++i) {
+            sumSquares += frame[i] * frame[i];
+            if (i > 0 && (frame[i] >= 0.0f) != (frame[i - 1] >= 0.0f)) ++crossings;
+        }
+        frameDb[f] = 10.0f * std::log10(sumSquares / frameLength_ + 1e-12f);
+        zcr[f] = static_cast<float>(crossings) / frameLength_;
+        peakDb = std::max(peakDb, frameDb[f]);
+    }
+
+    std::vector<std::complex<float>> scratch;
+    std::vector<float> power;
+    size_t voiced = 0, pitched = 0;
+    float flatnessSum = 0.0f;
+
+    for (size_t f = 0; f < frames; ++f) {
+        if (frameDb[f] < peakDb - 25.0f || zcr[f] > 0.3f) continue;
+        ++voiced;
+
+        const float* frame = signal.data() + f * frameLength_;
+        fft_.powerSpectrum(frame, window_.data(), frameLength_, scratch, power);
+        double logSum = 0.0, linSum = 0.0;
+        for (size_t bin = 1; bin < power.size(); ++bin) {
+            logSum += std::log(power[bin] + 1e-12);
+            linSum += power[bin];
+        }
+        size_t bins = power.size() - 1;
+        flatnessSum += static_cast<float>(std::exp(logSum / bins) / (linSum / bins + 1e-12));
+
+        if (config.minPitchedRatio > 0.0f && pitchClarity(frame, config) >= config.pitchClarity) {
+            ++pitched;
+        }
+    }
+
+    verdict.voicedRatio = static_cast<float>(voiced) / frames;
+    verdict.spectralFlatness = voiced ? flatnessSum / voiced : 1.0f;
+    verdict.pitchedRatio = voiced ? static_cast<float>(pitched) / voiced : 0.0f;
+
+    if (verdict.voicedRatio < config.minVoicedRatio) {
+        verdict.reason = Reason::LowVoicing;
+    } else if (verdict.spectralFlatness > config.maxSpectralFlatness) {
+        verdict.reason = Reason::NoiseLike;
+    } else if (config.minPitchedRatio > 0.0f && verdict.pitchedRatio < config.minPitchedRatio) {
+        verdict.reason = Reason::NoPitch;
+    }
+    return verdict;
+}
+
+}
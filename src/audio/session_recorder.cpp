@@ -0,0 +1,414 @@
+#include "audio/session_recorder.hpp"
+#include "log/logger.hpp"
+#include "trace/tracer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+
+namespace sadhana {
+
+namespace {
+
+void putLE16(unsigned char* p, uint16_t value) {
+    p[0] = static_cast<unsigned char>(value);
+    p[1] = static_cast<unsigned char>(value >> 8);
+}
+
+void putLE32(unsigned char* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+std::string defaultStem() {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char name[64];
+    std::strftime(name, sizeof(name), "session-%Y%m%d-%H%M%S", &local);
+    return name;
+}
+
+bool clearDirectIo(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags & ~O_DIRECT) == 0;
+}
+
+}
+
+SessionRecorder::SessionRecorder(const Config& config)
+    : config_(config)
+    , blocks_(config.queueBlocks)
+    , events_(config.queueEvents)
+    , droppedMetric_(MetricsRegistry::instance().counter(
+          "sadhana_recorder_dropped_blocks_total", "Audio blocks the session recorder dropped because its writer fell behind"))
+    , writeSecondsMetric_(MetricsRegistry::instance().histogram(
+          "sadhana_recorder_write_seconds", "Time spent in each session recorder disk write", 1e-5, 10.0)) {}
+
+SessionRecorder::~SessionRecorder() {
+    close();
+}
+
+int SessionRecorder::outputRate() const {
+    return config_.outputRate > 0 ? config_.outputRate : config_.inputRate;
+}
+
+bool SessionRecorder::open() {
+    if (running_) return true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+    if (ec) {
+        std::cerr << "Failed to create recording directory " << config_.directory << ": " << ec.message() << "\n";
+        return false;
+    }
+    std::string stem = config_.stem.empty() ? defaultStem() : config_.stem;
+    audioPath_ = (std::filesystem::path(config_.directory) / (stem + ".wav")).string();
+    eventsPath_ = (std::filesystem::path(config_.directory) / (stem + ".events.jsonl")).string();
+
+    // tmpfs and some network filesystems refuse O_DIRECT at open time
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    fdDirect_ = false;
+    if (config_.directIo) {
+        audioFd_ = ::open(audioPath_.c_str(), flags | O_DIRECT, 0644);
+        fdDirect_ = audioFd_ >= 0;
+    }
+    directIo_ = fdDirect_;
+    if (audioFd_ < 0) {
+        audioFd_ = ::open(audioPath_.c_str(), flags, 0644);
+    }
+    if (audioFd_ < 0) {
+        std::cerr << "Failed to open " << audioPath_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    eventsFd_ = ::open(eventsPath_.c_str(), flags | O_APPEND, 0644);
+    if (eventsFd_ < 0) {
+        std::cerr << "Failed to open " << eventsPath_ << ": " << std::strerror(errno) << "\n";
+        ::close(audioFd_);
+        audioFd_ = -1;
+        return false;
+    }
+
+    // Whole pages, so every write but the last one is a valid O_DIRECT transfer
+    bufferSize_ = std::max(DIRECT_IO_ALIGNMENT,
+                           config_.writeBufferBytes / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT);
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, bufferSize_) != 0) {
+        std::cerr << "Failed to allocate recorder buffer\n";
+        ::close(audioFd_);
+        ::close(eventsFd_);
+        audioFd_ = eventsFd_ = -1;
+        return false;
+    }
+    buffer_ = static_cast<unsigned char*>(buffer);
+    std::memset(buffer_, 0, WAV_HEADER_BYTES);  // filled in by finalizeHeader()
+    bufferFill_ = WAV_HEADER_BYTES;
+    fileOffset_ = 0;
+    nextSample_ = 0;
+    outputSamples_ = 0;
+    writeFailed_ = false;
+    resampler_ = Resampler(config_.inputRate, outputRate());
+
+    captured_ = 0;
+    capturedPublished_.store(0, std::memory_order_relaxed);
+    haveProgress_ = false;
+
+    running_ = true;
+    writer_ = std::thread([this]() { runWriter(); });
+    return true;
+}
+
+void SessionRecorder::close() {
+    if (!running_.exchange(false)) return;
+    signal_.notify();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    flushBuffer(true);
+    finalizeHeader();
+    fdatasync(audioFd_);
+    ::close(audioFd_);
+    ::close(eventsFd_);
+    audioFd_ = eventsFd_ = -1;
+    std::free(buffer_);
+    buffer_ = nullptr;
+
+    uint64_t dropped = droppedBlocks_.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+        SADHANA_LOG_WARN("recorder", "Dropped ", dropped, " audio blocks (",
+                         droppedSamples_.load(std::memory_order_relaxed), " samples written as silence)");
+    }
+}
+
+void SessionRecorder::pushAudio(const float* samples, size_t count) {
+    if (!running_.load(std::memory_order_relaxed)) return;
+
+    for (size_t offset = 0; offset < count; offset += BLOCK_FRAMES) {
+        size_t n = std::min(BLOCK_FRAMES, count - offset);
+        bool pushed = blocks_.tryPushWith([&](Block& block) {
+            std::copy(samples + offset, samples + offset + n, block.samples.begin());
+            block.count = static_cast<uint32_t>(n);
+            block.start = captured_;
+        });
+        if (!pushed) {
+            droppedBlocks_.fetch_add(1, std::memory_order_relaxed);
+            droppedSamples_.fetch_add(n, std::memory_order_relaxed);
+            droppedMetric_.inc();
+        }
+        captured_ += n;
+    }
+    capturedPublished_.store(captured_, std::memory_order_release);
+    signal_.notify();
+}
+
+void SessionRecorder::recordProgress(const FlowProgress& progress) {
+    if (!running_.load(std::memory_order_relaxed)) return;
+
+    bool moved = !haveProgress_ ||
+                 progress.currentSectionId != lastProgress_.currentSectionId ||
+                 progress.currentPartId != lastProgress_.currentPartId;
+    if (moved) {
+        pushEvent(nlohmann::json{
+            {"event", haveProgress_ ? "section" : "start"},
+            {"section", progress.currentSectionId},
+            {"part", progress.currentPartId},
+            {"repetition", progress.currentRepetition}
+        }.dump());
+    } else if (progress.currentRepetition > lastProgress_.currentRepetition) {
+        // The offering boundary the corpus is annotated with
+        pushEvent(nlohmann::json{
+            {"event", "offering"},
+            {"section", progress.currentSectionId},
+            {"part", progress.currentPartId},
+            {"step", progress.currentStepId},
+            {"repetition", progress.currentRepetition},
+            {"confidence", std::round(progress.lastConfidence * 1000.0) / 1000.0}
+        }.dump());
+    }
+    if (progress.awaitingManualIntervention && (moved || !lastProgress_.awaitingManualIntervention)) {
+        pushEvent(R"({"event":"awaiting_manual"})");
+    }
+    if (progress.complete && (!haveProgress_ || !lastProgress_.complete)) {
+        pushEvent(R"({"event":"complete"})");
+    }
+
+    lastProgress_ = progress;
+    lastProgress_.counts.clear();
+    haveProgress_ = true;
+}
+
+void SessionRecorder::recordRecognized(const std::string& text, float confidence) {
+    if (!running_.load(std::memory_order_relaxed)) return;
+    pushEvent(nlohmann::json{{"event", "recognized"}, {"text", text},
+                                   {"confidence", std::round(confidence * 1000.0) / 1000.0}}.dump());
+}
+
+void SessionRecorder::recordManualAdvance() {
+    if (!running_.load(std::memory_order_relaxed)) return;
+    pushEvent(R"({"event":"manual_advance"})");
+}
+
+void SessionRecorder::pushEvent(const std::string& body) {
+    Event event;
+    event.sample = capturedPublished_.load(std::memory_order_acquire);
+    event.body = body;
+    if (!events_.tryPush(std::move(event))) {
+        droppedEvents_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    signal_.notify();
+}
+
+SessionRecorder::Stats SessionRecorder::stats() const {
+    Stats stats;
+    stats.blocks = blockCount_.load(std::memory_order_relaxed);
+    stats.droppedBlocks = droppedBlocks_.load(std::memory_order_relaxed);
+    stats.droppedSamples = droppedSamples_.load(std::memory_order_relaxed);
+    stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+    stats.events = eventCount_.load(std::memory_order_relaxed);
+    stats.droppedEvents = droppedEvents_.load(std::memory_order_relaxed);
+    stats.recordedSeconds = static_cast<double>(writtenSamples_.load(std::memory_order_relaxed)) / outputRate();
+    stats.maxWriteMs = maxWriteMs_.load(std::memory_order_relaxed);
+    stats.directIo = directIo_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SessionRecorder::runWriter() {
+    SADHANA_TRACE_THREAD("recorder");
+    Block block;
+    Event event;
+
+    for (;;) {
+        uint32_t seen = signal_.current();
+        bool stopping = !running_.load(std::memory_order_acquire);
+        bool worked = false;
+
+        while (blocks_.tryPop(block)) {
+            worked = true;
+            writeSilenceUntil(block.start);
+            writeSamples(block.samples.data(), block.count);
+            nextSample_ = block.start + block.count;
+            blockCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+        while (events_.tryPop(event)) {
+            worked = true;
+            writeEvent(event);
+        }
+
+        if (!worked) {
+            if (stopping) {
+                // Capture has stopped; blocks dropped at the very end still count
+                writeSilenceUntil(capturedPublished_.load(std::memory_order_acquire));
+                resampler_.finish([this](float sample) { appendSample(sample); });
+                break;
+            }
+            signal_.wait(seen);
+        }
+    }
+}
+
+// Blocks the capture side dropped become silence of the same length
+void SessionRecorder::writeSilenceUntil(uint64_t sample) {
+    static const std::array<float, BLOCK_FRAMES> silence{};
+    while (nextSample_ < sample) {
+        size_t gap = static_cast<size_t>(std::min<uint64_t>(BLOCK_FRAMES, sample - nextSample_));
+        writeSamples(silence.data(), gap);
+        nextSample_ += gap;
+    }
+}
+
+void SessionRecorder::writeSamples(const float* samples, size_t count) {
+    // Same filter as resample() for whole files; output lags by the filter's half width
+    resampler_.process(samples, count, [this](float sample) { appendSample(sample); });
+}
+
+void SessionRecorder::appendSample(float sample) {
+    float clamped = std::clamp(sample, -1.0f, 1.0f);
+    auto value = static_cast<int16_t>(std::lrintf(clamped * 32767.0f));
+    putLE16(buffer_ + bufferFill_, static_cast<uint16_t>(value));
+    bufferFill_ += sizeof(int16_t);
+    ++outputSamples_;
+    if (bufferFill_ == bufferSize_) {
+        flushBuffer(false);
+    }
+}
+
+bool SessionRecorder::flushBuffer(bool final) {
+    if (!buffer_ || bufferFill_ == 0) return true;
+    size_t fill = bufferFill_;
+    bufferFill_ = 0;
+    if (writeFailed_) return false;
+
+    // O_DIRECT only takes whole pages; the tail on close goes out as a normal write
+    size_t aligned = final ? fill / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT : fill;
+    if (aligned > 0 && !writeAudio(buffer_, aligned)) return false;
+    if (aligned < fill) {
+        if (fdDirect_) {
+            clearDirectIo(audioFd_);
+            fdDirect_ = false;
+        }
+        if (!writeAudio(buffer_ + aligned, fill - aligned)) return false;
+    }
+    writtenSamples_.store(outputSamples_, std::memory_order_relaxed);
+    return true;
+}
+
+bool SessionRecorder::writeAudio(const void* data, size_t size) {
+    auto start = std::chrono::steady_clock::now();
+    const auto* p = static_cast<const unsigned char*>(data);
+    size_t remaining = size;
+    while (remaining > 0) {
+        ssize_t n = ::write(audioFd_, p, remaining);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            // Some filesystems accept O_DIRECT at open and reject the transfer
+            if (errno == EINVAL && fdDirect_ && clearDirectIo(audioFd_)) {
+                fdDirect_ = false;
+                directIo_ = false;
+                continue;
+            }
+            SADHANA_LOG_ERROR("recorder", "Write to ", audioPath_, " failed: ", std::strerror(errno),
+                              "; audio recording stopped");
+            writeFailed_ = true;
+            return false;
+        }
+        p += n;
+        remaining -= static_cast<size_t>(n);
+    }
+    fileOffset_ += size;
+    bytesWritten_.fetch_add(size, std::memory_order_relaxed);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    writeSecondsMetric_.observe(seconds);
+    if (seconds * 1000.0 > maxWriteMs_.load(std::memory_order_relaxed)) {
+        maxWriteMs_.store(seconds * 1000.0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void SessionRecorder::writeEvent(const Event& event) {
+    // Positions are in the WAV's own samples, so they survive resampling
+    double t = static_cast<double>(event.sample) / config_.inputRate;
+    auto sample = static_cast<uint64_t>(std::llround(t * outputRate()));
+    char prefix[96];
+    int n = std::snprintf(prefix, sizeof(prefix), "{\"t\":%.3f,\"sample\":%llu,", t,
+                          static_cast<unsigned long long>(sample));
+    eventLine_.assign(prefix, static_cast<size_t>(n));
+    eventLine_.append(event.body, 1, std::string::npos);
+    eventLine_ += '\n';
+
+    const char* p = eventLine_.data();
+    size_t remaining = eventLine_.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(eventsFd_, p, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            droppedEvents_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        p += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    eventCount_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool SessionRecorder::finalizeHeader() {
+    if (fdDirect_) {
+        clearDirectIo(audioFd_);
+        fdDirect_ = false;
+    }
+    uint64_t dataBytes = fileOffset_ > WAV_HEADER_BYTES ? fileOffset_ - WAV_HEADER_BYTES : 0;
+    auto rate = static_cast<uint32_t>(outputRate());
+
+    unsigned char header[WAV_HEADER_BYTES];
+    std::memcpy(header, "RIFF", 4);
+    putLE32(header + 4, static_cast<uint32_t>(36 + dataBytes));
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    putLE32(header + 16, 16);
+    putLE16(header + 20, 1);   // PCM
+    putLE16(header + 22, 1);   // mono
+    putLE32(header + 24, rate);
+    putLE32(header + 28, rate * sizeof(int16_t));
+    putLE16(header + 32, sizeof(int16_t));
+    putLE16(header + 34, 16);
+    std::memcpy(header + 36, "data", 4);
+    putLE32(header + 40, static_cast<uint32_t>(dataBytes));
+
+    if (::pwrite(audioFd_, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        std::cerr << "Failed to write WAV header to " << audioPath_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,554 @@
+#include "audio/utterance_pipeline.hpp"
+#include "host/ritual_assets.hpp"
+#include "ritual/flow_manager.hpp"
+#include "trace/tracer.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace sadhana {
+
+void UtterancePipeline::StageCounters::record(std::chrono::steady_clock::duration elapsed) {
+    auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    processed.fetch_add(1, std::memory_order_relaxed);
+    totalNs.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t prevMax = maxNs.load(std::memory_order_relaxed);
+    while (ns > prevMax && !maxNs.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed)) {
+    }
+}
+
+UtterancePipeline::StageStats UtterancePipeline::StageCounters::snapshot() const {
+    StageStats stats;
+    stats.processed = processed.load(std::memory_order_relaxed);
+    if (stats.processed > 0) {
+        stats.avgServiceMs = totalNs.load(std::memory_order_relaxed) / 1e6 / stats.processed;
+    }
+    stats.maxServiceMs = maxNs.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
+
+UtterancePipeline::Config UtterancePipeline::shippedConfig() {
+    Config config;
+    config.vadConfig.attackThreshold = 15.0f;
+    config.vadConfig.releaseThreshold = 12.0f;
+    config.vadConfig.hangTimeMs = 2000;
+    config.vadConfig.calibrationMs = 2000;
+    config.vadConfig.calibrationAttackFactor = 0.05f;
+    config.vadConfig.calibrationReleaseAboveFloor = 10.0f;
+    config.vadConfig.maxSilenceMs = 3000;
+    config.vadConfig.maxRecordingMs = 10000;
+    config.suspendVadBuffering = true;
+    return config;
+}
+
+UtterancePipeline::UtterancePipeline(const VoskASR& asr, const Clock& clock,
+                                     std::shared_ptr<const RitualAssets> assets, const Config& config)
+    : asr_(asr),
+      clock_(clock),
+      config_(config),
+      assets_(std::move(assets)),
+      vad_(config.vadConfig, clock),
+      admission_(config.sampleRate),
+      admissionConfig_(config.admission),
+      vadTriggersMetric_(MetricsRegistry::instance().counter(
+          "sadhana_vad_triggers_total", "Speech onsets detected by VAD")),
+      asrResultsMetric_(MetricsRegistry::instance().counter(
+          "sadhana_asr_results_total", "Utterances decoded or spotted")),
+      asrEmptyResultsMetric_(MetricsRegistry::instance().counter(
+          "sadhana_asr_empty_results_total", "Decodes that produced no text")),
+      asrRtfMetric_(MetricsRegistry::instance().histogram(
+          "sadhana_asr_real_time_factor", "Decode time over utterance duration", 0.001, 10.0)),
+      matchConfidenceMetric_(MetricsRegistry::instance().histogram(
+          "sadhana_match_confidence", "Phrase match confidence of recognized utterances", 0.01, 1.0)) {
+    for (size_t i = 0; i < SegmentAdmission::REASON_COUNT; ++i) {
+        admissionMetrics_[i] = &MetricsRegistry::instance().counter(
+            "sadhana_admission_segments_total", "VAD segments by admission verdict",
+            {{"verdict", SegmentAdmission::reasonName(static_cast<SegmentAdmission::Reason>(i))}});
+    }
+
+    tierCounters_ = std::make_unique<StageCounters[]>(std::max<size_t>(1, asr_.tierCount()));
+    for (size_t tier = 0; tier < asr_.tierCount(); ++tier) {
+        decodeSecondsMetrics_.push_back(&MetricsRegistry::instance().histogram(
+            "sadhana_asr_decode_seconds", "Vosk decode latency per utterance", 0.001, 30.0,
+            {{"tier", std::to_string(tier)}}));
+    }
+
+    if (config.enableKeywordSpotter) {
+        auto kwsConfig = config.kwsConfig;
+        kwsConfig.sampleRate = config.sampleRate;
+        spotter_ = std::make_unique<KeywordSpotter>(kwsConfig);
+    }
+
+    calibrationSamplesRemaining_ =
+        static_cast<long>(config.vadConfig.calibrationMs) * config.sampleRate / 1000;
+    calibrating_ = calibrationSamplesRemaining_ > 0;
+    prerollRing_.assign(static_cast<size_t>(config.prerollMs) * config.sampleRate / 1000, 0.0f);
+}
+
+std::optional<UtterancePipeline::Utterance> UtterancePipeline::processBlock(const float* samples,
+                                                                            size_t numSamples) {
+    auto begin = std::chrono::steady_clock::now();
+    [[maybe_unused]] int64_t blockStartNs = Tracer::timestamp();
+
+    if (calibrating_) {
+        vad_.calibrate(samples, numSamples);
+        calibrationSamplesRemaining_ -= static_cast<long>(numSamples);
+        if (calibrationSamplesRemaining_ <= 0) {
+            calibrating_ = false;
+            if (calibrationCallback_) {
+                calibrationCallback_();
+            }
+        }
+        return std::nullopt;
+    }
+
+    float sumSquares = 0.0f;
+    for (size_t i = 0; i < numSamples; ++i) {
+        sumSquares += samples[i] * samples[i];
+    }
+    float rms = numSamples ? std::sqrt(sumSquares / numSamples) : 0.0f;
+    currentLevelDb_.store(20.0f * std::log10(rms + 1e-9f), std::memory_order_relaxed);
+
+    bool wasSpeechActive = speechActive_;
+    bool speechActive = vad_.process(samples, numSamples);
+    speechActive_ = speechActive;
+    updateSuspension();
+
+    // Each utterance is traced from the block that opened it
+    if (speechActive && !wasSpeechActive) {
+        vadTriggersMetric_.inc();
+        speechTraceId_ = nextSequence_ + 1;
+        speechStartNs_ = Tracer::timestamp();
+    }
+    SADHANA_TRACE_RECORD("vad.block", speechActive || wasSpeechActive ? speechTraceId_ : 0,
+                         blockStartNs, Tracer::timestamp());
+
+    bool buffering = !vadSawSuspended_ || !config_.suspendVadBuffering;
+    if (!buffering) {
+        writePreroll(samples, numSamples);
+    }
+
+    if (speechActive && !wasSpeechActive) {
+        speechBuffer_.clear();
+    }
+
+    if (speechActive && buffering) {
+        speechBuffer_.insert(speechBuffer_.end(), samples, samples + numSamples);
+    }
+
+    std::optional<Utterance> finished;
+    if (!speechActive && wasSpeechActive && vadSawSuspended_) {
+        decodesSkipped_.fetch_add(1, std::memory_order_relaxed);
+        speechBuffer_.clear();
+    } else if (!speechActive && wasSpeechActive && !speechBuffer_.empty()) {
+        Utterance utterance;
+        utterance.samples = std::move(speechBuffer_);
+        utterance.sequence = nextSequence_++;
+        utterance.endTime = clock_.now();
+        utterance.traceId = speechTraceId_;
+        utterance.startNs = speechStartNs_;
+        utterance.endNs = Tracer::timestamp();
+        speechBuffer_ = {};
+        SADHANA_TRACE_RECORD("vad.hang", utterance.traceId,
+                             utterance.endNs - config_.vadConfig.hangTimeMs * 1000000LL, utterance.endNs);
+        if (admit(utterance)) {
+            finished = std::move(utterance);
+        }
+    }
+    vadCounters_.record(std::chrono::steady_clock::now() - begin);
+    return finished;
+}
+
+void UtterancePipeline::setAdmissionConfig(const SegmentAdmission::Config& config) {
+    std::lock_guard<std::mutex> lock(admissionMutex_);
+    admissionConfig_ = config;
+}
+
+bool UtterancePipeline::admit(const Utterance& utterance) {
+    SegmentAdmission::Config config;
+    {
+        std::lock_guard<std::mutex> lock(admissionMutex_);
+        config = admissionConfig_;
+    }
+
+    SADHANA_TRACE_SPAN("vad.admission");
+    auto verdict = admission_.evaluate(utterance.samples.data(), utterance.samples.size(), config);
+    admissionCounts_[static_cast<size_t>(verdict.reason)].fetch_add(1, std::memory_order_relaxed);
+    admissionMetrics_[static_cast<size_t>(verdict.reason)]->inc();
+    return verdict.admitted();
+}
+
+// Picks up suspend/resume on the segmentation thread. On resume
+// mid-utterance, the pre-roll ring supplies the speech that was not buffered
+// while suspended.
+void UtterancePipeline::updateSuspension() {
+    bool suspended = recognitionSuspended_.load(std::memory_order_relaxed);
+    if (suspended == vadSawSuspended_) return;
+
+    auto now = clock_.now();
+    vadSawSuspended_ = suspended;
+    if (suspended) {
+        suspendedSince_ = now;
+        prerollWrite_ = 0;
+        prerollFilled_ = 0;
+        return;
+    }
+
+    suspendedNs_.fetch_add(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - suspendedSince_).count()),
+        std::memory_order_relaxed);
+    auto preroll = drainPreroll();
+    if (speechActive_ && config_.suspendVadBuffering) {
+        speechBuffer_ = std::move(preroll);
+    }
+}
+
+void UtterancePipeline::writePreroll(const float* samples, size_t numSamples) {
+    if (prerollRing_.empty()) return;
+
+    for (size_t i = 0; i < numSamples; ++i) {
+        prerollRing_[prerollWrite_] = samples[i];
+        prerollWrite_ = (prerollWrite_ + 1) % prerollRing_.size();
+    }
+    prerollFilled_ = std::min(prerollRing_.size(), prerollFilled_ + numSamples);
+}
+
+std::vector<float> UtterancePipeline::drainPreroll() {
+    std::vector<float> samples;
+    samples.reserve(prerollFilled_);
+    size_t start = (prerollWrite_ + prerollRing_.size() - prerollFilled_) % std::max<size_t>(1, prerollRing_.size());
+    for (size_t i = 0; i < prerollFilled_; ++i) {
+        samples.push_back(prerollRing_[(start + i) % prerollRing_.size()]);
+    }
+    prerollWrite_ = 0;
+    prerollFilled_ = 0;
+    return samples;
+}
+
+// Queued before the flow paused; the result would only be thrown away
+bool UtterancePipeline::discardIfSuspended() {
+    if (!recognitionSuspended_.load(std::memory_order_relaxed)) return false;
+    decodesSkipped_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// Until enough confirmed markers are enrolled for the current part, features
+// are kept so accept() can enroll them once Vosk's transcript has been matched
+std::optional<std::string> UtterancePipeline::spotKeyword(uint64_t sequence, const Utterance& utterance) {
+    if (!spotter_ || !spottingEnabled_) return std::nullopt;
+
+    SADHANA_TRACE_SPAN("kws.spot");
+    auto begin = std::chrono::steady_clock::now();
+    std::string key, section;
+    {
+        std::lock_guard<std::mutex> lock(enrollmentMutex_);
+        key = spotKey_;
+        section = spotSection_;
+    }
+    auto features = spotter_->extractFeatures(utterance.samples.data(), utterance.samples.size());
+
+    if (!spotter_->isEnrolled(key)) {
+        std::lock_guard<std::mutex> lock(enrollmentMutex_);
+        pendingEnrollment_[sequence] = {std::move(features), std::move(key), std::move(section)};
+        while (pendingEnrollment_.size() > config_.retainedUtterances) {
+            pendingEnrollment_.erase(pendingEnrollment_.begin());
+        }
+        return std::nullopt;
+    }
+
+    auto spot = spotter_->spot(key, features);
+    kwsCounters_.record(std::chrono::steady_clock::now() - begin);
+
+    if (!spot.accepted || spot.confidence < config_.kwsMinConfidence) {
+        kwsFallbacks_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    nlohmann::json json;
+    json["text"] = spot.transcript;
+    json["kws_confidence"] = spot.confidence;
+    kwsHits_.fetch_add(1, std::memory_order_relaxed);
+    return json.dump();
+}
+
+void UtterancePipeline::enrollKeyword(uint64_t sequence, const std::string& sectionId, const std::string& text) {
+    PendingEnrollment pending;
+    {
+        std::lock_guard<std::mutex> lock(enrollmentMutex_);
+        auto it = pendingEnrollment_.find(sequence);
+        if (it != pendingEnrollment_.end()) {
+            pending = std::move(it->second);
+        }
+        // Older entries were empty or non-marker decodes; they will never be claimed
+        pendingEnrollment_.erase(pendingEnrollment_.begin(), pendingEnrollment_.upper_bound(sequence));
+    }
+
+    // Another section's marker would teach this part's templates the wrong text
+    if (pending.features.frames > 0 && pending.sectionId == sectionId) {
+        spotter_->enroll(pending.key, std::move(pending.features), text);
+    }
+}
+
+void UtterancePipeline::retainForEscalation(uint64_t sequence, const Utterance& utterance) {
+    if (asr_.tierCount() > 1) {
+        retainUtterance(sequence, utterance);
+    }
+}
+
+void UtterancePipeline::retainUtterance(uint64_t sequence, const Utterance& utterance) {
+    std::lock_guard<std::mutex> lock(retainedMutex_);
+    retainedUtterances_[sequence] = utterance;
+    while (retainedUtterances_.size() > config_.retainedUtterances) {
+        retainedUtterances_.erase(retainedUtterances_.begin());
+    }
+}
+
+UtterancePipeline::Utterance UtterancePipeline::releaseUtterance(uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(retainedMutex_);
+    Utterance utterance;
+    auto it = retainedUtterances_.find(sequence);
+    if (it != retainedUtterances_.end()) {
+        utterance = std::move(it->second);
+        retainedUtterances_.erase(it);
+    }
+    return utterance;
+}
+
+void UtterancePipeline::recordDecode(size_t tier, std::chrono::steady_clock::duration decodeTime,
+                                     double audioSeconds) {
+    asrCounters_.record(decodeTime);
+    tierCounters_[tier].record(decodeTime);
+    double decodeSeconds = std::chrono::duration<double>(decodeTime).count();
+    decodeSecondsMetrics_[tier]->observe(decodeSeconds);
+    if (audioSeconds > 0.0) {
+        asrRtfMetric_.observe(decodeSeconds / audioSeconds);
+    }
+}
+
+std::string UtterancePipeline::parseText(const std::string& json) {
+    try {
+        SADHANA_TRACE_SPAN("asr.parse");
+        return nlohmann::json::parse(json).value("text", "");
+    } catch (const nlohmann::json::exception&) {
+        return {};
+    }
+}
+
+UtterancePipeline::Verdict UtterancePipeline::resolve(Transcript& transcript, Utterance* rerun) {
+    asrResultsMetric_.inc();
+    std::optional<Transcript> previous;
+    if (auto it = escalated_.find(transcript.sequence); it != escalated_.end()) {
+        previous = std::move(it->second);
+        escalated_.erase(it);
+    } else {
+        utterances_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (transcript.text.empty()) {
+        asrEmptyResultsMetric_.inc();
+    } else {
+        transcript.assets = assets_.load(std::memory_order_acquire);
+        SADHANA_TRACE_SPAN("match.phrase");
+        transcript.match = transcript.assets->matcher->matchPhrase(transcript.text);
+    }
+
+    // A larger model that heard nothing, or matched worse, does not overrule the smaller one
+    if (previous && (transcript.text.empty() || transcript.match.confidence < previous->match.confidence)) {
+        releaseUtterance(transcript.sequence);
+        escalationsKept_.fetch_add(1, std::memory_order_relaxed);
+        transcript = std::move(*previous);
+        return Verdict::Deliver;
+    }
+    if (transcript.text.empty()) {
+        return Verdict::Empty;
+    }
+
+    // Low-confidence results are held back and the retained audio goes to
+    // the next larger model
+    float threshold = escalationThreshold_.load(std::memory_order_relaxed);
+    size_t nextTier = transcript.tier + 1;
+    if (threshold <= 0.0f || transcript.match.confidence >= threshold || nextTier >= asr_.tierCount()) {
+        releaseUtterance(transcript.sequence);
+        return Verdict::Deliver;
+    }
+
+    auto utterance = releaseUtterance(transcript.sequence);
+    if (utterance.samples.empty()) {
+        return Verdict::Deliver;
+    }
+    if (nextTier + 1 < asr_.tierCount()) {
+        retainUtterance(transcript.sequence, utterance);
+    }
+    escalated_[transcript.sequence] = transcript;
+    escalations_.fetch_add(1, std::memory_order_relaxed);
+    *rerun = std::move(utterance);
+    return Verdict::Escalate;
+}
+
+UtterancePipeline::Transcript UtterancePipeline::abandonEscalation(uint64_t sequence) {
+    Transcript transcript;
+    if (auto it = escalated_.find(sequence); it != escalated_.end()) {
+        transcript = std::move(it->second);
+        escalated_.erase(it);
+        escalations_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    releaseUtterance(sequence);
+    return transcript;
+}
+
+void UtterancePipeline::accept(const Transcript& transcript) {
+    matchConfidenceMetric_.observe(transcript.match.confidence);
+    if (spotter_ && transcript.match.markerType == "iteration") {
+        enrollKeyword(transcript.sequence, transcript.match.sectionId, transcript.text);
+    }
+}
+
+void UtterancePipeline::recordMatch(std::chrono::steady_clock::duration elapsed) {
+    matchCounters_.record(elapsed);
+}
+
+bool UtterancePipeline::createRecognizers(std::string* error) {
+    recognizers_.clear();
+    for (size_t tier = 0; tier < asr_.tierCount(); ++tier) {
+        auto recognizer = asr_.createRecognizer(tier);
+        if (!recognizer) {
+            if (error) *error = "failed to create recognizer for tier " + std::to_string(tier);
+            return false;
+        }
+        recognizers_.push_back(std::move(recognizer));
+    }
+    return true;
+}
+
+UtterancePipeline::Transcript UtterancePipeline::decode(const Utterance& utterance, uint64_t sequence,
+                                                        size_t tier) {
+    Transcript transcript;
+    transcript.sequence = sequence;
+    transcript.tier = tier;
+    transcript.endTime = utterance.endTime;
+    transcript.traceId = utterance.traceId;
+    transcript.startNs = utterance.startNs;
+    if (tier >= recognizers_.size()) return transcript;
+
+    // VoskASR::decode traces the conversion and the decode itself
+    auto begin = std::chrono::steady_clock::now();
+    std::string json = VoskASR::decode(recognizers_[tier].get(), utterance.samples.data(),
+                                       utterance.samples.size());
+    auto decodeTime = std::chrono::steady_clock::now() - begin;
+    recordDecode(tier, decodeTime, static_cast<double>(utterance.samples.size()) / config_.sampleRate);
+    transcript.decodeMs = std::chrono::duration<float, std::milli>(decodeTime).count();
+    transcript.text = parseText(json);
+    return transcript;
+}
+
+std::optional<UtterancePipeline::Transcript> UtterancePipeline::recognize(Utterance utterance) {
+    if (discardIfSuspended()) return std::nullopt;
+
+    SADHANA_TRACE_CONTEXT(utterance.traceId);
+    const uint64_t sequence = utterance.sequence;
+    Transcript transcript;
+    if (auto spotted = spotKeyword(sequence, utterance)) {
+        transcript.sequence = sequence;
+        transcript.endTime = utterance.endTime;
+        transcript.traceId = utterance.traceId;
+        transcript.startNs = utterance.startNs;
+        transcript.text = parseText(*spotted);
+    } else {
+        retainForEscalation(sequence, utterance);
+        transcript = decode(utterance, sequence, 0);
+    }
+
+    Utterance rerun;
+    Verdict verdict;
+    while ((verdict = resolve(transcript, &rerun)) == Verdict::Escalate) {
+        transcript = decode(rerun, sequence, transcript.tier + 1);
+    }
+    if (verdict == Verdict::Empty) {
+        return std::nullopt;
+    }
+
+    accept(transcript);
+    return transcript;
+}
+
+void UtterancePipeline::followFlow(const FlowManager& flow, const FlowProgress& progress) {
+    setRecognitionSuspended(progress.awaitingManualIntervention);
+    auto section = assets_.load(std::memory_order_acquire)->ritual->findSection(progress.currentSectionId);
+    setKeywordSpottingEnabled(section && (*section)->iteration_marker && !progress.awaitingManualIntervention);
+    {
+        // Each part opens its offerings differently, so each enrolls its own templates
+        std::lock_guard<std::mutex> lock(enrollmentMutex_);
+        spotKey_ = progress.currentSectionId + "/" + progress.currentPartId;
+        spotSection_ = progress.currentSectionId;
+    }
+    setEscalationThreshold(flow.getThresholdForSection(progress.currentSectionId));
+    setAdmissionConfig(SegmentAdmission::configFromJson(
+        flow.getAdmissionSettings(progress.currentSectionId), config_.admission));
+}
+
+namespace {
+
+bool sameIterationMarkers(const RitualDefinition& before, const RitualDefinition& after) {
+    const auto& a = before.getSections();
+    const auto& b = after.getSections();
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const auto& x = a[i].iteration_marker;
+        const auto& y = b[i].iteration_marker;
+        if (x.has_value() != y.has_value()) return false;
+        if (x && (x->canonical != y->canonical || x->variants != y->variants ||
+                  x->with_svaha_variants != y->with_svaha_variants)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+void UtterancePipeline::reload(std::shared_ptr<const RitualAssets> assets) {
+    if (!assets || !assets->ritual || !assets->matcher) return;
+    auto previous = assets_.exchange(assets, std::memory_order_acq_rel);
+    // Spotted templates stand in for Vosk's transcript, so they must not
+    // outlive the marker text they were enrolled with
+    if (spotter_ && previous && !sameIterationMarkers(*previous->ritual, *assets->ritual)) {
+        spotter_->reset();
+        std::lock_guard<std::mutex> lock(enrollmentMutex_);
+        pendingEnrollment_.clear();
+    }
+}
+
+UtterancePipeline::Stats UtterancePipeline::stats() const {
+    Stats stats;
+    stats.vad = vadCounters_.snapshot();
+    stats.asr = asrCounters_.snapshot();
+    stats.match = matchCounters_.snapshot();
+    stats.kws = kwsCounters_.snapshot();
+    for (size_t tier = 0; tier < asr_.tierCount(); ++tier) {
+        stats.asrTiers.push_back(tierCounters_[tier].snapshot());
+    }
+    stats.utterances = utterances_.load(std::memory_order_relaxed);
+    stats.kwsTemplates = spotter_ ? spotter_->templateCount() : 0;
+    stats.kwsHits = kwsHits_.load(std::memory_order_relaxed);
+    stats.kwsFallbacks = kwsFallbacks_.load(std::memory_order_relaxed);
+    stats.escalations = escalations_.load(std::memory_order_relaxed);
+    stats.escalationsKept = escalationsKept_.load(std::memory_order_relaxed);
+    if (!stats.asrTiers.empty() && stats.asrTiers[0].processed > 0) {
+        stats.escalationRate = static_cast<double>(stats.escalations) / stats.asrTiers[0].processed;
+    }
+    stats.decodesSkipped = decodesSkipped_.load(std::memory_order_relaxed);
+    stats.suspendedSeconds = suspendedNs_.load(std::memory_order_relaxed) / 1e9;
+    for (size_t i = 0; i < admissionCounts_.size(); ++i) {
+        auto reason = static_cast<SegmentAdmission::Reason>(i);
+        uint64_t count = admissionCounts_[i].load(std::memory_order_relaxed);
+        stats.admission[SegmentAdmission::reasonName(reason)] = count;
+        if (reason != SegmentAdmission::Reason::Admitted) {
+            stats.rejected += count;
+        }
+    }
+    return stats;
+}
+
+}
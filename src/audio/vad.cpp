@@ -5,7 +5,7 @@
 
 namespace sadhana {
 
-VAD::VAD(const Config& config) : config_(config) {
+VAD::VAD(const Config& config, const Clock& clock) : config_(config), clock_(&clock) {
 }
 
 void VAD::calibrate(const float* samples, size_t numSamples) {
@@ -40,7 +40,7 @@ bool VAD::process(const float* samples, size_t numSamples) {
     const float MIN_SPEECH_DB = -50.0f;
     if (dbFS < MIN_SPEECH_DB) {
         if (speechActive_) {
-            auto now = std::chrono::steady_clock::now();
+            auto now = clock_->now();
             auto timeSinceLastSpeech =
                 std::chrono::duration_cast<std::chrono::milliseconds>(
                     now - lastSpeechTime_).count();
@@ -52,7 +52,7 @@ bool VAD::process(const float* samples, size_t numSamples) {
     }
 
     bool prevSpeechActive = speechActive_;
-    auto now = std::chrono::steady_clock::now();
+    auto now = clock_->now();
 
     if (!speechActive_) {
         auto timeSinceLastTrigger =
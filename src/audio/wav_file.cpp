@@ -0,0 +1,117 @@
+#include "audio/wav_file.hpp"
+#include "audio/resampler.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace sadhana {
+
+namespace {
+
+uint32_t readLE32(const char* p) {
+    return static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8) |
+           (static_cast<uint8_t>(p[2]) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(p[3])) << 24);
+}
+
+uint16_t readLE16(const char* p) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8));
+}
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+}
+
+bool readWavFile(const std::string& path, WavData& out, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return fail(error, "cannot open " + path);
+    }
+
+    char header[12];
+    if (!file.read(header, sizeof(header)) ||
+        std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0) {
+        return fail(error, "not a RIFF/WAVE file: " + path);
+    }
+
+    uint16_t format = 0, channels = 0, bitsPerSample = 0;
+    uint32_t sampleRate = 0;
+    bool haveFormat = false;
+
+    char chunkHeader[8];
+    while (file.read(chunkHeader, sizeof(chunkHeader))) {
+        uint32_t chunkSize = readLE32(chunkHeader + 4);
+
+        if (std::memcmp(chunkHeader, "fmt ", 4) == 0) {
+            std::vector<char> fmt(chunkSize);
+            if (chunkSize < 16 || !file.read(fmt.data(), chunkSize)) {
+                return fail(error, "bad fmt chunk in " + path);
+            }
+            format = readLE16(fmt.data());
+            channels = readLE16(fmt.data() + 2);
+            sampleRate = readLE32(fmt.data() + 4);
+            bitsPerSample = readLE16(fmt.data() + 14);
+            // WAVE_FORMAT_EXTENSIBLE carries the real format in the sub-format GUID
+            if (format == 0xFFFE && chunkSize >= 26) {
+                format = readLE16(fmt.data() + 24);
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunkHeader, "data", 4) == 0) {
+            if (!haveFormat || channels == 0) {
+                return fail(error, "data before fmt in " + path);
+            }
+
+            std::vector<char> data(chunkSize);
+            file.read(data.data(), chunkSize);
+            data.resize(static_cast<size_t>(file.gcount()));
+
+            size_t bytesPerSample = bitsPerSample / 8;
+            size_t frames = data.size() / (bytesPerSample * channels);
+            out.samples.assign(frames, 0.0f);
+            out.sampleRate = static_cast<int>(sampleRate);
+
+            for (size_t f = 0; f < frames; ++f) {
+                float sum = 0.0f;
+                for (size_t c = 0; c < channels; ++c) {
+                    const char* p = data.data() + (f * channels + c) * bytesPerSample;
+                    if (format == 1 && bitsPerSample == 16) {
+                        sum += static_cast<int16_t>(readLE16(p)) / 32768.0f;
+                    } else if (format == 3 && bitsPerSample == 32) {
+                        uint32_t bits = readLE32(p);
+                        float value;
+                        std::memcpy(&value, &bits, sizeof(value));
+                        sum += value;
+                    } else {
+                        return fail(error, "unsupported WAV encoding in " + path);
+                    }
+                }
+                out.samples[f] = sum / channels;
+            }
+            return true;
+        } else {
+            file.seekg(chunkSize + (chunkSize & 1), std::ios::cur);
+        }
+    }
+
+    return fail(error, "no data chunk in " + path);
+}
+
+std::vector<float> resample(const std::vector<float>& samples, int fromRate, int toRate) {
+    if (fromRate == toRate || samples.empty() || fromRate <= 0 || toRate <= 0) {
+        return samples;
+    }
+
+    size_t outCount = static_cast<size_t>(static_cast<double>(samples.size()) * toRate / fromRate);
+    std::vector<float> out;
+    out.reserve(outCount + 1);
+    Resampler resampler(fromRate, toRate);
+    auto emit = [&out](float sample) { out.push_back(sample); };
+    resampler.process(samples.data(), samples.size(), emit);
+    resampler.finish(emit);
+    out.resize(outCount);
+    return out;
+}
+
+}
@@ -1,301 +1,105 @@
 #include "definition/definition.hpp"
+#include "definition/definition_reader.hpp"
+#include "log/logger.hpp"
 #include <fstream>
 #include <iostream>
 #include <filesystem>
 
 namespace sadhana {
 
-void RitualDefinition::loadMaterialsFromJson(const JsonValue& json) {
-    std::cout << "Loading materials from JSON..." << std::endl;
-    std::cout << "JSON content type: " << json.type_name() << std::endl;
+namespace {
 
-    materials_.clear();
-
-    const JsonValue* materialsArray = nullptr;
-    
-    if (json.contains("materials") && json["materials"].is_array()) {
-        materialsArray = &json["materials"];
-    } else if (json.is_array()) {
-        materialsArray = &json;
-    }
-
-    if (!materialsArray) {
-        std::cerr << "Warning: No materials array found in expected locations" << std::endl;
-        return;
+bool readTextFile(const std::filesystem::path& path, std::string& text, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        if (error) *error = "failed to open " + path.string();
+        return false;
     }
+    text.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    SADHANA_LOG_DEBUG("definition", "Read ", path.string(), ": ", text.length(), " bytes");
+    return true;
+}
 
-    for (const auto& materialJson : *materialsArray) {
-        Material material;
-        
-        if (!materialJson.contains("id") || !materialJson.contains("name")) {
-            std::cerr << "Skipping material: missing required fields (id or name)" << std::endl;
-            continue;
-        }
-
-        material.id = materialJson["id"].get<std::string>();
-        material.name = materialJson["name"].get<std::string>();
-        
-        if (materialJson.contains("details")) {
-            material.details = materialJson["details"].get<std::string>();
-        }
-        if (materialJson.contains("optional")) {
-            material.optional = materialJson["optional"].get<bool>();
-        }
+template <typename T>
+std::shared_ptr<const T> readCommonFile(const std::filesystem::path& path,
+                                        std::shared_ptr<const T> (*read)(std::string_view, std::string*),
+                                        std::string* error) {
+    std::string text;
+    std::string readError;
+    if (!readTextFile(path, text, error)) return nullptr;
+    auto value = read(text, &readError);
+    if (!value && error) *error = "error parsing " + path.string() + ": " + readError;
+    return value;
+}
 
-        for (const auto& [key, value] : materialJson.items()) {
-            if (key != "id" && key != "name" && key != "details" && key != "optional") {
-                material.additional_data[key] = value;
-            }
-        }
+}
 
-        materials_.push_back(std::move(material));
-    }
+std::string RitualDefinition::commonDirectoryFor(const std::string& filepath) {
+    std::filesystem::path absPath = std::filesystem::absolute(filepath);
+    return (absPath.parent_path().parent_path().parent_path() / "common").string();
+}
 
-    std::cout << "Successfully loaded " << materials_.size() << " materials" << std::endl;
+RitualDefinition::CommonResolver RitualDefinition::directoryResolver(const std::string& commonDirectory) {
+    std::filesystem::path base(commonDirectory);
+    CommonResolver resolver;
+    resolver.materials = [base](const std::string& ref, std::string* error) -> std::shared_ptr<const MaterialList> {
+        auto path = base / "materials" / (ref + ".json");
+        if (!std::filesystem::exists(path)) return nullptr;
+        return readCommonFile(path, &DefinitionReader::readMaterials, error);
+    };
+    resolver.mantras = [base](const std::string& ref, std::string* error) {
+        return readCommonFile(base / "mantras" / (ref + ".json"), &DefinitionReader::readMantras, error);
+    };
+    resolver.procedures = [base](const std::string& ref, std::string* error) {
+        return readCommonFile(base / "procedures" / (ref + ".json"), &DefinitionReader::readProcedures, error);
+    };
+    return resolver;
 }
 
 bool RitualDefinition::loadFromFile(const std::string& filepath) {
-    try {
-        std::cout << "Opening file: " << filepath << std::endl;
-        std::ifstream file(filepath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file: " << filepath << std::endl;
-            return false;
-        }
-
-        std::string content;
-        std::string line;
-        while (std::getline(file, line)) {
-            content += line + "\n";
-        }
-
-        JsonValue mainJson = nlohmann::json::parse(content);
-        if (!loadFromJson(mainJson)) {
-            return false;
-        }
-
-        std::filesystem::path absPath = std::filesystem::absolute(filepath);
-        std::filesystem::path basePath = absPath.parent_path().parent_path().parent_path();
-
-        if (mainJson.contains("materials_ref")) {
-            auto materialsPath = basePath / "common" / "materials" /
-                               (mainJson["materials_ref"].get<std::string>() + ".json");
-            std::cout << "Loading materials from: " << materialsPath << std::endl;
-
-            if (std::filesystem::exists(materialsPath)) {
-                std::ifstream materialsFile(materialsPath);
-                std::string materialsContent((std::istreambuf_iterator<char>(materialsFile)),
-                                          std::istreambuf_iterator<char>());
-                std::cout << "Materials file size: " << materialsContent.length() << " bytes" << std::endl;
-
-                JsonValue materialsJson = nlohmann::json::parse(materialsContent);
-                loadMaterialsFromJson(materialsJson);
-            }
-        }
-
-        if (mainJson.contains("mantras_ref")) {
-            auto mantrasPath = basePath / "common" / "mantras" /
-                              (mainJson["mantras_ref"].get<std::string>() + ".json");
-            
-            std::cout << "Debug: Base path: " << basePath << std::endl;
-            std::cout << "Debug: Mantras ref: " << mainJson["mantras_ref"].get<std::string>() << std::endl;
-            std::cout << "Debug: Full mantras path: " << mantrasPath << std::endl;
-            
-            std::ifstream testFile(mantrasPath);
-            if (testFile.is_open()) {
-                std::string rawContent;
-                testFile.seekg(0, std::ios::end);
-                rawContent.reserve(testFile.tellg());
-                testFile.seekg(0, std::ios::beg);
-                rawContent.assign((std::istreambuf_iterator<char>(testFile)),
-                                std::istreambuf_iterator<char>());
-                std::cout << "Debug: Raw file content first 100 chars:\n" << rawContent.substr(0, 100) << std::endl;
-                testFile.close();
-            } else {
-                std::cerr << "Debug: Could not open mantras file for direct reading" << std::endl;
-            }
-
-            std::cout << "Loading mantras from: " << mantrasPath << std::endl;
-
-            if (std::filesystem::exists(mantrasPath)) {
-                std::ifstream mantrasFile(mantrasPath);
-                std::string mantrasContent((std::istreambuf_iterator<char>(mantrasFile)),
-                                        std::istreambuf_iterator<char>());
-                std::cout << "Mantras file content length: " << mantrasContent.length() << " bytes" << std::endl;
-
-                try {
-                    JsonValue mantrasJson = nlohmann::json::parse(mantrasContent);
-                    loadMantrasFromJson(mantrasJson);
-                } catch (const std::exception& e) {
-                    std::cerr << "Error parsing mantras file: " << e.what() << std::endl;
-                    return false;
-                }
-            } else {
-                std::cerr << "Mantras file not found at: " << mantrasPath << std::endl;
-                return false;
-            }
-        }
-
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error loading ritual definition: " << e.what() << std::endl;
+    SADHANA_LOG_INFO("definition", "Opening file: ", filepath);
+    std::string text;
+    std::string error;
+    if (!readTextFile(filepath, text, &error) ||
+        !loadFromText(text, directoryResolver(commonDirectoryFor(filepath)), &error)) {
+        std::cerr << "Error loading ritual definition: " << error << std::endl;
         return false;
     }
+    return true;
 }
 
-bool RitualDefinition::loadFromJson(const JsonValue& json) {
-    try {
-        parseFromJson(json);
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing ritual definition: " << e.what() << std::endl;
-        return false;
-    }
+bool RitualDefinition::loadFromText(std::string_view text, const CommonResolver& resolver, std::string* error) {
+    CommonRefs refs;
+    return DefinitionReader::readDefinition(text, *this, refs, error) && attachCommon(refs, resolver, error);
 }
 
-void RitualDefinition::loadProceduresFromJson(const JsonValue& json) {
-    if (!json.contains("procedures")) return;
-
-    for (const auto& [id, proc] : json["procedures"].items()) {
-        if (proc.contains("steps")) {
-            auto section_it = std::find_if(sections_.begin(), sections_.end(),
-                [&id](const Section& s) { return s.id == id; });
-
-            if (section_it != sections_.end()) {
-                std::vector<Step> steps;
-                for (const auto& step_json : proc["steps"]) {
-                    Step step;
-                    step.id = step_json.at("id").get<std::string>();
-                    step.title = step_json.at("title").get<std::string>();
-                    step.items = step_json.value("items", std::vector<std::string>());
-                    step.instructions = step_json.value("instructions", std::vector<std::string>());
-                    step.mantra_refs = step_json.value("mantra_refs", std::vector<std::string>());
-
-                    for (const auto& [key, value] : step_json.items()) {
-                        if (key != "id" && key != "title" && key != "items" &&
-                            key != "instructions" && key != "mantra_refs") {
-                            step.additional_data[key] = value;
-                        }
-                    }
-
-                    steps.push_back(std::move(step));
-                }
-                section_it->steps = std::move(steps);
-            }
+bool RitualDefinition::attachCommon(const CommonRefs& refs, const CommonResolver& resolver, std::string* error) {
+    if (refs.materials && resolver.materials) {
+        std::string materialsError;
+        auto materials = resolver.materials(*refs.materials, &materialsError);
+        if (materials) {
+            materials_ = std::move(materials);
+        } else if (!materialsError.empty()) {
+            if (error) *error = materialsError;
+            return false;
         }
     }
-}
-
-void RitualDefinition::parseFromJson(const JsonValue& json) {
-    id_ = json.at("id").get<std::string>();
-    title_ = json.at("title").get<std::string>();
-    version_ = json.at("version").get<std::string>();
-    source_ = json.at("source").get<std::string>();
-
-    if (json.contains("metadata")) {
-        metadata_ = json["metadata"].get<MetadataMap>();
+    if (refs.mantras && resolver.mantras) {
+        auto mantras = resolver.mantras(*refs.mantras, error);
+        if (!mantras) return false;
+        mantras_ = std::move(mantras);
     }
-
-    if (json.contains("sections")) {
-        for (const auto& section_json : json["sections"]) {
-            Section section;
-            section.id = section_json.at("id").get<std::string>();
-            section.title = section_json.at("title").get<std::string>();
-            section.notes = section_json.value("discipline_note", "");
-
-            // Add these lines
-            if (section_json.contains("description")) {
-                section.description = section_json["description"].get<std::string>();
-            }
-            if (section_json.contains("introduction")) {
-                section.introduction = section_json["introduction"].get<std::string>();
-            }
-
-            if (section_json.contains("iteration_marker")) {
-                const auto& marker_json = section_json["iteration_marker"];
-                ProgressMarker marker;
-                marker.canonical = marker_json.at("canonical").get<std::string>();
-                marker.variants = marker_json.value("variants", std::vector<std::string>());
-                marker.with_svaha_variants = marker_json.value("with_svaha_variants", false);
-                marker.cooldown_ms = marker_json.value("cooldown_ms", 700);
-
-                for (const auto& [key, value] : marker_json.items()) {
-                    if (key != "canonical" && key != "variants" &&
-                        key != "with_svaha_variants" && key != "cooldown_ms") {
-                        marker.additional_params[key] = value;
-                    }
-                }
-
-                section.iteration_marker = std::move(marker);
-            }
-
-            if (section_json.contains("parts")) {
-                std::vector<Part> parts;
-                for (const auto& part_json : section_json["parts"]) {
-                    Part part;
-                    part.id = part_json.at("id").get<std::string>();
-                    part.title = part_json.at("title").get<std::string>();
-                    part.notes = part_json.value("notes", "");
-
-                    // Add this line
-                    if (part_json.contains("description")) {
-                        part.description = part_json["description"].get<std::string>();
-                    }
-
-                    if (part_json.contains("repetitions")) {
-                        part.repetitions = part_json["repetitions"].get<int>();
-                    }
-                    if (part_json.contains("utterance")) {
-                        part.utterance = part_json["utterance"].get<std::string>();
-                    }
-                    if (part_json.contains("sequence")) {
-                        part.sequence = part_json["sequence"].get<std::vector<std::string>>();
-                    }
-                    if (part_json.contains("pairs")) {
-                        part.pairs = part_json["pairs"].get<std::vector<std::vector<std::string>>>();
-                    }
-
-                    if (part_json.contains("derived_counts")) {
-                        for (const auto& [key, value] : part_json["derived_counts"].items()) {
-                            part.counts[key] = value.get<int>();
-                        }
-                    }
-
-                    if (part_json.contains("mantra_ref")) {
-                        part.mantra_ref = part_json["mantra_ref"].get<std::string>();
-                    }
-
-                    for (const auto& [key, value] : part_json.items()) {
-                        if (key != "id" && key != "title" && key != "notes" &&
-                            key != "repetitions" && key != "utterance" &&
-                            key != "sequence" && key != "pairs" &&
-                            key != "derived_counts") {
-                            part.additional_data[key] = value;
-                        }
-                    }
-
-                    parts.push_back(std::move(part));
-                }
-                section.parts = std::move(parts);
-            }
-
-            if (section_json.contains("derived_totals")) {
-                for (const auto& [key, value] : section_json["derived_totals"].items()) {
-                    section.counts[key] = value.get<int>();
-                }
-            }
-
-            for (const auto& [key, value] : section_json.items()) {
-                if (key != "id" && key != "title" && key != "steps" &&
-                    key != "parts" && key != "iteration_marker" &&
-                    key != "derived_totals" && key != "discipline_note") {
-                    section.additional_data[key] = value;
-                }
-            }
-
-            sections_.push_back(std::move(section));
-        }
+    if (refs.procedures && resolver.procedures) {
+        auto procedures = resolver.procedures(*refs.procedures, error);
+        if (!procedures) return false;
+        procedures_ = std::move(procedures);
     }
+    return true;
+}
+
+const Step* RitualDefinition::findProcedure(const std::string& id) const {
+    auto it = procedures_->find(id);
+    return it != procedures_->end() ? &it->second : nullptr;
 }
 
 std::optional<const Section*> RitualDefinition::findSection(const std::string& id) const {
@@ -358,25 +162,6 @@ std::optional<int> RitualDefinition::getCooldownForMarker(const std::string& mar
     return std::nullopt;
 }
 
-void RitualDefinition::loadMantrasFromJson(const JsonValue& json) {
-    mantras_.clear();
-    
-    if (!json.contains("mantras")) {
-        std::cout << "Debug: No mantras section in JSON\n" << std::flush;
-        return;
-    }
-    
-    const auto& mantrasJson = json["mantras"];
-    std::cout << "Debug: Loading mantras:\n" << std::flush;
-    for (auto it = mantrasJson.begin(); it != mantrasJson.end(); ++it) {
-        std::cout << "Debug: Found mantra '" << it.key() << "': " 
-                  << it.value().dump() << "\n" << std::flush;
-        mantras_[it.key()] = it.value();
-    }
-    
-    std::cout << "Debug: Loaded " << mantras_.size() << " mantras\n" << std::flush;
-}
-
 std::string RitualDefinition::getCurrentMantra(const std::string& sectionId, const std::string& partId) const {
     auto section = std::find_if(sections_.begin(), sections_.end(),
         [&](const Section& s) { return s.id == sectionId; });
@@ -413,8 +198,7 @@ RitualDefinition::CurrentState RitualDefinition::getCurrentState(
     const std::string& sectionId, const std::string& partId) const {
     
     CurrentState state;
-    std::cout << "Debug: Getting state for section: " << sectionId 
-              << ", part: " << partId << "\n" << std::flush;
+    SADHANA_LOG_TRACE("definition", "Getting state for section: ", sectionId, ", part: ", partId);
     
     auto section = findSection(sectionId);
     if (!section) return state;
@@ -425,23 +209,18 @@ RitualDefinition::CurrentState RitualDefinition::getCurrentState(
             
         if (part != (*section)->parts->end()) {
             if (part->mantra_ref) {
-                std::cout << "Debug: Found mantra_ref: " << *part->mantra_ref << "\n" << std::flush;
+                SADHANA_LOG_TRACE("definition", "Found mantra_ref: ", *part->mantra_ref);
                 
-                auto mantraIt = mantras_.find(*part->mantra_ref);
-                if (mantraIt != mantras_.end()) {
-                    const auto& mantraJson = mantraIt->second;
-                    if (mantraJson.contains("text")) {
-                        state.expectedUtterance = mantraJson["text"].get<std::string>() + " tarpayaami namaha";
-                    } else if (mantraJson.contains("beejas")) {
-                        auto beejas = mantraJson["beejas"].get<std::vector<std::string>>();
-                        if (!beejas.empty()) {
-                            state.expectedUtterance = beejas[0] + " tarpayaami namaha";
-                        }
-                    } else if (mantraJson.contains("pairs")) {
-                        auto pairs = mantraJson["pairs"].get<std::vector<std::vector<std::string>>>();
-                        if (!pairs.empty() && pairs[0].size() >= 2) {
-                            state.expectedUtterance = pairs[0][0] + " " + pairs[0][1] + " tarpayaami namaha";
-                        }
+                auto mantraIt = mantras_->find(*part->mantra_ref);
+                if (mantraIt != mantras_->end()) {
+                    const auto& mantra = mantraIt->second;
+                    if (mantra.text) {
+                        state.expectedUtterance = *mantra.text + " tarpayaami namaha";
+                    } else if (!mantra.beejas.empty()) {
+                        state.expectedUtterance = mantra.beejas[0] + " tarpayaami namaha";
+                    } else if (!mantra.pairs.empty() && mantra.pairs[0].size() >= 2) {
+                        const auto& pair = mantra.pairs[0];
+                        state.expectedUtterance = pair[0] + " " + pair[1] + " tarpayaami namaha";
                     }
                 }
             } else if (part->utterance) {
@@ -458,8 +237,8 @@ RitualDefinition::CurrentState RitualDefinition::getCurrentState(
         }
     }
     
-    std::cout << "Debug: Final state - utterance: '" << state.expectedUtterance 
-              << "', repetitions: " << state.requiredRepetitions << "\n" << std::flush;
+    SADHANA_LOG_TRACE("definition", "Final state - utterance: '", state.expectedUtterance,
+                      "', repetitions: ", state.requiredRepetitions);
     
     return state;
 }
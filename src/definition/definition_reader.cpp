@@ -0,0 +1,679 @@
+#include "definition/definition_reader.hpp"
+#include "log/logger.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace sadhana {
+
+namespace {
+
+// FNV-1a with the seed folded into the offset basis
+constexpr uint32_t hashKey(std::string_view key, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (char c : key) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 16);
+}
+
+constexpr size_t slotsFor(size_t keys) {
+    size_t slots = 1;
+    while (slots < 2 * keys) slots <<= 1;
+    return slots;
+}
+
+// Perfect hash over a fixed key set. The seed is searched for at compile
+// time until every key lands in a slot of its own, so a lookup costs one
+// hash and at most one comparison; a key set without a seed fails the build.
+template <size_t N>
+class KeyTable {
+public:
+    static constexpr size_t SLOTS = slotsFor(N);
+
+    constexpr explicit KeyTable(const std::array<std::string_view, N>& keys) : keys_(keys) {
+        for (seed_ = 0; seed_ < (1u << 16); ++seed_) {
+            if (place()) return;
+        }
+        throw "no perfect hash for this key set";
+    }
+
+    // Position of the key in the constructor's list, -1 when it is not there
+    constexpr int find(std::string_view key) const {
+        int index = slots_[hashKey(key, seed_) & (SLOTS - 1)];
+        return index >= 0 && keys_[index] == key ? index : -1;
+    }
+    constexpr std::string_view name(int index) const { return keys_[index]; }
+
+private:
+    std::array<std::string_view, N> keys_;
+    std::array<int8_t, SLOTS> slots_{};
+    uint32_t seed_{0};
+
+    constexpr bool place() {
+        for (auto& slot : slots_) slot = -1;
+        for (size_t i = 0; i < N; ++i) {
+            auto& slot = slots_[hashKey(keys_[i], seed_) & (SLOTS - 1)];
+            if (slot >= 0) return false;
+            slot = static_cast<int8_t>(i);
+        }
+        return true;
+    }
+};
+
+template <typename... Keys>
+constexpr auto keyTable(Keys... keys) {
+    return KeyTable<sizeof...(Keys)>(std::array<std::string_view, sizeof...(Keys)>{std::string_view(keys)...});
+}
+
+constexpr uint32_t bit(int key) {
+    return 1u << key;
+}
+
+// Key ids follow the order of each table
+namespace RootKey {
+enum : int { Id, Title, Version, Source, Metadata, MaterialsRef, MantrasRef, ProceduresRef, Sections };
+constexpr auto TABLE = keyTable("id", "title", "version", "source", "metadata",
+                                "materials_ref", "mantras_ref", "procedures_ref", "sections");
+constexpr uint32_t REQUIRED = bit(Id) | bit(Title) | bit(Version) | bit(Source);
+}
+
+namespace SectionKey {
+enum : int { Id, Title, DisciplineNote, Description, Introduction, IterationMarker, Parts, DerivedTotals, Steps };
+constexpr auto TABLE = keyTable("id", "title", "discipline_note", "description", "introduction",
+                                "iteration_marker", "parts", "derived_totals", "steps");
+constexpr uint32_t REQUIRED = bit(Id) | bit(Title);
+}
+
+namespace MarkerKey {
+enum : int { Canonical, Variants, WithSvahaVariants, CooldownMs };
+constexpr auto TABLE = keyTable("canonical", "variants", "with_svaha_variants", "cooldown_ms");
+constexpr uint32_t REQUIRED = bit(Canonical);
+}
+
+namespace PartKey {
+enum : int { Id, Title, Notes, Description, Repetitions, Utterance, MantraRef, Sequence, Pairs, DerivedCounts };
+constexpr auto TABLE = keyTable("id", "title", "notes", "description", "repetitions", "utterance",
+                                "mantra_ref", "sequence", "pairs", "derived_counts");
+constexpr uint32_t REQUIRED = bit(Id) | bit(Title);
+}
+
+namespace MantraKey {
+enum : int { Text, Type, Beejas, Pairs, FullVariants };
+constexpr auto TABLE = keyTable("text", "type", "beejas", "pairs", "full_variants");
+}
+
+namespace MaterialKey {
+enum : int { Id, Name, Details, Optional };
+constexpr auto TABLE = keyTable("id", "name", "details", "optional");
+constexpr uint32_t REQUIRED = bit(Id) | bit(Name);
+}
+
+namespace ProcedureKey {
+enum : int { Id, Title, Items, Instructions, MantraRefs };
+constexpr auto TABLE = keyTable("id", "title", "items", "instructions", "mantra_refs");
+}
+
+enum class Document { Definition, Materials, Mantras, Procedures };
+
+// What the innermost open object or array is being read into
+enum class Frame : uint8_t {
+    Root, Sections, Section, Marker, Parts, Part,
+    Strings, StringLists, Counts,
+    Values,    // map<string, JsonValue>: metadata, additional_params
+    Capture,   // an unmodelled value, built as JSON
+    Skip,      // read and dropped
+    MantraFile, Mantras, Mantra,
+    MaterialFile, Materials, Material,
+    ProcedureFile, Procedures, Procedure
+};
+
+struct Level {
+    Frame frame;
+    void* target{nullptr};
+    int key{-1};         // id of the pending key, -1 when the struct does not model it
+    uint32_t seen{0};    // modelled keys met so far
+    std::string name;    // the pending key as written
+};
+
+// Where a definition's top-level fields go
+struct DefinitionTargets {
+    std::string id;
+    std::string title;
+    std::string version;
+    std::string source;
+    RitualDefinition::MetadataMap metadata;
+    std::vector<Section> sections;
+    RitualDefinition::CommonRefs refs;
+};
+
+class Reader : public nlohmann::json_sax<nlohmann::json> {
+public:
+    explicit Reader(Document document) : document_(document) {
+        stack_.reserve(16);
+    }
+
+    DefinitionTargets definition;
+    RitualDefinition::MaterialList materials;
+    RitualDefinition::MantraMap mantras;
+    RitualDefinition::ProcedureMap procedures;
+    std::string error;
+
+    bool null() override { return scalar(JsonValue()); }
+    bool boolean(bool value) override { return flag(value); }
+    bool number_integer(number_integer_t value) override { return number(value, JsonValue(value)); }
+    bool number_unsigned(number_unsigned_t value) override {
+        return number(static_cast<int64_t>(value), JsonValue(value));
+    }
+    bool number_float(number_float_t value, const string_t&) override {
+        return number(static_cast<int64_t>(value), JsonValue(value));
+    }
+    bool binary(binary_t&) override { return fail("unexpected binary value"); }
+    bool string(string_t& value) override { return text(std::move(value)); }
+
+    bool key(string_t& value) override {
+        Level& top = stack_.back();
+        top.key = -1;
+        switch (top.frame) {
+            case Frame::Root: top.key = RootKey::TABLE.find(value); break;
+            case Frame::Section: top.key = SectionKey::TABLE.find(value); break;
+            case Frame::Marker: top.key = MarkerKey::TABLE.find(value); break;
+            case Frame::Part: top.key = PartKey::TABLE.find(value); break;
+            case Frame::Mantra: top.key = MantraKey::TABLE.find(value); break;
+            case Frame::Material: top.key = MaterialKey::TABLE.find(value); break;
+            case Frame::Procedure: top.key = ProcedureKey::TABLE.find(value); break;
+            default: break;
+        }
+        if (top.key >= 0) top.seen |= bit(top.key);
+        // Copied rather than moved, so the lexer keeps its buffer
+        top.name.assign(value);
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        if (stack_.empty()) {
+            switch (document_) {
+                case Document::Definition: return push(Frame::Root, &definition);
+                case Document::Materials: return push(Frame::MaterialFile);
+                case Document::Mantras: return push(Frame::MantraFile);
+                case Document::Procedures: return push(Frame::ProcedureFile);
+            }
+        }
+
+        Level& top = stack_.back();
+        switch (top.frame) {
+            case Frame::Root:
+                if (top.key == RootKey::Metadata) return push(Frame::Values, &definition.metadata);
+                return top.key < 0 ? push(Frame::Skip) : wrongType(top);
+            case Frame::Sections: {
+                auto& sections = target<std::vector<Section>>(top);
+                return push(Frame::Section, &sections.emplace_back());
+            }
+            case Frame::Section: {
+                auto& section = target<Section>(top);
+                switch (top.key) {
+                    case SectionKey::IterationMarker: return push(Frame::Marker, &section.iteration_marker.emplace());
+                    case SectionKey::DerivedTotals: return push(Frame::Counts, &section.counts);
+                    case SectionKey::Steps: return push(Frame::Skip);
+                    case -1: return capture(section.additional_data[top.name], JsonValue::object());
+                    default: return wrongType(top);
+                }
+            }
+            case Frame::Parts: {
+                auto& parts = target<std::vector<Part>>(top);
+                return push(Frame::Part, &parts.emplace_back());
+            }
+            case Frame::Part: {
+                auto& part = target<Part>(top);
+                if (top.key == PartKey::DerivedCounts) return push(Frame::Counts, &part.counts);
+                return top.key < 0 ? capture(part.additional_data[top.name], JsonValue::object()) : wrongType(top);
+            }
+            case Frame::Marker: {
+                auto& marker = target<ProgressMarker>(top);
+                return top.key < 0 ? capture(marker.additional_params[top.name], JsonValue::object())
+                                   : wrongType(top);
+            }
+            case Frame::Values:
+                return capture(target<RitualDefinition::MetadataMap>(top)[top.name], JsonValue::object());
+            case Frame::Capture:
+                return capture(child(top), JsonValue::object());
+            case Frame::Skip:
+            case Frame::MaterialFile:
+            case Frame::Materials:
+                if (top.frame == Frame::Materials) {
+                    return push(Frame::Material, &materials.emplace_back());
+                }
+                return push(Frame::Skip);
+            case Frame::MantraFile:
+                return push(top.name == "mantras" ? Frame::Mantras : Frame::Skip);
+            case Frame::Mantras: {
+                auto& mantra = mantras[top.name];
+                mantra = Mantra();
+                mantra.id = top.name;
+                return push(Frame::Mantra, &mantra);
+            }
+            case Frame::Mantra: {
+                auto& mantra = target<Mantra>(top);
+                return top.key < 0 ? capture(mantra.additional_data[top.name], JsonValue::object()) : wrongType(top);
+            }
+            case Frame::Material: {
+                auto& material = target<Material>(top);
+                return top.key < 0 ? capture(material.additional_data[top.name], JsonValue::object())
+                                   : wrongType(top);
+            }
+            case Frame::ProcedureFile:
+                return push(top.name == "procedures" ? Frame::Procedures : Frame::Skip);
+            case Frame::Procedures: {
+                auto& step = procedures[top.name];
+                step = Step();
+                step.id = top.name;
+                return push(Frame::Procedure, &step);
+            }
+            case Frame::Procedure: {
+                auto& step = target<Step>(top);
+                return top.key < 0 ? capture(step.additional_data[top.name], JsonValue::object()) : wrongType(top);
+            }
+            case Frame::Strings:
+            case Frame::StringLists:
+            case Frame::Counts:
+                return wrongType(top);
+        }
+        return wrongType(top);
+    }
+
+    bool start_array(std::size_t) override {
+        if (stack_.empty()) {
+            // A materials file may be the bare list
+            if (document_ == Document::Materials) return push(Frame::Materials);
+            return fail("expected a JSON object");
+        }
+
+        Level& top = stack_.back();
+        switch (top.frame) {
+            case Frame::Root:
+                if (top.key == RootKey::Sections) {
+                    definition.sections.clear();
+                    return push(Frame::Sections, &definition.sections);
+                }
+                return top.key < 0 ? push(Frame::Skip) : wrongType(top);
+            case Frame::Section: {
+                auto& section = target<Section>(top);
+                switch (top.key) {
+                    case SectionKey::Parts: return push(Frame::Parts, &section.parts.emplace());
+                    case SectionKey::Steps: return push(Frame::Skip);
+                    case -1: return capture(section.additional_data[top.name], JsonValue::array());
+                    default: return wrongType(top);
+                }
+            }
+            case Frame::Part: {
+                auto& part = target<Part>(top);
+                switch (top.key) {
+                    case PartKey::Sequence: return push(Frame::Strings, &part.sequence.emplace());
+                    case PartKey::Pairs: return push(Frame::StringLists, &part.pairs.emplace());
+                    case -1: return capture(part.additional_data[top.name], JsonValue::array());
+                    default: return wrongType(top);
+                }
+            }
+            case Frame::Marker: {
+                auto& marker = target<ProgressMarker>(top);
+                if (top.key == MarkerKey::Variants) return push(Frame::Strings, &marker.variants);
+                return top.key < 0 ? capture(marker.additional_params[top.name], JsonValue::array())
+                                   : wrongType(top);
+            }
+            case Frame::StringLists: {
+                auto& lists = target<std::vector<std::vector<std::string>>>(top);
+                return push(Frame::Strings, &lists.emplace_back());
+            }
+            case Frame::Values:
+                return capture(target<RitualDefinition::MetadataMap>(top)[top.name], JsonValue::array());
+            case Frame::Capture:
+                return capture(child(top), JsonValue::array());
+            case Frame::Mantras: {
+                auto& mantra = mantras[top.name];
+                mantra = Mantra();
+                mantra.id = top.name;
+                return push(Frame::Strings, &mantra.sequence);
+            }
+            case Frame::Mantra: {
+                auto& mantra = target<Mantra>(top);
+                switch (top.key) {
+                    case MantraKey::Beejas: return push(Frame::Strings, &mantra.beejas);
+                    case MantraKey::Pairs: return push(Frame::StringLists, &mantra.pairs);
+                    case MantraKey::FullVariants: return push(Frame::Strings, &mantra.full_variants);
+                    case -1: return capture(mantra.additional_data[top.name], JsonValue::array());
+                    default: return wrongType(top);
+                }
+            }
+            case Frame::MaterialFile:
+                return push(top.name == "materials" ? Frame::Materials : Frame::Skip);
+            case Frame::Material: {
+                auto& material = target<Material>(top);
+                return top.key < 0 ? capture(material.additional_data[top.name], JsonValue::array())
+                                   : wrongType(top);
+            }
+            case Frame::Procedure: {
+                auto& step = target<Step>(top);
+                switch (top.key) {
+                    case ProcedureKey::Items: return push(Frame::Strings, &step.items);
+                    case ProcedureKey::Instructions: return push(Frame::Strings, &step.instructions);
+                    case ProcedureKey::MantraRefs: return push(Frame::Strings, &step.mantra_refs);
+                    case -1: return capture(step.additional_data[top.name], JsonValue::array());
+                    default: return wrongType(top);
+                }
+            }
+            case Frame::Skip:
+            case Frame::MantraFile:
+            case Frame::Materials:
+            case Frame::ProcedureFile:
+                return push(Frame::Skip);
+            case Frame::Sections:
+            case Frame::Parts:
+            case Frame::Strings:
+            case Frame::Counts:
+            case Frame::Procedures:
+                return wrongType(top);
+        }
+        return wrongType(top);
+    }
+
+    bool end_object() override { return close(); }
+    bool end_array() override { return close(); }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) override {
+        error = e.what();
+        return false;
+    }
+
+private:
+    Document document_;
+    std::vector<Level> stack_;
+
+    template <typename T>
+    static T& target(const Level& level) {
+        return *static_cast<T*>(level.target);
+    }
+
+    bool push(Frame frame, void* target = nullptr) {
+        stack_.push_back(Level{frame, target, -1, 0, {}});
+        return true;
+    }
+
+    bool fail(std::string message) {
+        if (error.empty()) error = std::move(message);
+        return false;
+    }
+
+    bool wrongType(const Level& level) {
+        return fail("unexpected value type for \"" + level.name + "\"");
+    }
+
+    // Slot for the next value inside a captured array or object
+    static JsonValue& child(const Level& level) {
+        auto& container = target<JsonValue>(level);
+        if (container.is_array()) {
+            container.push_back(nullptr);
+            return container.back();
+        }
+        return container[level.name];
+    }
+
+    bool capture(JsonValue& slot, JsonValue initial) {
+        slot = std::move(initial);
+        return push(Frame::Capture, &slot);
+    }
+
+    // A value the innermost struct does not model
+    bool keep(Level& top, JsonValue&& value) {
+        switch (top.frame) {
+            case Frame::Capture: child(top) = std::move(value); return true;
+            case Frame::Values: target<RitualDefinition::MetadataMap>(top)[top.name] = std::move(value); return true;
+            case Frame::Skip:
+            case Frame::Root:
+            case Frame::MantraFile:
+            case Frame::MaterialFile:
+            case Frame::ProcedureFile:
+            case Frame::Materials:
+                return top.key < 0 ? true : wrongType(top);
+            case Frame::Section:
+                if (top.key >= 0) return wrongType(top);
+                target<Section>(top).additional_data[top.name] = std::move(value);
+                return true;
+            case Frame::Part:
+                if (top.key >= 0) return wrongType(top);
+                target<Part>(top).additional_data[top.name] = std::move(value);
+                return true;
+            case Frame::Marker:
+                if (top.key >= 0) return wrongType(top);
+                target<ProgressMarker>(top).additional_params[top.name] = std::move(value);
+                return true;
+            case Frame::Mantra:
+                if (top.key >= 0) return wrongType(top);
+                target<Mantra>(top).additional_data[top.name] = std::move(value);
+                return true;
+            case Frame::Material:
+                if (top.key >= 0) return wrongType(top);
+                target<Material>(top).additional_data[top.name] = std::move(value);
+                return true;
+            case Frame::Procedure:
+                if (top.key >= 0) return wrongType(top);
+                target<Step>(top).additional_data[top.name] = std::move(value);
+                return true;
+            default:
+                return wrongType(top);
+        }
+    }
+
+    bool scalar(JsonValue&& value) {
+        return keep(stack_.back(), std::move(value));
+    }
+
+    bool text(std::string&& value) {
+        Level& top = stack_.back();
+        switch (top.frame) {
+            case Frame::Strings:
+                target<std::vector<std::string>>(top).push_back(std::move(value));
+                return true;
+            case Frame::Root:
+                switch (top.key) {
+                    case RootKey::Id: definition.id = std::move(value); return true;
+                    case RootKey::Title: definition.title = std::move(value); return true;
+                    case RootKey::Version: definition.version = std::move(value); return true;
+                    case RootKey::Source: definition.source = std::move(value); return true;
+                    case RootKey::MaterialsRef: definition.refs.materials = std::move(value); return true;
+                    case RootKey::MantrasRef: definition.refs.mantras = std::move(value); return true;
+                    case RootKey::ProceduresRef: definition.refs.procedures = std::move(value); return true;
+                }
+                break;
+            case Frame::Section: {
+                auto& section = target<Section>(top);
+                switch (top.key) {
+                    case SectionKey::Id: section.id = std::move(value); return true;
+                    case SectionKey::Title: section.title = std::move(value); return true;
+                    case SectionKey::DisciplineNote: section.notes = std::move(value); return true;
+                    // These two are modelled but also kept in additional_data, as
+                    // the document loader always did
+                    case SectionKey::Description:
+                        section.additional_data[top.name] = value;
+                        section.description = std::move(value);
+                        return true;
+                    case SectionKey::Introduction:
+                        section.additional_data[top.name] = value;
+                        section.introduction = std::move(value);
+                        return true;
+                }
+                break;
+            }
+            case Frame::Marker:
+                if (top.key == MarkerKey::Canonical) {
+                    target<ProgressMarker>(top).canonical = std::move(value);
+                    return true;
+                }
+                break;
+            case Frame::Part: {
+                auto& part = target<Part>(top);
+                switch (top.key) {
+                    case PartKey::Id: part.id = std::move(value); return true;
+                    case PartKey::Title: part.title = std::move(value); return true;
+                    case PartKey::Notes: part.notes = std::move(value); return true;
+                    case PartKey::Utterance: part.utterance = std::move(value); return true;
+                    // Also kept in additional_data, as for sections
+                    case PartKey::Description:
+                        part.additional_data[top.name] = value;
+                        part.description = std::move(value);
+                        return true;
+                    case PartKey::MantraRef:
+                        part.additional_data[top.name] = value;
+                        part.mantra_ref = std::move(value);
+                        return true;
+                }
+                break;
+            }
+            case Frame::Mantra: {
+                auto& mantra = target<Mantra>(top);
+                switch (top.key) {
+                    case MantraKey::Text: mantra.text = std::move(value); return true;
+                    case MantraKey::Type: mantra.type = std::move(value); return true;
+                }
+                break;
+            }
+            case Frame::Material: {
+                auto& material = target<Material>(top);
+                switch (top.key) {
+                    case MaterialKey::Id: material.id = std::move(value); return true;
+                    case MaterialKey::Name: material.name = std::move(value); return true;
+                    case MaterialKey::Details: material.details = std::move(value); return true;
+                }
+                break;
+            }
+            case Frame::Procedure: {
+                auto& step = target<Step>(top);
+                switch (top.key) {
+                    case ProcedureKey::Id: step.id = std::move(value); return true;
+                    case ProcedureKey::Title: step.title = std::move(value); return true;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        return keep(top, JsonValue(std::move(value)));
+    }
+
+    bool number(int64_t value, JsonValue&& json) {
+        Level& top = stack_.back();
+        if (top.frame == Frame::Counts) {
+            target<std::map<std::string, int>>(top)[top.name] = static_cast<int>(value);
+            return true;
+        }
+        if (top.frame == Frame::Part && top.key == PartKey::Repetitions) {
+            target<Part>(top).repetitions = static_cast<int>(value);
+            return true;
+        }
+        if (top.frame == Frame::Marker && top.key == MarkerKey::CooldownMs) {
+            target<ProgressMarker>(top).cooldown_ms = static_cast<int>(value);
+            return true;
+        }
+        return keep(top, std::move(json));
+    }
+
+    bool flag(bool value) {
+        Level& top = stack_.back();
+        if (top.frame == Frame::Marker && top.key == MarkerKey::WithSvahaVariants) {
+            target<ProgressMarker>(top).with_svaha_variants = value;
+            return true;
+        }
+        if (top.frame == Frame::Material && top.key == MaterialKey::Optional) {
+            target<Material>(top).optional = value;
+            return true;
+        }
+        return keep(top, JsonValue(value));
+    }
+
+    template <typename Table>
+    bool require(const Level& level, const Table& table, uint32_t required, const char* what) {
+        uint32_t missing = required & ~level.seen;
+        if (missing == 0) return true;
+        int key = 0;
+        while (!(missing & bit(key))) ++key;
+        return fail(std::string(what) + " is missing \"" + std::string(table.name(key)) + "\"");
+    }
+
+    bool close() {
+        Level done = std::move(stack_.back());
+        stack_.pop_back();
+        switch (done.frame) {
+            case Frame::Root: return require(done, RootKey::TABLE, RootKey::REQUIRED, "ritual");
+            case Frame::Section: return require(done, SectionKey::TABLE, SectionKey::REQUIRED, "section");
+            case Frame::Part: return require(done, PartKey::TABLE, PartKey::REQUIRED, "part");
+            case Frame::Marker: return require(done, MarkerKey::TABLE, MarkerKey::REQUIRED, "iteration_marker");
+            // Lists are filled one element at a time; keep only what they hold,
+            // as a list read from a document would
+            case Frame::Strings: target<std::vector<std::string>>(done).shrink_to_fit(); return true;
+            case Frame::StringLists: target<std::vector<std::vector<std::string>>>(done).shrink_to_fit(); return true;
+            case Frame::Sections: target<std::vector<Section>>(done).shrink_to_fit(); return true;
+            case Frame::Parts: target<std::vector<Part>>(done).shrink_to_fit(); return true;
+            case Frame::Materials: materials.shrink_to_fit(); return true;
+            case Frame::Material:
+                if ((done.seen & MaterialKey::REQUIRED) != MaterialKey::REQUIRED) {
+                    SADHANA_LOG_WARN("definition", "Skipping material: missing required fields (id or name)");
+                    materials.pop_back();
+                }
+                return true;
+            default:
+                return true;
+        }
+    }
+};
+
+bool run(Reader& reader, std::string_view text, std::string* error) {
+    bool ok = nlohmann::json::sax_parse(text.begin(), text.end(), &reader);
+    if (!ok && error) {
+        *error = reader.error.empty() ? "unexpected end of the document" : reader.error;
+    }
+    return ok;
+}
+
+}
+
+bool DefinitionReader::readDefinition(std::string_view text, RitualDefinition& definition,
+                                      RitualDefinition::CommonRefs& refs, std::string* error) {
+    Reader reader(Document::Definition);
+    if (!run(reader, text, error)) return false;
+
+    auto& parsed = reader.definition;
+    definition.id_ = std::move(parsed.id);
+    definition.title_ = std::move(parsed.title);
+    definition.version_ = std::move(parsed.version);
+    definition.source_ = std::move(parsed.source);
+    definition.metadata_ = std::move(parsed.metadata);
+    definition.sections_ = std::move(parsed.sections);
+    refs = std::move(parsed.refs);
+    return true;
+}
+
+std::shared_ptr<const RitualDefinition::MaterialList> DefinitionReader::readMaterials(std::string_view text,
+                                                                                      std::string* error) {
+    Reader reader(Document::Materials);
+    if (!run(reader, text, error)) return nullptr;
+    SADHANA_LOG_INFO("definition", "Loaded ", reader.materials.size(), " materials");
+    return std::make_shared<const RitualDefinition::MaterialList>(std::move(reader.materials));
+}
+
+std::shared_ptr<const RitualDefinition::MantraMap> DefinitionReader::readMantras(std::string_view text,
+                                                                                 std::string* error) {
+    Reader reader(Document::Mantras);
+    if (!run(reader, text, error)) return nullptr;
+    SADHANA_LOG_INFO("definition", "Loaded ", reader.mantras.size(), " mantras");
+    return std::make_shared<const RitualDefinition::MantraMap>(std::move(reader.mantras));
+}
+
+std::shared_ptr<const RitualDefinition::ProcedureMap> DefinitionReader::readProcedures(std::string_view text,
+                                                                                       std::string* error) {
+    Reader reader(Document::Procedures);
+    if (!run(reader, text, error)) return nullptr;
+    SADHANA_LOG_INFO("definition", "Loaded ", reader.procedures.size(), " procedures");
+    return std::make_shared<const RitualDefinition::ProcedureMap>(std::move(reader.procedures));
+}
+
+}
@@ -0,0 +1,87 @@
+#include "eval/offline_session.hpp"
+#include "host/ritual_assets.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace sadhana {
+
+OfflineSession::OfflineSession(const RitualDefinition& ritual, const VoskASR& asr, const Config& config)
+    : ritual_(ritual), asr_(asr), config_(config) {}
+
+OfflineSession::Result OfflineSession::run(const std::vector<float>& samples) {
+    Result result;
+    auto wallStart = std::chrono::steady_clock::now();
+
+    const int sampleRate = static_cast<int>(asr_.getConfig().sampleRate);
+    result.audioSeconds = static_cast<double>(samples.size()) / sampleRate;
+
+    // The caller keeps the definition alive; the flow and pipeline share one matcher
+    auto assets = std::make_shared<RitualAssets>();
+    assets->ritual = std::shared_ptr<const RitualDefinition>(&ritual_, [](const RitualDefinition*) {});
+    assets->matcher = std::make_shared<const PhraseManager>(ritual_);
+
+    SampleClock clock(sampleRate);
+    auto pipelineConfig = config_.pipeline;
+    pipelineConfig.sampleRate = sampleRate;
+    UtterancePipeline pipeline(asr_, clock, assets, pipelineConfig);
+    if (!pipeline.createRecognizers(&result.error)) {
+        return result;
+    }
+
+    FlowManager flow(ritual_, assets->matcher);
+    if (!flow.loadFlowConfiguration(config_.flowConfigPath)) {
+        result.error = "failed to load flow configuration: " + config_.flowConfigPath;
+        return result;
+    }
+    flow.setClock(clock);
+    flow.setUtteranceLog(config_.analytics);
+
+    // The flow is driven synchronously: each posted event is applied before
+    // the next block, and the pipeline follows it as the live app's does
+    auto settleFlow = [&]() {
+        auto progress = flow.snapshot();
+        if (config_.autoAdvance && progress->awaitingManualIntervention && !progress->complete) {
+            flow.postManualIntervention();
+            flow.processPending();
+            progress = flow.snapshot();
+        }
+        pipeline.followFlow(flow, *progress);
+    };
+    settleFlow();
+
+    for (size_t offset = 0; offset < samples.size(); offset += config_.blockFrames) {
+        size_t count = std::min(config_.blockFrames, samples.size() - offset);
+        clock.advance(count);
+        auto utterance = pipeline.processBlock(samples.data() + offset, count);
+        if (!utterance) continue;
+
+        auto begin = std::chrono::steady_clock::now();
+        auto transcript = pipeline.recognize(std::move(*utterance));
+        if (!transcript) continue;
+
+        int repetition = flow.snapshot()->currentRepetition;
+        flow.postRecognizedPhrase(transcript->text, transcript->match, transcript->assets,
+                                  transcript->decodeMs);
+        flow.processPending();
+        if (flow.snapshot()->currentRepetition > repetition) {
+            CountEvent event;
+            event.audioSeconds = static_cast<double>(offset + count) / sampleRate;
+            event.processingMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - begin).count();
+            event.text = transcript->text;
+            result.counts.push_back(std::move(event));
+        }
+        settleFlow();
+    }
+
+    result.pipeline = pipeline.stats();
+    result.utterances = result.pipeline.utterances;
+    result.rejected = result.pipeline.rejected;
+    result.finalProgress = *flow.snapshot();
+    result.processingSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wallStart).count();
+    result.ok = true;
+    return result;
+}
+
+}
@@ -0,0 +1,201 @@
+#include "event/event_loop.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+namespace {
+
+timespec toTimespec(std::chrono::milliseconds ms) {
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(ms.count() / 1000);
+    ts.tv_nsec = static_cast<long>((ms.count() % 1000) * 1000000);
+    return ts;
+}
+
+}
+
+EventLoop::~EventLoop() {
+    for (auto& [fd, watch] : watches_) {
+        (void)watch;
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    if (wakeFd_ >= 0) close(wakeFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+}
+
+bool EventLoop::init() {
+    if (epollFd_ >= 0) return true;
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd_ < 0) {
+        std::cerr << "epoll_create1 failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd_ < 0) {
+        std::cerr << "eventfd failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return addWatch(wakeFd_, std::make_shared<Watch>(Watch{[this](uint32_t) { drainWake(); }}));
+}
+
+bool EventLoop::addWatch(int fd, std::shared_ptr<Watch> watch) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        std::cerr << "epoll_ctl failed for fd " << fd << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    watches_[fd] = std::move(watch);
+    return true;
+}
+
+bool EventLoop::watchReadable(int fd, FdHandler handler) {
+    if (epollFd_ < 0) return false;
+    return addWatch(fd, std::make_shared<Watch>(Watch{std::move(handler)}));
+}
+
+bool EventLoop::setWritable(int fd, bool writable) {
+    auto it = watches_.find(fd);
+    if (it == watches_.end()) return false;
+    if (it->second->writable == writable) return true;
+
+    epoll_event event{};
+    event.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) < 0) {
+        std::cerr << "epoll_ctl failed for fd " << fd << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    it->second->writable = writable;
+    return true;
+}
+
+void EventLoop::unwatch(int fd) {
+    if (watches_.erase(fd) > 0) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+EventLoop::TimerId EventLoop::addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval,
+                                       Task callback) {
+    if (epollFd_ < 0) return -1;
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "timerfd_create failed: " << std::strerror(errno) << "\n";
+        return -1;
+    }
+
+    // A zero it_value would disarm the timer
+    itimerspec spec{};
+    spec.it_value = toTimespec(std::max(delay, std::chrono::milliseconds(0)));
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;
+    }
+    spec.it_interval = toTimespec(interval);
+    if (timerfd_settime(fd, 0, &spec, nullptr) < 0) {
+        std::cerr << "timerfd_settime failed: " << std::strerror(errno) << "\n";
+        close(fd);
+        return -1;
+    }
+
+    bool oneShot = interval.count() <= 0;
+    auto handler = [this, fd, oneShot, callback = std::move(callback)](uint32_t) {
+        uint64_t expirations = 0;
+        if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            return;
+        }
+        // Missed expirations collapse into one call; callers want the latest tick, not a backlog
+        callback();
+        if (oneShot) {
+            cancelTimer(fd);
+        }
+    };
+    if (!addWatch(fd, std::make_shared<Watch>(Watch{std::move(handler)}))) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void EventLoop::cancelTimer(TimerId id) {
+    if (id < 0 || watches_.find(id) == watches_.end()) return;
+    unwatch(id);
+    close(id);
+}
+
+void EventLoop::post(Task task) {
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        wasEmpty = posted_.empty();
+        posted_.push_back(std::move(task));
+    }
+    // Tasks posted while a wake is already pending ride along with it
+    if (wasEmpty) {
+        signalWake();
+    }
+}
+
+void EventLoop::signalWake() {
+    if (wakeFd_ < 0) return;
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd_, &one, sizeof(one));
+    (void)written;  // EAGAIN means the counter is already non-zero
+}
+
+void EventLoop::drainWake() {
+    uint64_t value = 0;
+    ssize_t n = read(wakeFd_, &value, sizeof(value));
+    (void)n;
+
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        std::swap(runQueue_, posted_);
+    }
+    for (auto& task : runQueue_) {
+        task();
+    }
+    runQueue_.clear();
+}
+
+bool EventLoop::run() {
+    if (epollFd_ < 0) return false;
+
+    constexpr int MAX_EVENTS = 64;
+    epoll_event events[MAX_EVENTS];
+
+    while (!stopRequested_.load(std::memory_order_acquire)) {
+        int count = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << "\n";
+            return false;
+        }
+
+        for (int i = 0; i < count && !stopRequested_.load(std::memory_order_acquire); ++i) {
+            // Hold the watch so a handler can unwatch itself or others mid-dispatch
+            auto it = watches_.find(events[i].data.fd);
+            if (it == watches_.end()) continue;
+            std::shared_ptr<Watch> watch = it->second;
+            watch->handler(events[i].events);
+        }
+    }
+    return true;
+}
+
+void EventLoop::stop() {
+    stopRequested_.store(true, std::memory_order_release);
+    signalWake();
+}
+
+}
@@ -0,0 +1,50 @@
+#include "host/ritual_assets.hpp"
+#include <fstream>
+#include <iterator>
+
+namespace sadhana {
+
+std::shared_ptr<const RitualAssets> RitualAssets::load(const std::string& ritualPath,
+                                                       const std::string& flowPath,
+                                                       std::string* error) {
+    return load(ritualPath, flowPath,
+                RitualDefinition::directoryResolver(RitualDefinition::commonDirectoryFor(ritualPath)),
+                error);
+}
+
+std::shared_ptr<const RitualAssets> RitualAssets::load(const std::string& ritualPath,
+                                                       const std::string& flowPath,
+                                                       const RitualDefinition::CommonResolver& resolver,
+                                                       std::string* error) {
+    auto fail = [error](const std::string& message) -> std::shared_ptr<const RitualAssets> {
+        if (error) *error = message;
+        return nullptr;
+    };
+
+    auto ritual = std::make_shared<RitualDefinition>();
+    {
+        std::ifstream file(ritualPath, std::ios::binary);
+        if (!file.is_open()) {
+            return fail("failed to open ritual definition: " + ritualPath);
+        }
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::string ritualError;
+        if (!ritual->loadFromText(text, resolver, &ritualError)) {
+            return fail("failed to load ritual definition " + ritualPath + ": " + ritualError);
+        }
+    }
+
+    auto assets = std::make_shared<RitualAssets>();
+    try {
+        std::ifstream file(flowPath);
+        assets->flowConfig = nlohmann::json::parse(file);
+    } catch (const std::exception& e) {
+        return fail("failed to load flow configuration " + flowPath + ": " + e.what());
+    }
+
+    assets->ritual = std::move(ritual);
+    assets->matcher = std::make_shared<const PhraseManager>(*assets->ritual);
+    return assets;
+}
+
+}
@@ -0,0 +1,330 @@
+#include "host/ritual_library.hpp"
+#include "definition/definition_reader.hpp"
+#include "log/logger.hpp"
+#include "trace/tracer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace sadhana {
+
+namespace {
+
+// Collects the top-level id, title and version of a definition and stops
+// the parse as soon as it has them, so the sections are never read
+class CatalogSax : public nlohmann::json_sax<nlohmann::json> {
+public:
+    std::string id;
+    std::string title;
+    std::string version;
+    std::string error;
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t) override { return true; }
+    bool number_unsigned(number_unsigned_t) override { return true; }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& value) override {
+        if (depth_ == 1 && field_) {
+            *field_ = value;
+            field_ = nullptr;
+            return id.empty() || title.empty() || version.empty();
+        }
+        return true;
+    }
+
+    bool key(string_t& value) override {
+        field_ = nullptr;
+        if (depth_ == 1) {
+            if (value == "id") field_ = &id;
+            else if (value == "title") field_ = &title;
+            else if (value == "version") field_ = &version;
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        field_ = nullptr;
+        ++depth_;
+        return true;
+    }
+    bool end_object() override {
+        --depth_;
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        field_ = nullptr;
+        ++depth_;
+        return true;
+    }
+    bool end_array() override {
+        --depth_;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) override {
+        error = e.what();
+        return false;
+    }
+
+private:
+    int depth_{0};
+    std::string* field_{nullptr};
+};
+
+bool isFlowFile(const std::filesystem::path& path) {
+    auto name = path.filename().string();
+    return name == "flow.json" ||
+           (name.size() > 10 && name.compare(name.size() - 10, 10, ".flow.json") == 0);
+}
+
+}
+
+RitualLibrary::RitualLibrary() : RitualLibrary(Config()) {}
+
+RitualLibrary::RitualLibrary(const Config& config) : config_(config) {
+    if (config_.workers == 0) {
+        config_.workers = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+    }
+    for (size_t i = 0; i < config_.workers; ++i) {
+        workers_.emplace_back([this]() { runWorker(); });
+    }
+}
+
+RitualLibrary::~RitualLibrary() {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        running_ = false;
+    }
+    jobsCv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    // Whoever waits on a load still queued gets an error rather than broken_promise
+    for (auto& job : jobs_) {
+        job(true);
+    }
+    jobs_.clear();
+}
+
+bool RitualLibrary::scan(std::string* error) {
+    namespace fs = std::filesystem;
+    auto definitions = fs::path(config_.root) / "definitions";
+
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(definitions, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file() && it->path().extension() == ".json" && !isFlowFile(it->path())) {
+            files.push_back(it->path());
+        }
+    }
+    if (ec) {
+        if (error) *error = definitions.string() + ": " + ec.message();
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    std::map<std::string, Entry> catalog;
+    for (const auto& path : files) {
+        std::ifstream file(path);
+        CatalogSax sax;
+        nlohmann::json::sax_parse(file, &sax);
+        if (!sax.error.empty() || sax.id.empty()) {
+            SADHANA_LOG_WARN("library", "Skipping ", path.string(), ": ",
+                             sax.error.empty() ? "no ritual id" : sax.error);
+            continue;
+        }
+
+        Entry entry;
+        entry.id = sax.id;
+        entry.title = sax.title;
+        entry.version = sax.version;
+        entry.definitionPath = path.string();
+        auto flow = path.parent_path() / (path.stem().string() + ".flow.json");
+        entry.flowPath = (fs::exists(flow) ? flow : path.parent_path() / "flow.json").string();
+
+        auto [it, inserted] = catalog.emplace(entry.id, entry);
+        if (!inserted) {
+            SADHANA_LOG_WARN("library", "Ritual '", entry.id, "' in ", entry.definitionPath,
+                             " is already defined by ", it->second.definitionPath);
+        }
+    }
+
+    SADHANA_LOG_INFO("library", "Found ", catalog.size(), " rituals under ", definitions.string());
+    std::lock_guard<std::mutex> lock(mutex_);
+    catalog_ = std::move(catalog);
+    return true;
+}
+
+std::vector<RitualLibrary::Entry> RitualLibrary::catalog() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Entry> entries;
+    entries.reserve(catalog_.size());
+    for (const auto& [id, entry] : catalog_) {
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+std::optional<RitualLibrary::Entry> RitualLibrary::find(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = catalog_.find(id);
+    if (it == catalog_.end()) return std::nullopt;
+    return it->second;
+}
+
+std::shared_future<RitualLibrary::LoadResult> RitualLibrary::loadAsync(const std::string& id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto loaded = loads_.find(id);
+    if (loaded != loads_.end()) {
+        return loaded->second;
+    }
+
+    auto entry = catalog_.find(id);
+    if (entry == catalog_.end()) {
+        std::promise<LoadResult> missing;
+        missing.set_value(LoadResult{nullptr, "no ritual '" + id + "' in " + config_.root});
+        return missing.get_future().share();
+    }
+
+    Entry toLoad = entry->second;
+    auto promise = std::make_shared<std::promise<LoadResult>>();
+    auto future = promise->get_future().share();
+    loads_.emplace(id, future);
+    lock.unlock();
+
+    std::function<void(bool)> job = [this, promise, entry = std::move(toLoad)](bool cancelled) {
+        auto result = cancelled
+            ? LoadResult{nullptr, "ritual library shut down before loading '" + entry.id + "'"}
+            : loadEntry(entry);
+        if (!result.assets) {
+            // A failed load is not remembered, so a later call tries again
+            std::lock_guard<std::mutex> lock(mutex_);
+            loads_.erase(entry.id);
+        }
+        promise->set_value(std::move(result));
+    };
+    {
+        std::lock_guard<std::mutex> jobsLock(jobsMutex_);
+        if (running_) {
+            jobs_.push_back(std::move(job));
+            job = nullptr;
+        }
+    }
+    if (job) {
+        job(true);  // shutting down; no worker would take it
+        return future;
+    }
+    jobsCv_.notify_one();
+    return future;
+}
+
+std::shared_ptr<const RitualAssets> RitualLibrary::load(const std::string& id, std::string* error) {
+    auto result = loadAsync(id).get();
+    if (!result.assets && error) *error = result.error;
+    return result.assets;
+}
+
+void RitualLibrary::release(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loads_.erase(id);
+}
+
+RitualLibrary::Stats RitualLibrary::stats() const {
+    Stats stats;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.rituals = catalog_.size();
+    stats.loaded = loads_.size();
+    for (const auto& [key, slot] : common_) {
+        std::lock_guard<std::mutex> slotLock(slot->mutex);
+        if (!slot->value.expired()) ++stats.commonLive;
+    }
+    stats.commonParsed = commonParsed_.load();
+    stats.commonShared = commonShared_.load();
+    return stats;
+}
+
+void RitualLibrary::runWorker() {
+    SADHANA_TRACE_THREAD("ritual-loader");
+    for (;;) {
+        std::function<void(bool)> job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex_);
+            jobsCv_.wait(lock, [this]() { return !running_ || !jobs_.empty(); });
+            if (!running_) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job(false);
+    }
+}
+
+RitualLibrary::LoadResult RitualLibrary::loadEntry(const Entry& entry) {
+    auto start = std::chrono::steady_clock::now();
+    LoadResult result;
+    result.assets = RitualAssets::load(entry.definitionPath, entry.flowPath, resolver(), &result.error);
+    if (result.assets) {
+        SADHANA_LOG_INFO("library", "Loaded '", entry.id, "' in ",
+                         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                         " ms");
+    } else {
+        SADHANA_LOG_ERROR("library", result.error);
+    }
+    return result;
+}
+
+RitualDefinition::CommonResolver RitualLibrary::resolver() {
+    RitualDefinition::CommonResolver resolver;
+    resolver.materials = [this](const std::string& ref, std::string* error) {
+        return common<RitualDefinition::MaterialList>("materials", ref, &DefinitionReader::readMaterials, true, error);
+    };
+    resolver.mantras = [this](const std::string& ref, std::string* error) {
+        return common<RitualDefinition::MantraMap>("mantras", ref, &DefinitionReader::readMantras, false, error);
+    };
+    resolver.procedures = [this](const std::string& ref, std::string* error) {
+        return common<RitualDefinition::ProcedureMap>("procedures", ref, &DefinitionReader::readProcedures, false, error);
+    };
+    return resolver;
+}
+
+template <typename T>
+std::shared_ptr<const T> RitualLibrary::common(const std::string& kind, const std::string& ref,
+                                               std::shared_ptr<const T> (*read)(std::string_view, std::string*),
+                                               bool optional, std::string* error) {
+    std::shared_ptr<CommonSlot> slot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = common_[kind + "/" + ref];
+        if (!entry) entry = std::make_shared<CommonSlot>();
+        slot = entry;
+    }
+
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (auto value = slot->value.lock()) {
+        commonShared_.fetch_add(1);
+        return std::static_pointer_cast<const T>(value);
+    }
+
+    auto path = std::filesystem::path(config_.root) / "common" / kind / (ref + ".json");
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        if (!optional && error) *error = "failed to open " + path.string();
+        return nullptr;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string readError;
+    auto value = read(text, &readError);
+    if (!value) {
+        if (error) *error = "error parsing " + path.string() + ": " + readError;
+        return nullptr;
+    }
+    commonParsed_.fetch_add(1);
+    slot->value = value;
+    return value;
+}
+
+}
@@ -0,0 +1,196 @@
+#include "host/ritual_watcher.hpp"
+#include "log/logger.hpp"
+#include "trace/tracer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+namespace {
+
+constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+}
+
+RitualWatcher::RitualWatcher(const Config& config)
+    : config_(config)
+    , reloadsMetric_(MetricsRegistry::instance().counter(
+          "sadhana_ritual_reloads_total", "Ritual definitions recompiled after an edit and taken into use"))
+    , failuresMetric_(MetricsRegistry::instance().counter(
+          "sadhana_ritual_reload_failures_total", "Edited ritual definitions that failed to load or were refused"))
+    , reloadSecondsMetric_(MetricsRegistry::instance().histogram(
+          "sadhana_ritual_reload_seconds", "Time to parse a ritual and compile its matcher", 0.0001, 10.0)) {}
+
+RitualWatcher::~RitualWatcher() {
+    stop();
+}
+
+bool RitualWatcher::start() {
+    if (running_.load()) return true;
+
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotifyFd_ < 0 || wakeFd_ < 0) {
+        std::cerr << "Failed to set up ritual watcher: " << std::strerror(errno) << "\n";
+        stop();
+        return false;
+    }
+
+    // Directories rather than files: editors replace a file by renaming a new
+    // one over it, which would silently end a watch on the file itself
+    namespace fs = std::filesystem;
+    auto ritualDir = fs::absolute(config_.ritualPath).parent_path();
+    auto flowDir = fs::absolute(config_.flowPath).parent_path();
+    ritualDirWatch_ = inotify_add_watch(inotifyFd_, ritualDir.c_str(), WATCH_MASK);
+    flowDirWatch_ = inotify_add_watch(inotifyFd_, flowDir.c_str(), WATCH_MASK);
+    if (ritualDirWatch_ < 0 || flowDirWatch_ < 0) {
+        std::cerr << "Failed to watch " << ritualDir << ": " << std::strerror(errno) << "\n";
+        stop();
+        return false;
+    }
+    auto common = fs::path(RitualDefinition::commonDirectoryFor(config_.ritualPath));
+    for (const char* kind : {"materials", "mantras", "procedures"}) {
+        auto dir = common / kind;
+        if (fs::is_directory(dir) && inotify_add_watch(inotifyFd_, dir.c_str(), WATCH_MASK) < 0) {
+            SADHANA_LOG_WARN("watcher", "Cannot watch ", dir.string(), ": ", std::strerror(errno));
+        }
+    }
+
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+    SADHANA_LOG_INFO("watcher", "Watching ", config_.ritualPath, " and ", config_.flowPath);
+    return true;
+}
+
+void RitualWatcher::stop() {
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        [[maybe_unused]] auto n = ::write(wakeFd_, &one, sizeof(one));
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+    if (inotifyFd_ >= 0) {
+        ::close(inotifyFd_);
+        inotifyFd_ = -1;
+    }
+    if (wakeFd_ >= 0) {
+        ::close(wakeFd_);
+        wakeFd_ = -1;
+    }
+}
+
+RitualWatcher::Stats RitualWatcher::stats() const {
+    Stats stats;
+    stats.reloads = reloads_.load();
+    stats.failures = failures_.load();
+    stats.lastReloadMs = lastReloadMs_.load();
+    std::lock_guard<std::mutex> lock(versionMutex_);
+    stats.version = version_;
+    return stats;
+}
+
+void RitualWatcher::run() {
+    SADHANA_TRACE_THREAD("ritual-watcher");
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    bool pending = false;
+    auto deadline = std::chrono::steady_clock::now();
+
+    while (running_.load(std::memory_order_acquire)) {
+        int timeout = -1;
+        if (pending) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            timeout = static_cast<int>(std::max<int64_t>(0, left));
+        }
+
+        pollfd fds[2] = {{inotifyFd_, POLLIN, 0}, {wakeFd_, POLLIN, 0}};
+        int ready = ::poll(fds, 2, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            SADHANA_LOG_ERROR("watcher", "poll failed: ", std::strerror(errno));
+            return;
+        }
+        if (fds[1].revents & POLLIN) break;
+
+        if (fds[0].revents & POLLIN) {
+            ssize_t n;
+            while ((n = ::read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+                if (relevant(buffer, static_cast<size_t>(n))) {
+                    // Every further write restarts the quiet period
+                    pending = true;
+                    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.debounceMs);
+                }
+            }
+            continue;
+        }
+
+        if (pending && std::chrono::steady_clock::now() >= deadline) {
+            pending = false;
+            reload();
+        }
+    }
+}
+
+bool RitualWatcher::relevant(const char* buffer, size_t length) const {
+    namespace fs = std::filesystem;
+    auto ritualName = fs::path(config_.ritualPath).filename().string();
+    auto flowName = fs::path(config_.flowPath).filename().string();
+
+    for (size_t offset = 0; offset < length;) {
+        const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+        offset += sizeof(struct inotify_event) + event->len;
+        if (event->len == 0 || (event->mask & IN_ISDIR)) continue;
+
+        std::string name(event->name);
+        if (event->wd == ritualDirWatch_ && name == ritualName) return true;
+        if (event->wd == flowDirWatch_ && name == flowName) return true;
+        if (event->wd != ritualDirWatch_ && event->wd != flowDirWatch_ &&
+            fs::path(name).extension() == ".json") {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RitualWatcher::reload() {
+    SADHANA_TRACE_SPAN("ritual.reload");
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    // Common files are read afresh: a shared copy would be the one being replaced
+    auto assets = RitualAssets::load(config_.ritualPath, config_.flowPath, &error);
+    double reloadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (!assets) {
+        failures_.fetch_add(1);
+        failuresMetric_.inc();
+        SADHANA_LOG_ERROR("watcher", "Keeping the running ritual: ", error);
+        return;
+    }
+    if (reloadCallback_ && !reloadCallback_(assets, reloadMs)) {
+        failures_.fetch_add(1);
+        failuresMetric_.inc();
+        return;
+    }
+
+    reloads_.fetch_add(1);
+    reloadsMetric_.inc();
+    reloadSecondsMetric_.observe(reloadMs / 1000.0);
+    lastReloadMs_.store(reloadMs);
+    {
+        std::lock_guard<std::mutex> lock(versionMutex_);
+        version_ = assets->ritual->getVersion();
+    }
+    SADHANA_LOG_INFO("watcher", "Reloaded ", assets->ritual->getId(), " version ",
+                     assets->ritual->getVersion(), " in ", reloadMs, " ms");
+}
+
+}
@@ -0,0 +1,179 @@
+#include "host/session.hpp"
+#include "host/session_host.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace sadhana {
+
+namespace {
+// Time constant of recentRtf, in seconds of processed audio
+constexpr double RECENT_RTF_TAU_SECONDS = 30.0;
+
+UtterancePipeline::Config withSampleRate(UtterancePipeline::Config config, int sampleRate) {
+    config.sampleRate = sampleRate;
+    return config;
+}
+}
+
+Session::Session(SessionHost& host, std::shared_ptr<const RitualAssets> assets,
+                 const VoskASR& asr, int sampleRate, const Config& config)
+    : host_(host),
+      assets_(std::move(assets)),
+      sampleRate_(sampleRate),
+      config_(config),
+      clock_(sampleRate),
+      pipeline_(asr, clock_, assets_, withSampleRate(config.pipeline, sampleRate)),
+      flow_(*assets_->ritual, assets_->matcher),
+      queue_(config.queueBlocks) {
+    flow_.setClock(clock_);
+}
+
+bool Session::init(std::string* error) {
+    if (!flow_.setFlowConfiguration(assets_->flowConfig)) {
+        if (error) *error = "invalid flow configuration";
+        return false;
+    }
+    if (!pipeline_.createRecognizers(error)) {
+        return false;
+    }
+    settleFlow();
+    return true;
+}
+
+namespace {
+
+inline float toFloat(float sample) { return sample; }
+inline float toFloat(int16_t sample) { return static_cast<float>(sample) * (1.0f / 32768.0f); }
+
+}
+
+template <typename Sample>
+bool Session::pushSamples(const Sample* samples, size_t count) {
+    if (closed_.load(std::memory_order_acquire)) return false;
+
+    bool ok = true;
+    while (count > 0) {
+        size_t n = std::min(count, MAX_BLOCK_FRAMES);
+        bool pushed = queue_.tryPushWith([&](AudioBlock& block) {
+            for (size_t i = 0; i < n; ++i) {
+                block.samples[i] = toFloat(samples[i]);
+            }
+            block.count = n;
+        });
+        if (!pushed) {
+            droppedBlocks_.fetch_add(1, std::memory_order_relaxed);
+            ok = false;
+        }
+        samples += n;
+        count -= n;
+    }
+
+    // Pairs with the fence in SessionHost::runWorker so a worker either sees
+    // this audio or this call sees the session unscheduled
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    host_.schedule(shared_from_this());
+    return ok;
+}
+
+bool Session::pushAudio(const float* samples, size_t count) {
+    return pushSamples(samples, count);
+}
+
+bool Session::pushAudio(const int16_t* samples, size_t count) {
+    return pushSamples(samples, count);
+}
+
+void Session::postManualIntervention() {
+    flow_.postManualIntervention();
+    manualPending_.store(true, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    host_.schedule(shared_from_this());
+}
+
+Session::Stats Session::stats() const {
+    Stats stats;
+    stats.id = config_.id;
+    stats.audioSeconds = static_cast<double>(audioFrames_.load(std::memory_order_relaxed)) / sampleRate_;
+    stats.busySeconds = static_cast<double>(busyNs_.load(std::memory_order_relaxed)) / 1e9;
+    stats.rtf = stats.audioSeconds > 0.0 ? stats.busySeconds / stats.audioSeconds : 0.0;
+    stats.recentRtf = recentRtf_.load(std::memory_order_relaxed);
+    stats.backlogBlocks = queue_.size();
+    stats.droppedBlocks = droppedBlocks_.load(std::memory_order_relaxed);
+    stats.pipeline = pipeline_.stats();
+    stats.utterances = stats.pipeline.utterances;
+    stats.rejected = stats.pipeline.rejected;
+    return stats;
+}
+
+void Session::runSlice(size_t maxBlocks) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Key presses posted since the last slice
+    if (manualPending_.exchange(false, std::memory_order_acq_rel) && flow_.processPending() > 0) {
+        settleFlow();
+    }
+
+    size_t frames = 0;
+    AudioBlock block;
+    for (size_t i = 0; i < maxBlocks && !closed_.load(std::memory_order_acquire); ++i) {
+        if (!queue_.tryPop(block)) break;
+        processBlock(block);
+        frames += block.count;
+    }
+
+    auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    busyNs_.fetch_add(static_cast<uint64_t>(busy.count()), std::memory_order_relaxed);
+    audioFrames_.fetch_add(frames, std::memory_order_relaxed);
+    if (frames == 0) return;
+
+    // Weighted by audio time, so a slice of 10 blocks counts as much as 10 slices of one
+    double audioSeconds = static_cast<double>(frames) / sampleRate_;
+    double sliceRtf = static_cast<double>(busy.count()) / 1e9 / audioSeconds;
+    double recent = recentRtf_.load(std::memory_order_relaxed);
+    if (recentAudioSeconds_ == 0.0) {
+        recent = sliceRtf;
+    } else {
+        double alpha = 1.0 - std::exp(-audioSeconds / RECENT_RTF_TAU_SECONDS);
+        recent += alpha * (sliceRtf - recent);
+    }
+    recentAudioSeconds_ += audioSeconds;
+    recentRtf_.store(recent, std::memory_order_relaxed);
+}
+
+void Session::processBlock(const AudioBlock& block) {
+    clock_.advance(block.count);
+    if (auto utterance = pipeline_.processBlock(block.samples.data(), block.count)) {
+        finishUtterance(std::move(*utterance));
+    }
+}
+
+// Same decisions as the live processor, made inline on the worker
+void Session::finishUtterance(UtterancePipeline::Utterance utterance) {
+    auto transcript = pipeline_.recognize(std::move(utterance));
+    if (!transcript) return;
+
+    auto begin = std::chrono::steady_clock::now();
+    const float confidence = transcript->match.confidence;
+    if (transcriptionCallback_) {
+        transcriptionCallback_(transcript->text, confidence);
+    }
+    flow_.postRecognizedPhrase(transcript->text, transcript->match, transcript->assets,
+                               transcript->decodeMs);
+    flow_.processPending();
+    settleFlow();
+    pipeline_.recordMatch(std::chrono::steady_clock::now() - begin);
+}
+
+void Session::settleFlow() {
+    auto progress = flow_.snapshot();
+    if (config_.autoAdvance && progress->awaitingManualIntervention && !progress->complete) {
+        flow_.postManualIntervention();
+        flow_.processPending();
+        progress = flow_.snapshot();
+    }
+    pipeline_.followFlow(flow_, *progress);
+}
+
+}
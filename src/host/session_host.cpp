@@ -0,0 +1,218 @@
+#include "host/session_host.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace sadhana {
+
+SessionHost::SessionHost(std::shared_ptr<const VoskASR> asr)
+    : SessionHost(std::move(asr), Config()) {}
+
+SessionHost::SessionHost(std::shared_ptr<const VoskASR> asr, const Config& config)
+    : asr_(std::move(asr)),
+      config_(config),
+      sampleRate_(static_cast<int>(asr_->getConfig().sampleRate)),
+      sessionsMetric_(MetricsRegistry::instance().gauge(
+          "sadhana_host_sessions", "Sessions currently open in the host")),
+      utilizationMetric_(MetricsRegistry::instance().gauge(
+          "sadhana_host_utilization", "Summed recent real-time factor of all sessions per worker")),
+      rejectedMetric_(MetricsRegistry::instance().counter(
+          "sadhana_host_rejected_total", "Sessions refused by admission control")) {
+    if (config_.workers == 0) {
+        config_.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    config_.sliceBlocks = std::max<size_t>(1, config_.sliceBlocks);
+}
+
+SessionHost::~SessionHost() {
+    stop();
+}
+
+bool SessionHost::start() {
+    std::lock_guard<std::mutex> lock(readyMutex_);
+    if (running_) return true;
+    running_ = true;
+    for (size_t i = 0; i < config_.workers; ++i) {
+        workers_.emplace_back(&SessionHost::runWorker, this);
+    }
+    return true;
+}
+
+void SessionHost::stop() {
+    std::map<std::string, std::shared_ptr<Session>> sessions;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        sessions.swap(sessions_);
+    }
+    for (auto& [id, session] : sessions) {
+        session->closed_.store(true, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(readyMutex_);
+        running_ = false;
+    }
+    readyCv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    workers_.clear();
+    ready_.clear();
+    sessionsMetric_.set(0.0);
+}
+
+std::shared_ptr<Session> SessionHost::openSession(std::shared_ptr<const RitualAssets> assets,
+                                                  const Session::Config& config,
+                                                  std::string* error) {
+    auto reject = [&](const std::string& reason) -> std::shared_ptr<Session> {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        rejectedMetric_.inc();
+        if (error) *error = reason;
+        return nullptr;
+    };
+
+    if (!assets || !assets->ritual || !assets->matcher) {
+        return reject("missing ritual assets");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        std::string reason;
+        if (sessions_.count(config.id)) return reject("session id already in use: " + config.id);
+        if (!canAdmitLocked(&reason)) return reject(reason);
+    }
+
+    // Recognizer and flow setup happen outside the lock; the models themselves are shared
+    auto session = std::make_shared<Session>(*this, std::move(assets), *asr_, sampleRate_, config);
+    std::string initError;
+    if (!session->init(&initError)) return reject(initError);
+
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        // Checked again: other sessions may have been admitted meanwhile
+        std::string reason;
+        if (sessions_.count(config.id)) return reject("session id already in use: " + config.id);
+        if (!canAdmitLocked(&reason)) return reject(reason);
+        sessions_.emplace(config.id, session);
+        sessionsMetric_.set(static_cast<double>(sessions_.size()));
+    }
+    admitted_.fetch_add(1, std::memory_order_relaxed);
+    SADHANA_LOG_DEBUG("host", "Opened session ", config.id);
+    return session;
+}
+
+void SessionHost::closeSession(const std::string& id) {
+    std::shared_ptr<Session> session;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        auto it = sessions_.find(id);
+        if (it == sessions_.end()) return;
+        session = std::move(it->second);
+        sessions_.erase(it);
+        sessionsMetric_.set(static_cast<double>(sessions_.size()));
+    }
+    // A worker still holding it finishes its current block and drops it
+    session->closed_.store(true, std::memory_order_release);
+}
+
+double SessionHost::loadLocked() const {
+    double load = 0.0;
+    for (const auto& [id, session] : sessions_) {
+        auto stats = session->stats();
+        double rtf = stats.recentRtf;
+        if (stats.audioSeconds < config_.warmupSeconds) {
+            rtf = std::max(rtf, config_.newSessionRtf);
+        }
+        load += rtf;
+    }
+    return load;
+}
+
+bool SessionHost::canAdmitLocked(std::string* reason) const {
+    auto fail = [reason](const std::string& message) {
+        if (reason) *reason = message;
+        return false;
+    };
+
+    if (sessions_.size() >= config_.maxSessions) {
+        return fail("session limit reached (" + std::to_string(config_.maxSessions) + ")");
+    }
+    for (const auto& [id, session] : sessions_) {
+        if (session->queue_.size() > config_.maxBacklogBlocks) {
+            return fail("session " + id + " is falling behind");
+        }
+    }
+
+    double projected = (loadLocked() + config_.newSessionRtf) / static_cast<double>(config_.workers);
+    if (projected > config_.maxUtilization) {
+        return fail("projected utilization " + std::to_string(projected) +
+                    " exceeds " + std::to_string(config_.maxUtilization));
+    }
+    return true;
+}
+
+bool SessionHost::canAdmit(std::string* reason) const {
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    return canAdmitLocked(reason);
+}
+
+double SessionHost::utilization() const {
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    return loadLocked() / static_cast<double>(config_.workers);
+}
+
+SessionHost::Stats SessionHost::stats() const {
+    Stats stats;
+    stats.workers = config_.workers;
+    stats.admitted = admitted_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    stats.sessions = sessions_.size();
+    for (const auto& [id, session] : sessions_) {
+        stats.perSession.push_back(session->stats());
+    }
+    stats.utilization = loadLocked() / static_cast<double>(config_.workers);
+    utilizationMetric_.set(stats.utilization);
+    return stats;
+}
+
+void SessionHost::schedule(std::shared_ptr<Session> session) {
+    if (session->scheduled_.exchange(true, std::memory_order_acq_rel)) return;
+    {
+        std::lock_guard<std::mutex> lock(readyMutex_);
+        if (!running_) {
+            session->scheduled_.store(false, std::memory_order_release);
+            return;
+        }
+        ready_.push_back(std::move(session));
+    }
+    readyCv_.notify_one();
+}
+
+void SessionHost::runWorker() {
+    for (;;) {
+        std::shared_ptr<Session> session;
+        {
+            std::unique_lock<std::mutex> lock(readyMutex_);
+            readyCv_.wait(lock, [this] { return !running_ || !ready_.empty(); });
+            if (!running_) return;
+            session = std::move(ready_.front());
+            ready_.pop_front();
+        }
+
+        if (!session->isClosed()) {
+            session->runSlice(config_.sliceBlocks);
+        }
+
+        // Unscheduled first, then checked: input that arrived during the slice
+        // either sees the flag cleared and schedules itself, or is seen here
+        session->scheduled_.store(false, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!session->isClosed() && session->hasPendingWork()) {
+            schedule(std::move(session));
+        }
+    }
+}
+
+}
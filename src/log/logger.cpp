@@ -0,0 +1,154 @@
+#include "log/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+namespace sadhana {
+
+namespace {
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO ";
+        case LogLevel::Warn: return "WARN ";
+        case LogLevel::Error: return "ERROR";
+        case LogLevel::Off: break;
+    }
+    return "";
+}
+
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+// Registering here also makes the registry outlive the logger's final flush
+Logger::Logger()
+    : droppedMetric_(MetricsRegistry::instance().counter(
+          "sadhana_log_dropped_total", "Log messages dropped because their thread's ring was full")) {
+    writer_ = std::thread([this]() { run(); });
+}
+
+Logger::~Logger() {
+    running_ = false;
+    wakeup_.notify();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    flush();
+    if (output_ != stderr) {
+        std::fclose(output_);
+    }
+}
+
+int64_t Logger::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Logger::ThreadRing& Logger::threadRing() {
+    // Rings stay registered after their thread exits so nothing is lost
+    thread_local std::shared_ptr<ThreadRing> ring;
+    if (!ring) {
+        ring = std::make_shared<ThreadRing>();
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        ring->id = static_cast<uint32_t>(rings_.size() + 1);
+        rings_.push_back(ring);
+    }
+    return *ring;
+}
+
+LogLevel Logger::parseLevel(std::string_view name, LogLevel fallback) {
+    if (name == "trace") return LogLevel::Trace;
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "info") return LogLevel::Info;
+    if (name == "warn") return LogLevel::Warn;
+    if (name == "error") return LogLevel::Error;
+    if (name == "off") return LogLevel::Off;
+    return fallback;
+}
+
+bool Logger::setOutputFile(const std::string& path) {
+    std::FILE* file = stderr;
+    if (!path.empty()) {
+        file = std::fopen(path.c_str(), "a");
+        if (!file) return false;
+    }
+
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    if (output_ != stderr) {
+        std::fclose(output_);
+    }
+    output_ = file;
+    toConsole_.store(file == stderr, std::memory_order_relaxed);
+    return true;
+}
+
+void Logger::flush() {
+    drain();
+}
+
+void Logger::drain() {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> ringsLock(ringsMutex_);
+        rings = rings_;
+    }
+
+    batch_.clear();
+    Record record;
+    for (auto& ring : rings) {
+        while (ring->queue.tryPop(record)) {
+            batch_.push_back(record);
+        }
+    }
+    if (batch_.empty()) return;
+
+    std::stable_sort(batch_.begin(), batch_.end(),
+                     [](const Record& a, const Record& b) { return a.timeNs < b.timeNs; });
+
+    // Messages queued just before the console floor was raised stay off the
+    // terminal too
+    LogLevel floor = output_ == stderr ? consoleFloor_.load(std::memory_order_relaxed) : LogLevel::Trace;
+    for (const auto& entry : batch_) {
+        if (entry.level < floor) continue;
+        std::time_t seconds = static_cast<std::time_t>(entry.timeNs / 1000000000);
+        std::tm local{};
+        localtime_r(&seconds, &local);
+        char stamp[16];
+        std::strftime(stamp, sizeof(stamp), "%H:%M:%S", &local);
+        std::fprintf(output_, "%s.%03d %s [%s] t%u %.*s\n", stamp,
+                     static_cast<int>(entry.timeNs / 1000000 % 1000), levelName(entry.level),
+                     entry.tag, entry.thread, static_cast<int>(entry.length), entry.text);
+    }
+
+    uint64_t total = dropped_.load(std::memory_order_relaxed);
+    uint64_t dropped = total - reportedDropped_;
+    reportedDropped_ = total;
+    if (dropped > 0) {
+        droppedMetric_.inc(dropped);
+        std::fprintf(output_, "[log] %llu messages dropped, ring full\n",
+                     static_cast<unsigned long long>(dropped));
+    }
+    std::fflush(output_);
+}
+
+void Logger::run() {
+    // Read the signal before draining so a message queued mid-drain wakes the
+    // next wait instead of sitting in its ring
+    while (running_) {
+        uint32_t seen = wakeup_.current();
+        drain();
+        if (!running_) break;
+        wakeup_.wait(seen);
+    }
+    drain();
+}
+
+}
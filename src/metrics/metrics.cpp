@@ -0,0 +1,135 @@
+#include "metrics/metrics.hpp"
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace sadhana {
+
+Histogram::Histogram(double lowest, double highest, int subBuckets)
+    : lowest_(lowest > 0.0 ? lowest : 1e-9),
+      subBuckets_(subBuckets > 0 ? subBuckets : 1) {
+    for (int i = 0;; ++i) {
+        double bound = lowest_ * std::exp2(i / subBuckets_);
+        bounds_.push_back(bound);
+        if (bound >= highest) break;
+    }
+    buckets_ = std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1);
+}
+
+void Histogram::observe(double value) {
+    size_t index = 0;
+    if (value > lowest_) {
+        double position = std::ceil(std::log2(value / lowest_) * subBuckets_);
+        index = position < static_cast<double>(bounds_.size()) ? static_cast<size_t>(position) : bounds_.size();
+        // log2 rounding can be off by one right at a bucket edge
+        while (index > 0 && value <= bounds_[index - 1]) --index;
+        while (index < bounds_.size() && value > bounds_[index]) ++index;
+    }
+
+    buckets_[index].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+std::vector<uint64_t> Histogram::bucketCounts() const {
+    std::vector<uint64_t> counts(bounds_.size() + 1);
+    for (size_t i = 0; i < counts.size(); ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help, Type type) {
+    auto [it, inserted] = families_.try_emplace(name);
+    if (inserted) {
+        it->second.type = type;
+        it->second.help = help;
+    } else if (it->second.type != type) {
+        throw std::logic_error("metric " + name + " registered with two types");
+    }
+    return it->second;
+}
+
+std::string MetricsRegistry::formatLabels(const Labels& labels) {
+    std::string out;
+    for (const auto& [key, value] : labels) {
+        if (!out.empty()) out += ",";
+        out += key + "=\"" + value + "\"";
+    }
+    return out;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = family(name, help, Type::Counter).counters[formatLabels(labels)];
+    if (!slot) slot = std::make_unique<Counter>();
+    return *slot;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = family(name, help, Type::Gauge).gauges[formatLabels(labels)];
+    if (!slot) slot = std::make_unique<Gauge>();
+    return *slot;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                      double lowest, double highest, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = family(name, help, Type::Histogram).histograms[formatLabels(labels)];
+    if (!slot) slot = std::make_unique<Histogram>(lowest, highest);
+    return *slot;
+}
+
+std::string MetricsRegistry::renderPrometheus() const {
+    std::ostringstream out;
+    out.precision(9);
+
+    auto series = [](const std::string& name, const std::string& labels) {
+        return labels.empty() ? name : name + "{" + labels + "}";
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, family] : families_) {
+        out << "# HELP " << name << " " << family.help << "\n";
+        switch (family.type) {
+            case Type::Counter:
+                out << "# TYPE " << name << " counter\n";
+                for (const auto& [labels, counter] : family.counters) {
+                    out << series(name, labels) << " " << counter->value() << "\n";
+                }
+                break;
+            case Type::Gauge:
+                out << "# TYPE " << name << " gauge\n";
+                for (const auto& [labels, gauge] : family.gauges) {
+                    out << series(name, labels) << " " << gauge->value() << "\n";
+                }
+                break;
+            case Type::Histogram:
+                out << "# TYPE " << name << " histogram\n";
+                for (const auto& [labels, histogram] : family.histograms) {
+                    std::string prefix = labels.empty() ? "" : labels + ",";
+                    auto counts = histogram->bucketCounts();
+                    const auto& bounds = histogram->bounds();
+                    uint64_t cumulative = 0;
+                    for (size_t i = 0; i < bounds.size(); ++i) {
+                        cumulative += counts[i];
+                        out << name << "_bucket{" << prefix << "le=\"" << bounds[i] << "\"} " << cumulative << "\n";
+                    }
+                    cumulative += counts.back();
+                    out << name << "_bucket{" << prefix << "le=\"+Inf\"} " << cumulative << "\n";
+                    out << series(name + "_sum", labels) << " " << histogram->sum() << "\n";
+                    out << series(name + "_count", labels) << " " << cumulative << "\n";
+                }
+                break;
+        }
+    }
+    return out.str();
+}
+
+}
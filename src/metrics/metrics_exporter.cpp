@@ -0,0 +1,131 @@
+#include "metrics/metrics_exporter.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(const Config& config) {
+    if (running_) return false;
+    config_ = config;
+
+    if (!config_.socketPath.empty() && !openSocket()) {
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!running_) return;
+
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        unlink(config_.socketPath.c_str());
+        listenFd_ = -1;
+    }
+    if (!config_.filePath.empty()) {
+        writeFile();
+    }
+}
+
+bool MetricsExporter::openSocket() {
+    sockaddr_un addr{};
+    if (config_.socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Metrics socket path too long: " << config_.socketPath << "\n";
+        return false;
+    }
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "Failed to create metrics socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, config_.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(config_.socketPath.c_str());
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd_, 8) < 0) {
+        std::cerr << "Failed to bind metrics socket " << config_.socketPath << ": " << std::strerror(errno) << "\n";
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+bool MetricsExporter::writeFile() const {
+    // Scrapers must never see a half-written file
+    std::string tmpPath = config_.filePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) return false;
+        out << registry_.renderPrometheus();
+        if (!out.flush()) return false;
+    }
+    return std::rename(tmpPath.c_str(), config_.filePath.c_str()) == 0;
+}
+
+void MetricsExporter::serveClient(int fd) const {
+    // Drain whatever request the client sent; a bare connect gets the text too
+    pollfd pfd{fd, POLLIN, 0};
+    char request[1024];
+    if (poll(&pfd, 1, 100) > 0) {
+        [[maybe_unused]] auto n = read(fd, request, sizeof(request));
+    }
+
+    std::string body = registry_.renderPrometheus();
+    std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += static_cast<size_t>(n);
+    }
+    close(fd);
+}
+
+void MetricsExporter::run() {
+    using Clock = std::chrono::steady_clock;
+    auto nextWrite = Clock::now();
+    const int tickMs = 200;  // how quickly stop() is noticed
+
+    while (running_) {
+        if (!config_.filePath.empty() && Clock::now() >= nextWrite) {
+            writeFile();
+            nextWrite = Clock::now() + std::chrono::milliseconds(config_.fileIntervalMs);
+        }
+
+        if (listenFd_ < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(tickMs));
+            continue;
+        }
+
+        pollfd pfd{listenFd_, POLLIN, 0};
+        if (poll(&pfd, 1, tickMs) > 0 && (pfd.revents & POLLIN)) {
+            int client = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0) {
+                serveClient(client);
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,345 @@
+#include "net/event_stream_server.hpp"
+#include "log/logger.hpp"
+#include "trace/tracer.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+namespace {
+
+constexpr size_t MAX_REQUEST_BYTES = 4096;
+constexpr int MAX_IOVECS = 16;
+
+const char* const STREAM_RESPONSE =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "\r\n"
+    "retry: 2000\n\n";
+
+// Enough for a phone in the room to follow along without an app
+const char* const PAGE_BODY = R"(<!doctype html>
+<html><head><meta charset="utf-8"><meta name="viewport" content="width=device-width">
+<title>Sadhana</title>
+<style>body{font-family:sans-serif;margin:2em;font-size:1.4em}#count{font-size:3em}</style>
+</head><body>
+<div id="where">Waiting for the ritual...</div>
+<div id="count"></div>
+<div id="heard"></div>
+<script>
+const es = new EventSource('/events');
+es.addEventListener('progress', e => {
+  const p = JSON.parse(e.data);
+  document.getElementById('where').textContent = p.section + (p.part ? ' / ' + p.part : '');
+  document.getElementById('count').textContent = p.complete ? 'Complete' : p.repetition;
+});
+es.addEventListener('recognized', e => {
+  document.getElementById('heard').textContent = JSON.parse(e.data).text;
+});
+</script>
+</body></html>
+)";
+
+int64_t wallMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+EventStreamServer::EventStreamServer() : EventStreamServer(Config()) {}
+
+EventStreamServer::EventStreamServer(const Config& config)
+    : config_(config),
+      clientsMetric_(MetricsRegistry::instance().gauge(
+          "sadhana_events_clients", "Connected event stream clients")),
+      droppedMetric_(MetricsRegistry::instance().counter(
+          "sadhana_events_dropped_total", "Event frames dropped for clients that fell behind")) {}
+
+EventStreamServer::~EventStreamServer() {
+    stop();
+}
+
+bool EventStreamServer::start() {
+    if (thread_.joinable()) return true;
+    if (!loop_.init()) return false;
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "socket failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(config_.port));
+    if (inet_pton(AF_INET, config_.bindAddress.c_str(), &addr.sin_addr) != 1 ||
+        ::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listenFd_, SOMAXCONN) < 0) {
+        std::cerr << "Failed to listen on " << config_.bindAddress << ":" << config_.port
+                  << ": " << std::strerror(errno) << "\n";
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    loop_.watchReadable(listenFd_, [this](uint32_t) { acceptClients(); });
+
+    if (config_.heartbeatMs > 0) {
+        auto heartbeat = std::make_shared<const std::string>(":\n\n");
+        loop_.addTimer(std::chrono::milliseconds(config_.heartbeatMs),
+                       std::chrono::milliseconds(config_.heartbeatMs),
+                       [this, heartbeat]() { broadcast(heartbeat, false); });
+    }
+
+    thread_ = std::thread([this]() {
+        SADHANA_TRACE_THREAD("events");
+        loop_.run();
+    });
+    return true;
+}
+
+void EventStreamServer::stop() {
+    if (!thread_.joinable()) return;
+    loop_.stop();
+    thread_.join();
+
+    for (auto& [fd, client] : clients_) {
+        ::close(fd);
+    }
+    clients_.clear();
+    clientCount_.store(0, std::memory_order_relaxed);
+    clientsMetric_.set(0.0);
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        listenFd_ = -1;
+    }
+}
+
+EventStreamServer::Stats EventStreamServer::stats() const {
+    Stats stats;
+    stats.clients = clientCount_.load(std::memory_order_relaxed);
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.events = events_.load(std::memory_order_relaxed);
+    stats.framesQueued = framesQueued_.load(std::memory_order_relaxed);
+    stats.framesDropped = framesDropped_.load(std::memory_order_relaxed);
+    stats.bytesSent = bytesSent_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+EventStreamServer::Frame EventStreamServer::makeFrame(const char* event, const nlohmann::json& data) {
+    std::string frame;
+    frame.reserve(256);
+    frame += "id: ";
+    frame += std::to_string(nextEventId_.fetch_add(1, std::memory_order_relaxed));
+    frame += "\nevent: ";
+    frame += event;
+    frame += "\ndata: ";
+    frame += data.dump();
+    frame += "\n\n";
+    return std::make_shared<const std::string>(std::move(frame));
+}
+
+void EventStreamServer::publishProgress(const FlowProgress& progress) {
+    auto data = progressToJson(progress);
+    data["sent_us"] = wallMicros();
+    Frame frame = makeFrame("progress", data);
+    loop_.post([this, frame]() { broadcast(frame, true); });
+}
+
+void EventStreamServer::publishRecognized(const std::string& text, float confidence) {
+    Frame frame = makeFrame("recognized", {
+        {"text", text},
+        {"confidence", confidence},
+        {"sent_us", wallMicros()}
+    });
+    loop_.post([this, frame]() { broadcast(frame, false); });
+}
+
+void EventStreamServer::broadcast(const Frame& frame, bool progress) {
+    if (progress) {
+        latestProgress_ = frame;
+        events_.fetch_add(1, std::memory_order_relaxed);
+    } else if (frame->front() != ':') {
+        events_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Collected first: flushing may close a client and erase it from the map
+    std::vector<int> blocked;
+    for (auto& [fd, client] : clients_) {
+        if (!client->streaming) continue;
+        bool wasIdle = client->queue.empty();
+        enqueue(*client, frame);
+        if (wasIdle) blocked.push_back(fd);
+    }
+    for (int fd : blocked) {
+        auto it = clients_.find(fd);
+        if (it != clients_.end()) flush(*it->second);
+    }
+}
+
+void EventStreamServer::acceptClients() {
+    for (;;) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                SADHANA_LOG_WARN("events", "accept failed: ", std::strerror(errno));
+            }
+            return;
+        }
+        if (clients_.size() >= config_.maxClients) {
+            ::close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto client = std::make_unique<Client>();
+        client->fd = fd;
+        bool watched = loop_.watchReadable(fd, [this, fd](uint32_t events) {
+            auto it = clients_.find(fd);
+            if (it == clients_.end()) return;
+            Client& client = *it->second;
+            if (events & (EPOLLERR | EPOLLHUP)) {
+                closeClient(fd);
+                return;
+            }
+            if ((events & EPOLLOUT) && !flush(client)) return;
+            if (events & EPOLLIN) readRequest(client);
+        });
+        if (!watched) {
+            ::close(fd);
+            continue;
+        }
+        clients_[fd] = std::move(client);
+        accepted_.fetch_add(1, std::memory_order_relaxed);
+        clientCount_.store(clients_.size(), std::memory_order_relaxed);
+        clientsMetric_.set(static_cast<double>(clients_.size()));
+    }
+}
+
+bool EventStreamServer::readRequest(Client& client) {
+    char buffer[1024];
+    for (;;) {
+        ssize_t n = ::read(client.fd, buffer, sizeof(buffer));
+        if (n == 0) {
+            closeClient(client.fd);
+            return false;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeClient(client.fd);
+            return false;
+        }
+        // Streaming clients have nothing more to say; anything they send is ignored
+        if (client.streaming) continue;
+        client.request.append(buffer, static_cast<size_t>(n));
+        if (client.request.size() > MAX_REQUEST_BYTES) {
+            closeClient(client.fd);
+            return false;
+        }
+    }
+    if (client.streaming || client.request.find("\r\n\r\n") == std::string::npos) return true;
+
+    auto lineEnd = client.request.find("\r\n");
+    std::string requestLine = client.request.substr(0, lineEnd);
+    client.request.clear();
+    client.request.shrink_to_fit();
+
+    if (requestLine.rfind("GET /events", 0) == 0) {
+        client.streaming = true;
+        enqueue(client, std::make_shared<const std::string>(STREAM_RESPONSE));
+        // A new viewer sees the current position straight away
+        if (latestProgress_) enqueue(client, latestProgress_);
+    } else if (requestLine.rfind("GET / ", 0) == 0) {
+        std::string body = PAGE_BODY;
+        enqueue(client, std::make_shared<const std::string>(
+            "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nContent-Length: " +
+            std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body));
+        client.closeAfterFlush = true;
+    } else {
+        enqueue(client, std::make_shared<const std::string>(
+            "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"));
+        client.closeAfterFlush = true;
+    }
+    return flush(client);
+}
+
+void EventStreamServer::enqueue(Client& client, const Frame& frame) {
+    // Drop the oldest frames that have not started going out; a partly sent
+    // frame has to finish or the stream would be corrupted
+    while (client.queue.size() >= config_.queueFrames) {
+        auto victim = client.offset > 0 ? client.queue.begin() + 1 : client.queue.begin();
+        if (victim == client.queue.end()) break;
+        client.queue.erase(victim);
+        framesDropped_.fetch_add(1, std::memory_order_relaxed);
+        droppedMetric_.inc();
+    }
+    client.queue.push_back(frame);
+    framesQueued_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool EventStreamServer::flush(Client& client) {
+    while (!client.queue.empty()) {
+        iovec iov[MAX_IOVECS];
+        int count = 0;
+        for (auto it = client.queue.begin(); it != client.queue.end() && count < MAX_IOVECS; ++it, ++count) {
+            size_t skip = count == 0 ? client.offset : 0;
+            iov[count].iov_base = const_cast<char*>((*it)->data() + skip);
+            iov[count].iov_len = (*it)->size() - skip;
+        }
+
+        ssize_t n = ::writev(client.fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeClient(client.fd);
+            return false;
+        }
+        bytesSent_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+
+        size_t sent = static_cast<size_t>(n);
+        while (sent > 0) {
+            size_t remaining = client.queue.front()->size() - client.offset;
+            if (sent < remaining) {
+                client.offset += sent;
+                break;
+            }
+            sent -= remaining;
+            client.queue.pop_front();
+            client.offset = 0;
+        }
+    }
+
+    if (client.queue.empty() && client.closeAfterFlush) {
+        closeClient(client.fd);
+        return false;
+    }
+    loop_.setWritable(client.fd, !client.queue.empty());
+    return true;
+}
+
+void EventStreamServer::closeClient(int fd) {
+    loop_.unwatch(fd);
+    ::close(fd);
+    clients_.erase(fd);
+    clientCount_.store(clients_.size(), std::memory_order_relaxed);
+    clientsMetric_.set(static_cast<double>(clients_.size()));
+}
+
+}
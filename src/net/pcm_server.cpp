@@ -0,0 +1,567 @@
+#include "net/pcm_server.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+namespace {
+
+// Reads per readiness event, so one fast sender cannot hold the loop
+constexpr int MAX_READS_PER_EVENT = 4;
+
+}
+
+PcmServer::PcmServer(EventLoop& loop, SessionHost& host, std::shared_ptr<const RitualAssets> assets,
+                     const Config& config)
+    : loop_(loop),
+      host_(host),
+      assets_(std::move(assets)),
+      config_(config),
+      connectionsMetric_(MetricsRegistry::instance().gauge(
+          "sadhana_net_connections", "Open PCM ingestion connections")),
+      bytesMetric_(MetricsRegistry::instance().counter(
+          "sadhana_net_received_bytes_total", "Bytes received from PCM clients")),
+      lostFramesMetric_(MetricsRegistry::instance().counter(
+          "sadhana_net_lost_frames_total", "Audio frames missing from client sequence numbers")),
+      progressSkippedMetric_(MetricsRegistry::instance().counter(
+          "sadhana_net_progress_skipped_total", "Progress frames skipped for slow readers")) {}
+
+PcmServer::~PcmServer() {
+    stop();
+}
+
+bool PcmServer::start() {
+    if (config_.tcpPort > 0) {
+        tcpFd_ = listenTcp();
+        if (tcpFd_ < 0) return false;
+        loop_.watchReadable(tcpFd_, [this](uint32_t) { acceptConnections(tcpFd_); });
+    }
+    if (!config_.unixPath.empty()) {
+        unixFd_ = listenUnix();
+        if (unixFd_ < 0) return false;
+        loop_.watchReadable(unixFd_, [this](uint32_t) { acceptConnections(unixFd_); });
+    }
+    if (tcpFd_ < 0 && unixFd_ < 0) {
+        std::cerr << "PCM server has neither a TCP port nor a Unix socket path\n";
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(openMutex_);
+        openerRunning_ = true;
+    }
+    opener_ = std::thread([this]() { runOpener(); });
+    return true;
+}
+
+void PcmServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(openMutex_);
+        openerRunning_ = false;
+        openJobs_.clear();
+    }
+    openCv_.notify_all();
+    if (opener_.joinable()) {
+        opener_.join();
+    }
+
+    while (!connections_.empty()) {
+        closeConnection(connections_.begin()->second);
+    }
+    for (int* fd : {&tcpFd_, &unixFd_}) {
+        if (*fd < 0) continue;
+        loop_.unwatch(*fd);
+        ::close(*fd);
+        *fd = -1;
+    }
+    if (!config_.unixPath.empty()) {
+        ::unlink(config_.unixPath.c_str());
+    }
+}
+
+PcmServer::Stats PcmServer::stats() const {
+    Stats stats;
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.lostFrames = lostFrames_.load(std::memory_order_relaxed);
+    stats.replayedFrames = replayedFrames_.load(std::memory_order_relaxed);
+    stats.openingDroppedFrames = openingDroppedFrames_.load(std::memory_order_relaxed);
+    stats.progressSent = progressSent_.load(std::memory_order_relaxed);
+    stats.progressSkipped = progressSkipped_.load(std::memory_order_relaxed);
+    stats.protocolErrors = protocolErrors_.load(std::memory_order_relaxed);
+    stats.connections = openConnections_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+int PcmServer::listenTcp() {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "socket failed: " << std::strerror(errno) << "\n";
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(config_.tcpPort));
+    if (inet_pton(AF_INET, config_.bindAddress.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Invalid bind address: " << config_.bindAddress << "\n";
+        ::close(fd);
+        return -1;
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+        std::cerr << "Failed to listen on " << config_.bindAddress << ":" << config_.tcpPort
+                  << ": " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int PcmServer::listenUnix() {
+    sockaddr_un addr{};
+    if (config_.unixPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Unix socket path too long: " << config_.unixPath << "\n";
+        return -1;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "socket failed: " << std::strerror(errno) << "\n";
+        return -1;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, config_.unixPath.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(config_.unixPath.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+        std::cerr << "Failed to listen on " << config_.unixPath << ": " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void PcmServer::acceptConnections(int listenFd) {
+    for (;;) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                SADHANA_LOG_WARN("net", "accept failed: ", std::strerror(errno));
+            }
+            return;
+        }
+        if (connections_.size() >= config_.maxConnections) {
+            ::close(fd);
+            continue;
+        }
+
+        // Progress frames are small and latency matters more than packet count
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+        connection->id = nextConnectionId_++;
+        // Room for two full frames, so a partial one rarely needs moving
+        connection->in.resize(2 * (sizeof(PcmFrameHeader) + config_.maxPayloadBytes));
+
+        std::weak_ptr<Connection> weak = connection;
+        bool watched = loop_.watchReadable(fd, [this, weak](uint32_t events) {
+            auto connection = weak.lock();
+            if (!connection) return;
+            if (events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(connection);
+                return;
+            }
+            if (events & EPOLLOUT) {
+                flush(connection);
+                if (connection->closed) return;
+            }
+            if (events & EPOLLIN) {
+                readConnection(connection);
+            }
+        });
+        if (!watched) {
+            ::close(fd);
+            continue;
+        }
+        connections_[fd] = std::move(connection);
+        accepted_.fetch_add(1, std::memory_order_relaxed);
+        openConnections_.store(connections_.size(), std::memory_order_relaxed);
+        connectionsMetric_.set(static_cast<double>(connections_.size()));
+    }
+}
+
+void PcmServer::readConnection(const std::shared_ptr<Connection>& connection) {
+    Connection& c = *connection;
+    const size_t maxFrame = sizeof(PcmFrameHeader) + config_.maxPayloadBytes;
+
+    for (int reads = 0; reads < MAX_READS_PER_EVENT; ++reads) {
+        // Keep room for a whole frame after the unparsed bytes
+        if (c.in.size() - c.inBegin < maxFrame) {
+            std::memmove(c.in.data(), c.in.data() + c.inBegin, c.inEnd - c.inBegin);
+            c.inEnd -= c.inBegin;
+            c.inBegin = 0;
+        }
+
+        const size_t room = c.in.size() - c.inEnd;
+        ssize_t n = ::read(c.fd, c.in.data() + c.inEnd, room);
+        if (n == 0) {
+            closeConnection(connection);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(connection);
+            return;
+        }
+        c.inEnd += static_cast<size_t>(n);
+        bytes_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+        bytesMetric_.inc(static_cast<uint64_t>(n));
+
+        while (c.inEnd - c.inBegin >= sizeof(PcmFrameHeader)) {
+            PcmFrameHeader header = readPcmHeader(c.in.data() + c.inBegin);
+            if (header.magic != PcmFrameHeader::MAGIC || header.payloadBytes > config_.maxPayloadBytes) {
+                protocolErrors_.fetch_add(1, std::memory_order_relaxed);
+                queueFrame(connection, PcmFrameType::Error, 0, "malformed frame header", false);
+                flush(connection);
+                closeConnection(connection);
+                return;
+            }
+            size_t frameBytes = sizeof(PcmFrameHeader) + header.payloadBytes;
+            if (c.inEnd - c.inBegin < frameBytes) break;
+
+            // Samples are read in place; move the frame down if its payload is misaligned
+            const size_t payloadAt = c.inBegin + sizeof(PcmFrameHeader);
+            if (payloadAt % alignof(float) != 0) {
+                std::memmove(c.in.data(), c.in.data() + c.inBegin, c.inEnd - c.inBegin);
+                c.inEnd -= c.inBegin;
+                c.inBegin = 0;
+            }
+
+            if (!handleFrame(connection, header, c.in.data() + c.inBegin + sizeof(PcmFrameHeader))) {
+                flush(connection);
+                closeConnection(connection);
+                return;
+            }
+            c.inBegin += frameBytes;
+        }
+        if (c.inBegin == c.inEnd) {
+            c.inBegin = c.inEnd = 0;
+        }
+        if (static_cast<size_t>(n) < room) return;  // drained for now
+    }
+}
+
+bool PcmServer::handleFrame(const std::shared_ptr<Connection>& connection, const PcmFrameHeader& header,
+                            const unsigned char* payload) {
+    frames_.fetch_add(1, std::memory_order_relaxed);
+
+    switch (static_cast<PcmFrameType>(header.type)) {
+        case PcmFrameType::Audio:
+            handleAudio(connection, header, payload);
+            return true;
+
+        case PcmFrameType::ManualAdvance: {
+            auto it = connection->streams.find(header.sessionId);
+            if (it != connection->streams.end()) {
+                if (it->second.session) {
+                    it->second.session->postManualIntervention();
+                } else if (it->second.openTicket != 0) {
+                    it->second.advancePending = true;
+                }
+            }
+            return true;
+        }
+
+        case PcmFrameType::End: {
+            auto& refused = connection->refused;
+            refused.erase(std::remove(refused.begin(), refused.end(), header.sessionId), refused.end());
+            auto it = connection->streams.find(header.sessionId);
+            if (it != connection->streams.end()) {
+                if (it->second.session) host_.closeSession(it->second.session->id());
+                connection->streams.erase(it);
+            }
+            return true;
+        }
+
+        default:
+            protocolErrors_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+    }
+}
+
+void PcmServer::handleAudio(const std::shared_ptr<Connection>& connection, const PcmFrameHeader& header,
+                            const unsigned char* payload) {
+    // A handful of ids; a linear scan beats a set
+    const auto& refused = connection->refused;
+    if (std::find(refused.begin(), refused.end(), header.sessionId) != refused.end()) {
+        return;  // refused or failed earlier; the client was told
+    }
+    // Ended streams still opening count too, so counting up sessionIds cannot
+    // queue opener jobs without bound
+    if (!connection->streams.count(header.sessionId) &&
+        (connection->streams.size() >= config_.maxStreamsPerConnection ||
+         connection->openingStreams >= config_.maxStreamsPerConnection)) {
+        failStream(connection, header.sessionId, "too many streams on this connection");
+        return;
+    }
+
+    auto format = static_cast<PcmSampleFormat>(header.format);
+    size_t sampleBytes = pcmSampleBytes(format);
+    if (sampleBytes == 0 || header.payloadBytes % sampleBytes != 0) {
+        protocolErrors_.fetch_add(1, std::memory_order_relaxed);
+        failStream(connection, header.sessionId, "unsupported sample format");
+        return;
+    }
+    if (static_cast<int>(header.sampleRate) != host_.sampleRate()) {
+        protocolErrors_.fetch_add(1, std::memory_order_relaxed);
+        failStream(connection, header.sessionId, "sample rate must be " + std::to_string(host_.sampleRate()));
+        return;
+    }
+
+    Stream& stream = openStream(connection, header.sessionId);
+    if (stream.started) {
+        if (header.sequence < stream.nextSequence) {
+            replayedFrames_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (header.sequence > stream.nextSequence) {
+            uint64_t lost = header.sequence - stream.nextSequence;
+            lostFrames_.fetch_add(lost, std::memory_order_relaxed);
+            lostFramesMetric_.inc(lost);
+        }
+    }
+    stream.started = true;
+    stream.nextSequence = header.sequence + 1;
+
+    size_t count = header.payloadBytes / sampleBytes;
+    if (!stream.session) {
+        // Still opening: hold the start of the recitation rather than lose it
+        const size_t limit = static_cast<size_t>(config_.openingBufferSeconds * host_.sampleRate());
+        if (stream.opening.size() + count > limit) {
+            openingDroppedFrames_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (format == PcmSampleFormat::Int16) {
+            const auto* samples = reinterpret_cast<const int16_t*>(payload);
+            for (size_t i = 0; i < count; ++i) {
+                stream.opening.push_back(static_cast<float>(samples[i]) * (1.0f / 32768.0f));
+            }
+        } else {
+            const auto* samples = reinterpret_cast<const float*>(payload);
+            stream.opening.insert(stream.opening.end(), samples, samples + count);
+        }
+        return;
+    }
+
+    if (format == PcmSampleFormat::Int16) {
+        stream.session->pushAudio(reinterpret_cast<const int16_t*>(payload), count);
+    } else {
+        stream.session->pushAudio(reinterpret_cast<const float*>(payload), count);
+    }
+}
+
+PcmServer::Stream& PcmServer::openStream(const std::shared_ptr<Connection>& connection, uint32_t sessionId) {
+    auto it = connection->streams.find(sessionId);
+    if (it != connection->streams.end()) return it->second;
+
+    Stream& stream = connection->streams[sessionId];
+    stream.openTicket = nextOpenTicket_++;
+    ++connection->openingStreams;
+    Session::Config sessionConfig = config_.session;
+    sessionConfig.id = "net-" + std::to_string(connection->id) + "-" + std::to_string(sessionId);
+
+    std::weak_ptr<Connection> weak = connection;
+    auto job = [this, weak, sessionId, ticket = stream.openTicket, assets = assets_, sessionConfig]() {
+        std::string error;
+        std::shared_ptr<Session> session = host_.openSession(assets, sessionConfig, &error);
+        SessionHost* host = &host_;
+        // The connection, and with it the server, may be gone by the time the loop runs this
+        loop_.post([this, host, weak, sessionId, ticket, session, error]() {
+            auto connection = weak.lock();
+            if (connection) --connection->openingStreams;
+            if (!connection || connection->closed) {
+                if (session) host->closeSession(session->id());
+                return;
+            }
+            streamOpened(connection, sessionId, ticket, session, error);
+        });
+    };
+    {
+        std::lock_guard<std::mutex> lock(openMutex_);
+        openJobs_.push_back(std::move(job));
+    }
+    openCv_.notify_one();
+    return stream;
+}
+
+void PcmServer::streamOpened(const std::shared_ptr<Connection>& connection, uint32_t sessionId, uint64_t ticket,
+                             std::shared_ptr<Session> session, const std::string& error) {
+    auto it = connection->streams.find(sessionId);
+    if (it == connection->streams.end() || it->second.openTicket != ticket) {
+        // The client ended this stream, and maybe started another under its id, meanwhile
+        if (session) host_.closeSession(session->id());
+        return;
+    }
+    Stream& stream = it->second;
+    stream.openTicket = 0;
+    if (!session) {
+        failStream(connection, sessionId, error);
+        return;
+    }
+    stream.session = std::move(session);
+
+    // Runs on host workers; the connection may be gone by then
+    std::weak_ptr<Connection> weak = connection;
+    auto sendProgress = [this, weak, sessionId](const FlowManager::ProgressSnapshot& progress) {
+        if (auto connection = weak.lock()) {
+            queueFrame(connection, PcmFrameType::Progress, sessionId, progressToJson(*progress).dump(), true);
+        }
+    };
+    stream.session->setProgressCallback(sendProgress);
+    sendProgress(stream.session->progress());
+
+    if (!stream.opening.empty()) {
+        stream.session->pushAudio(stream.opening.data(), stream.opening.size());
+        std::vector<float>().swap(stream.opening);
+    }
+    if (stream.advancePending) {
+        stream.advancePending = false;
+        stream.session->postManualIntervention();
+    }
+}
+
+void PcmServer::failStream(const std::shared_ptr<Connection>& connection, uint32_t sessionId,
+                           const std::string& error) {
+    // A session still opening finds no stream when it arrives and is closed
+    auto it = connection->streams.find(sessionId);
+    if (it != connection->streams.end()) {
+        if (it->second.session) host_.closeSession(it->second.session->id());
+        connection->streams.erase(it);
+    }
+    auto& refused = connection->refused;
+    if (std::find(refused.begin(), refused.end(), sessionId) == refused.end()) {
+        refused.push_back(sessionId);
+        if (refused.size() > config_.maxRefusedStreams) refused.pop_front();
+    }
+    queueFrame(connection, PcmFrameType::Error, sessionId, error, false);
+}
+
+void PcmServer::closeConnection(const std::shared_ptr<Connection>& connection) {
+    {
+        std::lock_guard<std::mutex> lock(connection->pendingMutex);
+        if (connection->closed) return;
+        connection->closed = true;
+    }
+    for (const auto& [sessionId, stream] : connection->streams) {
+        if (stream.session) host_.closeSession(stream.session->id());
+    }
+    connection->streams.clear();
+
+    loop_.unwatch(connection->fd);
+    ::close(connection->fd);
+    connections_.erase(connection->fd);
+    openConnections_.store(connections_.size(), std::memory_order_relaxed);
+    connectionsMetric_.set(static_cast<double>(connections_.size()));
+}
+
+void PcmServer::queueFrame(const std::shared_ptr<Connection>& connection, PcmFrameType type,
+                           uint32_t sessionId, const std::string& payload, bool droppable) {
+    PcmFrameHeader header;
+    header.type = static_cast<uint8_t>(type);
+    header.sessionId = sessionId;
+    header.payloadBytes = static_cast<uint32_t>(payload.size());
+
+    bool post = false;
+    {
+        std::lock_guard<std::mutex> lock(connection->pendingMutex);
+        if (connection->closed) return;
+        // Progress is a full state, so a skipped frame loses nothing the next one lacks
+        if (droppable && connection->pending.size() >= config_.maxOutboundBytes) {
+            progressSkipped_.fetch_add(1, std::memory_order_relaxed);
+            progressSkippedMetric_.inc();
+            return;
+        }
+        connection->pending.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        connection->pending.append(payload);
+        post = !connection->flushPosted;
+        connection->flushPosted = true;
+    }
+    if (type == PcmFrameType::Progress) {
+        progressSent_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (post) {
+        std::weak_ptr<Connection> weak = connection;
+        loop_.post([this, weak]() {
+            if (auto connection = weak.lock()) flush(connection);
+        });
+    }
+}
+
+void PcmServer::flush(const std::shared_ptr<Connection>& connection) {
+    Connection& c = *connection;
+    {
+        std::lock_guard<std::mutex> lock(c.pendingMutex);
+        if (c.closed) return;
+        c.flushPosted = false;
+        if (c.outOffset == c.out.size()) {
+            c.out.clear();
+            c.outOffset = 0;
+        }
+        // Appended while the socket was full, the outbound buffer stays bounded by maxOutboundBytes
+        if (!c.pending.empty() && c.out.size() - c.outOffset < config_.maxOutboundBytes) {
+            c.out.append(c.pending);
+            c.pending.clear();
+        }
+    }
+
+    while (c.outOffset < c.out.size()) {
+        ssize_t n = ::send(c.fd, c.out.data() + c.outOffset, c.out.size() - c.outOffset, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeConnection(connection);
+            return;
+        }
+        c.outOffset += static_cast<size_t>(n);
+    }
+
+    bool blocked = c.outOffset < c.out.size();
+    if (!blocked) {
+        std::lock_guard<std::mutex> lock(c.pendingMutex);
+        blocked = !c.pending.empty();
+        if (blocked) c.flushPosted = true;
+    }
+    loop_.setWritable(c.fd, blocked);
+}
+
+void PcmServer::runOpener() {
+    std::unique_lock<std::mutex> lock(openMutex_);
+    for (;;) {
+        openCv_.wait(lock, [this]() { return !openerRunning_ || !openJobs_.empty(); });
+        if (!openerRunning_) return;
+        auto job = std::move(openJobs_.front());
+        openJobs_.pop_front();
+        lock.unlock();
+        job();
+        lock.lock();
+    }
+}
+
+}
@@ -289,7 +289,7 @@ std::optional<PhraseManager::MarkerInfo> PhraseManager::findBestMatch(
     return bestMatch;
 }
 
-PhraseManager::MatchResult PhraseManager::matchPhrase(const std::string& text) {
+PhraseManager::MatchResult PhraseManager::matchPhrase(const std::string& text) const {
     std::string normalized = normalizeText(text);
 
     MatchResult result;
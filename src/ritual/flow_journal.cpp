@@ -0,0 +1,444 @@
+#include "ritual/flow_journal.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+namespace {
+
+const std::array<uint32_t, 256> CRC_TABLE = []() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}();
+
+uint32_t crc32(const unsigned char* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void fnv1a(uint64_t& hash, const std::string& text) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    hash ^= 0xff;
+    hash *= 0x100000001b3ull;
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readFile(const std::string& path, std::vector<unsigned char>& out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        return false;
+    }
+    out.resize(static_cast<size_t>(st.st_size));
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = ::read(fd, out.data() + done, out.size() - done);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    out.resize(done);
+    ::close(fd);
+    return true;
+}
+
+}
+
+FlowJournal::FlowJournal(const RitualDefinition& ritual, const Config& config)
+    : ritual_(ritual)
+    , config_(config)
+    , queue_(config.queueRecords)
+    , droppedMetric_(MetricsRegistry::instance().counter(
+          "sadhana_journal_dropped_total", "Flow journal records dropped because the writer fell behind or could not write"))
+    , appendSecondsMetric_(MetricsRegistry::instance().histogram(
+          "sadhana_journal_append_seconds", "Flow thread time spent appending a journal record", 1e-7, 1e-2))
+    , commitSecondsMetric_(MetricsRegistry::instance().histogram(
+          "sadhana_journal_commit_seconds", "Write plus fdatasync time per journal group commit", 1e-5, 10.0))
+    , batchRecordsMetric_(MetricsRegistry::instance().histogram(
+          "sadhana_journal_batch_records", "Records made durable by one journal group commit", 1.0, 4096.0)) {
+    fingerprint_ = computeFingerprint();
+}
+
+FlowJournal::~FlowJournal() {
+    close();
+}
+
+std::string FlowJournal::journalPath() const {
+    return (std::filesystem::path(config_.directory) / "flow.journal").string();
+}
+
+std::string FlowJournal::snapshotPath() const {
+    return (std::filesystem::path(config_.directory) / "flow.snapshot").string();
+}
+
+uint64_t FlowJournal::computeFingerprint() const {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    fnv1a(hash, ritual_.getId());
+    for (const auto& section : ritual_.getSections()) {
+        fnv1a(hash, section.id);
+        if (section.parts) {
+            for (const auto& part : *section.parts) {
+                fnv1a(hash, part.id);
+            }
+        }
+    }
+    return hash;
+}
+
+uint32_t FlowJournal::recordCrc(const Record& record) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&record);
+    return crc32(bytes + sizeof(record.crc), sizeof(Record) - sizeof(record.crc));
+}
+
+bool FlowJournal::decode(const Record& record, ResumeState& state) const {
+    const auto& sections = ritual_.getSections();
+    if (record.section >= sections.size()) return false;
+    const auto& section = sections[record.section];
+
+    std::string partId;
+    if (record.part != NO_INDEX) {
+        if (!section.parts || record.part >= section.parts->size()) return false;
+        partId = (*section.parts)[record.part].id;
+    }
+
+    state.progress.currentSectionId = section.id;
+    state.progress.currentPartId = std::move(partId);
+    state.progress.currentRepetition = static_cast<int>(record.repetition);
+    state.progress.awaitingManualIntervention = record.awaiting != 0;
+    state.completedSections = record.completedSections;
+    uint64_t all = sections.size() >= 64 ? ~0ull : (1ull << sections.size()) - 1;
+    state.progress.complete = (record.completedSections & all) == all;
+    state.sequence = record.sequence;
+    return true;
+}
+
+bool FlowJournal::load(ResumeState& state, std::string* error) {
+    auto start = std::chrono::steady_clock::now();
+    auto fail = [error](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    state = ResumeState();
+    loaded_ = false;
+    bool found = false;
+    std::vector<unsigned char> bytes;
+
+    if (readFile(snapshotPath(), bytes)) {
+        FileHeader header{};
+        Record record{};
+        if (bytes.size() != sizeof(header) + sizeof(record)) {
+            return fail("truncated snapshot: " + snapshotPath());
+        }
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        std::memcpy(&record, bytes.data() + sizeof(header), sizeof(record));
+        if (header.magic != SNAPSHOT_MAGIC || header.version != FORMAT_VERSION) {
+            return fail("not a flow snapshot: " + snapshotPath());
+        }
+        if (header.fingerprint != fingerprint_) {
+            return fail("snapshot was written for a different ritual definition");
+        }
+        if (record.crc != recordCrc(record) || !decode(record, state)) {
+            return fail("corrupt snapshot: " + snapshotPath());
+        }
+        lastRecord_ = record;
+        state.fromSnapshot = true;
+        found = true;
+    }
+
+    validJournalBytes_ = 0;
+    if (readFile(journalPath(), bytes) && bytes.size() >= sizeof(FileHeader)) {
+        FileHeader header{};
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != JOURNAL_MAGIC || header.version != FORMAT_VERSION) {
+            return fail("not a flow journal: " + journalPath());
+        }
+        if (header.fingerprint != fingerprint_) {
+            return fail("journal was written for a different ritual definition");
+        }
+        validJournalBytes_ = sizeof(header);
+
+        // Stop at the first record that is torn, corrupt or out of order; anything
+        // after it was never acknowledged by an fdatasync
+        uint64_t lastSequence = 0;
+        for (size_t offset = sizeof(header); offset + sizeof(Record) <= bytes.size(); offset += sizeof(Record)) {
+            Record record{};
+            std::memcpy(&record, bytes.data() + offset, sizeof(record));
+            if (record.crc != recordCrc(record) || record.sequence <= lastSequence) break;
+            lastSequence = record.sequence;
+            validJournalBytes_ = offset + sizeof(Record);
+
+            // Compaction may have crashed before truncating; those records are in the snapshot
+            if (record.sequence <= state.sequence) continue;
+            ResumeState next = state;
+            if (!decode(record, next)) break;
+            state = std::move(next);
+            lastRecord_ = record;
+            ++state.replayedRecords;
+            found = true;
+        }
+    }
+
+    loaded_ = found;
+    nextSequence_ = found ? state.sequence + 1 : 1;
+    state.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return found;
+}
+
+bool FlowJournal::open(bool resume) {
+    if (running_) return true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+    if (ec) {
+        std::cerr << "Failed to create journal directory " << config_.directory << ": " << ec.message() << "\n";
+        return false;
+    }
+
+    resume = resume && loaded_;
+    if (!resume) {
+        ::unlink(snapshotPath().c_str());
+        nextSequence_ = 1;
+        validJournalBytes_ = 0;
+    }
+
+    fd_ = ::open(journalPath().c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Failed to open journal " << journalPath() << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // Cut any torn tail so new records follow the last intact one
+    if (validJournalBytes_ < sizeof(FileHeader)) {
+        FileHeader header{JOURNAL_MAGIC, FORMAT_VERSION, fingerprint_};
+        if (ftruncate(fd_, 0) < 0 || !writeAll(fd_, &header, sizeof(header)) || fdatasync(fd_) < 0) {
+            std::cerr << "Failed to initialize journal " << journalPath() << ": " << std::strerror(errno) << "\n";
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+    } else if (ftruncate(fd_, static_cast<off_t>(validJournalBytes_)) < 0) {
+        std::cerr << "Failed to truncate journal " << journalPath() << ": " << std::strerror(errno) << "\n";
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    journalEnd_ = static_cast<off_t>(std::max<uint64_t>(validJournalBytes_, sizeof(FileHeader)));
+    lseek(fd_, journalEnd_, SEEK_SET);
+
+    sinceSnapshot_ = 0;
+    running_ = true;
+    writer_ = std::thread([this]() { runWriter(); });
+    return true;
+}
+
+void FlowJournal::close() {
+    if (!running_.exchange(false)) return;
+    signal_.notify();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void FlowJournal::append(RecordType type, const FlowProgress& progress, uint64_t completedSections) {
+    if (!running_.load(std::memory_order_relaxed)) return;
+    auto start = std::chrono::steady_clock::now();
+
+    Record record{};
+    record.type = static_cast<uint8_t>(type);
+    record.awaiting = progress.awaitingManualIntervention ? 1 : 0;
+    record.section = NO_INDEX;
+    record.part = NO_INDEX;
+
+    // A handful of sections and parts; a linear scan beats building an index
+    const auto& sections = ritual_.getSections();
+    for (size_t i = 0; i < sections.size(); ++i) {
+        if (sections[i].id != progress.currentSectionId) continue;
+        record.section = static_cast<uint16_t>(i);
+        if (!progress.currentPartId.empty() && sections[i].parts) {
+            const auto& parts = *sections[i].parts;
+            for (size_t j = 0; j < parts.size(); ++j) {
+                if (parts[j].id == progress.currentPartId) {
+                    record.part = static_cast<uint16_t>(j);
+                    break;
+                }
+            }
+        }
+        break;
+    }
+    if (record.section == NO_INDEX) return;
+
+    record.repetition = static_cast<uint32_t>(std::max(progress.currentRepetition, 0));
+    record.sequence = nextSequence_++;
+    record.completedSections = completedSections;
+    record.wallTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.crc = recordCrc(record);
+
+    if (queue_.tryPush(record)) {
+        appended_.fetch_add(1, std::memory_order_relaxed);
+        signal_.notify();
+    } else {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        droppedMetric_.inc();
+    }
+    appendSecondsMetric_.observe(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+void FlowJournal::runWriter() {
+    std::vector<Record> batch;
+    batch.reserve(queue_.capacity());
+
+    for (;;) {
+        uint32_t seen = signal_.current();
+        bool stopping = !running_.load(std::memory_order_acquire);
+        if (queue_.empty()) {
+            if (stopping) break;
+            signal_.wait(seen);
+            continue;
+        }
+
+        // Let the group fill: one fdatasync covers everything appended in the interval
+        if (!stopping && config_.commitIntervalMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(config_.commitIntervalMs));
+        }
+
+        Record record;
+        while (queue_.tryPop(record)) {
+            batch.push_back(record);
+        }
+        commitBatch(batch);
+        batch.clear();
+
+        if (config_.snapshotEvery > 0 && sinceSnapshot_ >= config_.snapshotEvery) {
+            if (!writeSnapshot(lastRecord_)) {
+                SADHANA_LOG_ERROR("journal", "Snapshot failed: ", std::strerror(errno));
+            }
+        }
+    }
+}
+
+// A failed write may leave part of the batch behind. Recovery stops at the
+// first torn record, so everything appended after it would be lost on resume:
+// cut back to the last good record before writing anything else.
+void FlowJournal::commitBatch(const std::vector<Record>& batch) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (writeBatch(batch)) return;
+        SADHANA_LOG_ERROR("journal", "Journal write failed: ", std::strerror(errno));
+        if (ftruncate(fd_, journalEnd_) < 0 || lseek(fd_, journalEnd_, SEEK_SET) < 0) break;
+    }
+
+    dropped_.fetch_add(batch.size(), std::memory_order_relaxed);
+    droppedMetric_.inc(batch.size());
+    // Each record holds the whole position, so a snapshot of the newest one
+    // stands in for the batch
+    if (!writeSnapshot(batch.back())) {
+        SADHANA_LOG_ERROR("journal", "Snapshot after a failed write failed: ", std::strerror(errno));
+        return;
+    }
+    lastRecord_ = batch.back();
+}
+
+bool FlowJournal::writeBatch(const std::vector<Record>& batch) {
+    if (batch.empty()) return true;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!writeAll(fd_, batch.data(), batch.size() * sizeof(Record)) || fdatasync(fd_) < 0) {
+        return false;
+    }
+    journalEnd_ += static_cast<off_t>(batch.size() * sizeof(Record));
+    commitSecondsMetric_.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    batchRecordsMetric_.observe(static_cast<double>(batch.size()));
+
+    lastRecord_ = batch.back();
+    sinceSnapshot_ += batch.size();
+    committed_.fetch_add(batch.size(), std::memory_order_relaxed);
+    commits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool FlowJournal::writeSnapshot(const Record& record) {
+    std::string path = snapshotPath();
+    std::string tmpPath = path + ".tmp";
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    FileHeader header{SNAPSHOT_MAGIC, FORMAT_VERSION, fingerprint_};
+    bool ok = writeAll(fd, &header, sizeof(header)) && writeAll(fd, &record, sizeof(record)) && fdatasync(fd) == 0;
+    ::close(fd);
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+
+    // The rename must be durable before the journal loses the records it replaces
+    int dirFd = ::open(config_.directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+
+    if (ftruncate(fd_, sizeof(FileHeader)) < 0) return false;
+    journalEnd_ = sizeof(FileHeader);
+    lseek(fd_, journalEnd_, SEEK_SET);
+    sinceSnapshot_ = 0;
+    snapshots_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+FlowJournal::Stats FlowJournal::stats() const {
+    Stats stats;
+    stats.appended = appended_.load(std::memory_order_relaxed);
+    stats.committed = committed_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.commits = commits_.load(std::memory_order_relaxed);
+    stats.snapshots = snapshots_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}
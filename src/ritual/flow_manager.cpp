@@ -1,12 +1,32 @@
 #include "ritual/flow_manager.hpp"
+#include "ritual/flow_journal.hpp"
+#include "analytics/utterance_log.hpp"
+#include "host/ritual_assets.hpp"
+#include "audio/segment_admission.hpp"
+#include "trace/tracer.hpp"
+#include "log/logger.hpp"
 #include <fstream>
-#include <iostream>
+#include <algorithm>
 
 namespace sadhana {
 
 FlowManager::FlowManager(const RitualDefinition& definition)
-    : definition_(definition)
-    , phraseManager_(definition) {
+    : FlowManager(definition, std::make_shared<const PhraseManager>(definition)) {}
+
+FlowManager::FlowManager(const RitualDefinition& definition, std::shared_ptr<const PhraseManager> matcher)
+    : offeringsMetric_(MetricsRegistry::instance().counter(
+          "sadhana_offerings_total", "Repetitions counted by the flow, recognized or manual"))
+    , manualInterventionsMetric_(MetricsRegistry::instance().counter(
+          "sadhana_manual_interventions_total", "Manual advances and manually counted repetitions"))
+    , recognitionFailuresMetric_(MetricsRegistry::instance().counter(
+          "sadhana_recognition_failures_total", "Recognized phrases that did not match the expected text")) {
+    // The caller keeps the definition alive, as before reloads existed
+    auto assets = std::make_shared<RitualAssets>();
+    assets->ritual = std::shared_ptr<const RitualDefinition>(&definition, [](const RitualDefinition*) {});
+    assets->matcher = std::move(matcher);
+    active_ = assets;
+    assets_.store(active_, std::memory_order_release);
+
     // Initialize with the first section (purvangam)
     const auto& sections = definition.getSections();
     if (!sections.empty()) {
@@ -19,26 +39,272 @@ FlowManager::FlowManager(const RitualDefinition& definition)
             progress_.awaitingManualIntervention = true;
         }
     }
+    publish();
+}
+
+FlowManager::~FlowManager() {
+    stop();
 }
 
 bool FlowManager::loadFlowConfiguration(const std::string& configPath) {
     try {
         std::ifstream file(configPath);
-        flowConfig_ = nlohmann::json::parse(file);
-        return validateConfiguration();
+        return setFlowConfiguration(nlohmann::json::parse(file));
     } catch (const std::exception& e) {
         return false;
     }
 }
 
-bool FlowManager::validateConfiguration() const {
-    // Basic validation that required fields exist
+bool FlowManager::setFlowConfiguration(const nlohmann::json& config) {
+    if (!validateConfiguration(config)) {
+        return false;
+    }
     try {
-        const auto& exec = flowConfig_["execution"];
-        if (exec["recognition_settings"]["default_threshold"].get<float>() < 0 ||
-            exec["recognition_settings"]["default_threshold"].get<float>() > 1) {
+        auto assets = std::make_shared<RitualAssets>(*active_);
+        assets->flowConfig = config;
+        active_ = assets;
+        assets_.store(active_, std::memory_order_release);
+        applyLoggingSettings(active_->flowConfig);
+        return true;
+    } catch (const std::exception& e) {
+        return false;
+    }
+}
+
+bool FlowManager::reload(std::shared_ptr<const RitualAssets> assets, std::string* error) {
+    auto fail = [error](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+    if (!assets || !assets->ritual || !assets->matcher) {
+        return fail("incomplete ritual assets");
+    }
+    if (!validateConfiguration(assets->flowConfig)) {
+        return fail("invalid flow configuration");
+    }
+
+    auto current = assets_.load(std::memory_order_acquire);
+    const auto& before = current->ritual->getSections();
+    const auto& after = assets->ritual->getSections();
+    bool sameSections = before.size() == after.size() &&
+        std::equal(before.begin(), before.end(), after.begin(),
+                   [](const Section& a, const Section& b) { return a.id == b.id; });
+    if (!sameSections) {
+        return fail("sections changed; restart to use the new definition");
+    }
+    // Progress names a part too, and auto-advance walks parts in order
+    for (size_t i = 0; i < before.size(); ++i) {
+        static const std::vector<Part> none;
+        const auto& partsBefore = before[i].parts ? *before[i].parts : none;
+        const auto& partsAfter = after[i].parts ? *after[i].parts : none;
+        bool sameParts = partsBefore.size() == partsAfter.size() &&
+            std::equal(partsBefore.begin(), partsBefore.end(), partsAfter.begin(),
+                       [](const Part& a, const Part& b) { return a.id == b.id; });
+        if (!sameParts) {
+            return fail("parts of section " + before[i].id + " changed; restart to use the new definition");
+        }
+    }
+
+    SADHANA_LOG_INFO("flow", "Publishing ", assets->ritual->getId(), " version ",
+                     assets->ritual->getVersion(), " as generation ", assetsGeneration() + 1);
+    assets_.store(std::move(assets), std::memory_order_release);
+    assetsGeneration_.fetch_add(1, std::memory_order_acq_rel);
+    // Wakes an idle processing thread so the swap is not left until the next utterance
+    eventSignal_.notify();
+    return true;
+}
+
+void FlowManager::activateLatestAssets() {
+    auto latest = assets_.load(std::memory_order_acquire);
+    if (latest == active_) return;
+    active_ = std::move(latest);
+    applyLoggingSettings(active_->flowConfig);
+    SADHANA_LOG_INFO("flow", "Now using ", active_->ritual->getId(), " version ",
+                     active_->ritual->getVersion(), ", generation ", assetsGeneration());
+}
+
+void FlowManager::applyLoggingSettings(const nlohmann::json& flowConfig) {
+    const auto logging = flowConfig.contains("execution")
+        ? flowConfig["execution"].value("logging", nlohmann::json::object())
+        : nlohmann::json::object();
+    trackManualInterventions_ = logging.value("track_manual_interventions", false);
+    trackRecognitionFailures_ = logging.value("track_recognition_failures", false);
+}
+
+const RitualDefinition& FlowManager::definition() const {
+    return *active_->ritual;
+}
+
+bool FlowManager::postRecognizedPhrase(std::string phrase, float confidence, float decodeMs,
+                                       uint64_t traceId, int64_t traceStartNs) {
+    Event event;
+    event.type = Event::Type::RecognizedPhrase;
+    event.phrase = std::move(phrase);
+    event.confidence = confidence;
+    event.decodeMs = decodeMs;
+    event.traceId = traceId;
+    event.traceStartNs = traceStartNs;
+    return post(std::move(event));
+}
+
+bool FlowManager::postRecognizedPhrase(std::string phrase, PhraseManager::MatchResult match,
+                                       const std::shared_ptr<const RitualAssets>& matchedWith, float decodeMs,
+                                       uint64_t traceId, int64_t traceStartNs) {
+    Event event;
+    event.type = Event::Type::RecognizedPhrase;
+    event.phrase = std::move(phrase);
+    event.confidence = match.confidence;
+    event.decodeMs = decodeMs;
+    event.traceId = traceId;
+    event.traceStartNs = traceStartNs;
+    event.match = std::move(match);
+    event.matchedWith = matchedWith ? matchedWith->matcher : nullptr;
+    return post(std::move(event));
+}
+
+bool FlowManager::postManualIntervention() {
+    Event event;
+    event.type = Event::Type::ManualIntervention;
+    return post(std::move(event));
+}
+
+bool FlowManager::post(Event event) {
+    event.time = clock_.load(std::memory_order_acquire)->now();
+    if (!events_.tryPush(std::move(event))) {
+        droppedEvents_.fetch_add(1, std::memory_order_relaxed);
+        SADHANA_LOG_WARN("flow", "Event queue full, dropping event");
+        return false;
+    }
+    eventSignal_.notify();
+    return true;
+}
+
+void FlowManager::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void FlowManager::stop() {
+    if (!running_.exchange(false)) return;
+    eventSignal_.notify();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void FlowManager::run() {
+    SADHANA_TRACE_THREAD("flow");
+    while (running_.load(std::memory_order_acquire)) {
+        uint32_t seen = eventSignal_.current();
+        if (processPending() == 0 && running_.load(std::memory_order_acquire)) {
+            eventSignal_.wait(seen);
+        }
+    }
+    // Events posted before stop() still count
+    processPending();
+}
+
+size_t FlowManager::processPending() {
+    size_t processed = 0;
+    Event event;
+    activateLatestAssets();
+    while (events_.tryPop(event)) {
+        activateLatestAssets();
+        apply(event);
+        ++processed;
+    }
+    return processed;
+}
+
+void FlowManager::apply(const Event& event) {
+    applyingManual_ = event.type == Event::Type::ManualIntervention;
+    progress_.traceId = event.traceId;
+    progress_.traceStartNs = event.traceStartNs;
+    switch (event.type) {
+        case Event::Type::RecognizedPhrase:
+            handleRecognizedPhrase(event);
+            break;
+        case Event::Type::ManualIntervention:
+            // Logged where the key was pressed, before the flow moves on
+            logUtterance(event, false, nullptr);
+            handleManualIntervention();
+            break;
+    }
+}
+
+void FlowManager::restore(const FlowProgress& progress, uint64_t completedSections) {
+    progress_.currentSectionId = progress.currentSectionId;
+    progress_.currentPartId = progress.currentPartId;
+    progress_.currentRepetition = progress.currentRepetition;
+    progress_.awaitingManualIntervention = progress.awaitingManualIntervention;
+
+    const auto& sections = definition().getSections();
+    for (size_t i = 0; i < sections.size() && i < 64; ++i) {
+        sectionStates_[sections[i].id].isComplete = (completedSections >> i) & 1;
+    }
+    publish(true);
+}
+
+void FlowManager::publish(bool restored) {
+    progress_.complete = allSectionsComplete();
+    ++progress_.version;
+
+    if (journal_) {
+        auto previous = snapshot_.load(std::memory_order_relaxed);
+        auto type = FlowJournal::RecordType::Offering;
+        if (restored) {
+            type = FlowJournal::RecordType::Restored;
+        } else if (!previous || previous->currentSectionId != progress_.currentSectionId ||
+                   previous->currentPartId != progress_.currentPartId) {
+            type = FlowJournal::RecordType::SectionChange;
+        } else if (applyingManual_) {
+            type = FlowJournal::RecordType::ManualAdvance;
+        }
+        journal_->append(type, progress_, completedSectionMask());
+    }
+
+    auto snapshot = std::make_shared<const FlowProgress>(progress_);
+    snapshot_.store(snapshot, std::memory_order_release);
+    if (progressCallback_) {
+        progressCallback_(snapshot);
+    }
+}
+
+bool FlowManager::validateConfiguration(const nlohmann::json& flowConfig) {
+    // Basic validation that required fields exist, plus every block the flow
+    // thread reads later, so a bad edit is refused instead of throwing mid-session
+    try {
+        const auto& exec = flowConfig.at("execution");
+        float threshold = exec.at("recognition_settings").at("default_threshold").get<float>();
+        if (threshold < 0 || threshold > 1) {
             return false;
         }
+
+        if (exec.contains("logging")) {
+            const auto& logging = exec["logging"];
+            if (!logging.is_object()) return false;
+            for (const char* key : {"track_manual_interventions", "track_recognition_failures"}) {
+                if (logging.contains(key) && !logging[key].is_boolean()) return false;
+            }
+        }
+
+        if (exec.contains("admission")) {
+            const auto& admission = exec["admission"];
+            if (!admission.is_object()) return false;
+            auto defaults = admission.value("default", nlohmann::json::object());
+            if (!SegmentAdmission::validateJson(defaults)) return false;
+            if (admission.contains("section_overrides")) {
+                const auto& overrides = admission["section_overrides"];
+                if (!overrides.is_object()) return false;
+                // Overrides are applied on top of the defaults, as in getAdmissionSettings
+                for (const auto& section : overrides.items()) {
+                    if (!section.value().is_object()) return false;
+                    auto merged = defaults;
+                    merged.update(section.value());
+                    if (!SegmentAdmission::validateJson(merged)) return false;
+                }
+            }
+        }
         return true;
     } catch (...) {
         return false;
@@ -46,58 +312,42 @@ bool FlowManager::validateConfiguration() const {
 }
 
 void FlowManager::handleManualIntervention() {
-    std::cout << "Debug: Manual intervention handler called\n" << std::flush;
+    SADHANA_LOG_DEBUG("flow", "Manual intervention");
+    if (trackManualInterventions_) {
+        manualInterventionsMetric_.inc();
+    }
     
     // Get current state once at the beginning
-    auto currentState = definition_.getCurrentState(progress_.currentSectionId, progress_.currentPartId);
+    auto currentState = definition().getCurrentState(progress_.currentSectionId, progress_.currentPartId);
     
     // If we're in a part that requires repetitions and not awaiting intervention,
     // count this as a successful repetition
     if (!progress_.awaitingManualIntervention && !progress_.currentPartId.empty()) {
         progress_.currentRepetition++;
-        std::cout << "Debug: Manual intervention counted as repetition " 
-                  << progress_.currentRepetition << "/" << currentState.requiredRepetitions 
-                  << "\n" << std::flush;
-                  
+        offeringsMetric_.inc();
+        SADHANA_LOG_DEBUG("flow", "Manual intervention counted as repetition ",
+                          progress_.currentRepetition, "/", currentState.requiredRepetitions);
+
+
         // Check if we've reached the required repetitions
         if (progress_.currentRepetition >= currentState.requiredRepetitions) {
             progress_.awaitingManualIntervention = true;
         }
         
-        if (progressCallback_) {
-            progressCallback_(progress_);
-        }
+        publish();
         return;
     }
     
-    // Show current state for debugging
-    std::cout << "Debug: Current state before intervention:\n"
-              << "  Section: " << progress_.currentSectionId << "\n"
-              << "  Part: " << progress_.currentPartId << "\n"
-              << "  Expected utterance: " << currentState.expectedUtterance << "\n"
-              << "  Awaiting intervention: " << progress_.awaitingManualIntervention << "\n" << std::flush;
-    
-    // Rest of the existing code...
-    if (!progress_.awaitingManualIntervention) {
-        std::cout << "Debug: Ignoring manual intervention - not awaiting\n" << std::flush;
-        return;
-    }
-    
-    // ... (existing section transition code)
-    //auto currentState = definition_.getCurrentState(progress_.currentSectionId, progress_.currentPartId);
-    std::cout << "Debug: Current state before intervention:\n"
-              << "  Section: " << progress_.currentSectionId << "\n"
-              << "  Part: " << progress_.currentPartId << "\n"
-              << "  Expected utterance: " << currentState.expectedUtterance << "\n"
-              << "  Awaiting intervention: " << progress_.awaitingManualIntervention << "\n" << std::flush;
-    
+    SADHANA_LOG_DEBUG("flow", "State before intervention: section ", progress_.currentSectionId,
+                      ", part ", progress_.currentPartId,
+                      ", awaiting ", progress_.awaitingManualIntervention);
+
     if (!progress_.awaitingManualIntervention) {
-        std::cout << "Debug: Ignoring manual intervention - not awaiting\n" << std::flush;
+        SADHANA_LOG_DEBUG("flow", "Ignoring manual intervention - not awaiting");
         return;
     }
-    
+
     if (progress_.currentSectionId == "purvangam") {
-        std::cout << "Debug: In purvangam section, advancing...\n" << std::flush;
         
         // Mark current section complete and move to tarpanam
         sectionStates_[progress_.currentSectionId].isComplete = true;
@@ -107,7 +357,7 @@ void FlowManager::handleManualIntervention() {
         progress_.awaitingManualIntervention = false;
         
     } else if (progress_.currentSectionId == "tarpanam") {
-        const auto& sections = definition_.getSections();
+        const auto& sections = definition().getSections();
         auto section = std::find_if(sections.begin(), sections.end(),
             [this](const auto& s) { return s.id == "tarpanam"; });
             
@@ -117,57 +367,70 @@ void FlowManager::handleManualIntervention() {
                 
             if (currentPart != section->parts->end()) {
                 int required = currentPart->repetitions.value_or(1);
-                std::cout << "Debug: Current part requires " << required 
-                          << " repetitions, current: " << progress_.currentRepetition << "\n" << std::flush;
-                          
+                SADHANA_LOG_DEBUG("flow", "Current part requires ", required,
+                                  " repetitions, current: ", progress_.currentRepetition);
+
+
                 if (progress_.currentRepetition >= required) {
                     auto nextPart = std::next(currentPart);
                     if (nextPart != section->parts->end()) {
                         progress_.currentPartId = nextPart->id;
                         progress_.currentRepetition = 0;
                         progress_.awaitingManualIntervention = false;
-                        std::cout << "Debug: Advanced to next part: " << nextPart->id << "\n" << std::flush;
+                        SADHANA_LOG_DEBUG("flow", "Advanced to next part: ", nextPart->id);
                     } else {
                         sectionStates_[progress_.currentSectionId].isComplete = true;
                         progress_.currentSectionId = "uttarangam";
                         progress_.currentPartId = "";
                         progress_.currentRepetition = 0;
                         progress_.awaitingManualIntervention = true;
-                        std::cout << "Debug: Advanced to uttarangam section\n" << std::flush;
+                        SADHANA_LOG_DEBUG("flow", "Advanced to uttarangam section");
                     }
                 } else {
-                    std::cout << "Debug: Need more repetitions for current part\n" << std::flush;
+                    SADHANA_LOG_DEBUG("flow", "Need more repetitions for current part");
                     progress_.awaitingManualIntervention = false;
                 }
             }
         }
     }
     
-    // Get and log new state after changes
-    auto newState = definition_.getCurrentState(progress_.currentSectionId, progress_.currentPartId);
-    std::cout << "Debug: New state after intervention:\n"
-              << "  Section: " << progress_.currentSectionId << "\n"
-              << "  Part: " << progress_.currentPartId << "\n"
-              << "  Expected utterance: " << newState.expectedUtterance << "\n"
-              << "  Awaiting intervention: " << progress_.awaitingManualIntervention << "\n" << std::flush;
+    SADHANA_LOG_DEBUG("flow", "State after intervention: section ", progress_.currentSectionId,
+                      ", part ", progress_.currentPartId,
+                      ", awaiting ", progress_.awaitingManualIntervention);
     
-    if (progressCallback_) {
-        progressCallback_(progress_);
-    }
+    publish();
 }
 
-void FlowManager::handleRecognizedPhrase(const std::string& phrase, float confidence) {
+void FlowManager::handleRecognizedPhrase(const Event& event) {
+    const auto& phrase = event.phrase;
+    const TimePoint at = event.time;
     if (progress_.awaitingManualIntervention || phrase.empty()) {
         return;  // Don't process if waiting for manual intervention or empty phrase
     }
+    SADHANA_TRACE_CONTEXT(event.traceId);
+    SADHANA_TRACE_SPAN("flow.phrase");
 
-    auto result = phraseManager_.matchPhrase(phrase);
-    if (!result.matchedText.empty() && result.confidence >= getThresholdForSection(progress_.currentSectionId)) {
+    // The pipeline already matched the phrase to decide on escalation; only a
+    // reload since then makes the flow match it again, with its own matcher
+    auto result = event.match && event.matchedWith == active_->matcher
+        ? *event.match
+        : active_->matcher->matchPhrase(phrase);
+    auto& sectionState = sectionStates_[progress_.currentSectionId];
+    sectionState.lastAttempt = at;
+
+    bool accepted = !result.matchedText.empty() &&
+                    result.confidence >= thresholdForSection(active_->flowConfig, progress_.currentSectionId);
+    logUtterance(event, accepted, &result);
+
+    if (accepted) {
         // Valid phrase recognized
+        sectionState.failedAttempts = 0;
         progress_.currentRepetition++;
+        progress_.lastConfidence = result.confidence;
+        offeringsMetric_.inc();
         
         // Check if we need manual intervention after this repetition
-        const auto& sections = definition_.getSections();
+        const auto& sections = definition().getSections();
         auto section = std::find_if(sections.begin(), sections.end(),
             [this](const auto& s) { return s.id == progress_.currentSectionId; });
             
@@ -183,25 +446,73 @@ void FlowManager::handleRecognizedPhrase(const std::string& phrase, float confid
             }
         }
         
-        if (progressCallback_) {
-            progressCallback_(progress_);
+        publish();
+    } else {
+        sectionState.failedAttempts++;
+        if (trackRecognitionFailures_) {
+            recognitionFailuresMetric_.inc();
         }
     }
 }
 
+void FlowManager::logUtterance(const Event& event, bool accepted, const PhraseManager::MatchResult* match) {
+    if (!utteranceLog_) return;
+
+    UtteranceRecord record;
+    record.wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.streamMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        event.time.time_since_epoch()).count();
+    record.kind = event.type == Event::Type::ManualIntervention ? UtteranceKind::ManualAdvance
+                                                                 : UtteranceKind::Recognized;
+    record.accepted = accepted;
+    record.section = progress_.currentSectionId;
+    record.part = progress_.currentPartId;
+    record.transcript = event.phrase;
+    if (match) {
+        record.marker = match->matchedText;
+        record.confidence = match->confidence;
+    }
+    record.decodeMs = event.decodeMs;
+    // Accepted rows carry the repetition they complete
+    record.repetition = progress_.currentRepetition + (accepted ? 1 : 0);
+    utteranceLog_->append(record);
+}
+
 float FlowManager::getThresholdForSection(const std::string& sectionId) const {
+    return thresholdForSection(assets_.load(std::memory_order_acquire)->flowConfig, sectionId);
+}
+
+float FlowManager::thresholdForSection(const nlohmann::json& flowConfig, const std::string& sectionId) {
+    const auto& settings = flowConfig.at("execution").at("recognition_settings");
     try {
-        const auto& thresholds = flowConfig_["execution"]["recognition_settings"]["section_specific_thresholds"];
+        const auto& thresholds = settings.at("section_specific_thresholds");
         if (thresholds.contains(sectionId)) {
             return thresholds[sectionId].get<float>();
         }
     } catch (...) {}
     
-    return flowConfig_["execution"]["recognition_settings"]["default_threshold"].get<float>();
+    return settings.at("default_threshold").get<float>();
+}
+
+nlohmann::json FlowManager::getAdmissionSettings(const std::string& sectionId) const {
+    auto assets = assets_.load(std::memory_order_acquire);
+    nlohmann::json settings = nlohmann::json::object();
+    try {
+        const auto& admission = assets->flowConfig.at("execution").at("admission");
+        if (admission.contains("default")) {
+            settings = admission["default"];
+        }
+        if (admission.contains("section_overrides") && admission["section_overrides"].contains(sectionId)) {
+            settings.update(admission["section_overrides"][sectionId]);
+        }
+    } catch (...) {}
+
+    return settings;
 }
 
 bool FlowManager::checkSectionCompletion(const std::string& sectionId) {
-    const auto& sections = definition_.getSections();
+    const auto& sections = definition().getSections();
     auto it = std::find_if(sections.begin(), sections.end(),
         [&](const auto& section) { return section.id == sectionId; });
     
@@ -223,7 +534,7 @@ bool FlowManager::checkSectionCompletion(const std::string& sectionId) {
 }
 
 void FlowManager::advanceSection() {
-    const auto& sections = definition_.getSections();
+    const auto& sections = definition().getSections();
     auto it = std::find_if(sections.begin(), sections.end(),
         [&](const auto& section) { return section.id == progress_.currentSectionId; });
     
@@ -245,8 +556,20 @@ void FlowManager::advanceSection() {
     }
 }
 
-bool FlowManager::isComplete() const {
-    const auto& sections = definition_.getSections();
+uint64_t FlowManager::completedSectionMask() const {
+    uint64_t mask = 0;
+    const auto& sections = definition().getSections();
+    for (size_t i = 0; i < sections.size() && i < 64; ++i) {
+        auto it = sectionStates_.find(sections[i].id);
+        if (it != sectionStates_.end() && it->second.isComplete) {
+            mask |= 1ull << i;
+        }
+    }
+    return mask;
+}
+
+bool FlowManager::allSectionsComplete() const {
+    const auto& sections = definition().getSections();
     return std::all_of(sections.begin(), sections.end(),
         [this](const auto& section) {
             auto it = sectionStates_.find(section.id);
@@ -254,4 +577,17 @@ bool FlowManager::isComplete() const {
         });
 }
 
-} // namespace sadhana
\ No newline at end of file
+nlohmann::json progressToJson(const FlowProgress& progress) {
+    return {
+        {"section", progress.currentSectionId},
+        {"part", progress.currentPartId},
+        {"step", progress.currentStepId},
+        {"repetition", progress.currentRepetition},
+        {"awaiting_manual", progress.awaitingManualIntervention},
+        {"confidence", progress.lastConfidence},
+        {"complete", progress.complete},
+        {"version", progress.version}
+    };
+}
+
+} // namespace sadhana
@@ -0,0 +1,113 @@
+#include "ritual/flow_trace.hpp"
+#include <chrono>
+
+namespace sadhana {
+
+namespace {
+
+TimePoint traceTime(double seconds) {
+    return TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(seconds)));
+}
+
+}
+
+bool loadFlowTrace(const std::string& path, std::vector<FlowTraceEvent>& events, std::string* error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (line.empty()) continue;
+
+        try {
+            auto json = nlohmann::json::parse(line);
+            FlowTraceEvent event;
+            event.time = json.value("t", 0.0);
+
+            std::string type = json.value("type", "asr");
+            if (type == "key") {
+                event.type = FlowTraceEvent::Type::ManualAdvance;
+            } else if (type == "asr") {
+                event.type = FlowTraceEvent::Type::Recognized;
+                event.confidence = json.value("confidence", 0.8f);
+                if (json.contains("text")) {
+                    event.text = json["text"].get<std::string>();
+                } else if (json.contains("result")) {
+                    const auto& result = json["result"];
+                    event.text = result.is_string()
+                        ? nlohmann::json::parse(result.get<std::string>()).value("text", "")
+                        : result.value("text", "");
+                }
+            } else {
+                continue;
+            }
+            events.push_back(std::move(event));
+        } catch (const nlohmann::json::exception& e) {
+            if (error) *error = path + ":" + std::to_string(lineNumber) + ": " + e.what();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FlowTraceRecorder::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.open(path, std::ios::out | std::ios::trunc);
+    start_ = clock_->now();
+    return file_.is_open();
+}
+
+void FlowTraceRecorder::recordRecognized(const std::string& text, float confidence) {
+    write({{"type", "asr"}, {"text", text}, {"confidence", confidence}});
+}
+
+void FlowTraceRecorder::recordManualAdvance() {
+    write({{"type", "key"}, {"key", "space"}});
+}
+
+void FlowTraceRecorder::write(const nlohmann::json& line) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) return;
+
+    auto entry = line;
+    entry["t"] = std::chrono::duration<double>(clock_->now() - start_).count();
+    file_ << entry.dump() << "\n" << std::flush;
+}
+
+FlowReplayStats replayFlowTrace(FlowManager& flow, const std::vector<FlowTraceEvent>& events) {
+    FlowReplayStats stats;
+    ManualClock clock;
+    flow.setClock(clock);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (const auto& event : events) {
+        clock.set(traceTime(event.time));
+        if (event.type == FlowTraceEvent::Type::ManualAdvance) {
+            flow.postManualIntervention();
+            flow.processPending();
+            ++stats.manualAdvances;
+            continue;
+        }
+
+        int before = flow.snapshot()->currentRepetition;
+        flow.postRecognizedPhrase(event.text, event.confidence);
+        flow.processPending();
+        if (flow.snapshot()->currentRepetition > before) {
+            ++stats.countedRepetitions;
+        }
+        ++stats.phrases;
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    flow.setClock(SteadyClock::instance());
+    stats.phrasesPerSecond = stats.seconds > 0.0 ? stats.phrases / stats.seconds : 0.0;
+    stats.finalProgress = *flow.snapshot();
+    return stats;
+}
+
+}
@@ -0,0 +1,79 @@
+#include "shm/progress_page.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+ProgressPageReader::~ProgressPageReader() {
+    close();
+}
+
+bool ProgressPageReader::open(const std::string& name, std::string* error) {
+    auto fail = [error](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    close();
+    int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return fail("shm_open " + name + ": " + std::strerror(errno));
+    }
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(ProgressPage)) {
+        ::close(fd);
+        return fail(name + " is not a progress page");
+    }
+
+    void* mapping = ::mmap(nullptr, sizeof(ProgressPage), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return fail("mmap " + name + ": " + std::strerror(errno));
+    }
+
+    auto* page = static_cast<const ProgressPage*>(mapping);
+    if (page->magic != ProgressPage::MAGIC || page->layoutVersion != ProgressPage::LAYOUT_VERSION ||
+        page->dataSize != sizeof(ProgressPageData)) {
+        ::munmap(mapping, sizeof(ProgressPage));
+        return fail(name + " has an incompatible layout");
+    }
+
+    page_ = page;
+    mappedSize_ = sizeof(ProgressPage);
+    lastSequence_ = 0;
+    return true;
+}
+
+void ProgressPageReader::close() {
+    if (page_) {
+        ::munmap(const_cast<ProgressPage*>(page_), mappedSize_);
+        page_ = nullptr;
+    }
+}
+
+ProgressPageReader::Result ProgressPageReader::read(ProgressPageData& out, int maxAttempts) {
+    if (!page_) return Result::Busy;
+
+    ProgressPageData copy;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        uint64_t before = page_->sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;  // writer inside
+        if (before == lastSequence_) return Result::Unchanged;
+
+        // The copy may race with a writer; the sequence check below discards it if so
+        std::memcpy(&copy, &page_->data, sizeof(copy));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page_->sequence.load(std::memory_order_relaxed) == before) {
+            out = copy;
+            lastSequence_ = before;
+            return Result::Updated;
+        }
+    }
+    return Result::Busy;
+}
+
+}
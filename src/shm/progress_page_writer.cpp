@@ -0,0 +1,139 @@
+#include "shm/progress_page_writer.hpp"
+#include "host/ritual_assets.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace sadhana {
+
+namespace {
+
+template <size_t N>
+void copyField(char (&field)[N], const std::string& value) {
+    size_t n = std::min(value.size(), N - 1);
+    std::memcpy(field, value.data(), n);
+    field[n] = '\0';
+}
+
+int64_t wallMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+ProgressPageWriter::ProgressPageWriter(const FlowManager& flow)
+    : ProgressPageWriter(flow, Config()) {}
+
+ProgressPageWriter::ProgressPageWriter(const FlowManager& flow, const Config& config)
+    : flow_(flow), config_(config) {
+    data_.sectionIndex = -1;
+    data_.sectionCount = static_cast<int32_t>(flow_.assets()->ritual->getSections().size());
+}
+
+ProgressPageWriter::~ProgressPageWriter() {
+    close();
+}
+
+bool ProgressPageWriter::open() {
+    if (page_) return true;
+
+    int fd = ::shm_open(config_.name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, config_.mode);
+    if (fd < 0) {
+        std::cerr << "shm_open " << config_.name << " failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    if (ftruncate(fd, sizeof(ProgressPage)) < 0) {
+        std::cerr << "ftruncate " << config_.name << " failed: " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, sizeof(ProgressPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "mmap " << config_.name << " failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // A page left by an earlier run is reused; its sequence keeps counting so
+    // readers that stayed attached still see the change
+    page_ = static_cast<ProgressPage*>(mapping);
+    uint64_t sequence = page_->magic == ProgressPage::MAGIC ? page_->sequence.load(std::memory_order_relaxed) : 0;
+    page_->magic = ProgressPage::MAGIC;
+    page_->layoutVersion = ProgressPage::LAYOUT_VERSION;
+    page_->dataSize = sizeof(ProgressPageData);
+    page_->writerPid = static_cast<uint32_t>(getpid());
+    page_->sequence.store(sequence & ~1ull, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    commit();
+    return true;
+}
+
+void ProgressPageWriter::close() {
+    if (!page_) return;
+    ::munmap(page_, sizeof(ProgressPage));
+    page_ = nullptr;
+    ::shm_unlink(config_.name.c_str());
+}
+
+void ProgressPageWriter::publish(const FlowProgress& progress) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The generation is read before the bundle, so a reload in between only
+    // means one more lookup on the next publish
+    uint64_t generation = flow_.assetsGeneration();
+    if (progress.currentSectionId != stateSectionId_ || progress.currentPartId != statePartId_ ||
+        generation != stateGeneration_) {
+        stateSectionId_ = progress.currentSectionId;
+        statePartId_ = progress.currentPartId;
+        stateGeneration_ = generation;
+
+        auto assets = flow_.assets();
+        auto state = assets->ritual->getCurrentState(stateSectionId_, statePartId_);
+        copyField(data_.expectedUtterance, state.expectedUtterance);
+        data_.requiredRepetitions = state.requiredRepetitions;
+
+        const auto& sections = assets->ritual->getSections();
+        auto it = std::find_if(sections.begin(), sections.end(),
+                               [this](const auto& section) { return section.id == stateSectionId_; });
+        data_.sectionIndex = it == sections.end() ? -1 : static_cast<int32_t>(it - sections.begin());
+        copyField(data_.sectionTitle, it == sections.end() ? std::string() : it->title);
+    }
+
+    copyField(data_.sectionId, progress.currentSectionId);
+    copyField(data_.partId, progress.currentPartId);
+    copyField(data_.stepId, progress.currentStepId);
+    data_.repetition = progress.currentRepetition;
+    data_.awaitingManual = progress.awaitingManualIntervention;
+    data_.complete = progress.complete;
+    data_.version = progress.version;
+    commit();
+}
+
+void ProgressPageWriter::publishRecognized(const std::string& text, float confidence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    copyField(data_.lastRecognized, text);
+    data_.lastConfidence = confidence;
+    commit();
+}
+
+void ProgressPageWriter::commit() {
+    if (!page_) return;
+    data_.updatedWallMs = wallMs();
+
+    // Seqlock write: odd while the data is being replaced, even and larger afterwards
+    uint64_t sequence = page_->sequence.load(std::memory_order_relaxed);
+    page_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&page_->data, &data_, sizeof(data_));
+    page_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,153 @@
+#include "trace/tracer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sadhana {
+
+namespace {
+
+struct TraceEvent {
+    const char* name{nullptr};
+    uint64_t traceId{0};
+    int64_t beginNs{0};
+    int64_t endNs{0};
+};
+
+// Written only by its own thread; kept alive by the registry after the
+// thread exits so short-lived workers still show up in the dump
+struct ThreadRing {
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[Tracer::RING_EVENTS]};
+    std::atomic<uint64_t> written{0};
+    std::string name;
+    uint32_t tid{0};
+};
+
+std::mutex registryMutex;
+std::vector<std::shared_ptr<ThreadRing>> registry;
+// Waiting for its real-time thread; registered already, so never freed
+std::atomic<ThreadRing*> preparedRing{nullptr};
+
+// Plain pointers: the registry owns every ring, and trivial thread_locals
+// cost nothing to reach from any thread
+thread_local ThreadRing* localRing = nullptr;
+thread_local bool localUntraced = false;  // real-time thread without a prepared ring
+thread_local uint64_t localTraceId = 0;
+
+ThreadRing* registerRing() {
+    auto ring = std::make_shared<ThreadRing>();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    ring->tid = static_cast<uint32_t>(registry.size() + 1);
+    ring->name = "thread-" + std::to_string(ring->tid);
+    registry.push_back(ring);
+    return ring.get();
+}
+
+ThreadRing* threadRing() {
+    if (!localRing && !localUntraced) {
+        localRing = registerRing();
+    }
+    return localRing;
+}
+
+}
+
+int64_t Tracer::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char* name, uint64_t traceId, int64_t beginNs, int64_t endNs) {
+    auto* ring = threadRing();
+    if (!ring) return;
+    uint64_t index = ring->written.load(std::memory_order_relaxed);
+    ring->events[index % RING_EVENTS] = {name, traceId, beginNs, endNs};
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const char* name) {
+    auto* ring = threadRing();
+    if (!ring) return;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    ring->name = name;
+}
+
+void Tracer::prepareRealtimeThread(const char* name) {
+    ThreadRing* ring = registerRing();
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ring->name = name;
+    }
+    // One nobody claimed (a stream that never started) stays in the dump, empty
+    preparedRing.store(ring, std::memory_order_release);
+}
+
+void Tracer::enterRealtimeThread() {
+    if (localRing || localUntraced) return;
+    localRing = preparedRing.exchange(nullptr, std::memory_order_acq_rel);
+    localUntraced = !localRing;
+}
+
+uint64_t Tracer::currentTraceId() {
+    return localTraceId;
+}
+
+void Tracer::setCurrentTraceId(uint64_t traceId) {
+    localTraceId = traceId;
+}
+
+bool Tracer::writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        rings = registry;
+    }
+
+    // Timestamps are relative to the earliest event so the viewer opens at zero
+    int64_t origin = INT64_MAX;
+    for (const auto& ring : rings) {
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        for (uint64_t i = written > RING_EVENTS ? written - RING_EVENTS : 0; i < written; ++i) {
+            origin = std::min(origin, ring->events[i % RING_EVENTS].beginNs);
+        }
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() -> std::ostream& {
+        if (!first) out << ",\n";
+        first = false;
+        return out;
+    };
+
+    for (const auto& ring : rings) {
+        separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+                    << ",\"args\":{\"name\":\"" << ring->name << "\"}}";
+
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        for (uint64_t i = written > RING_EVENTS ? written - RING_EVENTS : 0; i < written; ++i) {
+            const auto& event = ring->events[i % RING_EVENTS];
+            separator() << "{\"name\":\"" << event.name << "\",\"cat\":\"sadhana\",\"ph\":\"X\""
+                        << ",\"pid\":1,\"tid\":" << ring->tid
+                        << ",\"ts\":" << (event.beginNs - origin) / 1000.0
+                        << ",\"dur\":" << (event.endNs - event.beginNs) / 1000.0
+                        << ",\"args\":{\"trace_id\":" << event.traceId << "}}";
+        }
+    }
+
+    out << "\n]}\n";
+    return out.good();
+}
+
+}
@@ -0,0 +1,40 @@
+#include "allocation_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+std::atomic<int64_t> bytes{0};
+std::atomic<int64_t> peak{0};
+
+}
+
+void* operator new(std::size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    int64_t usable = static_cast<int64_t>(malloc_usable_size(p));
+    int64_t now = bytes.fetch_add(usable, std::memory_order_relaxed) + usable;
+    int64_t high = peak.load(std::memory_order_relaxed);
+    while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) {}
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    bytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(p)), std::memory_order_relaxed);
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+namespace sadhana {
+
+uint64_t allocationCount() { return allocations.load(std::memory_order_relaxed); }
+int64_t heapBytes() { return bytes.load(std::memory_order_relaxed); }
+int64_t heapPeak() { return peak.load(std::memory_order_relaxed); }
+void resetHeapPeak() { peak.store(bytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+}
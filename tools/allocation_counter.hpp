@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// Benchmarks link tools/allocation_counter.cpp, which replaces the global
+// operator new and delete, so a code path can be charged for exactly the
+// heap it touches.
+namespace sadhana {
+
+uint64_t allocationCount();
+// Usable bytes currently held through operator new
+int64_t heapBytes();
+// Highest heapBytes() since the last resetHeapPeak()
+int64_t heapPeak();
+void resetHeapPeak();
+
+}
@@ -0,0 +1,301 @@
+// Replays a corpus of recorded sessions through the offline pipeline and
+// reports counting accuracy, marker errors, real-time factor and latency.
+//
+//   sadhana_eval <manifest.json> [-j threads] [-o results.json] [-a analytics-dir]
+//
+// Audio paths in the manifest are relative to the manifest; ritual, flow and
+// model paths are relative to the working directory, like the main binary.
+// "escalation_models" lists larger models for low-confidence utterances.
+// With -a, every utterance is also written to the columnar analytics store
+// (one file per worker, session = audio path) for sadhana_stats.
+
+#include "audio/wav_file.hpp"
+#include "eval/offline_session.hpp"
+#include "analytics/utterance_log.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+struct Recording {
+    std::string audioPath;
+    int expectedCount{0};
+    std::vector<double> markerTimes;  // end of each ground-truth marker, seconds
+};
+
+struct FileReport {
+    std::string audioPath;
+    sadhana::OfflineSession::Result result;
+    int expectedCount{0};
+    int falseMarkers{0};
+    int missedMarkers{0};
+    std::vector<double> latenciesMs;
+};
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+nlohmann::json latencyJson(const std::vector<double>& latencies) {
+    return {
+        {"p50", percentile(latencies, 50)},
+        {"p95", percentile(latencies, 95)},
+        {"p99", percentile(latencies, 99)}
+    };
+}
+
+// Pairs counts with ground-truth markers in time order. Without marker times
+// only the totals can be compared, and latency falls back to VAD hang plus
+// processing time.
+void scoreRecording(const Recording& recording, double toleranceS, int hangTimeMs, FileReport& report) {
+    const auto& counts = report.result.counts;
+    int counted = static_cast<int>(counts.size());
+
+    if (recording.markerTimes.empty()) {
+        report.falseMarkers = std::max(0, counted - recording.expectedCount);
+        report.missedMarkers = std::max(0, recording.expectedCount - counted);
+        for (const auto& event : counts) {
+            report.latenciesMs.push_back(hangTimeMs + event.processingMs);
+        }
+        return;
+    }
+
+    std::vector<bool> used(counts.size(), false);
+    size_t first = 0;
+    for (double markerTime : recording.markerTimes) {
+        bool matched = false;
+        for (size_t i = first; i < counts.size(); ++i) {
+            double delay = counts[i].audioSeconds - markerTime;
+            if (delay < 0.0 || used[i]) continue;
+            if (delay > toleranceS) break;
+            used[i] = true;
+            first = i + 1;
+            report.latenciesMs.push_back(delay * 1000.0 + counts[i].processingMs);
+            matched = true;
+            break;
+        }
+        if (!matched) report.missedMarkers++;
+    }
+    report.falseMarkers = static_cast<int>(std::count(used.begin(), used.end(), false));
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <manifest.json> [-j threads] [-o results.json] [-a analytics-dir]\n";
+        return 1;
+    }
+
+    std::string manifestPath = argv[1];
+    std::string outputPath;
+    std::string analyticsDir;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "-j") {
+            threads = std::max(1, std::atoi(argv[i + 1]));
+        } else if (flag == "-o") {
+            outputPath = argv[i + 1];
+        } else if (flag == "-a") {
+            analyticsDir = argv[i + 1];
+        }
+    }
+
+    sadhana::Logger::instance().setLevel(sadhana::LogLevel::Warn);
+
+    nlohmann::json manifest;
+    try {
+        std::ifstream file(manifestPath);
+        manifest = nlohmann::json::parse(file);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to read manifest: " << e.what() << "\n";
+        return 1;
+    }
+
+    auto manifestDir = std::filesystem::path(manifestPath).parent_path();
+    std::vector<Recording> recordings;
+    for (const auto& entry : manifest.value("recordings", nlohmann::json::array())) {
+        Recording recording;
+        recording.audioPath = (manifestDir / entry.at("audio").get<std::string>()).string();
+        recording.expectedCount = entry.value("expected_count", 0);
+        recording.markerTimes = entry.value("marker_times", std::vector<double>{});
+        std::sort(recording.markerTimes.begin(), recording.markerTimes.end());
+        if (entry.contains("marker_times") && !entry.contains("expected_count")) {
+            recording.expectedCount = static_cast<int>(recording.markerTimes.size());
+        }
+        recordings.push_back(std::move(recording));
+    }
+    if (recordings.empty()) {
+        std::cerr << "Manifest lists no recordings\n";
+        return 1;
+    }
+
+    sadhana::RitualDefinition ritual;
+    std::string ritualPath = manifest.value("ritual",
+        "rituals/definitions/ganapati/maha_ganapati_caturvrtti_tarpanam.json");
+    if (!ritual.loadFromFile(ritualPath)) {
+        std::cerr << "Failed to load ritual definition: " << ritualPath << "\n";
+        return 1;
+    }
+
+    // One set of models for every worker; each session makes its own recognizers
+    sadhana::VoskASR::Config asrConfig;
+    asrConfig.modelPath = manifest.value("model", "models/vosk-model-small-en-us-0.15");
+    asrConfig.sampleRate = manifest.value("sample_rate", 16000.0f);
+    asrConfig.escalationModelPaths = manifest.value("escalation_models", std::vector<std::string>{});
+    sadhana::VoskASR asr(asrConfig);
+    if (!asr.init()) {
+        return 1;
+    }
+
+    sadhana::OfflineSession::Config sessionConfig;
+    sessionConfig.flowConfigPath = manifest.value("flow", "rituals/definitions/ganapati/flow.json");
+    sessionConfig.autoAdvance = manifest.value("auto_advance", true);
+    double toleranceS = manifest.value("match_tolerance_s", 3.0);
+
+    std::vector<FileReport> reports(recordings.size());
+    std::atomic<size_t> nextRecording{0};
+    threads = std::min(threads, recordings.size());
+
+    std::vector<std::unique_ptr<sadhana::UtteranceLogWriter>> analytics;
+    if (!analyticsDir.empty()) {
+        std::filesystem::create_directories(analyticsDir);
+        for (size_t t = 0; t < threads; ++t) {
+            sadhana::UtteranceLogWriter::Config logConfig;
+            logConfig.path = (std::filesystem::path(analyticsDir) /
+                              ("eval-" + std::to_string(t) + ".sdua")).string();
+            analytics.push_back(std::make_unique<sadhana::UtteranceLogWriter>(logConfig));
+            std::string error;
+            if (!analytics.back()->open(&error)) {
+                std::cerr << "Failed to open analytics file: " << error << "\n";
+                return 1;
+            }
+        }
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            auto workerConfig = sessionConfig;
+            workerConfig.analytics = analytics.empty() ? nullptr : analytics[t].get();
+            for (size_t i = nextRecording++; i < recordings.size(); i = nextRecording++) {
+                const auto& recording = recordings[i];
+                auto& report = reports[i];
+                report.audioPath = recording.audioPath;
+                report.expectedCount = recording.expectedCount;
+
+                sadhana::WavData wav;
+                if (!sadhana::readWavFile(recording.audioPath, wav, &report.result.error)) {
+                    continue;
+                }
+                auto samples = sadhana::resample(wav.samples, wav.sampleRate,
+                                                       static_cast<int>(asrConfig.sampleRate));
+
+                if (workerConfig.analytics) {
+                    workerConfig.analytics->setSession(recording.audioPath);
+                }
+                sadhana::OfflineSession session(ritual, asr, workerConfig);
+                report.result = session.run(samples);
+                if (report.result.ok) {
+                    scoreRecording(recording, toleranceS, sessionConfig.pipeline.vadConfig.hangTimeMs, report);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& log : analytics) {
+        log->close();
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    nlohmann::json files = nlohmann::json::array();
+    std::vector<double> allLatencies;
+    double audioSeconds = 0.0, processingSeconds = 0.0;
+    int expected = 0, counted = 0, absError = 0, falseMarkers = 0, missedMarkers = 0, failed = 0;
+
+    for (const auto& report : reports) {
+        const auto& result = report.result;
+        if (!result.ok) {
+            failed++;
+            files.push_back({{"audio", report.audioPath}, {"error", result.error}});
+            continue;
+        }
+
+        int count = static_cast<int>(result.counts.size());
+        files.push_back({
+            {"audio", report.audioPath},
+            {"expected", report.expectedCount},
+            {"counted", count},
+            {"count_error", count - report.expectedCount},
+            {"false_markers", report.falseMarkers},
+            {"missed_markers", report.missedMarkers},
+            {"utterances", result.utterances},
+            {"rejected_segments", result.rejected},
+            {"kws_hits", result.pipeline.kwsHits},
+            {"escalations", result.pipeline.escalations},
+            {"escalations_kept", result.pipeline.escalationsKept},
+            {"audio_seconds", result.audioSeconds},
+            {"rtf", result.audioSeconds > 0 ? result.processingSeconds / result.audioSeconds : 0.0},
+            {"latency_ms", latencyJson(report.latenciesMs)},
+            {"final_section", result.finalProgress.currentSectionId},
+            {"final_part", result.finalProgress.currentPartId}
+        });
+
+        expected += report.expectedCount;
+        counted += count;
+        absError += std::abs(count - report.expectedCount);
+        falseMarkers += report.falseMarkers;
+        missedMarkers += report.missedMarkers;
+        audioSeconds += result.audioSeconds;
+        processingSeconds += result.processingSeconds;
+        allLatencies.insert(allLatencies.end(), report.latenciesMs.begin(), report.latenciesMs.end());
+    }
+
+    nlohmann::json output = {
+        {"files", files},
+        {"aggregate", {
+            {"recordings", reports.size()},
+            {"failed", failed},
+            {"threads", threads},
+            {"expected", expected},
+            {"counted", counted},
+            {"count_error", counted - expected},
+            {"abs_count_error", absError},
+            {"false_markers", falseMarkers},
+            {"missed_markers", missedMarkers},
+            {"audio_seconds", audioSeconds},
+            {"rtf", audioSeconds > 0 ? processingSeconds / audioSeconds : 0.0},
+            {"wall_seconds", wallSeconds},
+            {"throughput_x_realtime", wallSeconds > 0 ? audioSeconds / wallSeconds : 0.0},
+            {"latency_ms", latencyJson(allLatencies)}
+        }}
+    };
+
+    if (outputPath.empty()) {
+        std::cout << output.dump(2) << "\n";
+    } else {
+        std::ofstream out(outputPath);
+        out << output.dump(2) << "\n";
+        std::cerr << "Wrote " << outputPath << "\n";
+    }
+
+    return failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,239 @@
+// Runs recorded sessions concurrently inside one SessionHost, each fed at
+// real-time pace as if a practitioner were speaking, and reports per-session
+// real-time factor, admission decisions and final flow position.
+//
+//   sadhana_host <manifest.json> [-w workers] [-s speed] [-o results.json]
+//
+// The manifest has the same shape as sadhana_eval's; "stagger_s" spaces out
+// session starts and "max_sessions" / "max_utilization" tune admission.
+// "escalation_models" lists larger models for low-confidence utterances.
+// -s 2 feeds audio at twice real time, which halves the headroom per session.
+
+#include "audio/wav_file.hpp"
+#include "host/session_host.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+struct SessionReport {
+    std::string audioPath;
+    bool admitted{false};
+    std::string error;
+    int expectedCount{0};
+    int counted{0};
+    sadhana::Session::Stats stats;
+    sadhana::FlowManager::ProgressSnapshot progress;
+    double utilizationAtOpen{0.0};
+};
+
+constexpr size_t FEED_BLOCK_FRAMES = 1440;
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <manifest.json> [-w workers] [-s speed] [-o results.json]\n";
+        return 1;
+    }
+
+    std::string manifestPath = argv[1];
+    std::string outputPath;
+    size_t workers = 0;
+    double speed = 1.0;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "-w") {
+            workers = static_cast<size_t>(std::max(1, std::atoi(argv[i + 1])));
+        } else if (flag == "-s") {
+            speed = std::max(0.01, std::atof(argv[i + 1]));
+        } else if (flag == "-o") {
+            outputPath = argv[i + 1];
+        }
+    }
+
+    sadhana::Logger::instance().setLevel(sadhana::LogLevel::Warn);
+
+    nlohmann::json manifest;
+    try {
+        std::ifstream file(manifestPath);
+        manifest = nlohmann::json::parse(file);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to read manifest: " << e.what() << "\n";
+        return 1;
+    }
+
+    auto manifestDir = std::filesystem::path(manifestPath).parent_path();
+    std::vector<SessionReport> reports;
+    for (const auto& entry : manifest.value("recordings", nlohmann::json::array())) {
+        SessionReport report;
+        report.audioPath = (manifestDir / entry.at("audio").get<std::string>()).string();
+        report.expectedCount = entry.value("expected_count", 0);
+        reports.push_back(std::move(report));
+    }
+    if (reports.empty()) {
+        std::cerr << "Manifest lists no recordings\n";
+        return 1;
+    }
+
+    // Loaded once; every session below shares the definition, matcher and model
+    std::string loadError;
+    auto assets = sadhana::RitualAssets::load(
+        manifest.value("ritual", "rituals/definitions/ganapati/maha_ganapati_caturvrtti_tarpanam.json"),
+        manifest.value("flow", "rituals/definitions/ganapati/flow.json"), &loadError);
+    if (!assets) {
+        std::cerr << loadError << "\n";
+        return 1;
+    }
+
+    sadhana::VoskASR::Config asrConfig;
+    asrConfig.modelPath = manifest.value("model", "models/vosk-model-small-en-us-0.15");
+    asrConfig.sampleRate = manifest.value("sample_rate", 16000.0f);
+    asrConfig.escalationModelPaths = manifest.value("escalation_models", std::vector<std::string>{});
+    auto asr = std::make_shared<sadhana::VoskASR>(asrConfig);
+    if (!asr->init()) {
+        return 1;
+    }
+
+    sadhana::SessionHost::Config hostConfig;
+    hostConfig.workers = workers;
+    hostConfig.maxSessions = manifest.value("max_sessions", hostConfig.maxSessions);
+    hostConfig.maxUtilization = manifest.value("max_utilization", hostConfig.maxUtilization);
+    sadhana::SessionHost host(asr, hostConfig);
+    host.start();
+
+    const double staggerS = manifest.value("stagger_s", 0.0);
+    const int sampleRate = static_cast<int>(asrConfig.sampleRate);
+    auto wallStart = std::chrono::steady_clock::now();
+
+    // One feeder per recording plays the part of that practitioner's microphone
+    std::vector<std::thread> feeders;
+    for (size_t i = 0; i < reports.size(); ++i) {
+        feeders.emplace_back([&, i]() {
+            auto& report = reports[i];
+            std::this_thread::sleep_until(wallStart + std::chrono::duration<double>(i * staggerS / speed));
+
+            sadhana::WavData wav;
+            if (!sadhana::readWavFile(report.audioPath, wav, &report.error)) {
+                return;
+            }
+            auto samples = sadhana::resample(wav.samples, wav.sampleRate, sampleRate);
+
+            sadhana::Session::Config config;
+            config.id = "s" + std::to_string(i);
+            config.autoAdvance = manifest.value("auto_advance", true);
+            report.utilizationAtOpen = host.utilization();
+            auto session = host.openSession(assets, config, &report.error);
+            if (!session) {
+                return;
+            }
+            report.admitted = true;
+
+            // Repetitions counted from speech, as sadhana_eval reports them
+            auto counted = std::make_shared<std::atomic<int>>(0);
+            auto lastRepetition = std::make_shared<int>(session->progress()->currentRepetition);
+            session->setProgressCallback([counted, lastRepetition](const auto& progress) {
+                if (progress->currentRepetition > *lastRepetition) ++*counted;
+                *lastRepetition = progress->currentRepetition;
+            });
+
+            auto feedStart = std::chrono::steady_clock::now();
+            for (size_t offset = 0; offset < samples.size(); offset += FEED_BLOCK_FRAMES) {
+                size_t count = std::min(FEED_BLOCK_FRAMES, samples.size() - offset);
+                auto due = feedStart + std::chrono::duration<double>(
+                    static_cast<double>(offset + count) / sampleRate / speed);
+                std::this_thread::sleep_until(due);
+                session->pushAudio(samples.data() + offset, count);
+            }
+
+            // Let the workers finish what is queued before reading the result
+            while (!session->isIdle()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            report.stats = session->stats();
+            report.progress = session->progress();
+            report.counted = counted->load();
+            host.closeSession(config.id);
+        });
+    }
+    for (auto& feeder : feeders) {
+        feeder.join();
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    auto hostStats = host.stats();
+    host.stop();
+
+    nlohmann::json sessions = nlohmann::json::array();
+    double audioSeconds = 0.0, busySeconds = 0.0;
+    size_t admitted = 0;
+    for (const auto& report : reports) {
+        nlohmann::json entry = {
+            {"audio", report.audioPath},
+            {"admitted", report.admitted},
+            {"utilization_at_open", report.utilizationAtOpen}
+        };
+        if (!report.admitted) {
+            entry["error"] = report.error;
+            sessions.push_back(std::move(entry));
+            continue;
+        }
+
+        const auto& stats = report.stats;
+        entry.update({
+            {"id", stats.id},
+            {"expected", report.expectedCount},
+            {"counted", report.counted},
+            {"audio_seconds", stats.audioSeconds},
+            {"busy_seconds", stats.busySeconds},
+            {"rtf", stats.rtf},
+            {"recent_rtf", stats.recentRtf},
+            {"dropped_blocks", stats.droppedBlocks},
+            {"utterances", stats.utterances},
+            {"rejected_segments", stats.rejected},
+            {"kws_hits", stats.pipeline.kwsHits},
+            {"escalations", stats.pipeline.escalations},
+            {"escalations_kept", stats.pipeline.escalationsKept},
+            {"final_section", report.progress->currentSectionId},
+            {"final_part", report.progress->currentPartId},
+            {"complete", report.progress->complete}
+        });
+        sessions.push_back(std::move(entry));
+
+        ++admitted;
+        audioSeconds += stats.audioSeconds;
+        busySeconds += stats.busySeconds;
+    }
+
+    nlohmann::json output = {
+        {"sessions", sessions},
+        {"aggregate", {
+            {"recordings", reports.size()},
+            {"admitted", admitted},
+            {"rejected", hostStats.rejected},
+            {"workers", hostStats.workers},
+            {"speed", speed},
+            {"audio_seconds", audioSeconds},
+            {"busy_seconds", busySeconds},
+            {"rtf", audioSeconds > 0 ? busySeconds / audioSeconds : 0.0},
+            {"wall_seconds", wallSeconds}
+        }}
+    };
+
+    if (outputPath.empty()) {
+        std::cout << output.dump(2) << "\n";
+    } else {
+        std::ofstream out(outputPath);
+        out << output.dump(2) << "\n";
+        std::cerr << "Wrote " << outputPath << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,550 @@
+// Compares the two ritual loaders on a synthetic library: the document path
+// (nlohmann::json::parse, then copying the document into the structs, the
+// loader DefinitionReader replaced, kept below as the baseline) and the
+// streaming path (RitualDefinition::loadFromText over DefinitionReader).
+//
+//   sadhana_load_bench [-d dir] [-n rituals] [-s sections] [-p parts]
+//                      [-v variants] [-g groups] [-r rounds] [--keep]
+//
+// Each ritual references materials, mantras and procedures files shared by
+// its group. Both paths read the same files and resolve the common files
+// anew for every ritual. Reports the best wall time over the rounds, the
+// peak heap above the starting point while all rituals are loaded, what the
+// loaded rituals keep, and allocation counts; then checks that both paths
+// produced identical definitions.
+
+#include "definition/definition.hpp"
+#include "log/logger.hpp"
+#include "allocation_counter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+namespace fs = std::filesystem;
+using sadhana::JsonValue;
+using sadhana::RitualDefinition;
+
+struct Shape {
+    int rituals{100};
+    int sections{8};
+    int parts{12};
+    int variants{24};
+    int groups{10};
+};
+
+// A braced list of two-string lists would otherwise become an object
+JsonValue pairs(std::initializer_list<std::vector<std::string>> lists) {
+    JsonValue json = JsonValue::array();
+    for (const auto& list : lists) json.push_back(list);
+    return json;
+}
+
+void writeJson(const fs::path& path, const JsonValue& json) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << json.dump(2);
+}
+
+// Definitions look like the shipped ones: markers with many misrecognition
+// variants, parts with sequences and pairs, counts, and some keys the
+// structs do not model
+void generateLibrary(const fs::path& root, const Shape& shape) {
+    for (int g = 0; g < shape.groups; ++g) {
+        std::string group = "group_" + std::to_string(g);
+
+        JsonValue materials = JsonValue::array();
+        for (int i = 0; i < 30; ++i) {
+            materials.push_back({{"id", "material_" + std::to_string(i)},
+                                 {"name", "Material " + std::to_string(i)},
+                                 {"details", "Kept in a copper vessel, " + std::to_string(i) + " measures"},
+                                 {"optional", i % 4 == 0},
+                                 {"quantity", {{"amount", i}, {"unit", "spoon"}}}});
+        }
+        writeJson(root / "common/materials" / (group + ".json"), {{"materials", materials}});
+
+        JsonValue mantras = JsonValue::object();
+        for (int i = 0; i < 40; ++i) {
+            std::string id = "mantra_" + std::to_string(i);
+            if (i % 5 == 0) {
+                mantras[id] = {"om shrim hrim klim", "glaum gam ganapataye", "vara varada"};
+                continue;
+            }
+            JsonValue mantra = {{"text", "om " + id + " namaha"}, {"type", i % 2 ? "beeja" : "mula"},
+                                {"beejas", {"om", "shrim", "hrim", "klim", "glaum", "gam"}},
+                                {"pairs", pairs({{"shrim", "shriyai"}, {"hrim", "hriyai"}})},
+                                {"full_variants", JsonValue::array()}, {"deity", "ganapati"}};
+            for (int v = 0; v < shape.variants / 2; ++v) {
+                mantra["full_variants"].push_back("om " + id + " nama ha " + std::to_string(v));
+            }
+            mantras[id] = std::move(mantra);
+        }
+        writeJson(root / "common/mantras" / (group + ".json"), {{"mantras", mantras}});
+
+        JsonValue procedures = JsonValue::object();
+        for (int i = 0; i < 20; ++i) {
+            std::string id = "procedure_" + std::to_string(i);
+            procedures[id] = {{"title", "Procedure " + std::to_string(i)},
+                              {"items", {"water", "turmeric", "flowers"}},
+                              {"instructions", {"Sip water three times", "Touch the eyes", "Sit facing east"}},
+                              {"mantra_refs", {"mantra_1", "mantra_2"}},
+                              {"duration_s", 30 + i}};
+        }
+        writeJson(root / "common/procedures" / (group + ".json"), {{"procedures", procedures}});
+    }
+
+    for (int r = 0; r < shape.rituals; ++r) {
+        std::string group = "group_" + std::to_string(r % shape.groups);
+        std::string id = "ritual_" + std::to_string(r);
+
+        JsonValue sections = JsonValue::array();
+        for (int s = 0; s < shape.sections; ++s) {
+            std::string sectionId = "section_" + std::to_string(s);
+            JsonValue section = {{"id", sectionId}, {"title", "Section " + std::to_string(s)},
+                                 {"description", "Offerings to the " + std::to_string(s) + "th avarana"},
+                                 {"discipline_note", "Keep the count silently"},
+                                 {"procedure_refs", {"procedure_1", "procedure_2"}},
+                                 {"derived_totals", {{"offerings", shape.parts * 4}, {"rounds", 4}}}};
+            if (s % 2 == 0) {
+                section["introduction"] = "Begin with the dhyana of section " + std::to_string(s);
+            }
+
+            JsonValue variants = JsonValue::array();
+            for (int v = 0; v < shape.variants; ++v) {
+                variants.push_back("tarpayami namaha " + std::to_string(v));
+            }
+            section["iteration_marker"] = {{"canonical", "tarpayaami namaha"}, {"variants", variants},
+                                           {"with_svaha_variants", s % 2 == 0}, {"cooldown_ms", 700},
+                                           {"phonetic_key", "TRPYMNMH"}};
+
+            JsonValue parts = JsonValue::array();
+            for (int p = 0; p < shape.parts; ++p) {
+                std::string partId = sectionId + "_part_" + std::to_string(p);
+                JsonValue part = {{"id", partId}, {"title", "Part " + std::to_string(p)},
+                                  {"repetitions", 4}, {"notes", "Offer with the ring finger"},
+                                  {"mantra_ref", "mantra_" + std::to_string(p % 40)},
+                                  {"derived_counts", {{"offerings", 4}}},
+                                  {"display", {{"devanagari", true}, {"emphasis", {"om", "namaha"}}}}};
+                if (p % 3 == 0) {
+                    part["sequence"] = {"om shrim", "om hrim", "om klim", "om glaum"};
+                } else if (p % 3 == 1) {
+                    part["pairs"] = pairs({{"shrim", "shriyai"}, {"hrim", "hriyai"}, {"klim", "kliyai"}});
+                } else {
+                    part["utterance"] = "om " + partId + " tarpayaami namaha";
+                    part["description"] = "Single offering";
+                }
+                parts.push_back(std::move(part));
+            }
+            section["parts"] = std::move(parts);
+            sections.push_back(std::move(section));
+        }
+
+        JsonValue ritual = {{"id", id}, {"title", "Ritual " + std::to_string(r)}, {"version", "1.0.0"},
+                            {"source", "synthetic"},
+                            {"metadata", {{"language", "en"}, {"scripts_supported", {"IAST", "ASCII"}}}},
+                            {"materials_ref", group}, {"mantras_ref", group}, {"procedures_ref", group},
+                            {"sections", std::move(sections)}};
+        writeJson(root / "definitions" / group / (id + ".json"), ritual);
+    }
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// The loader before DefinitionReader, kept here as the baseline: every file
+// parsed into a document first, then copied field by field into the structs
+using sadhana::Material;
+using sadhana::Mantra;
+using sadhana::Part;
+using sadhana::ProgressMarker;
+using sadhana::Section;
+using sadhana::Step;
+
+struct DocumentRitual {
+    std::string id;
+    std::string title;
+    std::string version;
+    std::string source;
+    RitualDefinition::MetadataMap metadata;
+    std::vector<Section> sections;
+    std::shared_ptr<const RitualDefinition::MaterialList> materials;
+    std::shared_ptr<const RitualDefinition::MantraMap> mantras;
+    std::shared_ptr<const RitualDefinition::ProcedureMap> procedures;
+
+    // The RitualDefinition getters definitionJson() reads
+    const std::string& getId() const { return id; }
+    const std::string& getTitle() const { return title; }
+    const std::string& getVersion() const { return version; }
+    const std::string& getSource() const { return source; }
+    const RitualDefinition::MetadataMap& getMetadata() const { return metadata; }
+    const std::vector<Section>& getSections() const { return sections; }
+    const RitualDefinition::MaterialList& getMaterials() const { return *materials; }
+    const RitualDefinition::MantraMap& getMantras() const { return *mantras; }
+    const RitualDefinition::ProcedureMap& getProcedures() const { return *procedures; }
+};
+
+std::shared_ptr<const RitualDefinition::MaterialList> parseMaterials(const JsonValue& json) {
+    auto materials = std::make_shared<RitualDefinition::MaterialList>();
+    const JsonValue* materialsArray = nullptr;
+    if (json.contains("materials") && json["materials"].is_array()) {
+        materialsArray = &json["materials"];
+    } else if (json.is_array()) {
+        materialsArray = &json;
+    }
+    if (!materialsArray) return materials;
+
+    for (const auto& materialJson : *materialsArray) {
+        if (!materialJson.contains("id") || !materialJson.contains("name")) continue;
+        Material material;
+        material.id = materialJson["id"].get<std::string>();
+        material.name = materialJson["name"].get<std::string>();
+        if (materialJson.contains("details")) material.details = materialJson["details"].get<std::string>();
+        if (materialJson.contains("optional")) material.optional = materialJson["optional"].get<bool>();
+        for (const auto& [key, value] : materialJson.items()) {
+            if (key != "id" && key != "name" && key != "details" && key != "optional") {
+                material.additional_data[key] = value;
+            }
+        }
+        materials->push_back(std::move(material));
+    }
+    return materials;
+}
+
+Mantra mantraFromJson(const std::string& id, const JsonValue& json) {
+    Mantra mantra;
+    mantra.id = id;
+    if (json.is_array()) {
+        mantra.sequence = json.get<std::vector<std::string>>();
+        return mantra;
+    }
+    for (const auto& [key, value] : json.items()) {
+        if (key == "text") mantra.text = value.get<std::string>();
+        else if (key == "type") mantra.type = value.get<std::string>();
+        else if (key == "beejas") mantra.beejas = value.get<std::vector<std::string>>();
+        else if (key == "pairs") mantra.pairs = value.get<std::vector<std::vector<std::string>>>();
+        else if (key == "full_variants") mantra.full_variants = value.get<std::vector<std::string>>();
+        else mantra.additional_data[key] = value;
+    }
+    return mantra;
+}
+
+std::shared_ptr<const RitualDefinition::MantraMap> parseMantras(const JsonValue& json) {
+    auto mantras = std::make_shared<RitualDefinition::MantraMap>();
+    if (!json.contains("mantras")) return mantras;
+    for (const auto& [id, value] : json["mantras"].items()) {
+        (*mantras)[id] = mantraFromJson(id, value);
+    }
+    return mantras;
+}
+
+std::shared_ptr<const RitualDefinition::ProcedureMap> parseProcedures(const JsonValue& json) {
+    auto procedures = std::make_shared<RitualDefinition::ProcedureMap>();
+    if (!json.contains("procedures")) return procedures;
+    for (const auto& [id, proc] : json["procedures"].items()) {
+        Step step;
+        step.id = proc.value("id", id);
+        step.title = proc.value("title", "");
+        step.items = proc.value("items", std::vector<std::string>());
+        step.instructions = proc.value("instructions", std::vector<std::string>());
+        step.mantra_refs = proc.value("mantra_refs", std::vector<std::string>());
+        for (const auto& [key, value] : proc.items()) {
+            if (key != "id" && key != "title" && key != "items" &&
+                key != "instructions" && key != "mantra_refs") {
+                step.additional_data[key] = value;
+            }
+        }
+        (*procedures)[id] = std::move(step);
+    }
+    return procedures;
+}
+
+ProgressMarker markerFromJson(const JsonValue& json) {
+    ProgressMarker marker;
+    marker.canonical = json.at("canonical").get<std::string>();
+    marker.variants = json.value("variants", std::vector<std::string>());
+    marker.with_svaha_variants = json.value("with_svaha_variants", false);
+    marker.cooldown_ms = json.value("cooldown_ms", 700);
+    for (const auto& [key, value] : json.items()) {
+        if (key != "canonical" && key != "variants" && key != "with_svaha_variants" && key != "cooldown_ms") {
+            marker.additional_params[key] = value;
+        }
+    }
+    return marker;
+}
+
+Part partFromJson(const JsonValue& json) {
+    Part part;
+    part.id = json.at("id").get<std::string>();
+    part.title = json.at("title").get<std::string>();
+    part.notes = json.value("notes", "");
+    if (json.contains("description")) part.description = json["description"].get<std::string>();
+    if (json.contains("repetitions")) part.repetitions = json["repetitions"].get<int>();
+    if (json.contains("utterance")) part.utterance = json["utterance"].get<std::string>();
+    if (json.contains("sequence")) part.sequence = json["sequence"].get<std::vector<std::string>>();
+    if (json.contains("pairs")) part.pairs = json["pairs"].get<std::vector<std::vector<std::string>>>();
+    if (json.contains("derived_counts")) {
+        for (const auto& [key, value] : json["derived_counts"].items()) part.counts[key] = value.get<int>();
+    }
+    if (json.contains("mantra_ref")) part.mantra_ref = json["mantra_ref"].get<std::string>();
+    for (const auto& [key, value] : json.items()) {
+        if (key != "id" && key != "title" && key != "notes" && key != "repetitions" && key != "utterance" &&
+            key != "sequence" && key != "pairs" && key != "derived_counts") {
+            part.additional_data[key] = value;
+        }
+    }
+    return part;
+}
+
+Section sectionFromJson(const JsonValue& json) {
+    Section section;
+    section.id = json.at("id").get<std::string>();
+    section.title = json.at("title").get<std::string>();
+    section.notes = json.value("discipline_note", "");
+    if (json.contains("description")) section.description = json["description"].get<std::string>();
+    if (json.contains("introduction")) section.introduction = json["introduction"].get<std::string>();
+    if (json.contains("iteration_marker")) section.iteration_marker = markerFromJson(json["iteration_marker"]);
+    if (json.contains("parts")) {
+        std::vector<Part> parts;
+        for (const auto& partJson : json["parts"]) parts.push_back(partFromJson(partJson));
+        section.parts = std::move(parts);
+    }
+    if (json.contains("derived_totals")) {
+        for (const auto& [key, value] : json["derived_totals"].items()) section.counts[key] = value.get<int>();
+    }
+    for (const auto& [key, value] : json.items()) {
+        if (key != "id" && key != "title" && key != "steps" && key != "parts" && key != "iteration_marker" &&
+            key != "derived_totals" && key != "discipline_note") {
+            section.additional_data[key] = value;
+        }
+    }
+    return section;
+}
+
+// Throws on anything malformed, as nlohmann does
+void loadDocument(const fs::path& file, const fs::path& common, DocumentRitual& ritual) {
+    JsonValue json = JsonValue::parse(readFile(file));
+    ritual.id = json.at("id").get<std::string>();
+    ritual.title = json.at("title").get<std::string>();
+    ritual.version = json.at("version").get<std::string>();
+    ritual.source = json.at("source").get<std::string>();
+    if (json.contains("metadata")) ritual.metadata = json["metadata"].get<RitualDefinition::MetadataMap>();
+    if (json.contains("sections")) {
+        for (const auto& sectionJson : json["sections"]) ritual.sections.push_back(sectionFromJson(sectionJson));
+    }
+
+    auto commonFile = [&](const char* key, const char* directory) {
+        return JsonValue::parse(readFile(common / directory / (json[key].get<std::string>() + ".json")));
+    };
+    ritual.materials = json.contains("materials_ref") ? parseMaterials(commonFile("materials_ref", "materials"))
+                                                      : std::make_shared<const RitualDefinition::MaterialList>();
+    ritual.mantras = json.contains("mantras_ref") ? parseMantras(commonFile("mantras_ref", "mantras"))
+                                                  : std::make_shared<const RitualDefinition::MantraMap>();
+    ritual.procedures = json.contains("procedures_ref") ? parseProcedures(commonFile("procedures_ref", "procedures"))
+                                                        : std::make_shared<const RitualDefinition::ProcedureMap>();
+}
+
+template <typename Ritual>
+struct Pass {
+    double bestMs{0.0};
+    int64_t peakBytes{0};
+    int64_t retainedBytes{0};
+    uint64_t allocations{0};
+    std::vector<std::unique_ptr<Ritual>> rituals;  // from the last round
+};
+
+template <typename Ritual, typename LoadOne>
+bool runPass(const std::vector<fs::path>& files, int rounds, LoadOne loadOne, Pass<Ritual>& pass) {
+    for (int round = 0; round < rounds; ++round) {
+        pass.rituals.clear();
+        pass.rituals.shrink_to_fit();
+
+        int64_t base = sadhana::heapBytes();
+        sadhana::resetHeapPeak();
+        uint64_t allocationsBefore = sadhana::allocationCount();
+        auto start = std::chrono::steady_clock::now();
+
+        pass.rituals.reserve(files.size());
+        for (const auto& file : files) {
+            auto ritual = std::make_unique<Ritual>();
+            std::string error;
+            if (!loadOne(file, *ritual, error)) {
+                std::cerr << "Failed to load " << file.string() << ": " << error << "\n";
+                return false;
+            }
+            pass.rituals.push_back(std::move(ritual));
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (round == 0 || ms < pass.bestMs) pass.bestMs = ms;
+        pass.peakBytes = sadhana::heapPeak() - base;
+        pass.retainedBytes = sadhana::heapBytes() - base;
+        pass.allocations = sadhana::allocationCount() - allocationsBefore;
+    }
+    return true;
+}
+
+JsonValue markerJson(const sadhana::ProgressMarker& marker) {
+    return {{"canonical", marker.canonical}, {"variants", marker.variants},
+            {"with_svaha_variants", marker.with_svaha_variants}, {"cooldown_ms", marker.cooldown_ms},
+            {"additional_params", marker.additional_params}};
+}
+
+// Everything the structs hold, for comparing the two loaders
+template <typename Ritual>
+JsonValue definitionJson(const Ritual& ritual) {
+    JsonValue sections = JsonValue::array();
+    for (const auto& section : ritual.getSections()) {
+        JsonValue parts = nullptr;
+        if (section.parts) {
+            parts = JsonValue::array();
+            for (const auto& part : *section.parts) {
+                parts.push_back({{"id", part.id}, {"title", part.title}, {"notes", part.notes},
+                                 {"description", part.description ? JsonValue(*part.description) : JsonValue()},
+                                 {"repetitions", part.repetitions ? JsonValue(*part.repetitions) : JsonValue()},
+                                 {"utterance", part.utterance ? JsonValue(*part.utterance) : JsonValue()},
+                                 {"mantra_ref", part.mantra_ref ? JsonValue(*part.mantra_ref) : JsonValue()},
+                                 {"sequence", part.sequence ? JsonValue(*part.sequence) : JsonValue()},
+                                 {"pairs", part.pairs ? JsonValue(*part.pairs) : JsonValue()},
+                                 {"counts", part.counts}, {"additional_data", part.additional_data}});
+            }
+        }
+        sections.push_back({{"id", section.id}, {"title", section.title}, {"notes", section.notes},
+                            {"description", section.description ? JsonValue(*section.description) : JsonValue()},
+                            {"introduction", section.introduction ? JsonValue(*section.introduction) : JsonValue()},
+                            {"iteration_marker", section.iteration_marker ? markerJson(*section.iteration_marker)
+                                                                          : JsonValue()},
+                            {"parts", parts}, {"counts", section.counts},
+                            {"additional_data", section.additional_data}});
+    }
+
+    JsonValue materials = JsonValue::array();
+    for (const auto& material : ritual.getMaterials()) {
+        materials.push_back({{"id", material.id}, {"name", material.name}, {"details", material.details},
+                             {"optional", material.optional}, {"additional_data", material.additional_data}});
+    }
+    JsonValue mantras = JsonValue::object();
+    for (const auto& [id, mantra] : ritual.getMantras()) {
+        mantras[id] = {{"id", mantra.id}, {"text", mantra.text ? JsonValue(*mantra.text) : JsonValue()},
+                       {"type", mantra.type}, {"beejas", mantra.beejas}, {"pairs", mantra.pairs},
+                       {"sequence", mantra.sequence}, {"full_variants", mantra.full_variants},
+                       {"additional_data", mantra.additional_data}};
+    }
+    JsonValue procedures = JsonValue::object();
+    for (const auto& [id, step] : ritual.getProcedures()) {
+        procedures[id] = {{"id", step.id}, {"title", step.title}, {"items", step.items},
+                          {"instructions", step.instructions}, {"mantra_refs", step.mantra_refs},
+                          {"additional_data", step.additional_data}};
+    }
+
+    return {{"id", ritual.getId()}, {"title", ritual.getTitle()}, {"version", ritual.getVersion()},
+            {"source", ritual.getSource()}, {"metadata", ritual.getMetadata()}, {"sections", sections},
+            {"materials", materials}, {"mantras", mantras}, {"procedures", procedures}};
+}
+
+template <typename Ritual>
+JsonValue passJson(const Pass<Ritual>& pass, size_t rituals) {
+    return {{"best_ms", pass.bestMs},
+            {"ms_per_ritual", pass.bestMs / rituals},
+            {"peak_heap_bytes", pass.peakBytes},
+            {"retained_heap_bytes", pass.retainedBytes},
+            {"transient_heap_bytes", pass.peakBytes - pass.retainedBytes},
+            {"allocations", pass.allocations}};
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Shape shape;
+    fs::path root = fs::temp_directory_path() / "sadhana_load_bench";
+    int rounds = 5;
+    bool keep = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--keep") {
+            keep = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Usage: " << argv[0] << " [-d dir] [-n rituals] [-s sections] [-p parts]"
+                      << " [-v variants] [-g groups] [-r rounds] [--keep]\n";
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (flag == "-d") root = value;
+        else if (flag == "-n") shape.rituals = std::max(1, std::atoi(value.c_str()));
+        else if (flag == "-s") shape.sections = std::max(1, std::atoi(value.c_str()));
+        else if (flag == "-p") shape.parts = std::max(1, std::atoi(value.c_str()));
+        else if (flag == "-v") shape.variants = std::max(0, std::atoi(value.c_str()));
+        else if (flag == "-g") shape.groups = std::max(1, std::atoi(value.c_str()));
+        else if (flag == "-r") rounds = std::max(1, std::atoi(value.c_str()));
+    }
+
+    // The per-file "Loaded N ..." lines would only add noise to the timing
+    sadhana::Logger::instance().setLevel(sadhana::LogLevel::Warn);
+
+    fs::remove_all(root);
+    generateLibrary(root, shape);
+
+    std::vector<fs::path> files;
+    uint64_t bytes = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".json") {
+            bytes += entry.file_size();
+            if (entry.path().parent_path().parent_path().filename() == "definitions") {
+                files.push_back(entry.path());
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+    fs::path common = root / "common";
+
+    Pass<DocumentRitual> document;
+    bool ok = runPass(files, rounds, [&common](const fs::path& file, DocumentRitual& ritual, std::string& error) {
+        try {
+            loadDocument(file, common, ritual);
+            return true;
+        } catch (const std::exception& e) {
+            error = e.what();
+            return false;
+        }
+    }, document);
+
+    Pass<RitualDefinition> streaming;
+    ok = ok && runPass(files, rounds, [&common](const fs::path& file, RitualDefinition& ritual, std::string& error) {
+        return ritual.loadFromText(readFile(file), RitualDefinition::directoryResolver(common.string()), &error);
+    }, streaming);
+    if (!ok) return 1;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (definitionJson(*document.rituals[i]) != definitionJson(*streaming.rituals[i])) {
+            if (mismatches++ == 0) std::cerr << "Loaders disagree on " << files[i].string() << "\n";
+        }
+    }
+
+    JsonValue output = {
+        {"library", root.string()},
+        {"rituals", files.size()},
+        {"json_bytes", bytes},
+        {"rounds", rounds},
+        {"document", passJson(document, files.size())},
+        {"streaming", passJson(streaming, files.size())},
+        {"speedup", streaming.bestMs > 0.0 ? document.bestMs / streaming.bestMs : 0.0},
+        {"peak_heap_ratio", streaming.peakBytes > 0 ? static_cast<double>(document.peakBytes) / streaming.peakBytes : 0.0},
+        {"mismatches", mismatches}
+    };
+    std::cout << output.dump(2) << "\n";
+
+    if (!keep) fs::remove_all(root);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,343 @@
+// Load generator for sadhana_server: replays WAV files as concurrent PCM
+// streams at real-time pace and collects the progress pushed back.
+//
+//   sadhana_pcm_client <host:port | unix-socket-path> <file.wav>... [-c streams]
+//                      [-s speed] [-f int16|float] [-r rate] [-o results.json]
+//
+// Streams cycle through the given files. Each stream is its own connection
+// and thread, sending 20 ms frames; -s 2 sends twice as fast as real time.
+// Whenever the server reports the flow waiting for a key press, the client
+// sends one, as sadhana_eval's auto-advance does.
+
+#include "audio/wav_file.hpp"
+#include "net/pcm_protocol.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int FRAME_MS = 20;
+constexpr uint32_t SESSION_ID = 1;
+
+struct StreamReport {
+    std::string audioPath;
+    std::string error;
+    uint64_t framesSent{0};
+    uint64_t bytesSent{0};
+    uint64_t progressUpdates{0};
+    int counted{0};
+    uint64_t manualAdvances{0};
+    bool advancePending{false};
+    double maxSendLagMs{0.0};
+    nlohmann::json lastProgress;
+};
+
+int connectTo(const std::string& target) {
+    if (target.find('/') != std::string::npos) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, target.c_str(), sizeof(addr.sun_path) - 1);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+
+    auto colon = target.rfind(':');
+    std::string host = colon == std::string::npos ? "127.0.0.1" : target.substr(0, colon);
+    std::string port = colon == std::string::npos ? target : target.substr(colon + 1);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* results = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &results) != 0) return -1;
+
+    int fd = -1;
+    for (addrinfo* ai = results; ai; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(results);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Parses whatever server frames are complete in buffer; false once the server reported an error
+bool consumeFrames(std::vector<unsigned char>& buffer, StreamReport& report, int& lastRepetition) {
+    size_t offset = 0;
+    bool ok = true;
+    while (buffer.size() - offset >= sizeof(sadhana::PcmFrameHeader)) {
+        auto header = sadhana::readPcmHeader(buffer.data() + offset);
+        size_t frameBytes = sizeof(header) + header.payloadBytes;
+        if (buffer.size() - offset < frameBytes) break;
+        std::string payload(reinterpret_cast<const char*>(buffer.data() + offset + sizeof(header)),
+                            header.payloadBytes);
+        offset += frameBytes;
+
+        auto type = static_cast<sadhana::PcmFrameType>(header.type);
+        if (type == sadhana::PcmFrameType::Error) {
+            report.error = payload;
+            ok = false;
+        } else if (type == sadhana::PcmFrameType::Progress) {
+            ++report.progressUpdates;
+            try {
+                report.lastProgress = nlohmann::json::parse(payload);
+                int repetition = report.lastProgress.value("repetition", 0);
+                if (repetition > lastRepetition) ++report.counted;
+                lastRepetition = repetition;
+                report.advancePending = report.lastProgress.value("awaiting_manual", false) &&
+                                        !report.lastProgress.value("complete", false);
+            } catch (const nlohmann::json::exception&) {
+            }
+        }
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+    return ok;
+}
+
+// Reads until timeoutMs passes with nothing to read, or the connection ends
+bool receiveFor(int fd, int timeoutMs, std::vector<unsigned char>& buffer, StreamReport& report,
+                int& lastRepetition) {
+    pollfd pfd{fd, POLLIN, 0};
+    while (::poll(&pfd, 1, timeoutMs) > 0) {
+        unsigned char chunk[4096];
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.insert(buffer.end(), chunk, chunk + n);
+        if (!consumeFrames(buffer, report, lastRepetition)) return false;
+        if (report.advancePending) {
+            sadhana::PcmFrameHeader advance;
+            advance.type = static_cast<uint8_t>(sadhana::PcmFrameType::ManualAdvance);
+            advance.sessionId = SESSION_ID;
+            if (!sendAll(fd, &advance, sizeof(advance))) return false;
+            report.advancePending = false;
+            ++report.manualAdvances;
+        }
+        timeoutMs = 0;
+    }
+    return true;
+}
+
+void runStream(const std::string& target, const std::vector<float>& samples, int sampleRate,
+               sadhana::PcmSampleFormat format, double speed, StreamReport& report) {
+    int fd = connectTo(target);
+    if (fd < 0) {
+        report.error = "failed to connect to " + target;
+        return;
+    }
+
+    const size_t frameSamples = static_cast<size_t>(sampleRate) * FRAME_MS / 1000;
+    std::vector<unsigned char> frame;
+    std::vector<unsigned char> inbound;
+    int lastRepetition = 0;
+    bool open = true;
+    uint32_t sequence = 0;
+    auto start = Clock::now();
+
+    for (size_t offset = 0; open && offset < samples.size(); offset += frameSamples) {
+        size_t count = std::min(frameSamples, samples.size() - offset);
+
+        // Wait for this frame's due time, handling progress that arrives meanwhile
+        auto due = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(offset) / sampleRate / speed));
+        for (auto now = Clock::now(); open && now < due; now = Clock::now()) {
+            int waitMs = static_cast<int>(std::ceil(std::chrono::duration<double, std::milli>(due - now).count()));
+            open = receiveFor(fd, waitMs, inbound, report, lastRepetition);
+        }
+        if (!open) break;
+        double lagMs = std::chrono::duration<double, std::milli>(Clock::now() - due).count();
+        report.maxSendLagMs = std::max(report.maxSendLagMs, lagMs);
+
+        sadhana::PcmFrameHeader header;
+        header.type = static_cast<uint8_t>(sadhana::PcmFrameType::Audio);
+        header.format = static_cast<uint8_t>(format);
+        header.sessionId = SESSION_ID;
+        header.sampleRate = static_cast<uint32_t>(sampleRate);
+        header.sequence = sequence++;
+        header.payloadBytes = static_cast<uint32_t>(count * sadhana::pcmSampleBytes(format));
+
+        frame.resize(sizeof(header) + header.payloadBytes);
+        std::memcpy(frame.data(), &header, sizeof(header));
+        if (format == sadhana::PcmSampleFormat::Int16) {
+            auto* out = reinterpret_cast<int16_t*>(frame.data() + sizeof(header));
+            for (size_t i = 0; i < count; ++i) {
+                float s = std::clamp(samples[offset + i], -1.0f, 1.0f);
+                out[i] = static_cast<int16_t>(std::lrint(s * 32767.0f));
+            }
+        } else {
+            std::memcpy(frame.data() + sizeof(header), samples.data() + offset, count * sizeof(float));
+        }
+
+        if (!sendAll(fd, frame.data(), frame.size())) {
+            report.error = "send failed: " + std::string(std::strerror(errno));
+            break;
+        }
+        ++report.framesSent;
+        report.bytesSent += frame.size();
+    }
+
+    if (open && report.error.empty()) {
+        // Give the server time to decode the tail before ending the stream
+        receiveFor(fd, 1500, inbound, report, lastRepetition);
+        sadhana::PcmFrameHeader end;
+        end.type = static_cast<uint8_t>(sadhana::PcmFrameType::End);
+        end.sessionId = SESSION_ID;
+        sendAll(fd, &end, sizeof(end));
+    }
+    ::close(fd);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <host:port | socket-path> <file.wav>... [-c streams]"
+                  << " [-s speed] [-f int16|float] [-r rate] [-o results.json]\n";
+        return 1;
+    }
+
+    std::string target = argv[1];
+    std::vector<std::string> wavPaths;
+    size_t streams = 1;
+    double speed = 1.0;
+    int sampleRate = 16000;
+    auto format = sadhana::PcmSampleFormat::Int16;
+    std::string outputPath;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.size() == 2 && arg[0] == '-' && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "-c") streams = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+            else if (arg == "-s") speed = std::max(0.01, std::atof(value.c_str()));
+            else if (arg == "-r") sampleRate = std::max(1, std::atoi(value.c_str()));
+            else if (arg == "-o") outputPath = value;
+            else if (arg == "-f") {
+                format = value == "float" ? sadhana::PcmSampleFormat::Float32 : sadhana::PcmSampleFormat::Int16;
+            }
+        } else {
+            wavPaths.push_back(arg);
+        }
+    }
+    if (wavPaths.empty()) {
+        std::cerr << "No WAV files given\n";
+        return 1;
+    }
+
+    std::vector<std::vector<float>> audio;
+    for (const auto& path : wavPaths) {
+        sadhana::WavData wav;
+        std::string error;
+        if (!sadhana::readWavFile(path, wav, &error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        audio.push_back(sadhana::resample(wav.samples, wav.sampleRate, sampleRate));
+    }
+
+    std::vector<StreamReport> reports(streams);
+    std::vector<std::thread> threads;
+    auto wallStart = Clock::now();
+    for (size_t i = 0; i < streams; ++i) {
+        reports[i].audioPath = wavPaths[i % wavPaths.size()];
+        threads.emplace_back([&, i]() {
+            runStream(target, audio[i % audio.size()], sampleRate, format, speed, reports[i]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double wallSeconds = std::chrono::duration<double>(Clock::now() - wallStart).count();
+
+    nlohmann::json results = nlohmann::json::array();
+    double audioSeconds = 0.0, maxLagMs = 0.0;
+    uint64_t bytes = 0, progress = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < reports.size(); ++i) {
+        const auto& report = reports[i];
+        double seconds = static_cast<double>(audio[i % audio.size()].size()) / sampleRate;
+        nlohmann::json entry = {
+            {"audio", report.audioPath},
+            {"frames_sent", report.framesSent},
+            {"bytes_sent", report.bytesSent},
+            {"progress_updates", report.progressUpdates},
+            {"counted", report.counted},
+            {"manual_advances", report.manualAdvances},
+            {"max_send_lag_ms", report.maxSendLagMs},
+            {"last_progress", report.lastProgress}
+        };
+        if (!report.error.empty()) {
+            entry["error"] = report.error;
+            ++failed;
+        } else {
+            audioSeconds += seconds;
+        }
+        results.push_back(std::move(entry));
+        bytes += report.bytesSent;
+        progress += report.progressUpdates;
+        maxLagMs = std::max(maxLagMs, report.maxSendLagMs);
+    }
+
+    nlohmann::json output = {
+        {"streams", results},
+        {"aggregate", {
+            {"streams", streams},
+            {"failed", failed},
+            {"speed", speed},
+            {"format", format == sadhana::PcmSampleFormat::Int16 ? "int16" : "float"},
+            {"audio_seconds", audioSeconds},
+            {"wall_seconds", wallSeconds},
+            {"bytes_sent", bytes},
+            {"send_mbit_per_s", wallSeconds > 0 ? bytes * 8.0 / wallSeconds / 1e6 : 0.0},
+            {"progress_updates", progress},
+            {"max_send_lag_ms", maxLagMs}
+        }}
+    };
+
+    if (outputPath.empty()) {
+        std::cout << output.dump(2) << "\n";
+    } else {
+        std::ofstream out(outputPath);
+        out << output.dump(2) << "\n";
+        std::cerr << "Wrote " << outputPath << "\n";
+    }
+    return failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,131 @@
+// Demo viewer for the shared-memory progress page: polls the page and prints
+// each change, as a projector or tablet display would consume it.
+//
+//   sadhana_progress_view [--name /sadhana-progress] [--interval ms] [--json]
+//
+// Start the app with --progress-shm first. Reads are plain memory copies;
+// the viewer makes no syscalls between polls other than its own sleep.
+
+#include "shm/progress_page.hpp"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void signalHandler(int) {
+    stopRequested = 1;
+}
+
+// Minimal escaping; the page only carries ids and recognized text
+std::string jsonString(const char* text) {
+    std::string out = "\"";
+    for (const char* p = text; *p; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    return out + "\"";
+}
+
+void printLine(const sadhana::ProgressPageData& page) {
+    std::cout << "[" << (page.sectionIndex + 1) << "/" << page.sectionCount << "] "
+              << (page.sectionTitle[0] ? page.sectionTitle : page.sectionId);
+    if (page.partId[0]) std::cout << " / " << page.partId;
+    std::cout << "  " << page.repetition << "/" << page.requiredRepetitions;
+    if (page.awaitingManual) std::cout << "  (press SPACE)";
+    if (page.complete) std::cout << "  complete";
+    if (page.lastRecognized[0]) {
+        std::cout << "  last: \"" << page.lastRecognized << "\" (" << page.lastConfidence << ")";
+    }
+    std::cout << std::endl;
+}
+
+void printJson(const sadhana::ProgressPageData& page) {
+    std::cout << "{\"section\":" << jsonString(page.sectionId)
+              << ",\"section_title\":" << jsonString(page.sectionTitle)
+              << ",\"section_index\":" << page.sectionIndex
+              << ",\"section_count\":" << page.sectionCount
+              << ",\"part\":" << jsonString(page.partId)
+              << ",\"step\":" << jsonString(page.stepId)
+              << ",\"repetition\":" << page.repetition
+              << ",\"required\":" << page.requiredRepetitions
+              << ",\"awaiting_manual\":" << (page.awaitingManual ? "true" : "false")
+              << ",\"complete\":" << (page.complete ? "true" : "false")
+              << ",\"last_recognized\":" << jsonString(page.lastRecognized)
+              << ",\"confidence\":" << page.lastConfidence
+              << ",\"version\":" << page.version
+              << ",\"updated_ms\":" << page.updatedWallMs << "}" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string name = sadhana::ProgressPage::DEFAULT_NAME;
+    int intervalMs = 100;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--interval" && i + 1 < argc) {
+            intervalMs = std::max(1, std::atoi(argv[++i]));
+        }
+    }
+
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
+    sadhana::ProgressPageReader reader;
+    sadhana::ProgressPageData page{};
+    uint64_t polls = 0, updates = 0, busy = 0;
+    bool waitingShown = false;
+
+    while (!stopRequested) {
+        if (!reader.isOpen()) {
+            std::string error;
+            if (!reader.open(name, &error)) {
+                if (!waitingShown) {
+                    std::cerr << "Waiting for " << name << " (" << error << ")\n";
+                    waitingShown = true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                continue;
+            }
+        }
+
+        ++polls;
+        switch (reader.read(page)) {
+            case sadhana::ProgressPageReader::Result::Updated:
+                ++updates;
+                json ? printJson(page) : printLine(page);
+                break;
+            case sadhana::ProgressPageReader::Result::Busy:
+                ++busy;
+                break;
+            case sadhana::ProgressPageReader::Result::Unchanged:
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+
+    std::cerr << polls << " polls, " << updates << " updates, " << busy << " overlapped a write\n";
+    return 0;
+}
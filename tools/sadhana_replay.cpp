@@ -0,0 +1,94 @@
+// Replays a recorded flow trace (see ritual/flow_trace.hpp) through
+// PhraseManager and FlowManager with no audio, for tuning the matching layer.
+//
+//   sadhana_replay <trace.jsonl> [-n iterations] [-r ritual.json] [-f flow.json]
+
+#include "definition/definition.hpp"
+#include "ritual/flow_manager.hpp"
+#include "ritual/flow_trace.hpp"
+#include "log/logger.hpp"
+#include "allocation_counter.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <trace.jsonl> [-n iterations] [-r ritual.json] [-f flow.json]\n";
+        return 1;
+    }
+
+    std::string tracePath = argv[1];
+    std::string ritualPath = "rituals/definitions/ganapati/maha_ganapati_caturvrtti_tarpanam.json";
+    std::string flowPath = "rituals/definitions/ganapati/flow.json";
+    int iterations = 1;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "-n") {
+            iterations = std::max(1, std::atoi(argv[i + 1]));
+        } else if (flag == "-r") {
+            ritualPath = argv[i + 1];
+        } else if (flag == "-f") {
+            flowPath = argv[i + 1];
+        }
+    }
+
+    std::vector<sadhana::FlowTraceEvent> events;
+    std::string error;
+    if (!sadhana::loadFlowTrace(tracePath, events, &error)) {
+        std::cerr << "Failed to load trace: " << error << "\n";
+        return 1;
+    }
+
+    // Debug logging from the flow would only add noise to the timing
+    sadhana::Logger::instance().setLevel(sadhana::LogLevel::Warn);
+
+    sadhana::RitualDefinition ritual;
+    if (!ritual.loadFromFile(ritualPath)) {
+        std::cerr << "Failed to load ritual definition: " << ritualPath << "\n";
+        return 1;
+    }
+
+    double seconds = 0.0;
+    uint64_t allocations = 0;
+    size_t phrases = 0;
+    sadhana::FlowReplayStats last;
+
+    for (int i = 0; i < iterations; ++i) {
+        sadhana::FlowManager flow(ritual);
+        if (!flow.loadFlowConfiguration(flowPath)) {
+            std::cerr << "Failed to load flow configuration: " << flowPath << "\n";
+            return 1;
+        }
+
+        uint64_t allocationsBefore = sadhana::allocationCount();
+        last = sadhana::replayFlowTrace(flow, events);
+        allocations += sadhana::allocationCount() - allocationsBefore;
+
+        seconds += last.seconds;
+        phrases += last.phrases;
+    }
+
+    const auto& progress = last.finalProgress;
+    nlohmann::json output = {
+        {"trace", tracePath},
+        {"events", events.size()},
+        {"iterations", iterations},
+        {"phrases", last.phrases},
+        {"manual_advances", last.manualAdvances},
+        {"counted_repetitions", last.countedRepetitions},
+        {"seconds", seconds},
+        {"phrases_per_second", seconds > 0.0 ? phrases / seconds : 0.0},
+        {"allocations_per_phrase", phrases ? static_cast<double>(allocations) / phrases : 0.0},
+        {"final_progress", {
+            {"section", progress.currentSectionId},
+            {"part", progress.currentPartId},
+            {"step", progress.currentStepId},
+            {"repetition", progress.currentRepetition},
+            {"awaiting_manual_intervention", progress.awaitingManualIntervention}
+        }}
+    };
+    std::cout << output.dump(2) << "\n";
+    return 0;
+}
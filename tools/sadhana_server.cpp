@@ -0,0 +1,121 @@
+// Recognition server for remote practitioners: accepts PCM streams over TCP
+// and/or a Unix socket, runs each as a session in one SessionHost and pushes
+// progress back on the same connection. See net/pcm_protocol.hpp for framing.
+//
+//   sadhana_server [--port N] [--unix path] [--workers N] [--max-sessions N]
+//                  [--library dir] [--ritual-id id] [--model dir]
+//                  [--metrics-file path] [--log-level level]
+
+#include "event/event_loop.hpp"
+#include "host/session_host.hpp"
+#include "host/ritual_library.hpp"
+#include "net/pcm_server.hpp"
+#include "metrics/metrics_exporter.hpp"
+#include "log/logger.hpp"
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+static sadhana::EventLoop eventLoop;
+
+void signalHandler(int) {
+    eventLoop.stop();
+}
+
+int main(int argc, char* argv[]) {
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::string ritualId = sadhana::RitualLibrary::DEFAULT_RITUAL;
+    sadhana::RitualLibrary::Config libraryConfig;
+    sadhana::VoskASR::Config asrConfig;
+    asrConfig.modelPath = "models/vosk-model-small-en-us-0.15";
+    asrConfig.sampleRate = 16000.0f;
+    sadhana::SessionHost::Config hostConfig;
+    sadhana::PcmServer::Config serverConfig;
+    sadhana::MetricsExporter::Config metricsConfig;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--port") {
+            serverConfig.tcpPort = std::atoi(value.c_str());
+        } else if (arg == "--bind") {
+            serverConfig.bindAddress = value;
+        } else if (arg == "--unix") {
+            serverConfig.unixPath = value;
+        } else if (arg == "--workers") {
+            hostConfig.workers = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+        } else if (arg == "--max-sessions") {
+            hostConfig.maxSessions = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+        } else if (arg == "--library") {
+            libraryConfig.root = value;
+        } else if (arg == "--ritual-id") {
+            ritualId = value;
+        } else if (arg == "--model") {
+            asrConfig.modelPath = value;
+        } else if (arg == "--metrics-file") {
+            metricsConfig.filePath = value;
+        } else if (arg == "--log-level") {
+            sadhana::Logger::instance().setLevel(sadhana::Logger::parseLevel(value));
+        }
+    }
+    if (serverConfig.tcpPort <= 0 && serverConfig.unixPath.empty()) {
+        serverConfig.tcpPort = 7077;
+    }
+
+    std::string error;
+    std::shared_ptr<const sadhana::RitualAssets> assets;
+    {
+        sadhana::RitualLibrary library(libraryConfig);
+        if (library.scan(&error)) {
+            assets = library.load(ritualId, &error);
+        }
+    }
+    if (!assets) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    auto asr = std::make_shared<sadhana::VoskASR>(asrConfig);
+    if (!asr->init()) {
+        return 1;
+    }
+
+    sadhana::SessionHost host(asr, hostConfig);
+    if (!eventLoop.init() || !host.start()) {
+        return 1;
+    }
+
+    sadhana::PcmServer server(eventLoop, host, assets, serverConfig);
+    if (!server.start()) {
+        return 1;
+    }
+
+    sadhana::MetricsExporter metricsExporter;
+    if (!metricsConfig.filePath.empty() && !metricsExporter.start(metricsConfig)) {
+        std::cerr << "Failed to start metrics exporter\n";
+    }
+
+    std::cerr << "Listening"
+              << (serverConfig.tcpPort > 0 ? " on " + serverConfig.bindAddress + ":" +
+                                                 std::to_string(serverConfig.tcpPort) : "")
+              << (serverConfig.unixPath.empty() ? "" : " on " + serverConfig.unixPath)
+              << " with " << host.getConfig().workers << " workers\n";
+
+    eventLoop.run();
+
+    server.stop();
+    auto stats = server.stats();
+    auto hostStats = host.stats();
+    host.stop();
+    metricsExporter.stop();
+
+    std::cerr << "Accepted " << stats.accepted << " connections, " << stats.frames << " frames, "
+              << stats.bytes << " bytes; lost " << stats.lostFrames << " frames, "
+              << stats.progressSent << " progress updates sent; "
+              << hostStats.admitted << " sessions admitted, " << hostStats.rejected << " refused\n";
+    return 0;
+}
@@ -0,0 +1,235 @@
+// Load test for EventStreamServer: one in-process server, many SSE viewers
+// on loopback, and a publisher posting progress at a fixed rate.
+//
+//   sadhana_sse_load [-c clients] [-r events/s] [-d seconds] [--slow n]
+//                    [--queue frames] [--port p]
+//
+// Viewers are read from a single epoll thread, as a room full of phones
+// would be from the server's point of view. --slow adds viewers that connect
+// and never read, to check they only lose their own frames. Reports events
+// seen per viewer and publish-to-receive latency.
+
+#include "net/event_stream_server.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+struct Viewer {
+    int fd{-1};
+    std::string buffer;
+    bool headersDone{false};
+    uint64_t events{0};
+};
+
+int64_t wallMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int connectViewer(int port, bool slow) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (slow) {
+        // Keep the kernel from absorbing the backlog on the viewer's behalf
+        int small = 4096;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    const char request[] = "GET /events HTTP/1.1\r\nHost: localhost\r\nAccept: text/event-stream\r\n\r\n";
+    if (::write(fd, request, sizeof(request) - 1) != static_cast<ssize_t>(sizeof(request) - 1)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Consumes complete events from the buffer; returns false on a malformed stream
+bool parseEvents(Viewer& viewer, std::vector<int64_t>& latencies) {
+    if (!viewer.headersDone) {
+        auto end = viewer.buffer.find("\r\n\r\n");
+        if (end == std::string::npos) return true;
+        if (viewer.buffer.rfind("HTTP/1.1 200", 0) != 0) return false;
+        viewer.buffer.erase(0, end + 4);
+        viewer.headersDone = true;
+    }
+    size_t start = 0;
+    for (;;) {
+        auto end = viewer.buffer.find("\n\n", start);
+        if (end == std::string::npos) break;
+        std::string_view block(viewer.buffer.data() + start, end - start);
+        start = end + 2;
+
+        if (block.find("event: progress") == std::string_view::npos) continue;
+        auto data = block.find("data: ");
+        if (data == std::string_view::npos) return false;
+        auto json = nlohmann::json::parse(block.substr(data + 6), nullptr, false);
+        if (json.is_discarded()) return false;
+        ++viewer.events;
+        latencies.push_back(wallMicros() - json.value("sent_us", int64_t{0}));
+    }
+    viewer.buffer.erase(0, start);
+    return true;
+}
+
+double percentile(std::vector<int64_t>& values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index] / 1000.0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int clients = 500;
+    int slowClients = 0;
+    double rate = 20.0;
+    double seconds = 10.0;
+    sadhana::EventStreamServer::Config config;
+    config.port = 18077;
+    config.bindAddress = "127.0.0.1";
+    config.heartbeatMs = 0;
+
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-c") {
+            clients = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-r") {
+            rate = std::max(0.1, std::atof(argv[++i]));
+        } else if (arg == "-d") {
+            seconds = std::max(0.1, std::atof(argv[++i]));
+        } else if (arg == "--slow") {
+            slowClients = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--queue") {
+            config.queueFrames = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--port") {
+            config.port = std::atoi(argv[++i]);
+        }
+    }
+
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    config.maxClients = static_cast<size_t>(clients + slowClients);
+
+    sadhana::EventStreamServer server(config);
+    if (!server.start()) return 1;
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Viewer> viewers(static_cast<size_t>(clients));
+    for (size_t i = 0; i < viewers.size(); ++i) {
+        viewers[i].fd = connectViewer(config.port, false);
+        if (viewers[i].fd < 0) {
+            std::cerr << "Viewer " << i << " failed to connect: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, viewers[i].fd, &event);
+    }
+    std::vector<int> slow;
+    for (int i = 0; i < slowClients; ++i) {
+        int fd = connectViewer(config.port, true);
+        if (fd >= 0) slow.push_back(fd);
+    }
+    while (server.stats().clients < static_cast<uint64_t>(clients) + slow.size()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    uint64_t published = 0;
+    std::thread publisher([&]() {
+        sadhana::FlowProgress progress;
+        progress.currentSectionId = "tarpanam";
+        progress.currentPartId = "ganapati";
+        progress.currentStepId = "mantra";
+        auto interval = std::chrono::duration<double>(1.0 / rate);
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::duration<double>(seconds);
+        auto next = start;
+        while (next < end) {
+            std::this_thread::sleep_until(next);
+            ++progress.currentRepetition;
+            ++progress.version;
+            server.publishProgress(progress);
+            ++published;
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+        }
+    });
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(clients * rate * seconds));
+    size_t broken = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds + 1.0);
+    std::vector<epoll_event> events(256);
+    char buffer[16384];
+    while (std::chrono::steady_clock::now() < deadline) {
+        int n = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 100);
+        for (int e = 0; e < n; ++e) {
+            Viewer& viewer = viewers[events[e].data.u64];
+            ssize_t got = ::read(viewer.fd, buffer, sizeof(buffer));
+            if (got <= 0) {
+                if (got < 0 && errno == EINTR) continue;
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, viewer.fd, nullptr);
+                ++broken;
+                continue;
+            }
+            viewer.buffer.append(buffer, static_cast<size_t>(got));
+            if (!parseEvents(viewer, latencies)) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, viewer.fd, nullptr);
+                ++broken;
+            }
+        }
+    }
+    publisher.join();
+
+    auto stats = server.stats();
+    server.stop();
+    for (auto& viewer : viewers) ::close(viewer.fd);
+    for (int fd : slow) ::close(fd);
+    ::close(epollFd);
+
+    std::vector<uint64_t> received;
+    for (const auto& viewer : viewers) received.push_back(viewer.events);
+    std::sort(received.begin(), received.end());
+    uint64_t complete = static_cast<uint64_t>(std::count(received.begin(), received.end(), published));
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "viewers " << clients << " (+" << slow.size() << " slow), published " << published
+              << " events at " << rate << "/s\n"
+              << "received per viewer: min " << received.front()
+              << ", median " << received[received.size() / 2]
+              << ", max " << received.back()
+              << "; " << complete << " viewers saw every event, " << broken << " broken streams\n"
+              << "latency ms: p50 " << percentile(latencies, 0.50)
+              << ", p99 " << percentile(latencies, 0.99)
+              << ", max " << percentile(latencies, 1.0) << "\n"
+              << "server: " << stats.framesQueued << " frames queued, " << stats.framesDropped
+              << " dropped, " << stats.bytesSent / 1024 << " KiB sent\n";
+    return complete == static_cast<uint64_t>(clients) && broken == 0 ? 0 : 2;
+}
@@ -0,0 +1,463 @@
+// Queries the columnar utterance store written by the app's --analytics and
+// by sadhana_eval -a.
+//
+//   sadhana_stats <query> <file|dir>... [--section id] [--part id] [--session id]
+//                 [--kind recognized|manual] [--accepted | --rejected]
+//                 [--top n] [--json]
+//
+// Queries:
+//   summary           rows, sessions, acceptance and scan speed
+//   markers           matched marker variants, by how often they fired
+//   transcripts       raw transcripts by count, with how many were counted
+//   offering-seconds  seconds between consecutive offerings, by section
+//   manual            manual advances by section and part
+//   decode            decode time percentiles, by section
+//
+// Directories are searched for *.sdua files. Each query reads only the
+// columns it needs; filters compare dictionary ids across whole column arrays
+// and aggregations index flat arrays by id, so strings are only touched once
+// per file when the results are named.
+
+#include "analytics/utterance_log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+using sadhana::UtteranceChunk;
+using sadhana::UtteranceKind;
+
+constexpr uint32_t NO_ID = UINT32_MAX;
+
+uint32_t bit(UtteranceChunk::Column column) {
+    return 1u << column;
+}
+
+enum class Query { Summary, Markers, Transcripts, OfferingSeconds, Manual, Decode };
+
+struct Filters {
+    std::string section, part, session;
+    bool hasSection{false}, hasPart{false}, hasSession{false};
+    int kind{0};       // 0 = any
+    int accepted{-1};  // -1 = any
+};
+
+struct Counts {
+    uint64_t rows{0};
+    uint64_t accepted{0};
+    double confidence{0.0};
+};
+
+struct Totals {
+    uint64_t files{0};
+    uint64_t chunks{0};
+    uint64_t bytes{0};
+    uint64_t rowsScanned{0};
+    uint64_t rows{0};
+    uint64_t recognized{0};
+    uint64_t accepted{0};
+    uint64_t manual{0};
+    std::set<std::string> sessions;
+    std::set<std::string> sections;
+};
+
+// Results by name, merged across files
+struct Results {
+    std::map<std::string, Counts> groups;
+    std::map<std::string, std::vector<float>> samples;
+    std::map<std::string, std::set<std::string>> groupSessions;
+    Totals totals;
+};
+
+// Resolves a filter string to this file's id once the dictionary has it
+struct IdLookup {
+    const std::string* value{nullptr};
+    uint32_t id{NO_ID};
+
+    void update(const std::vector<std::string>& dictionary, size_t from) {
+        if (!value || id != NO_ID) return;
+        for (size_t i = from; i < dictionary.size(); ++i) {
+            if (dictionary[i] == *value) {
+                id = static_cast<uint32_t>(i);
+                return;
+            }
+        }
+    }
+};
+
+template <typename T>
+void keepEqual(std::vector<uint8_t>& selected, const std::vector<T>& column, T value) {
+    const size_t n = selected.size();
+    uint8_t* s = selected.data();
+    const T* c = column.data();
+    for (size_t i = 0; i < n; ++i) {
+        s[i] &= static_cast<uint8_t>(c[i] == value);
+    }
+}
+
+uint32_t columnsFor(Query query, const Filters& filters) {
+    uint32_t columns = bit(UtteranceChunk::Kind) | bit(UtteranceChunk::Accepted);
+    if (filters.hasSection) columns |= bit(UtteranceChunk::Section);
+    if (filters.hasPart) columns |= bit(UtteranceChunk::Part);
+    if (filters.hasSession) columns |= bit(UtteranceChunk::Session);
+    switch (query) {
+        case Query::Summary:
+            columns |= bit(UtteranceChunk::Session) | bit(UtteranceChunk::Section);
+            break;
+        case Query::Markers:
+            columns |= bit(UtteranceChunk::Marker) | bit(UtteranceChunk::Confidence);
+            break;
+        case Query::Transcripts:
+            columns |= bit(UtteranceChunk::Transcript) | bit(UtteranceChunk::Confidence);
+            break;
+        case Query::OfferingSeconds:
+            columns |= bit(UtteranceChunk::Session) | bit(UtteranceChunk::Section) |
+                       bit(UtteranceChunk::StreamMs);
+            break;
+        case Query::Manual:
+            columns |= bit(UtteranceChunk::Session) | bit(UtteranceChunk::Section) |
+                       bit(UtteranceChunk::Part);
+            break;
+        case Query::Decode:
+            columns |= bit(UtteranceChunk::Section) | bit(UtteranceChunk::DecodeMs);
+            break;
+    }
+    return columns;
+}
+
+bool scanFile(const std::string& path, Query query, const Filters& filters, Results& results) {
+    sadhana::UtteranceLogReader reader;
+    std::string error;
+    if (!reader.open(path, &error)) {
+        std::cerr << error << "\n";
+        return false;
+    }
+    ++results.totals.files;
+    results.totals.bytes += std::filesystem::file_size(path);
+
+    const uint32_t columns = columnsFor(query, filters);
+    IdLookup section{filters.hasSection ? &filters.section : nullptr};
+    IdLookup part{filters.hasPart ? &filters.part : nullptr};
+    IdLookup session{filters.hasSession ? &filters.session : nullptr};
+    size_t indexed = 0;
+
+    // Aggregates by this file's ids; named and merged once the file is done
+    std::vector<Counts> byId;
+    std::unordered_map<uint64_t, Counts> byPair;  // section id << 32 | part id
+    std::unordered_map<uint64_t, std::unordered_set<uint32_t>> pairSessions;
+    std::unordered_map<uint32_t, std::vector<float>> samplesById;
+    std::unordered_map<uint32_t, std::pair<uint32_t, int64_t>> lastOffering;  // session -> section, ms
+    std::unordered_set<uint32_t> sessionsSeen, sectionsSeen;
+
+    UtteranceChunk chunk;
+    std::vector<uint8_t> selected;
+    while (reader.next(chunk, columns)) {
+        ++results.totals.chunks;
+        results.totals.rowsScanned += chunk.rows;
+        const auto& dictionary = reader.dictionary();
+        section.update(dictionary, indexed);
+        part.update(dictionary, indexed);
+        session.update(dictionary, indexed);
+        indexed = dictionary.size();
+        if ((section.value && section.id == NO_ID) || (part.value && part.id == NO_ID) ||
+            (session.value && session.id == NO_ID)) {
+            continue;
+        }
+
+        selected.assign(chunk.rows, 1);
+        if (section.value) keepEqual(selected, chunk.section, section.id);
+        if (part.value) keepEqual(selected, chunk.part, part.id);
+        if (session.value) keepEqual(selected, chunk.session, session.id);
+        if (filters.kind) keepEqual(selected, chunk.kind, static_cast<uint8_t>(filters.kind));
+        if (filters.accepted >= 0) keepEqual(selected, chunk.accepted, static_cast<uint8_t>(filters.accepted));
+        if (query == Query::Manual) {
+            keepEqual(selected, chunk.kind, static_cast<uint8_t>(UtteranceKind::ManualAdvance));
+        } else if (query == Query::OfferingSeconds) {
+            keepEqual(selected, chunk.kind, static_cast<uint8_t>(UtteranceKind::Recognized));
+            keepEqual(selected, chunk.accepted, uint8_t{1});
+        } else if (query == Query::Decode) {
+            keepEqual(selected, chunk.kind, static_cast<uint8_t>(UtteranceKind::Recognized));
+        }
+
+        if (byId.size() < dictionary.size()) byId.resize(dictionary.size());
+        const uint8_t* s = selected.data();
+        const size_t rows = chunk.rows;
+
+        for (size_t i = 0; i < rows; ++i) {
+            if (!s[i]) continue;
+            ++results.totals.rows;
+            bool recognized = chunk.kind[i] == static_cast<uint8_t>(UtteranceKind::Recognized);
+            results.totals.recognized += recognized;
+            results.totals.manual += !recognized;
+            results.totals.accepted += chunk.accepted[i];
+
+            switch (query) {
+                case Query::Summary:
+                    sessionsSeen.insert(chunk.session[i]);
+                    sectionsSeen.insert(chunk.section[i]);
+                    break;
+                case Query::Markers:
+                case Query::Transcripts: {
+                    uint32_t id = query == Query::Markers ? chunk.marker[i] : chunk.transcript[i];
+                    auto& counts = byId[id];
+                    ++counts.rows;
+                    counts.accepted += chunk.accepted[i];
+                    counts.confidence += chunk.confidence[i];
+                    break;
+                }
+                case Query::OfferingSeconds: {
+                    auto [it, first] = lastOffering.try_emplace(chunk.session[i], chunk.section[i], chunk.streamMs[i]);
+                    if (!first) {
+                        int64_t delta = chunk.streamMs[i] - it->second.second;
+                        // A new section, or a resumed run whose clock restarted, has no interval
+                        if (it->second.first == chunk.section[i] && delta > 0) {
+                            samplesById[chunk.section[i]].push_back(static_cast<float>(delta / 1000.0));
+                        }
+                        it->second = {chunk.section[i], chunk.streamMs[i]};
+                    }
+                    break;
+                }
+                case Query::Manual: {
+                    uint64_t key = (static_cast<uint64_t>(chunk.section[i]) << 32) | chunk.part[i];
+                    ++byPair[key].rows;
+                    pairSessions[key].insert(chunk.session[i]);
+                    break;
+                }
+                case Query::Decode:
+                    samplesById[chunk.section[i]].push_back(chunk.decodeMs[i]);
+                    break;
+            }
+        }
+    }
+
+    const auto& dictionary = reader.dictionary();
+    for (uint32_t id : sessionsSeen) results.totals.sessions.insert(dictionary[id]);
+    for (uint32_t id : sectionsSeen) results.totals.sections.insert(dictionary[id]);
+    for (size_t id = 0; id < byId.size(); ++id) {
+        if (byId[id].rows == 0) continue;
+        // Rows that matched nothing have an empty marker; they are not a variant
+        if (query == Query::Markers && dictionary[id].empty()) continue;
+        auto& merged = results.groups[dictionary[id]];
+        merged.rows += byId[id].rows;
+        merged.accepted += byId[id].accepted;
+        merged.confidence += byId[id].confidence;
+    }
+    for (const auto& [key, counts] : byPair) {
+        std::string name = dictionary[key >> 32] + " / " + dictionary[key & 0xffffffffu];
+        results.groups[name].rows += counts.rows;
+        for (uint32_t id : pairSessions[key]) {
+            results.groupSessions[name].insert(dictionary[id]);
+        }
+    }
+    for (auto& [id, values] : samplesById) {
+        auto& merged = results.samples[dictionary[id]];
+        merged.insert(merged.end(), values.begin(), values.end());
+    }
+    return true;
+}
+
+double percentile(std::vector<float>& values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+std::vector<std::pair<std::string, Counts>> topGroups(const Results& results, size_t top) {
+    std::vector<std::pair<std::string, Counts>> rows(results.groups.begin(), results.groups.end());
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return a.second.rows != b.second.rows ? a.second.rows > b.second.rows : a.first < b.first;
+    });
+    if (top > 0 && rows.size() > top) rows.resize(top);
+    return rows;
+}
+
+void printReport(Query query, Results& results, size_t top, bool json) {
+    nlohmann::json out = nlohmann::json::array();
+    std::cout << std::fixed << std::setprecision(2);
+
+    switch (query) {
+        case Query::Summary: {
+            const auto& t = results.totals;
+            nlohmann::json summary = {
+                {"files", t.files}, {"chunks", t.chunks}, {"bytes", t.bytes},
+                {"rows", t.rows}, {"recognized", t.recognized}, {"accepted", t.accepted},
+                {"manual", t.manual}, {"sessions", t.sessions.size()}, {"sections", t.sections.size()},
+                {"acceptance", t.recognized ? std::round(10000.0 * t.accepted / t.recognized) / 10000.0 : 0.0}
+            };
+            if (json) {
+                std::cout << summary.dump(2) << "\n";
+            } else {
+                for (const auto& [key, value] : summary.items()) {
+                    std::cout << std::left << std::setw(12) << key << value << "\n";
+                }
+            }
+            return;
+        }
+        case Query::Markers:
+        case Query::Transcripts:
+        case Query::Manual: {
+            auto rows = topGroups(results, top);
+            const char* label = query == Query::Markers ? "marker" : query == Query::Transcripts ? "transcript"
+                                                                                                 : "section_part";
+            if (!json) {
+                std::cout << std::right << std::setw(9) << "rows";
+                if (query == Query::Manual) {
+                    std::cout << std::setw(10) << "sessions";
+                } else {
+                    std::cout << std::setw(9) << "counted" << std::setw(11) << "mean conf";
+                }
+                std::cout << "  " << (query == Query::Manual ? "section / part" : label) << "\n";
+            }
+            for (const auto& [name, counts] : rows) {
+                nlohmann::json row = {{label, name}, {"rows", counts.rows}};
+                if (query == Query::Manual) {
+                    row["sessions"] = results.groupSessions[name].size();
+                } else {
+                    row["counted"] = counts.accepted;
+                    row["mean_confidence"] = counts.confidence / counts.rows;
+                }
+                if (json) {
+                    out.push_back(row);
+                    continue;
+                }
+                std::cout << std::right << std::setw(9) << counts.rows;
+                if (query == Query::Manual) {
+                    std::cout << std::setw(10) << results.groupSessions[name].size();
+                } else {
+                    std::cout << std::setw(9) << counts.accepted << std::setw(11)
+                              << counts.confidence / counts.rows;
+                }
+                std::cout << "  " << (name.empty() ? "(empty)" : name) << "\n";
+            }
+            break;
+        }
+        case Query::OfferingSeconds:
+        case Query::Decode: {
+            const char* unit = query == Query::Decode ? "ms" : "s";
+            if (!json) {
+                std::cout << std::right << std::setw(9) << "samples" << std::setw(10) << "median"
+                          << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "mean"
+                          << "  section (" << unit << ")\n";
+            }
+            for (auto& [name, values] : results.samples) {
+                if (values.empty()) continue;
+                double sum = 0.0;
+                for (float v : values) sum += v;
+                double mean = sum / values.size();
+                double p50 = percentile(values, 0.5);
+                double p90 = percentile(values, 0.9);
+                double p99 = percentile(values, 0.99);
+                if (json) {
+                    out.push_back({{"section", name}, {"samples", values.size()}, {"median", p50},
+                                   {"p90", p90}, {"p99", p99}, {"mean", mean}});
+                    continue;
+                }
+                std::cout << std::right << std::setw(9) << values.size() << std::setw(10) << p50
+                          << std::setw(10) << p90 << std::setw(10) << p99 << std::setw(10) << mean
+                          << "  " << name << "\n";
+            }
+            break;
+        }
+    }
+    if (json) {
+        std::cout << out.dump(2) << "\n";
+    }
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0
+              << " <summary|markers|transcripts|offering-seconds|manual|decode> <file|dir>...\n"
+              << "       [--section id] [--part id] [--session id] [--kind recognized|manual]\n"
+              << "       [--accepted | --rejected] [--top n] [--json]\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    static const std::map<std::string, Query> queries = {
+        {"summary", Query::Summary}, {"markers", Query::Markers}, {"transcripts", Query::Transcripts},
+        {"offering-seconds", Query::OfferingSeconds}, {"manual", Query::Manual}, {"decode", Query::Decode}
+    };
+    auto queryIt = queries.find(argv[1]);
+    if (queryIt == queries.end()) {
+        usage(argv[0]);
+        return 1;
+    }
+    Query query = queryIt->second;
+
+    Filters filters;
+    size_t top = 20;
+    bool json = false;
+    std::vector<std::string> files;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--section" && hasValue) {
+            filters.section = argv[++i];
+            filters.hasSection = true;
+        } else if (arg == "--part" && hasValue) {
+            filters.part = argv[++i];
+            filters.hasPart = true;
+        } else if (arg == "--session" && hasValue) {
+            filters.session = argv[++i];
+            filters.hasSession = true;
+        } else if (arg == "--kind" && hasValue) {
+            std::string kind = argv[++i];
+            filters.kind = static_cast<int>(kind == "manual" ? UtteranceKind::ManualAdvance
+                                                             : UtteranceKind::Recognized);
+        } else if (arg == "--accepted") {
+            filters.accepted = 1;
+        } else if (arg == "--rejected") {
+            filters.accepted = 0;
+        } else if (arg == "--top" && hasValue) {
+            top = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--json") {
+            json = true;
+        } else if (std::filesystem::is_directory(arg)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(arg)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".sdua") {
+                    files.push_back(entry.path().string());
+                }
+            }
+        } else {
+            files.push_back(arg);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) {
+        std::cerr << "No analytics files given\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Results results;
+    for (const auto& file : files) {
+        scanFile(file, query, filters, results);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printReport(query, results, top, json);
+    std::cerr << std::fixed << "Scanned " << results.totals.rowsScanned << " rows in " << results.totals.files << " files, "
+              << std::setprecision(3) << seconds << " s ("
+              << std::setprecision(1) << results.totals.rowsScanned / std::max(seconds, 1e-9) / 1e6
+              << " M rows/s)\n";
+    return 0;
+}